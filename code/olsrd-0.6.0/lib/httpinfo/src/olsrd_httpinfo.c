@@ -1047,14 +1047,14 @@ build_topo_body(struct autobuf *abuf)
 static void
 build_mid_body(struct autobuf *abuf)
 {
-  int idx;
+  uint32_t idx;
   const char *colspan = resolve_ip_addresses ? " colspan=\"2\"" : "";
 
   section_title(abuf, "MID Entries");
   abuf_appendf(abuf, "<tr><th%s>Main Address</th><th>Aliases</th></tr>\n", colspan);
 
   /* MID */
-  for (idx = 0; idx < HASHSIZE; idx++) {
+  for (idx = 0; idx < mid_set_size; idx++) {
     struct mid_entry *entry;
     for (entry = mid_set[idx].next; entry != &mid_set[idx]; entry = entry->next) {
       int mid_cnt;
@@ -113,7 +113,7 @@ mapwrite_work(FILE * fmap)
     }
   }
 
-  for (hash = 0; hash < HASHSIZE; hash++) {
+  for (hash = 0; hash < (int)mid_set_size; hash++) {
     struct mid_entry *entry = mid_set[hash].next;
     while (entry != &mid_set[hash]) {
       struct mid_address *alias = entry->aliases;
@@ -81,9 +81,6 @@ static int ipAddrLen;
 static union olsr_ip_addr *mainAddr;
 
 static struct interface *intTab = NULL;
-static struct neighbor_entry *neighTab = NULL;
-static struct mid_entry *midTab = NULL;
-static struct hna_entry *hnaTab = NULL;
 static struct olsrd_config *config = NULL;
 
 static int iterIndex;
@@ -184,12 +181,12 @@ iterNeighTabNext(char *buff, int len)
 
   iterNeighTab = iterNeighTab->next;
 
-  if (iterNeighTab == &neighTab[iterIndex]) {
+  if (iterNeighTab == &neighbortable[iterIndex]) {
     iterNeighTab = NULL;
 
-    while (++iterIndex < HASHSIZE)
-      if (neighTab[iterIndex].next != &neighTab[iterIndex]) {
-        iterNeighTab = neighTab[iterIndex].next;
+    while (++iterIndex < (int)neighbortable_size)
+      if (neighbortable[iterIndex].next != &neighbortable[iterIndex]) {
+        iterNeighTab = neighbortable[iterIndex].next;
         break;
       }
   }
@@ -202,12 +199,12 @@ iterNeighTabInit(void)
 {
   iterNeighTab = NULL;
 
-  if (neighTab == NULL)
+  if (neighbortable == NULL)
     return;
 
-  for (iterIndex = 0; iterIndex < HASHSIZE; iterIndex++)
-    if (neighTab[iterIndex].next != &neighTab[iterIndex]) {
-      iterNeighTab = neighTab[iterIndex].next;
+  for (iterIndex = 0; iterIndex < (int)neighbortable_size; iterIndex++)
+    if (neighbortable[iterIndex].next != &neighbortable[iterIndex]) {
+      iterNeighTab = neighbortable[iterIndex].next;
       break;
     }
 }
@@ -451,9 +448,6 @@ olsrd_plugin_init(void)
   mainAddr = &olsr_cnf->main_addr;
 
   intTab = ifnet;
-  neighTab = neighbortable;
-  midTab = mid_set;
-  hnaTab = hna_set;
   config = olsr_cnf;
 
   httpInit();
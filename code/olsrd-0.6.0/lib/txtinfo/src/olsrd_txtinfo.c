@@ -494,7 +494,7 @@ ipc_print_hna(struct autobuf *abuf)
 static void
 ipc_print_mid(struct autobuf *abuf)
 {
-  int idx;
+  uint32_t idx;
   unsigned short is_first;
   struct mid_entry *entry;
   struct mid_address *alias;
@@ -505,7 +505,7 @@ ipc_print_mid(struct autobuf *abuf)
 #endif /*vtime txtinfo*/
 
   /* MID */
-  for (idx = 0; idx < HASHSIZE; idx++) {
+  for (idx = 0; idx < mid_set_size; idx++) {
     entry = mid_set[idx].next;
 
     while (entry != &mid_set[idx]) {
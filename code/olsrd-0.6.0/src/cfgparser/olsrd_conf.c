@@ -473,6 +473,12 @@ olsrd_sanity_check_cnf(struct olsrd_config *cnf)
     return -1;
   }
 
+  /* Hash size */
+  if (cnf->hash_size < MIN_HASH_SIZE || cnf->hash_size > MAX_HASH_SIZE || (cnf->hash_size & (cnf->hash_size - 1)) != 0) {
+    fprintf(stderr, "Hash size %u is not allowed, it must be a power of two\n", cnf->hash_size);
+    return -1;
+  }
+
   /* TC redundancy */
   if (cnf->tc_redundancy != 2) {
     fprintf(stderr, "Sorry, tc-redundancy 0/1 are not working on 0.5.6. "
@@ -730,6 +736,7 @@ set_default_cnf(struct olsrd_config *cnf)
 
   cnf->pollrate = DEF_POLLRATE;
   cnf->nic_chgs_pollrate = DEF_NICCHGPOLLRT;
+  cnf->hash_size = DEF_HASH_SIZE;
 
   cnf->tc_redundancy = TC_REDUNDANCY;
   cnf->mpr_coverage = MPR_COVERAGE;
@@ -128,6 +128,18 @@ jenkins_hash(const uint8_t * k, uint32_t length)
  */
 uint32_t
 olsr_ip_hashing(const union olsr_ip_addr * address)
+{
+  return olsr_ip_hashing_size(address, HASHSIZE);
+}
+
+/**
+ * Hashing function for the resizable tables.
+ * @param address the address to hash
+ * @param size the number of buckets, a power of two
+ * @return the hash(a value in the (0 to size-1) range)
+ */
+uint32_t
+olsr_ip_hashing_size(const union olsr_ip_addr * address, uint32_t size)
 {
   uint32_t hash;
 
@@ -143,7 +155,7 @@ olsr_ip_hashing(const union olsr_ip_addr * address)
     break;
 
   }
-  return hash & HASHMASK;
+  return hash & (size - 1);
 }
 
 /*
@@ -45,9 +45,20 @@
 #define	HASHSIZE	128
 #define	HASHMASK	(HASHSIZE - 1)
 
+/*
+ * The neighbor table, the MID set and the HNA set start out with
+ * olsr_cnf->hash_size buckets (-hashsize) and double whenever they hold
+ * more than HASH_LOAD entries per bucket.  They never shrink, so that
+ * deleting entries while walking a table cannot move the others.
+ */
+#define HASH_LOAD	2
+
+#define HASH_OVERLOADED(count, size) ((count) > (size) * HASH_LOAD)
+
 #include "olsr_types.h"
 
 uint32_t olsr_ip_hashing(const union olsr_ip_addr *);
+uint32_t olsr_ip_hashing_size(const union olsr_ip_addr *, uint32_t);
 
 #endif
 
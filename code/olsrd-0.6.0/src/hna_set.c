@@ -49,26 +49,55 @@
 #include "gateway.h"
 #include "duplicate_handler.h"
 
-struct hna_entry hna_set[HASHSIZE];
+struct hna_entry *hna_set = NULL;
+uint32_t hna_set_size = 0;
 struct olsr_cookie_info *hna_net_timer_cookie = NULL;
 struct olsr_cookie_info *hna_entry_mem_cookie = NULL;
 struct olsr_cookie_info *hna_net_mem_cookie = NULL;
 
+static uint32_t hna_set_count = 0;
+
 static bool olsr_delete_hna_net_entry(struct hna_net *net_to_delete);
 
 /**
- * Initialize the HNA set
+ * Move all HNA gateway entries to a table of the given size.
+ *
+ * @param size the new number of buckets, a power of two
  */
-int
-olsr_init_hna_set(void)
+static void
+olsr_resize_hna_set(uint32_t size)
 {
-  int idx;
+  struct hna_entry *old_set = hna_set;
+  uint32_t old_size = hna_set_size;
+  uint32_t idx;
 
-  for (idx = 0; idx < HASHSIZE; idx++) {
+  hna_set = olsr_malloc(size * sizeof(struct hna_entry), "HNA set");
+  hna_set_size = size;
+
+  for (idx = 0; idx < size; idx++) {
     hna_set[idx].next = &hna_set[idx];
     hna_set[idx].prev = &hna_set[idx];
   }
 
+  for (idx = 0; idx < old_size; idx++) {
+    while (old_set[idx].next != &old_set[idx]) {
+      struct hna_entry *entry = old_set[idx].next;
+
+      DEQUEUE_ELEM(entry);
+      QUEUE_ELEM(hna_set[olsr_ip_hashing_size(&entry->A_gateway_addr, size)], entry);
+    }
+  }
+  free(old_set);
+}
+
+/**
+ * Initialize the HNA set
+ */
+int
+olsr_init_hna_set(void)
+{
+  olsr_resize_hna_set(olsr_cnf->hash_size);
+
   hna_net_timer_cookie = olsr_alloc_cookie("HNA Network", OLSR_COOKIE_TYPE_TIMER);
 
   hna_net_mem_cookie = olsr_alloc_cookie("hna_net", OLSR_COOKIE_TYPE_MEMORY);
@@ -126,7 +155,7 @@ struct hna_entry *
 olsr_lookup_hna_gw(const union olsr_ip_addr *gw)
 {
   struct hna_entry *tmp_hna;
-  uint32_t hash = olsr_ip_hashing(gw);
+  uint32_t hash = olsr_ip_hashing_size(gw, hna_set_size);
 
 #if 0
   OLSR_PRINTF(5, "HNA: lookup entry\n");
@@ -165,8 +194,12 @@ olsr_add_hna_entry(const union olsr_ip_addr *addr)
   new_entry->networks.next = &new_entry->networks;
   new_entry->networks.prev = &new_entry->networks;
 
+  if (HASH_OVERLOADED(++hna_set_count, hna_set_size)) {
+    olsr_resize_hna_set(hna_set_size * 2);
+  }
+
   /* queue */
-  hash = olsr_ip_hashing(addr);
+  hash = olsr_ip_hashing_size(addr, hna_set_size);
 
   hna_set[hash].next->prev = new_entry;
   new_entry->next = hna_set[hash].next;
@@ -245,6 +278,7 @@ olsr_delete_hna_net_entry(struct hna_net *net_to_delete) {
   if (hna_gw->networks.next == &hna_gw->networks) {
     DEQUEUE_ELEM(hna_gw);
     olsr_cookie_free(hna_entry_mem_cookie, hna_gw);
+    hna_set_count--;
     removed_entry = true;
   }
 
@@ -318,7 +352,7 @@ olsr_print_hna_set(void)
 {
 #ifdef NODEBUG
   /* The whole function doesn't do anything else. */
-  int idx;
+  uint32_t idx;
 
   OLSR_PRINTF(1, "\n--- %02d:%02d:%02d.%02d ------------------------------------------------- HNA SET\n\n", nowtm->tm_hour,
               nowtm->tm_min, nowtm->tm_sec, (int)now.tv_usec / 10000);
@@ -328,7 +362,7 @@ olsr_print_hna_set(void)
   else
     OLSR_PRINTF(1, "IP net/prefixlen               GW IP\n");
 
-  for (idx = 0; idx < HASHSIZE; idx++) {
+  for (idx = 0; idx < hna_set_size; idx++) {
     struct hna_entry *tmp_hna = hna_set[idx].next;
     /* Check all entrys */
     while (tmp_hna != &hna_set[idx]) {
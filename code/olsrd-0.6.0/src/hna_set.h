@@ -71,7 +71,7 @@ struct hna_entry {
 #define OLSR_FOR_ALL_HNA_ENTRIES(hna) \
 { \
   int _idx; \
-  for (_idx = 0; _idx < HASHSIZE; _idx++) { \
+  for (_idx = 0; _idx < (int)hna_set_size; _idx++) { \
     struct hna_entry *_next; \
     for(hna = hna_set[_idx].next; \
         hna != &hna_set[_idx]; \
@@ -79,7 +79,11 @@ struct hna_entry {
       _next = hna->next;
 #define OLSR_FOR_ALL_HNA_ENTRIES_END(hna) }}}
 
-extern struct hna_entry hna_set[HASHSIZE];
+/*
+ * The HNA set, hna_set_size buckets
+ */
+extern struct hna_entry *hna_set;
+extern uint32_t hna_set_size;
 
 int olsr_init_hna_set(void);
 void olsr_cleanup_hna(union olsr_ip_addr *orig);
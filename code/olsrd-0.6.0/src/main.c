@@ -802,6 +802,7 @@ static void print_usage(bool error) {
         "  [-hint <hello interval (secs)>] [-tcint <tc interval (secs)>]\n"
         "  [-midint <mid interval (secs)>] [-hnaint <hna interval (secs)>]\n"
         "  [-T <Polling Rate (secs)>] [-nofork] [-hemu <ip_address>]\n"
+        "  [-hashsize <initial hash buckets>]\n"
         "  [-lql <LQ level>] [-lqa <LQ aging factor>]\n",
         error ? "An error occured somwhere between your keyboard and your chair!\n" : "");
 }
@@ -1033,6 +1034,16 @@ static int olsr_process_arguments(int argc, char *argv[],
       continue;
     }
 
+    /*
+     * Set the initial size of the neighbor, MID and HNA tables.
+     */
+    if (strcmp(*argv, "-hashsize") == 0) {
+      NEXT_ARG;
+      CHECK_ARGC;
+      sscanf(*argv, "%u", &cnf->hash_size);
+      continue;
+    }
+
     /*
      * Should we display the contents of packages beeing sent?
      */
@@ -54,23 +54,33 @@
 #include "net_olsr.h"
 #include "duplicate_handler.h"
 
-struct mid_entry mid_set[HASHSIZE];
-struct mid_address reverse_mid_set[HASHSIZE];
+struct mid_entry *mid_set = NULL;
+struct mid_address *reverse_mid_set = NULL;
+uint32_t mid_set_size = 0;
+
+static uint32_t mid_set_count = 0;
 
 struct mid_entry *mid_lookup_entry_bymain(const union olsr_ip_addr *adr);
 
 /**
- * Initialize the MID set
+ * Move all MID entries and aliases to tables of the given size.
+ * Both tables are sized by the number of MID entries.
  *
+ * @param size the new number of buckets, a power of two
  */
-int
-olsr_init_mid_set(void)
+static void
+olsr_resize_mid_set(uint32_t size)
 {
-  int idx;
+  struct mid_entry *old_set = mid_set;
+  struct mid_address *old_reverse_set = reverse_mid_set;
+  uint32_t old_size = mid_set_size;
+  uint32_t idx;
 
-  OLSR_PRINTF(5, "MID: init\n");
+  mid_set = olsr_malloc(size * sizeof(struct mid_entry), "MID set");
+  reverse_mid_set = olsr_malloc(size * sizeof(struct mid_address), "MID reverse set");
+  mid_set_size = size;
 
-  for (idx = 0; idx < HASHSIZE; idx++) {
+  for (idx = 0; idx < size; idx++) {
     mid_set[idx].next = &mid_set[idx];
     mid_set[idx].prev = &mid_set[idx];
 
@@ -78,13 +88,42 @@ olsr_init_mid_set(void)
     reverse_mid_set[idx].prev = &reverse_mid_set[idx];
   }
 
+  for (idx = 0; idx < old_size; idx++) {
+    while (old_set[idx].next != &old_set[idx]) {
+      struct mid_entry *entry = old_set[idx].next;
+
+      DEQUEUE_ELEM(entry);
+      QUEUE_ELEM(mid_set[olsr_ip_hashing_size(&entry->main_addr, size)], entry);
+    }
+    while (old_reverse_set[idx].next != &old_reverse_set[idx]) {
+      struct mid_address *alias = old_reverse_set[idx].next;
+
+      DEQUEUE_ELEM(alias);
+      QUEUE_ELEM(reverse_mid_set[olsr_ip_hashing_size(&alias->alias, size)], alias);
+    }
+  }
+  free(old_set);
+  free(old_reverse_set);
+}
+
+/**
+ * Initialize the MID set
+ *
+ */
+int
+olsr_init_mid_set(void)
+{
+  OLSR_PRINTF(5, "MID: init\n");
+
+  olsr_resize_mid_set(olsr_cnf->hash_size);
+
   return 1;
 }
 
 void olsr_delete_all_mid_entries(void) {
-  int hash;
+  uint32_t hash;
 
-  for (hash = 0; hash < HASHSIZE; hash++) {
+  for (hash = 0; hash < mid_set_size; hash++) {
     while (mid_set[hash].next != &mid_set[hash]) {
       olsr_delete_mid_entry(mid_set[hash].next);
     }
@@ -155,8 +194,8 @@ insert_mid_tuple(union olsr_ip_addr *m_addr, struct mid_address *alias, olsr_rel
   uint32_t hash, alias_hash;
   union olsr_ip_addr *registered_m_addr;
 
-  hash = olsr_ip_hashing(m_addr);
-  alias_hash = olsr_ip_hashing(&alias->alias);
+  hash = olsr_ip_hashing_size(m_addr, mid_set_size);
+  alias_hash = olsr_ip_hashing_size(&alias->alias, mid_set_size);
 
   /* Check for registered entry */
   for (tmp = mid_set[hash].next; tmp != &mid_set[hash]; tmp = tmp->next) {
@@ -186,6 +225,12 @@ insert_mid_tuple(union olsr_ip_addr *m_addr, struct mid_address *alias, olsr_rel
     olsr_set_mid_timer(tmp, vtime);
   } else {
 
+    if (HASH_OVERLOADED(++mid_set_count, mid_set_size)) {
+      olsr_resize_mid_set(mid_set_size * 2);
+      hash = olsr_ip_hashing_size(m_addr, mid_set_size);
+      alias_hash = olsr_ip_hashing_size(&alias->alias, mid_set_size);
+    }
+
     /*Create new node */
     tmp = olsr_malloc(sizeof(struct mid_entry), "MID new alias");
 
@@ -233,10 +278,8 @@ insert_mid_tuple(union olsr_ip_addr *m_addr, struct mid_address *alias, olsr_rel
 
       replace_neighbor_link_set(tmp_neigh, real_neigh);
 
-      /* Dequeue */
-      DEQUEUE_ELEM(tmp_neigh);
-      /* Delete */
-      free(tmp_neigh);
+      /* Dequeue and delete */
+      olsr_free_neighbor_entry(tmp_neigh);
 
       changes_neighborhood = true;
     }
@@ -328,7 +371,7 @@ mid_lookup_main_addr(const union olsr_ip_addr *adr)
   uint32_t hash;
   struct mid_address *tmp_list;
 
-  hash = olsr_ip_hashing(adr);
+  hash = olsr_ip_hashing_size(adr, mid_set_size);
 
   /*Traverse MID list */
   for (tmp_list = reverse_mid_set[hash].next; tmp_list != &reverse_mid_set[hash]; tmp_list = tmp_list->next) {
@@ -351,7 +394,7 @@ mid_lookup_entry_bymain(const union olsr_ip_addr *adr)
   struct mid_entry *tmp_list;
   uint32_t hash;
 
-  hash = olsr_ip_hashing(adr);
+  hash = olsr_ip_hashing_size(adr, mid_set_size);
 
   /* Check all registered nodes... */
   for (tmp_list = mid_set[hash].next; tmp_list != &mid_set[hash]; tmp_list = tmp_list->next) {
@@ -388,7 +431,7 @@ olsr_update_mid_table(const union olsr_ip_addr *adr, olsr_reltime vtime)
   struct mid_entry *tmp_list = mid_set;
 
   OLSR_PRINTF(3, "MID: update %s\n", olsr_ip_to_string(&buf, adr));
-  hash = olsr_ip_hashing(adr);
+  hash = olsr_ip_hashing_size(adr, mid_set_size);
 
   /* Check all registered nodes... */
   for (tmp_list = mid_set[hash].next; tmp_list != &mid_set[hash]; tmp_list = tmp_list->next) {
@@ -420,7 +463,7 @@ olsr_prune_aliases(struct mid_message *message)
   struct mid_address *previous_alias;
   struct mid_alias *save_declared_aliases = declared_aliases;
 
-  hash = olsr_ip_hashing(m_addr);
+  hash = olsr_ip_hashing_size(m_addr, mid_set_size);
 
   /* Check for registered entry */
   for (entry = mid_set[hash].next; entry != &mid_set[hash]; entry = entry->next) {
@@ -522,6 +565,7 @@ olsr_delete_mid_entry(struct mid_entry *mid)
   /* Dequeue */
   DEQUEUE_ELEM(mid);
   free(mid);
+  mid_set_count--;
 }
 
 /**
@@ -531,11 +575,11 @@ olsr_delete_mid_entry(struct mid_entry *mid)
 void
 olsr_print_mid_set(void)
 {
-  int idx;
+  uint32_t idx;
 
   OLSR_PRINTF(1, "\n--- %s ------------------------------------------------- MID\n\n", olsr_wallclock_string());
 
-  for (idx = 0; idx < HASHSIZE; idx++) {
+  for (idx = 0; idx < mid_set_size; idx++) {
     struct mid_entry *tmp_list = mid_set[idx].next;
     /*Traverse MID list */
     for (tmp_list = mid_set[idx].next; tmp_list != &mid_set[idx]; tmp_list = tmp_list->next) {
@@ -71,8 +71,12 @@ struct mid_entry {
 
 #define OLSR_MID_JITTER 5       /* percent */
 
-extern struct mid_entry mid_set[HASHSIZE];
-extern struct mid_address reverse_mid_set[HASHSIZE];
+/*
+ * The MID set and the reverse (alias) set, mid_set_size buckets each
+ */
+extern struct mid_entry *mid_set;
+extern struct mid_address *reverse_mid_set;
+extern uint32_t mid_set_size;
 
 int olsr_init_mid_set(void);
 void olsr_delete_all_mid_entries(void);
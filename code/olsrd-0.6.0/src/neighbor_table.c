@@ -51,17 +51,59 @@
 #include "mpr_selector_set.h"
 #include "net_olsr.h"
 
-struct neighbor_entry neighbortable[HASHSIZE];
+struct neighbor_entry *neighbortable = NULL;
+uint32_t neighbortable_size = 0;
+
+static uint32_t neighbortable_count = 0;
+
+/**
+ * Move all neighbor entries to a table of the given size.
+ *
+ * @param size the new number of buckets, a power of two
+ */
+static void
+olsr_resize_neighbor_table(uint32_t size)
+{
+  struct neighbor_entry *old_table = neighbortable;
+  uint32_t old_size = neighbortable_size;
+  uint32_t idx;
+
+  neighbortable = olsr_malloc(size * sizeof(struct neighbor_entry), "Neighbor table");
+  neighbortable_size = size;
+
+  for (idx = 0; idx < size; idx++) {
+    neighbortable[idx].next = &neighbortable[idx];
+    neighbortable[idx].prev = &neighbortable[idx];
+  }
+
+  for (idx = 0; idx < old_size; idx++) {
+    while (old_table[idx].next != &old_table[idx]) {
+      struct neighbor_entry *entry = old_table[idx].next;
+
+      DEQUEUE_ELEM(entry);
+      QUEUE_ELEM(neighbortable[olsr_ip_hashing_size(&entry->neighbor_main_addr, size)], entry);
+    }
+  }
+  free(old_table);
+}
 
 void
 olsr_init_neighbor_table(void)
 {
-  int i;
+  olsr_resize_neighbor_table(olsr_cnf->hash_size);
+}
 
-  for (i = 0; i < HASHSIZE; i++) {
-    neighbortable[i].next = &neighbortable[i];
-    neighbortable[i].prev = &neighbortable[i];
-  }
+/**
+ * Unlink a neighbor entry from the neighbor table and free it.
+ *
+ * @param entry the entry to free
+ */
+void
+olsr_free_neighbor_entry(struct neighbor_entry *entry)
+{
+  DEQUEUE_ELEM(entry);
+  free(entry);
+  neighbortable_count--;
 }
 
 /**
@@ -166,7 +208,7 @@ olsr_delete_neighbor_table(const union olsr_ip_addr *neighbor_addr)
 
   //printf("inserting neighbor\n");
 
-  hash = olsr_ip_hashing(neighbor_addr);
+  hash = olsr_ip_hashing_size(neighbor_addr, neighbortable_size);
 
   entry = neighbortable[hash].next;
 
@@ -195,10 +237,8 @@ olsr_delete_neighbor_table(const union olsr_ip_addr *neighbor_addr)
     olsr_del_nbr2_list(two_hop_to_delete);
   }
 
-  /* Dequeue */
-  DEQUEUE_ELEM(entry);
-
-  free(entry);
+  /* Dequeue and delete */
+  olsr_free_neighbor_entry(entry);
 
   changes_neighborhood = true;
   return 1;
@@ -218,7 +258,7 @@ olsr_insert_neighbor_table(const union olsr_ip_addr *main_addr)
   uint32_t hash;
   struct neighbor_entry *new_neigh;
 
-  hash = olsr_ip_hashing(main_addr);
+  hash = olsr_ip_hashing_size(main_addr, neighbortable_size);
 
   /* Check if entry exists */
 
@@ -243,6 +283,11 @@ olsr_insert_neighbor_table(const union olsr_ip_addr *main_addr)
   new_neigh->is_mpr = false;
   new_neigh->was_mpr = false;
 
+  if (HASH_OVERLOADED(++neighbortable_count, neighbortable_size)) {
+    olsr_resize_neighbor_table(neighbortable_size * 2);
+    hash = olsr_ip_hashing_size(main_addr, neighbortable_size);
+  }
+
   /* Queue */
   QUEUE_ELEM(neighbortable[hash], new_neigh);
 
@@ -281,7 +326,7 @@ struct neighbor_entry *
 olsr_lookup_neighbor_table_alias(const union olsr_ip_addr *dst)
 {
   struct neighbor_entry *entry;
-  uint32_t hash = olsr_ip_hashing(dst);
+  uint32_t hash = olsr_ip_hashing_size(dst, neighbortable_size);
 
   //printf("\nLookup %s\n", olsr_ip_to_string(&buf, dst));
   for (entry = neighbortable[hash].next; entry != &neighbortable[hash]; entry = entry->next) {
@@ -370,13 +415,13 @@ olsr_print_neighbor_table(void)
 #ifndef NODEBUG
   const int iplen = olsr_cnf->ip_version == AF_INET ? 15 : 39;
 #endif
-  int idx;
+  uint32_t idx;
   OLSR_PRINTF(1,
               "\n--- %02d:%02d:%02d.%02d ------------------------------------------------ NEIGHBORS\n\n"
               "%*s  LQ     NLQ    SYM   MPR   MPRS  will\n", nowtm->tm_hour, nowtm->tm_min, nowtm->tm_sec, (int)now.tv_usec / 10000,
               iplen, "IP address");
 
-  for (idx = 0; idx < HASHSIZE; idx++) {
+  for (idx = 0; idx < neighbortable_size; idx++) {
     struct neighbor_entry *neigh;
     for (neigh = neighbortable[idx].next; neigh != &neighbortable[idx]; neigh = neigh->next) {
       struct link_entry *lnk = get_best_link_to_neighbor(&neigh->neighbor_main_addr);
@@ -72,19 +72,22 @@ struct neighbor_entry {
 #define OLSR_FOR_ALL_NBR_ENTRIES(nbr) \
 { \
   int _idx; \
-  for (_idx = 0; _idx < HASHSIZE; _idx++) { \
+  for (_idx = 0; _idx < (int)neighbortable_size; _idx++) { \
     for(nbr = neighbortable[_idx].next; \
         nbr != &neighbortable[_idx]; \
         nbr = nbr->next)
 #define OLSR_FOR_ALL_NBR_ENTRIES_END(nbr) }}
 
 /*
- * The neighbor table
+ * The neighbor table, neighbortable_size buckets
  */
-extern struct neighbor_entry neighbortable[HASHSIZE];
+extern struct neighbor_entry *neighbortable;
+extern uint32_t neighbortable_size;
 
 void olsr_init_neighbor_table(void);
 
+void olsr_free_neighbor_entry(struct neighbor_entry *);
+
 int olsr_delete_neighbor_2_pointer(struct neighbor_entry *, struct neighbor_2_entry *);
 
 struct neighbor_2_list_entry *olsr_lookup_my_neighbors(const struct neighbor_entry *, const union olsr_ip_addr *);
@@ -84,6 +84,7 @@
 #define DEF_UPLINK_SPEED     128
 #define DEF_DOWNLINK_SPEED   1024
 #define DEF_USE_SRCIP_ROUTES false
+#define DEF_HASH_SIZE        128
 
 #define DEF_IF_MODE          IF_MODE_MESH
 
@@ -112,6 +113,9 @@
 #define MAX_LQ_AGING         1.0
 #define MIN_LQ_AGING         0.01
 
+#define MAX_HASH_SIZE        65536
+#define MIN_HASH_SIZE        16
+
 #define MIN_SMARTGW_SPEED    1
 #define MAX_SMARTGW_SPEED    320000000
 
@@ -241,6 +245,7 @@ struct olsrd_config {
   struct olsr_if *interfaces;
   float pollrate;
   float nic_chgs_pollrate;
+  uint32_t hash_size;                  /* Initial buckets of the resizable tables */
   bool clear_screen;
   uint8_t tc_redundancy;
   uint8_t mpr_coverage;
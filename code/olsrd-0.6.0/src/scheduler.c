@@ -52,6 +52,11 @@
 #include <unistd.h>
 #include <assert.h>
 
+#ifdef linux
+#include <sys/epoll.h>
+#include <fcntl.h>
+#endif
+
 #ifdef WIN32
 #define close(x) closesocket(x)
 #endif
@@ -71,6 +76,20 @@ static struct olsr_cookie_info *timer_mem_cookie = NULL;
 /* Head of all OLSR used sockets */
 static struct list_node socket_head = { &socket_head, &socket_head };
 
+#ifdef linux
+/*
+ * The sockets with pollrate handlers and the ones with immediate
+ * handlers are waited for separately, so each kind has its own epoll(7)
+ * set.  The sets are kept in line with the socket entries as these are
+ * added, enabled, disabled and removed, and hand back the entry of each
+ * ready socket.
+ */
+#define EPOLL_MAX_EVENTS 64
+
+static int epoll_pr = -1;
+static int epoll_imm = -1;
+#endif
+
 /* Prototypes */
 static void walk_timers(uint32_t *);
 static void poll_sockets(void);
@@ -162,6 +181,102 @@ olsr_isTimedOut(uint32_t s)
   return now_times - s <= (1u << 31);
 }
 
+#ifdef linux
+static void
+olsr_open_epoll(void)
+{
+  if (epoll_pr >= 0) {
+    return;
+  }
+  epoll_pr = epoll_create(EPOLL_MAX_EVENTS);
+  epoll_imm = epoll_create(EPOLL_MAX_EVENTS);
+  if (epoll_pr < 0 || epoll_imm < 0) {
+    olsr_syslog(OLSR_LOG_ERR, "epoll_create: %s\n", strerror(errno));
+    olsr_exit(__func__, EXIT_FAILURE);
+  }
+  fcntl(epoll_pr, F_SETFD, FD_CLOEXEC);
+  fcntl(epoll_imm, F_SETFD, FD_CLOEXEC);
+}
+
+/**
+ * Map socket flags to epoll events, for one kind of handler.
+ */
+static uint32_t
+olsr_epoll_events(unsigned int flags, unsigned int read_flag, unsigned int write_flag)
+{
+  return ((flags & read_flag) != 0 ? EPOLLIN : 0) | ((flags & write_flag) != 0 ? EPOLLOUT : 0);
+}
+
+/**
+ * Map ready events back to socket flags. Like select(2), errors and
+ * hangups make a socket both readable and writable.
+ */
+static unsigned int
+olsr_epoll_flags(uint32_t events, unsigned int read_flag, unsigned int write_flag)
+{
+  return ((events & (EPOLLIN | EPOLLERR | EPOLLHUP)) != 0 ? read_flag : 0) |
+    ((events & (EPOLLOUT | EPOLLERR | EPOLLHUP)) != 0 ? write_flag : 0);
+}
+
+static void
+olsr_epoll_ctl(int epfd, struct olsr_socket_entry *entry, uint32_t old_events, uint32_t new_events)
+{
+  struct epoll_event event;
+  int op;
+
+  if (old_events == new_events) {
+    return;
+  }
+  if (old_events == 0) {
+    op = EPOLL_CTL_ADD;
+  } else if (new_events == 0) {
+    op = EPOLL_CTL_DEL;
+  } else {
+    op = EPOLL_CTL_MOD;
+  }
+
+  memset(&event, 0, sizeof(event));
+  event.events = new_events;
+  event.data.ptr = entry;
+  if (epoll_ctl(epfd, op, entry->fd, &event) < 0) {
+    /* Closing the fd already dropped it from the set; plugins such as
+     * BMF close their sockets before removing them. */
+    if (op == EPOLL_CTL_DEL && (errno == EBADF || errno == ENOENT)) {
+      return;
+    }
+    OLSR_PRINTF(1, "epoll_ctl error on socket %d: %s\n", entry->fd, strerror(errno));
+    olsr_syslog(OLSR_LOG_ERR, "epoll_ctl error on socket %d: %s\n", entry->fd, strerror(errno));
+  }
+}
+
+/**
+ * Bring both epoll sets in line with the flags and handlers
+ * of a socket entry.
+ */
+static void
+olsr_update_socket(struct olsr_socket_entry *entry)
+{
+  unsigned int flags = 0;
+
+  olsr_open_epoll();
+
+  if (entry->process_pollrate != NULL) {
+    flags |= entry->flags & (SP_PR_READ | SP_PR_WRITE);
+  }
+  if (entry->process_immediate != NULL) {
+    flags |= entry->flags & (SP_IMM_READ | SP_IMM_WRITE);
+  }
+
+  olsr_epoll_ctl(epoll_pr, entry, olsr_epoll_events(entry->epoll_flags, SP_PR_READ, SP_PR_WRITE),
+                 olsr_epoll_events(flags, SP_PR_READ, SP_PR_WRITE));
+  olsr_epoll_ctl(epoll_imm, entry, olsr_epoll_events(entry->epoll_flags, SP_IMM_READ, SP_IMM_WRITE),
+                 olsr_epoll_events(flags, SP_IMM_READ, SP_IMM_WRITE));
+  entry->epoll_flags = flags;
+}
+#else
+#define olsr_update_socket(entry) do { } while (0)
+#endif
+
 /**
  * Add a socket and handler to the socketset
  * beeing used in the main select(2) loop
@@ -192,6 +307,8 @@ add_olsr_socket(int fd, socket_handler_func pf_pr, socket_handler_func pf_imm, v
   /* Queue */
   list_node_init(&new_entry->socket_node);
   list_add_before(&socket_head, &new_entry->socket_node);
+
+  olsr_update_socket(new_entry);
 }
 
 /**
@@ -219,6 +336,7 @@ remove_olsr_socket(int fd, socket_handler_func pf_pr, socket_handler_func pf_imm
       entry->process_immediate = NULL;
       entry->process_pollrate = NULL;
       entry->flags = 0;
+      olsr_update_socket(entry);
       return 1;
     }
   }
@@ -234,6 +352,7 @@ enable_olsr_socket(int fd, socket_handler_func pf_pr, socket_handler_func pf_imm
   OLSR_FOR_ALL_SOCKETS(entry) {
     if (entry->fd == fd && entry->process_immediate == pf_imm && entry->process_pollrate == pf_pr) {
       entry->flags |= flags;
+      olsr_update_socket(entry);
     }
   }
   OLSR_FOR_ALL_SOCKETS_END(entry);
@@ -247,6 +366,7 @@ disable_olsr_socket(int fd, socket_handler_func pf_pr, socket_handler_func pf_im
   OLSR_FOR_ALL_SOCKETS(entry) {
     if (entry->fd == fd && entry->process_immediate == pf_imm && entry->process_pollrate == pf_pr) {
       entry->flags &= ~flags;
+      olsr_update_socket(entry);
     }
   }
   OLSR_FOR_ALL_SOCKETS_END(entry);
@@ -265,8 +385,137 @@ olsr_flush_sockets(void)
     list_remove(&entry->socket_node);
     free(entry);
   } OLSR_FOR_ALL_SOCKETS_END(entry);
+
+#ifdef linux
+  if (epoll_pr >= 0) {
+    CLOSE(epoll_pr);
+    CLOSE(epoll_imm);
+  }
+#endif
 }
 
+/**
+ * Free the socket entries removed while handling sockets.
+ */
+static void
+olsr_cleanup_sockets(void)
+{
+  struct olsr_socket_entry *entry;
+
+  OLSR_FOR_ALL_SOCKETS(entry) {
+    if (entry->process_immediate == NULL && entry->process_pollrate == NULL) {
+      /* clean up socket handler */
+      list_remove(&entry->socket_node);
+      free(entry);
+    }
+  } OLSR_FOR_ALL_SOCKETS_END(entry);
+}
+
+#ifdef linux
+static void
+poll_sockets(void)
+{
+  struct epoll_event events[EPOLL_MAX_EVENTS];
+  int n, i;
+
+  /* If there are no registered sockets we
+   * do not call epoll_wait(2)
+   */
+  if (list_is_empty(&socket_head)) {
+    return;
+  }
+
+  do {
+    n = epoll_wait(epoll_pr, events, EPOLL_MAX_EVENTS, 0);
+  } while (n == -1 && errno == EINTR);
+
+  if (n == 0) {
+    return;
+  }
+  if (n == -1) {                /* Did something go wrong? */
+    OLSR_PRINTF(1, "epoll_wait error: %s", strerror(errno));
+    return;
+  }
+
+  /* Update time since this is much used by the parsing functions */
+  now_times = olsr_times();
+  for (i = 0; i < n; i++) {
+    struct olsr_socket_entry *entry = events[i].data.ptr;
+    unsigned int flags;
+
+    /* removed or disabled by an earlier handler? */
+    if (entry->process_pollrate == NULL) {
+      continue;
+    }
+    flags = olsr_epoll_flags(events[i].events, SP_PR_READ, SP_PR_WRITE) & entry->flags;
+    if (flags != 0) {
+      entry->process_pollrate(entry->fd, entry->data, flags);
+    }
+  }
+}
+
+static void
+handle_fds(uint32_t next_interval)
+{
+  struct epoll_event events[EPOLL_MAX_EVENTS];
+  int32_t remaining;
+
+  /* calculate the first timeout */
+  now_times = olsr_times();
+
+  remaining = TIME_DUE(next_interval);
+  if (remaining <= 0 && list_is_empty(&socket_head)) {
+    /* If there are no registered sockets we do not call epoll_wait(2) */
+    return;
+  }
+
+  /* the immediate set also does the sleeping until the next interval */
+  olsr_open_epoll();
+
+  /* do at least one epoll_wait */
+  for (;;) {
+    int n, i;
+
+    do {
+      n = epoll_wait(epoll_imm, events, EPOLL_MAX_EVENTS, remaining > 0 ? remaining : 0);
+    } while (n == -1 && errno == EINTR);
+
+    if (n == 0) {               /* timeout! */
+      break;
+    }
+    if (n == -1) {              /* Did something go wrong? */
+      OLSR_PRINTF(1, "epoll_wait error: %s", strerror(errno));
+      break;
+    }
+
+    /* Update time since this is much used by the parsing functions */
+    now_times = olsr_times();
+    for (i = 0; i < n; i++) {
+      struct olsr_socket_entry *entry = events[i].data.ptr;
+      unsigned int flags;
+
+      /* removed or disabled by an earlier handler? */
+      if (entry->process_immediate == NULL) {
+        continue;
+      }
+      flags = olsr_epoll_flags(events[i].events, SP_IMM_READ, SP_IMM_WRITE) & entry->flags;
+      if (flags != 0) {
+        entry->process_immediate(entry->fd, entry->data, flags);
+      }
+    }
+
+    /* calculate the next timeout */
+    remaining = TIME_DUE(next_interval);
+    if (remaining <= 0) {
+      /* we are already over the interval */
+      break;
+    }
+  }
+
+  olsr_cleanup_sockets();
+}
+#else
+
 static void
 poll_sockets(void)
 {
@@ -438,14 +687,9 @@ handle_fds(uint32_t next_interval)
     tvp.tv_usec = (remaining % MSEC_PER_SEC) * USEC_PER_MSEC;
   }
 
-  OLSR_FOR_ALL_SOCKETS(entry) {
-    if (entry->process_immediate == NULL && entry->process_pollrate == NULL) {
-      /* clean up socket handler */
-      list_remove(&entry->socket_node);
-      free(entry);
-    }
-  } OLSR_FOR_ALL_SOCKETS_END(entry);
+  olsr_cleanup_sockets();
 }
+#endif
 
 /**
  * Main scheduler event loop. Polls at every
@@ -137,6 +137,9 @@ struct olsr_socket_entry {
   socket_handler_func process_pollrate;
   void *data;
   unsigned int flags;
+#ifdef linux
+  unsigned int epoll_flags;            /* flags registered with epoll(7) */
+#endif
   struct list_node socket_node;
 };
 
@@ -39,6 +39,8 @@ THE SOFTWARE.
 
 #include <zebra.h>
 #include "if.h"
+#include "prefix.h"
+#include "table.h"
 
 #include "babeld.h"
 #include "util.h"
@@ -53,66 +55,54 @@ THE SOFTWARE.
 
 static void consider_route(struct babel_route *route);
 
-struct babel_route **routes = NULL;
-static int route_slots = 0, max_route_slots = 0;
+static struct route_table *routes = NULL;
+static int route_slots = 0;
 int kernel_metric = 0;
 int allow_duplicates = -1;
 int diversity_kind = DIVERSITY_NONE;
 int diversity_factor = 256;     /* in units of 1/256 */
 int keep_unfeasible = 0;
 
-/* We maintain a list of "slots", ordered by prefix.  Every slot
+/* We maintain a table of "slots", indexed by prefix.  Every slot
    contains a linked list of the routes to this prefix, with the
-   installed route, if any, at the head of the list. */
+   installed route, if any, at the head of the list.  A slot holds a
+   lock on its route node for as long as its list is not empty, so the
+   walks below may flush routes as they go. */
 
-static int
-route_compare(const unsigned char *prefix, unsigned char plen,
-               struct babel_route *route)
+static void
+route_slot_prefix(struct prefix *p, const unsigned char *prefix,
+                  unsigned char plen)
 {
-    int i = memcmp(prefix, route->src->prefix, 16);
-    if(i != 0)
-        return i;
-
-    if(plen < route->src->plen)
-        return -1;
-    else if(plen > route->src->plen)
-        return 1;
-    else
-        return 0;
+    memset(p, 0, sizeof(struct prefix));
+    p->family = AF_INET6;
+    p->prefixlen = plen;
+    memcpy(&p->u.prefix6, prefix, 16);
+    apply_mask(p);
 }
 
-/* Performs binary search, returns -1 in case of failure.  In the latter
-   case, new_return is the place where to insert the new element. */
-
-static int
-find_route_slot(const unsigned char *prefix, unsigned char plen,
-                int *new_return)
+static struct route_node *
+route_slots_top(void)
 {
-    int p, m, g, c;
-
-    if(route_slots < 1) {
-        if(new_return)
-            *new_return = 0;
-        return -1;
-    }
-
-    p = 0; g = route_slots - 1;
+    if(routes == NULL)
+        routes = route_table_init();
+    return route_top(routes);
+}
 
-    do {
-        m = (p + g) / 2;
-        c = route_compare(prefix, plen, routes[m]);
-        if(c == 0)
-            return m;
-        else if(c < 0)
-            g = m - 1;
-        else
-            p = m + 1;
-    } while(p <= g);
+static struct route_node *
+find_route_slot(const unsigned char *prefix, unsigned char plen)
+{
+    struct prefix p;
+    struct route_node *rn;
 
-    if(new_return)
-        *new_return = p;
+    if(routes == NULL)
+        return NULL;
 
-    return -1;
+    route_slot_prefix(&p, prefix, plen);
+    rn = route_node_lookup(routes, &p);
+    if(rn == NULL)
+        return NULL;
+    route_unlock_node(rn);
+    return rn->info ? rn : NULL;
 }
 
 struct babel_route *
@@ -120,12 +110,12 @@ find_route(const unsigned char *prefix, unsigned char plen,
            struct neighbour *neigh, const unsigned char *nexthop)
 {
     struct babel_route *route;
-    int i = find_route_slot(prefix, plen, NULL);
+    struct route_node *rn = find_route_slot(prefix, plen);
 
-    if(i < 0)
+    if(rn == NULL)
         return NULL;
 
-    route = routes[i];
+    route = rn->info;
 
     while(route) {
         if(route->neigh == neigh && memcmp(route->nexthop, nexthop, 16) == 0)
@@ -139,10 +129,10 @@ find_route(const unsigned char *prefix, unsigned char plen,
 struct babel_route *
 find_installed_route(const unsigned char *prefix, unsigned char plen)
 {
-    int i = find_route_slot(prefix, plen, NULL);
+    struct route_node *rn = find_route_slot(prefix, plen);
 
-    if(i >= 0 && routes[i]->installed)
-        return routes[i];
+    if(rn && ((struct babel_route *)rn->info)->installed)
+        return rn->info;
 
     return NULL;
 }
@@ -154,55 +144,34 @@ installed_routes_estimate(void)
     return route_slots;
 }
 
-static int
-resize_route_table(int new_slots)
-{
-    struct babel_route **new_routes;
-    assert(new_slots >= route_slots);
-
-    if(new_slots == 0) {
-        new_routes = NULL;
-        free(routes);
-    } else {
-        new_routes = realloc(routes, new_slots * sizeof(struct babel_route*));
-        if(new_routes == NULL)
-            return -1;
-    }
-
-    max_route_slots = new_slots;
-    routes = new_routes;
-    return 1;
-}
-
 /* Insert a route into the table.  If successful, retains the route.
    On failure, caller must free the route. */
 static struct babel_route *
 insert_route(struct babel_route *route)
 {
-    int i, n;
+    struct prefix p;
+    struct route_node *rn;
 
     assert(!route->installed);
 
-    i = find_route_slot(route->src->prefix, route->src->plen, &n);
+    if(routes == NULL)
+        routes = route_table_init();
 
-    if(i < 0) {
-        if(route_slots >= max_route_slots)
-            resize_route_table(max_route_slots < 1 ? 8 : 2 * max_route_slots);
-        if(route_slots >= max_route_slots)
-            return NULL;
-        route->next = NULL;
-        if(n < route_slots)
-            memmove(routes + n + 1, routes + n,
-                    (route_slots - n) * sizeof(struct babel_route*));
+    route_slot_prefix(&p, route->src->prefix, route->src->plen);
+    rn = route_node_get(routes, &p);
+
+    route->next = NULL;
+    if(rn->info == NULL) {
+        /* Keep the lock taken by route_node_get for the new slot. */
+        rn->info = route;
         route_slots++;
-        routes[n] = route;
     } else {
         struct babel_route *r;
-        r = routes[i];
+        r = rn->info;
         while(r->next)
             r = r->next;
         r->next = route;
-        route->next = NULL;
+        route_unlock_node(rn);
     }
 
     return route;
@@ -211,7 +180,7 @@ insert_route(struct babel_route *route)
 void
 flush_route(struct babel_route *route)
 {
-    int i;
+    struct route_node *rn;
     struct source *src;
     unsigned oldmetric;
     int lost = 0;
@@ -224,28 +193,20 @@ flush_route(struct babel_route *route)
         lost = 1;
     }
 
-    i = find_route_slot(route->src->prefix, route->src->plen, NULL);
-    assert(i >= 0 && i < route_slots);
+    rn = find_route_slot(route->src->prefix, route->src->plen);
+    assert(rn != NULL);
 
-    if(route == routes[i]) {
-        routes[i] = route->next;
+    if(route == rn->info) {
+        rn->info = route->next;
         route->next = NULL;
         free(route);
 
-        if(routes[i] == NULL) {
-            if(i < route_slots - 1)
-                memmove(routes + i, routes + i + 1,
-                        (route_slots - i - 1) * sizeof(struct babel_route*));
-            routes[route_slots - 1] = NULL;
+        if(rn->info == NULL) {
             route_slots--;
+            route_unlock_node(rn);
         }
-
-        if(route_slots == 0)
-            resize_route_table(0);
-        else if(max_route_slots > 8 && route_slots < max_route_slots / 4)
-            resize_route_table(max_route_slots / 2);
     } else {
-        struct babel_route *r = routes[i];
+        struct babel_route *r = rn->info;
         while(r->next != route)
             r = r->next;
         r->next = route->next;
@@ -262,18 +223,16 @@ flush_route(struct babel_route *route)
 void
 flush_all_routes()
 {
-    int i;
+    struct route_node *rn;
 
-    /* Start from the end, to avoid shifting the table. */
-    i = route_slots - 1;
-    while(i >= 0) {
-        while(i < route_slots) {
-        /* Uninstall first, to avoid calling route_lost. */
-            if(routes[i]->installed)
-                uninstall_route(routes[0]);
-            flush_route(routes[i]);
+    for(rn = route_slots_top(); rn; rn = route_next(rn)) {
+        while(rn->info) {
+            struct babel_route *r = rn->info;
+            /* Uninstall first, to avoid calling route_lost. */
+            if(r->installed)
+                uninstall_route(r);
+            flush_route(r);
         }
-        i--;
     }
 
     check_sources_released();
@@ -282,12 +241,12 @@ flush_all_routes()
 void
 flush_neighbour_routes(struct neighbour *neigh)
 {
-    int i;
+    struct route_node *rn;
 
-    i = 0;
-    while(i < route_slots) {
+    for(rn = route_slots_top(); rn; rn = route_next(rn)) {
         struct babel_route *r;
-        r = routes[i];
+    again:
+        r = rn->info;
         while(r) {
             if(r->neigh == neigh) {
                 flush_route(r);
@@ -295,21 +254,18 @@ flush_neighbour_routes(struct neighbour *neigh)
             }
             r = r->next;
         }
-        i++;
-    again:
-        ;
     }
 }
 
 void
 flush_interface_routes(struct interface *ifp, int v4only)
 {
-    int i;
+    struct route_node *rn;
 
-    i = 0;
-    while(i < route_slots) {
+    for(rn = route_slots_top(); rn; rn = route_next(rn)) {
         struct babel_route *r;
-        r = routes[i];
+    again:
+        r = rn->info;
         while(r) {
             if(r->neigh->ifp == ifp &&
                (!v4only || v4mapped(r->nexthop))) {
@@ -318,9 +274,6 @@ flush_interface_routes(struct interface *ifp, int v4only)
             }
             r = r->next;
         }
-        i++;
-    again:
-        ;
     }
 }
 
@@ -328,10 +281,10 @@ flush_interface_routes(struct interface *ifp, int v4only)
 void
 for_all_routes(void (*f)(struct babel_route*, void*), void *closure)
 {
-    int i;
+    struct route_node *rn;
 
-    for(i = 0; i < route_slots; i++) {
-        struct babel_route *r = routes[i];
+    for(rn = route_slots_top(); rn; rn = route_next(rn)) {
+        struct babel_route *r = rn->info;
         while(r) {
             (*f)(r, closure);
             r = r->next;
@@ -342,11 +295,12 @@ for_all_routes(void (*f)(struct babel_route*, void*), void *closure)
 void
 for_all_installed_routes(void (*f)(struct babel_route*, void*), void *closure)
 {
-    int i;
+    struct route_node *rn;
 
-    for(i = 0; i < route_slots; i++) {
-        if(routes[i]->installed)
-            (*f)(routes[i], closure);
+    for(rn = route_slots_top(); rn; rn = route_next(rn)) {
+        struct babel_route *r = rn->info;
+        if(r && r->installed)
+            (*f)(r, closure);
     }
 }
 
@@ -359,25 +313,26 @@ metric_to_kernel(int metric)
 /* This is used to maintain the invariant that the installed route is at
    the head of the list. */
 static void
-move_installed_route(struct babel_route *route, int i)
+move_installed_route(struct babel_route *route, struct route_node *rn)
 {
-    assert(i >= 0 && i < route_slots);
+    assert(rn != NULL);
     assert(route->installed);
 
-    if(route != routes[i]) {
-        struct babel_route *r = routes[i];
+    if(route != rn->info) {
+        struct babel_route *r = rn->info;
         while(r->next != route)
             r = r->next;
         r->next = route->next;
-        route->next = routes[i];
-        routes[i] = route;
+        route->next = rn->info;
+        rn->info = route;
     }
 }
 
 void
 install_route(struct babel_route *route)
 {
-    int i, rc;
+    struct route_node *rn;
+    int rc;
 
     if(route->installed)
         return;
@@ -386,10 +341,10 @@ install_route(struct babel_route *route)
         zlog_err("WARNING: installing unfeasible route "
                  "(this shouldn't happen).");
 
-    i = find_route_slot(route->src->prefix, route->src->plen, NULL);
-    assert(i >= 0 && i < route_slots);
+    rn = find_route_slot(route->src->prefix, route->src->plen);
+    assert(rn != NULL);
 
-    if(routes[i] != route && routes[i]->installed) {
+    if(rn->info != route && ((struct babel_route *)rn->info)->installed) {
         fprintf(stderr, "WARNING: attempting to install duplicate route "
                 "(this shouldn't happen).");
         return;
@@ -406,7 +361,7 @@ install_route(struct babel_route *route)
             return;
     }
     route->installed = 1;
-    move_installed_route(route, i);
+    move_installed_route(route, rn);
 
 }
 
@@ -461,8 +416,8 @@ switch_routes(struct babel_route *old, struct babel_route *new)
 
     old->installed = 0;
     new->installed = 1;
-    move_installed_route(new, find_route_slot(new->src->prefix, new->src->plen,
-                                              NULL));
+    move_installed_route(new, find_route_slot(new->src->prefix,
+                                              new->src->plen));
 }
 
 static void
@@ -587,12 +542,12 @@ find_best_route(const unsigned char *prefix, unsigned char plen, int feasible,
                 struct neighbour *exclude)
 {
     struct babel_route *route = NULL, *r = NULL;
-    int i = find_route_slot(prefix, plen, NULL);
+    struct route_node *rn = find_route_slot(prefix, plen);
 
-    if(i < 0)
+    if(rn == NULL)
         return NULL;
 
-    route = routes[i];
+    route = rn->info;
 
     r = route->next;
     while(r) {
@@ -638,10 +593,10 @@ update_neighbour_metric(struct neighbour *neigh, int changed)
 {
 
     if(changed) {
-        int i;
+        struct route_node *rn;
 
-        for(i = 0; i < route_slots; i++) {
-            struct babel_route *r = routes[i];
+        for(rn = route_slots_top(); rn; rn = route_next(rn)) {
+            struct babel_route *r = rn->info;
             while(r) {
                 if(r->neigh == neigh)
                     update_route_metric(r);
@@ -654,10 +609,10 @@ update_neighbour_metric(struct neighbour *neigh, int changed)
 void
 update_interface_metric(struct interface *ifp)
 {
-    int i;
+    struct route_node *rn;
 
-    for(i = 0; i < route_slots; i++) {
-        struct babel_route *r = routes[i];
+    for(rn = route_slots_top(); rn; rn = route_next(rn)) {
+        struct babel_route *r = rn->info;
         while(r) {
             if(r->neigh->ifp == ifp)
                 update_route_metric(r);
@@ -862,10 +817,10 @@ consider_route(struct babel_route *route)
 void
 retract_neighbour_routes(struct neighbour *neigh)
 {
-    int i;
+    struct route_node *rn;
 
-    for(i = 0; i < route_slots; i++) {
-        struct babel_route *r = routes[i];
+    for(rn = route_slots_top(); rn; rn = route_next(rn)) {
+        struct babel_route *r = rn->info;
         while(r) {
             if(r->neigh == neigh) {
                 if(r->refmetric != INFINITY) {
@@ -877,7 +832,6 @@ retract_neighbour_routes(struct neighbour *neigh)
             }
             r = r->next;
         }
-        i++;
     }
 }
 
@@ -987,14 +941,14 @@ route_lost(struct source *src, unsigned oldmetric)
 void
 expire_routes(void)
 {
+    struct route_node *rn;
     struct babel_route *r;
-    int i;
 
     debugf(BABEL_DEBUG_COMMON,"Expiring old routes.");
 
-    i = 0;
-    while(i < route_slots) {
-        r = routes[i];
+    for(rn = route_slots_top(); rn; rn = route_next(rn)) {
+    again:
+        r = rn->info;
         while(r) {
             /* Protect against clock being stepped. */
             if(r->time > babel_now.tv_sec || route_old(r)) {
@@ -1012,8 +966,5 @@ expire_routes(void)
             }
             r = r->next;
         }
-        i++;
-    again:
-        ;
     }
 }
@@ -36,11 +36,14 @@ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
 THE SOFTWARE.
 */
 
+#include <zebra.h>
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
 #include <sys/time.h>
 
+#include "hash.h"
+#include "jhash.h"
 #include "babel_main.h"
 #include "babeld.h"
 #include "util.h"
@@ -48,26 +51,41 @@ THE SOFTWARE.
 #include "babel_interface.h"
 #include "route.h"
 
-struct source *srcs = NULL;
+static struct hash *sources = NULL;
+
+static unsigned int
+source_hash_key(void *arg)
+{
+    struct source *src = arg;
+    return jhash(src->prefix, 16,
+                 jhash(src->id, 8, src->plen));
+}
+
+static int
+source_hash_cmp(const void *a, const void *b)
+{
+    const struct source *s1 = a, *s2 = b;
+    return s1->plen == s2->plen &&
+        memcmp(s1->id, s2->id, 8) == 0 &&
+        memcmp(s1->prefix, s2->prefix, 16) == 0;
+}
 
 struct source*
 find_source(const unsigned char *id, const unsigned char *p, unsigned char plen,
             int create, unsigned short seqno)
 {
-    struct source *src;
-
-    for(src = srcs; src; src = src->next) {
-        /* This should really be a hash table.  For now, check the
-           last byte first. */
-        if(src->id[7] != id[7])
-            continue;
-        if(memcmp(src->id, id, 8) != 0)
-            continue;
-        if(src->plen != plen)
-            continue;
-        if(memcmp(src->prefix, p, 16) == 0)
-            return src;
-    }
+    struct source key, *src;
+
+    if(sources == NULL)
+        sources = hash_create(source_hash_key, source_hash_cmp,
+                              "Babel sources");
+
+    memcpy(key.id, id, 8);
+    memcpy(key.prefix, p, 16);
+    key.plen = plen;
+    src = hash_lookup(sources, &key);
+    if(src)
+        return src;
 
     if(!create)
         return NULL;
@@ -85,8 +103,7 @@ find_source(const unsigned char *id, const unsigned char *p, unsigned char plen,
     src->metric = INFINITY;
     src->time = babel_now.tv_sec;
     src->route_count = 0;
-    src->next = srcs;
-    srcs = src;
+    hash_get(sources, src, hash_alloc_intern);
     return src;
 }
 
@@ -112,15 +129,7 @@ flush_source(struct source *src)
         /* The source is in use by a route. */
         return 0;
 
-    if(srcs == src) {
-        srcs = src->next;
-    } else {
-        struct source *previous = srcs;
-        while(previous->next != src)
-            previous = previous->next;
-        previous->next = src->next;
-    }
-
+    hash_release(sources, src);
     free(src);
     return 1;
 }
@@ -145,36 +154,40 @@ update_source(struct source *src,
     src->time = babel_now.tv_sec;
 }
 
+static void
+expire_source(struct hash_backet *backet, void *arg)
+{
+    struct source *src = backet->data;
+
+    if(src->time > babel_now.tv_sec)
+        /* clock stepped */
+        src->time = babel_now.tv_sec;
+    if(src->time < babel_now.tv_sec - SOURCE_GC_TIME)
+        flush_source(src);
+}
+
 void
 expire_sources()
 {
-    struct source *src;
-
-    src = srcs;
-    while(src) {
-        if(src->time > babel_now.tv_sec)
-            /* clock stepped */
-            src->time = babel_now.tv_sec;
-        if(src->time < babel_now.tv_sec - SOURCE_GC_TIME) {
-            struct source *old = src;
-            src = src->next;
-            flush_source(old);
-            continue;
-        }
-        src = src->next;
-    }
+    if(sources)
+        hash_iterate(sources, expire_source, NULL);
+}
+
+static void
+check_source_released(struct hash_backet *backet, void *arg)
+{
+    struct source *src = backet->data;
+
+    if(src->route_count != 0)
+        fprintf(stderr, "Warning: source %s %s has refcount %d.\n",
+                format_eui64(src->id),
+                format_prefix(src->prefix, src->plen),
+                (int)src->route_count);
 }
 
 void
 check_sources_released(void)
 {
-    struct source *src;
-
-    for(src = srcs; src; src = src->next) {
-        if(src->route_count != 0)
-            fprintf(stderr, "Warning: source %s %s has refcount %d.\n",
-                    format_eui64(src->id),
-                    format_prefix(src->prefix, src->plen),
-                    (int)src->route_count);
-    }
+    if(sources)
+        hash_iterate(sources, check_source_released, NULL);
 }
@@ -42,7 +42,6 @@ THE SOFTWARE.
 #define SOURCE_GC_TIME 200
 
 struct source {
-    struct source *next;
     unsigned char id[8];
     unsigned char prefix[16];
     unsigned char plen;
@@ -40,6 +40,8 @@ THE SOFTWARE.
 #include <zebra.h>
 #include "if.h"
 #include "log.h"
+#include "prefix.h"
+#include "table.h"
 
 #include "babeld.h"
 #include "kernel.h"
@@ -54,8 +56,10 @@ static int xroute_add_new_route(unsigned char prefix[16], unsigned char plen,
                                 unsigned short metric, unsigned int ifindex,
                                 int proto, int send_updates);
 
-static struct xroute *xroutes;
-static int numxroutes = 0, maxxroutes = 0;
+/* Indexed by prefix; every node of the table that is in use holds one
+   xroute, and the lock route_node_get took for it. */
+static struct route_table *xroutes = NULL;
+static int numxroutes = 0;
 
 /* Add redistributed route to Babel table. */
 int
@@ -119,50 +123,60 @@ babel_ipv6_route_delete (struct zapi_ipv6 *api, struct prefix_ipv6 *prefix,
     return 0;
 }
 
+static void
+xroute_prefix(struct prefix *p, const unsigned char *prefix,
+              unsigned char plen)
+{
+    memset(p, 0, sizeof(struct prefix));
+    p->family = AF_INET6;
+    p->prefixlen = plen;
+    memcpy(&p->u.prefix6, prefix, 16);
+    apply_mask(p);
+}
+
+static struct route_node *
+find_xroute_node(const unsigned char *prefix, unsigned char plen)
+{
+    struct prefix p;
+    struct route_node *rn;
+
+    if(xroutes == NULL)
+        return NULL;
+
+    xroute_prefix(&p, prefix, plen);
+    rn = route_node_lookup(xroutes, &p);
+    if(rn)
+        route_unlock_node(rn);
+    return rn;
+}
+
 struct xroute *
 find_xroute(const unsigned char *prefix, unsigned char plen)
 {
-    int i;
-    for(i = 0; i < numxroutes; i++) {
-        if(xroutes[i].plen == plen &&
-           memcmp(xroutes[i].prefix, prefix, 16) == 0)
-            return &xroutes[i];
-    }
-    return NULL;
+    struct route_node *rn = find_xroute_node(prefix, plen);
+    return rn ? rn->info : NULL;
 }
 
 void
 flush_xroute(struct xroute *xroute)
 {
-    int i;
+    struct route_node *rn;
 
-    i = xroute - xroutes;
-    assert(i >= 0 && i < numxroutes);
+    rn = find_xroute_node(xroute->prefix, xroute->plen);
+    assert(rn != NULL && rn->info == xroute);
 
-    if(i != numxroutes - 1)
-        memcpy(xroutes + i, xroutes + numxroutes - 1, sizeof(struct xroute));
+    rn->info = NULL;
+    free(xroute);
     numxroutes--;
-    VALGRIND_MAKE_MEM_UNDEFINED(xroutes + numxroutes, sizeof(struct xroute));
-
-    if(numxroutes == 0) {
-        free(xroutes);
-        xroutes = NULL;
-        maxxroutes = 0;
-    } else if(maxxroutes > 8 && numxroutes < maxxroutes / 4) {
-        struct xroute *new_xroutes;
-        int n = maxxroutes / 2;
-        new_xroutes = realloc(xroutes, n * sizeof(struct xroute));
-        if(new_xroutes == NULL)
-            return;
-        xroutes = new_xroutes;
-        maxxroutes = n;
-    }
+    route_unlock_node(rn);
 }
 
 static int
 add_xroute(unsigned char prefix[16], unsigned char plen,
            unsigned short metric, unsigned int ifindex, int proto)
 {
+    struct prefix p;
+    struct route_node *rn;
     struct xroute *xroute = find_xroute(prefix, plen);
     if(xroute) {
         if(xroute->metric <= metric)
@@ -171,23 +185,21 @@ add_xroute(unsigned char prefix[16], unsigned char plen,
         return 1;
     }
 
-    if(numxroutes >= maxxroutes) {
-        struct xroute *new_xroutes;
-        int n = maxxroutes < 1 ? 8 : 2 * maxxroutes;
-        new_xroutes = xroutes == NULL ?
-            malloc(n * sizeof(struct xroute)) :
-            realloc(xroutes, n * sizeof(struct xroute));
-        if(new_xroutes == NULL)
-            return -1;
-        maxxroutes = n;
-        xroutes = new_xroutes;
-    }
-
-    memcpy(xroutes[numxroutes].prefix, prefix, 16);
-    xroutes[numxroutes].plen = plen;
-    xroutes[numxroutes].metric = metric;
-    xroutes[numxroutes].ifindex = ifindex;
-    xroutes[numxroutes].proto = proto;
+    xroute = malloc(sizeof(struct xroute));
+    if(xroute == NULL)
+        return -1;
+
+    memcpy(xroute->prefix, prefix, 16);
+    xroute->plen = plen;
+    xroute->metric = metric;
+    xroute->ifindex = ifindex;
+    xroute->proto = proto;
+
+    if(xroutes == NULL)
+        xroutes = route_table_init();
+    xroute_prefix(&p, prefix, plen);
+    rn = route_node_get(xroutes, &p);
+    rn->info = xroute;
     numxroutes++;
     return 1;
 }
@@ -202,10 +214,14 @@ xroutes_estimate()
 void
 for_all_xroutes(void (*f)(struct xroute*, void*), void *closure)
 {
-    int i;
+    struct route_node *rn;
+
+    if(xroutes == NULL)
+        return;
 
-    for(i = 0; i < numxroutes; i++)
-        (*f)(&xroutes[i], closure);
+    for(rn = route_top(xroutes); rn; rn = route_next(rn))
+        if(rn->info)
+            (*f)(rn->info, closure);
 }
 
 /* add an xroute, verifying some conditions; return 0 if there is no changes */
@@ -393,7 +393,8 @@ bgp_sync_init (struct peer *peer)
 	FIFO_INIT (&sync->withdraw);
 	FIFO_INIT (&sync->withdraw_low);
 	peer->sync[afi][safi] = sync;
-	peer->hash[afi][safi] = hash_create (baa_hash_key, baa_hash_cmp);
+	peer->hash[afi][safi] = hash_create (baa_hash_key, baa_hash_cmp,
+					     "BGP advertised attributes");
       }
 }
 
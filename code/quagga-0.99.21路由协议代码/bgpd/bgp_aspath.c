@@ -605,12 +605,13 @@ aspath_make_str_count (struct aspath *as)
   return str_buf;
 }
 
+/* Drop the cached string of an aspath whose segments have changed; it
+   is made again the next time it is asked for. */
 static void
-aspath_str_update (struct aspath *as)
+aspath_str_clear (struct aspath *as)
 {
   if (as->str)
     XFREE (MTYPE_AS_STR, as->str);
-  as->str = aspath_make_str_count (as);
 }
 
 /* Intern allocated AS path. */
@@ -630,9 +631,6 @@ aspath_intern (struct aspath *aspath)
 
   find->refcnt++;
 
-  if (! find->str)
-    find->str = aspath_make_str_count (find);
-
   return find;
 }
 
@@ -650,27 +648,15 @@ aspath_dup (struct aspath *aspath)
   else
     new->segments = NULL;
 
-  new->str = aspath_make_str_count (aspath);
-
   return new;
 }
 
+/* New aspath structure is needed.  Segment types have been checked by
+   whoever built ARG, so there is nothing left to reject here. */
 static void *
 aspath_hash_alloc (void *arg)
 {
-  struct aspath *aspath;
-
-  /* New aspath structure is needed. */
-  aspath = aspath_dup (arg);
-  
-  /* Malformed AS path value. */
-  if (! aspath->str)
-    {
-      aspath_free (aspath);
-      return NULL;
-    }
-
-  return aspath;
+  return aspath_dup (arg);
 }
 
 /* parse as-segment byte stream in struct assegment */
@@ -802,8 +788,6 @@ aspath_parse (struct stream *s, size_t length, int use32bit)
    * optimised out.
    */
   assegment_free_all (as.segments);
-  if (as.str)
-    XFREE (MTYPE_AS_STR, as.str);
   
   if (! find)
     return NULL;
@@ -1065,7 +1049,7 @@ aspath_aggregate (struct aspath *as1, struct aspath *as2)
     }
   
   assegment_normalise (aspath->segments);
-  aspath_str_update (aspath);
+  aspath_str_clear (aspath);
   return aspath;
 }
 
@@ -1190,7 +1174,7 @@ aspath_merge (struct aspath *as1, struct aspath *as2)
   
   last->next = as2->segments;
   as2->segments = new;
-  aspath_str_update (as2);
+  aspath_str_clear (as2);
   return as2;
 }
 
@@ -1211,7 +1195,7 @@ aspath_prepend (struct aspath *as1, struct aspath *as2)
   if (seg2 == NULL)
     {
       as2->segments = assegment_dup_all (as1->segments);
-      aspath_str_update (as2);
+      aspath_str_clear (as2);
       return as2;
     }
   
@@ -1263,7 +1247,7 @@ aspath_prepend (struct aspath *as1, struct aspath *as2)
       /* we've now prepended as1's segment chain to as2, merging
        * the inbetween AS_SEQUENCE of seg2 in the process 
        */
-      aspath_str_update (as2);
+      aspath_str_clear (as2);
       return as2;
     }
   else
@@ -1342,7 +1326,7 @@ aspath_filter_exclude (struct aspath * source, struct aspath * exclude_list)
       lastseg->next = newseg;
     lastseg = newseg;
   }
-  aspath_str_update (newpath);
+  aspath_str_clear (newpath);
   /* We are happy returning even an empty AS_PATH, because the administrator
    * might expect this very behaviour. There's a mean to avoid this, if necessary,
    * by having a match rule against certain AS_PATH regexps in the route-map index.
@@ -1467,7 +1451,7 @@ aspath_reconcile_as4 ( struct aspath *aspath, struct aspath *as4path)
   
   if ( BGP_DEBUG(as4, AS4))
     zlog_debug("[AS4] got AS_PATH %s and AS4_PATH %s synthesizing now",
-               aspath->str, as4path->str);
+               aspath_print (aspath), aspath_print (as4path));
 
   while (seg && hops > 0)
     {
@@ -1522,11 +1506,11 @@ aspath_reconcile_as4 ( struct aspath *aspath, struct aspath *as4path)
   mergedpath = aspath_merge (newpath, aspath_dup(as4path));
   aspath_free (newpath);
   mergedpath->segments = assegment_normalise (mergedpath->segments);
-  aspath_str_update (mergedpath);
+  aspath_str_clear (mergedpath);
   
   if ( BGP_DEBUG(as4, AS4))
     zlog_debug ("[AS4] result of synthesizing is %s",
-                mergedpath->str);
+                aspath_print (mergedpath));
   
   return mergedpath;
 }
@@ -1582,7 +1566,7 @@ aspath_delete_confed_seq (struct aspath *aspath)
       assegment_free (seg);
       seg = aspath->segments;
     }
-  aspath_str_update (aspath);
+  aspath_str_clear (aspath);
   return aspath;
 }
 
@@ -1639,7 +1623,6 @@ aspath_empty_get (void)
   struct aspath *aspath;
 
   aspath = aspath_new ();
-  aspath->str = aspath_make_str_count (aspath);
   return aspath;
 }
 
@@ -1798,22 +1781,24 @@ aspath_str2aspath (const char *str)
 	}
     }
 
-  aspath->str = aspath_make_str_count (aspath);
-
   return aspath;
 }
 
-/* Make hash value by raw aspath data. */
+/* Make hash value by raw aspath data: the type, length and ASNs of each
+   segment, so interning never has to render the path as a string. */
 unsigned int
 aspath_key_make (void *p)
 {
   struct aspath * aspath = (struct aspath *) p;
-  unsigned int key = 0;
+  struct assegment *seg;
+  unsigned int key = 2334325;
 
-  if (!aspath->str)
-    aspath_str_update (aspath);
-  
-  key = jhash (aspath->str, strlen(aspath->str), 2334325);
+  for (seg = aspath->segments; seg; seg = seg->next)
+    {
+      key = jhash_2words (seg->type, seg->length, key);
+      if (seg->length)
+        key = jhash2 (seg->as, seg->length, key);
+    }
 
   return key;
 }
@@ -1847,7 +1832,8 @@ aspath_cmp (const void *arg1, const void *arg2)
 void
 aspath_init (void)
 {
-  ashash = hash_create_size (32767, aspath_key_make, aspath_cmp);
+  ashash = hash_create_size (32767, aspath_key_make, aspath_cmp,
+			     "BGP AS paths");
 }
 
 void
@@ -1860,11 +1846,15 @@ aspath_finish (void)
     stream_free (snmp_stream);
 }
 
-/* return and as path value */
+/* return and as path value, making the string if it is not cached */
 const char *
 aspath_print (struct aspath *as)
 {
-  return (as ? as->str : NULL);
+  if (! as)
+    return NULL;
+  if (! as->str)
+    as->str = aspath_make_str_count (as);
+  return as->str;
 }
 
 /* Printing functions */
@@ -1874,9 +1864,11 @@ aspath_print (struct aspath *as)
 void
 aspath_print_vty (struct vty *vty, const char *format, struct aspath *as, const char * suffix)
 {
+  const char *str = aspath_print (as);
+
   assert (format);
-  vty_out (vty, format, as->str);
-  if (strlen (as->str) && strlen (suffix))
+  vty_out (vty, format, str);
+  if (strlen (str) && strlen (suffix))
     vty_out (vty, "%s", suffix);
 }
 
@@ -1888,7 +1880,7 @@ aspath_show_all_iterator (struct hash_backet *backet, struct vty *vty)
   as = (struct aspath *) backet->data;
 
   vty_out (vty, "[%p:%u] (%ld) ", backet, backet->key, as->refcnt);
-  vty_out (vty, "%s%s", as->str, VTY_NEWLINE);
+  vty_out (vty, "%s%s", aspath_print (as), VTY_NEWLINE);
 }
 
 /* Print all aspath and hash information.  This function is used from
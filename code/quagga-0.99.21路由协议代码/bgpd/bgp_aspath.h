@@ -56,7 +56,8 @@ struct aspath
   struct assegment *segments;
   
   /* String expression of AS path.  This string is used by vty output
-     and AS path regular expression match.  */
+     and AS path regular expression match.  It is made on first use by
+     aspath_print(); interning works on the segments alone.  */
   char *str;
 };
 
@@ -199,7 +199,8 @@ cluster_unintern (struct cluster_list *cluster)
 static void
 cluster_init (void)
 {
-  cluster_hash = hash_create (cluster_hash_key_make, cluster_hash_cmp);
+  cluster_hash = hash_create (cluster_hash_key_make, cluster_hash_cmp,
+			      "BGP cluster lists");
 }
 
 static void
@@ -275,7 +276,8 @@ transit_hash_cmp (const void *p1, const void *p2)
 static void
 transit_init (void)
 {
-  transit_hash = hash_create (transit_hash_key_make, transit_hash_cmp);
+  transit_hash = hash_create (transit_hash_key_make, transit_hash_cmp,
+			      "BGP transitive attributes");
 }
 
 static void
@@ -431,7 +433,7 @@ attrhash_cmp (const void *p1, const void *p2)
 static void
 attrhash_init (void)
 {
-  attrhash = hash_create (attrhash_key_make, attrhash_cmp);
+  attrhash = hash_create (attrhash_key_make, attrhash_cmp, "BGP attributes");
 }
 
 static void
@@ -1347,6 +1349,17 @@ bgp_attr_munge_as4_attrs (struct peer *const peer,
   /* need to reconcile NEW_AS_PATH and AS_PATH */
   if (!ignore_as4_path && (attr->flag & (ATTR_FLAG_BIT( BGP_ATTR_AS4_PATH))))
     {
+       /* An AS4_PATH is only half of a path, and there is no AS_PATH
+        * for it to go with. */
+       if (!attr->aspath)
+         {
+           zlog (peer->log, LOG_ERR,
+                 "%s sent AS4_PATH without AS_PATH", peer->host);
+           bgp_notify_send (peer, BGP_NOTIFY_UPDATE_ERR,
+                            BGP_NOTIFY_UPDATE_MAL_AS_PATH);
+           return BGP_ATTR_PARSE_ERROR;
+         }
+
        newpath = aspath_reconcile_as4 (attr->aspath, as4_path);
        aspath_unintern (&attr->aspath);
        attr->aspath = aspath_intern (newpath);
@@ -54,6 +54,24 @@ community_entry_new (void)
   return XCALLOC (MTYPE_COMMUNITY_LIST_ENTRY, sizeof (struct community_entry));
 }
 
+/* Drop the reference a regex memo holds on the (ext)community it
+   cached.  */
+static void
+community_memo_release (void *attr)
+{
+  struct community *com = attr;
+
+  community_unintern (&com);
+}
+
+static void
+ecommunity_memo_release (void *attr)
+{
+  struct ecommunity *ecom = attr;
+
+  ecommunity_unintern (&ecom);
+}
+
 /* Free community list entry.  */
 static void
 community_entry_free (struct community_entry *entry)
@@ -78,6 +96,11 @@ community_entry_free (struct community_entry *entry)
         XFREE (MTYPE_COMMUNITY_LIST_CONFIG, entry->config);
       if (entry->reg)
         bgp_regex_free (entry->reg);
+      if (entry->memo)
+        bgp_regex_memo_free (entry->memo,
+                             entry->style == COMMUNITY_LIST_EXPANDED
+                             ? community_memo_release
+                             : ecommunity_memo_release);
     default:
       break;
     }
@@ -331,45 +354,68 @@ community_list_entry_lookup (struct community_list *list, const void *arg,
 }
 
 /* Internal function to perform regular expression match for community
-   attribute.  */
+   attribute.  The result for an interned attribute is kept in the
+   entry, as the same attribute is usually shared by many routes.  */
 static int
-community_regexp_match (struct community *com, regex_t * reg)
+community_regexp_match (struct community *com,
+                        struct community_entry *entry)
 {
   const char *str;
+  void *old;
+  int match;
 
   /* When there is no communities attribute it is treated as empty
      string.  */
   if (com == NULL || com->size == 0)
-    str = "";
-  else
-    str = community_str (com);
+    return regexec (entry->reg, "", 0, NULL, 0) == 0;
+
+  if (com->refcnt && bgp_regex_memo_lookup (&entry->memo, com, &match))
+    return match;
+
+  str = community_str (com);
 
   /* Regular expression match.  */
-  if (regexec (reg, str, 0, NULL, 0) == 0)
-    return 1;
+  match = regexec (entry->reg, str, 0, NULL, 0) == 0;
 
-  /* No match.  */
-  return 0;
+  if (com->refcnt)
+    {
+      com->refcnt++;
+      old = bgp_regex_memo_store (entry->memo, com, match);
+      if (old)
+        community_memo_release (old);
+    }
+  return match;
 }
 
 static int
-ecommunity_regexp_match (struct ecommunity *ecom, regex_t * reg)
+ecommunity_regexp_match (struct ecommunity *ecom,
+                         struct community_entry *entry)
 {
   const char *str;
+  void *old;
+  int match;
 
   /* When there is no communities attribute it is treated as empty
      string.  */
   if (ecom == NULL || ecom->size == 0)
-    str = "";
-  else
-    str = ecommunity_str (ecom);
+    return regexec (entry->reg, "", 0, NULL, 0) == 0;
+
+  if (ecom->refcnt && bgp_regex_memo_lookup (&entry->memo, ecom, &match))
+    return match;
+
+  str = ecommunity_str (ecom);
 
   /* Regular expression match.  */
-  if (regexec (reg, str, 0, NULL, 0) == 0)
-    return 1;
+  match = regexec (entry->reg, str, 0, NULL, 0) == 0;
 
-  /* No match.  */
-  return 0;
+  if (ecom->refcnt)
+    {
+      ecom->refcnt++;
+      old = bgp_regex_memo_store (entry->memo, ecom, match);
+      if (old)
+        ecommunity_memo_release (old);
+    }
+  return match;
 }
 
 /* Delete community attribute using regular expression match.  Return
@@ -442,7 +488,7 @@ community_list_match (struct community *com, struct community_list *list)
         }
       else if (entry->style == COMMUNITY_LIST_EXPANDED)
         {
-          if (community_regexp_match (com, entry->reg))
+          if (community_regexp_match (com, entry))
             return entry->direct == COMMUNITY_PERMIT ? 1 : 0;
         }
     }
@@ -466,7 +512,7 @@ ecommunity_list_match (struct ecommunity *ecom, struct community_list *list)
         }
       else if (entry->style == EXTCOMMUNITY_LIST_EXPANDED)
         {
-          if (ecommunity_regexp_match (ecom, entry->reg))
+          if (ecommunity_regexp_match (ecom, entry))
             return entry->direct == COMMUNITY_PERMIT ? 1 : 0;
         }
     }
@@ -496,7 +542,7 @@ community_list_exact_match (struct community *com,
         }
       else if (entry->style == COMMUNITY_LIST_EXPANDED)
         {
-          if (community_regexp_match (com, entry->reg))
+          if (community_regexp_match (com, entry))
             return entry->direct == COMMUNITY_PERMIT ? 1 : 0;
         }
     }
@@ -536,7 +582,7 @@ community_list_match_delete (struct community *com,
                 break;
         }
       else if ((entry->style == COMMUNITY_LIST_EXPANDED)
-               && community_regexp_match (com, entry->reg))
+               && community_regexp_match (com, entry))
         {
           if (entry->direct == COMMUNITY_PERMIT)
             community_regexp_delete (com, entry->reg);
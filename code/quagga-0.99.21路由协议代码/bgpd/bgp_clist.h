@@ -87,6 +87,9 @@ struct community_entry
 
   /* Expanded community-list regular expression.  */
   regex_t *reg;
+
+  /* Results of reg for recently seen communities.  */
+  struct bgp_regex_memo *memo;
 };
 
 /* Linked list of community-list.  */
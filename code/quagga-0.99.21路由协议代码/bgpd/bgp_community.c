@@ -635,7 +635,8 @@ void
 community_init (void)
 {
   comhash = hash_create ((unsigned int (*) (void *))community_hash_make,
-			 (int (*) (const void *, const void *))community_cmp);
+			 (int (*) (const void *, const void *))community_cmp,
+			 "BGP communities");
 }
 
 void
@@ -24,6 +24,7 @@ Software Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
 #include "log.h"
 #include "memory.h"
 #include "buffer.h"
+#include "hash.h"
 
 #include "bgpd/bgpd.h"
 #include "bgpd/bgp_aspath.h"
@@ -46,6 +47,10 @@ struct as_list_master
   /* List of access_list which name is string. */
   struct as_list_list str;
 
+  /* struct as_list_ref by name, for every name either defined or
+     referred to. */
+  struct hash *names;
+
   /* Hook function which is executed when new access_list is added. */
   void (*add_hook) (void);
 
@@ -63,6 +68,9 @@ struct as_filter
 
   regex_t *reg;
   char *reg_str;
+
+  /* Results of reg for recently seen AS paths. */
+  struct bgp_regex_memo *memo;
 };
 
 enum as_list_type
@@ -92,6 +100,7 @@ static struct as_list_master as_list_master =
   {NULL, NULL},
   {NULL, NULL},
   NULL,
+  NULL,
   NULL
 };
 
@@ -102,10 +111,20 @@ as_filter_new (void)
   return XCALLOC (MTYPE_AS_FILTER, sizeof (struct as_filter));
 }
 
+static void
+as_filter_memo_release (void *attr)
+{
+  struct aspath *aspath = attr;
+
+  aspath_unintern (&aspath);
+}
+
 /* Free allocated AS filter. */
 static void
 as_filter_free (struct as_filter *asfilter)
 {
+  if (asfilter->memo)
+    bgp_regex_memo_free (asfilter->memo, as_filter_memo_release);
   if (asfilter->reg)
     bgp_regex_free (asfilter->reg);
   if (asfilter->reg_str)
@@ -152,24 +171,100 @@ as_list_filter_add (struct as_list *aslist, struct as_filter *asfilter)
   aslist->tail = asfilter;
 }
 
+static unsigned int
+as_list_ref_key (void *arg)
+{
+  struct as_list_ref *ref = arg;
+
+  return string_hash_make (ref->name);
+}
+
+static int
+as_list_ref_cmp (const void *a, const void *b)
+{
+  const struct as_list_ref *ref1 = a;
+  const struct as_list_ref *ref2 = b;
+
+  return strcmp (ref1->name, ref2->name) == 0;
+}
+
+static void *
+as_list_ref_alloc (void *arg)
+{
+  struct as_list_ref *key = arg;
+  struct as_list_ref *ref;
+  size_t len = strlen (key->name) + 1;
+  char *name;
+
+  /* The name is kept right after the entry, and freed with it. */
+  ref = XCALLOC (MTYPE_AS_LIST_REF, sizeof (struct as_list_ref) + len);
+  name = (char *) (ref + 1);
+  memcpy (name, key->name, len);
+  ref->name = name;
+  return ref;
+}
+
+/* The name's entry in the index, created if CREATE. */
+static struct as_list_ref *
+as_list_ref_lookup (const char *name, int create)
+{
+  struct as_list_ref key;
+
+  if (as_list_master.names == NULL)
+    {
+      if (! create)
+	return NULL;
+      as_list_master.names = hash_create (as_list_ref_key, as_list_ref_cmp,
+					  "AS-path list names");
+    }
+
+  key.name = name;
+  return hash_get (as_list_master.names, &key,
+		   create ? as_list_ref_alloc : NULL);
+}
+
+/* Drop the name from the index once nothing defines or refers to it. */
+static void
+as_list_ref_release (struct as_list_ref *ref)
+{
+  if (ref->aslist || ref->refcnt)
+    return;
+
+  hash_release (as_list_master.names, ref);
+  XFREE (MTYPE_AS_LIST_REF, ref);
+}
+
+/* Hold a reference to the AS path access-list of the given name, which
+   need not exist yet.  Release it with as_list_ref_put(). */
+struct as_list_ref *
+as_list_ref_get (const char *name)
+{
+  struct as_list_ref *ref;
+
+  ref = as_list_ref_lookup (name, 1);
+  ref->refcnt++;
+  return ref;
+}
+
+void
+as_list_ref_put (struct as_list_ref *ref)
+{
+  assert (ref->refcnt > 0);
+  ref->refcnt--;
+  as_list_ref_release (ref);
+}
+
 /* Lookup as_list from list of as_list by name. */
 struct as_list *
 as_list_lookup (const char *name)
 {
-  struct as_list *aslist;
+  struct as_list_ref *ref;
 
   if (name == NULL)
     return NULL;
 
-  for (aslist = as_list_master.num.head; aslist; aslist = aslist->next)
-    if (strcmp (aslist->name, name) == 0)
-      return aslist;
-
-  for (aslist = as_list_master.str.head; aslist; aslist = aslist->next)
-    if (strcmp (aslist->name, name) == 0)
-      return aslist;
-
-  return NULL;
+  ref = as_list_ref_lookup (name, 0);
+  return ref ? ref->aslist : NULL;
 }
 
 static struct as_list *
@@ -204,6 +299,7 @@ as_list_insert (const char *name)
   aslist = as_list_new ();
   aslist->name = strdup (name);
   assert (aslist->name);
+  as_list_ref_lookup (name, 1)->aslist = aslist;
 
   /* If name is made by all digit character.  We treat it as
      number. */
@@ -313,6 +409,7 @@ as_list_delete (struct as_list *aslist)
 {
   struct as_list_list *list;
   struct as_filter *filter, *next;
+  struct as_list_ref *ref;
 
   for (filter = aslist->head; filter; filter = next)
     {
@@ -335,6 +432,10 @@ as_list_delete (struct as_list *aslist)
   else
     list->head = aslist->next;
 
+  ref = as_list_ref_lookup (aslist->name, 0);
+  ref->aslist = NULL;
+  as_list_ref_release (ref);
+
   as_list_free (aslist);
 }
 
@@ -374,9 +475,23 @@ as_list_filter_delete (struct as_list *aslist, struct as_filter *asfilter)
 static int
 as_filter_match (struct as_filter *asfilter, struct aspath *aspath)
 {
-  if (bgp_regexec (asfilter->reg, aspath) != REG_NOMATCH)
-    return 1;
-  return 0;
+  void *old;
+  int match;
+
+  /* Only interned paths are shared between routes, and only they can
+     be held on to. */
+  if (! aspath->refcnt)
+    return bgp_regexec (asfilter->reg, aspath) != REG_NOMATCH;
+
+  if (bgp_regex_memo_lookup (&asfilter->memo, aspath, &match))
+    return match;
+
+  match = bgp_regexec (asfilter->reg, aspath) != REG_NOMATCH;
+  aspath->refcnt++;
+  old = bgp_regex_memo_store (asfilter->memo, aspath, match);
+  if (old)
+    as_filter_memo_release (old);
+  return match;
 }
 
 /* Apply AS path filter to AS. */
@@ -577,6 +692,25 @@ DEFUN (no_ip_as_path_all,
   return CMD_SUCCESS;
 }
 
+static void
+as_list_show_memo (struct vty *vty, struct as_list *aslist)
+{
+  struct as_filter *asfilter;
+  unsigned long hits = 0;
+  unsigned long misses = 0;
+
+  for (asfilter = aslist->head; asfilter; asfilter = asfilter->next)
+    if (asfilter->memo)
+      {
+	hits += asfilter->memo->hits;
+	misses += asfilter->memo->misses;
+      }
+
+  vty_out (vty, "    Regexp results cached: %lu hits, %lu misses (%lu%%)%s",
+	   hits, misses, hits + misses ? hits * 100 / (hits + misses) : 0,
+	   VTY_NEWLINE);
+}
+
 static void
 as_list_show (struct vty *vty, struct as_list *aslist)
 {
@@ -589,6 +723,7 @@ as_list_show (struct vty *vty, struct as_list *aslist)
       vty_out (vty, "    %s %s%s", filter_type_str (asfilter->type),
 	       asfilter->reg_str, VTY_NEWLINE);
     }
+  as_list_show_memo (vty, aslist);
 }
 
 static void
@@ -606,6 +741,7 @@ as_list_show_all (struct vty *vty)
 	  vty_out (vty, "    %s %s%s", filter_type_str (asfilter->type),
 		   asfilter->reg_str, VTY_NEWLINE);
 	}
+      as_list_show_memo (vty, aslist);
     }
 
   for (aslist = as_list_master.str.head; aslist; aslist = aslist->next)
@@ -617,6 +753,7 @@ as_list_show_all (struct vty *vty)
 	  vty_out (vty, "    %s %s%s", filter_type_str (asfilter->type),
 		   asfilter->reg_str, VTY_NEWLINE);
 	}
+      as_list_show_memo (vty, aslist);
     }
 }
 
@@ -27,12 +27,27 @@ enum as_filter_type
   AS_FILTER_PERMIT
 };
 
+/* An AS path access-list name as route-map rules refer to it, whether
+   or not a list of that name exists.  ASLIST follows the list as it is
+   added and deleted, so holders need no lookup by name. */
+struct as_list_ref
+{
+  const char *name;
+
+  /* The list of that name, or NULL. */
+  struct as_list *aslist;
+
+  unsigned long refcnt;
+};
+
 extern void bgp_filter_init (void);
 extern void bgp_filter_reset (void);
 
 extern enum as_filter_type as_list_apply (struct as_list *, void *);
 
 extern struct as_list *as_list_lookup (const char *);
+extern struct as_list_ref *as_list_ref_get (const char *);
+extern void as_list_ref_put (struct as_list_ref *);
 extern void as_list_add_hook (void (*func) (void));
 extern void as_list_delete_hook (void (*func) (void));
 
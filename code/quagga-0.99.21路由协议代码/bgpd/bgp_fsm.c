@@ -40,6 +40,7 @@ Software Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
 #include "bgpd/bgp_route.h"
 #include "bgpd/bgp_dump.h"
 #include "bgpd/bgp_open.h"
+#include "bgpd/bgp_updgrp.h"
 #ifdef HAVE_SNMP
 #include "bgpd/bgp_snmp.h"
 #endif /* HAVE_SNMP */
@@ -519,6 +520,9 @@ bgp_stop (struct peer *peer)
   if (peer->obuf)
     stream_fifo_clean (peer->obuf);
 
+  /* Stop sharing UPDATEs with the update groups. */
+  bgp_updgrp_leave_all (peer);
+
   /* Close of file descriptor. */
   if (peer->fd >= 0)
     {
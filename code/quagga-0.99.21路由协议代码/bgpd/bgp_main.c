@@ -260,9 +260,6 @@ bgp_exit (int status)
     }
   list_free (iflist);
 
-  /* reverse bgp_attr_init */
-  bgp_attr_finish ();
-
   /* reverse bgp_dump_init */
   bgp_dump_finish ();
 
@@ -293,6 +290,10 @@ bgp_exit (int status)
   /* reverse community_list_init */
   community_list_terminate (bgp_clist);
 
+  /* reverse bgp_attr_init, once the filters above have dropped the
+     attributes they hold */
+  bgp_attr_finish ();
+
   cmd_terminate ();
   vty_terminate ();
   if (zclient)
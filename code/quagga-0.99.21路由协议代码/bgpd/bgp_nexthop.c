@@ -56,16 +56,20 @@ static int bgp_scan_interval;
 /* BGP import interval. */
 static int bgp_import_interval;
 
+/* Connected route change thread. */
+static struct thread *bgp_connected_thread = NULL;
+
 /* Route table for next-hop lookup cache. */
 static struct bgp_table *bgp_nexthop_cache_table[AFI_MAX];
-static struct bgp_table *cache1_table[AFI_MAX];
-static struct bgp_table *cache2_table[AFI_MAX];
 
 /* Route table for connected route. */
 static struct bgp_table *bgp_connected_table[AFI_MAX];
 
 /* BGP nexthop lookup query client. */
 struct zclient *zlookup = NULL;
+
+/* BGP client, over which nexthops are tracked. */
+extern struct zclient *zclient;
 
 /* Add nexthop to the end of the list.  */
 static void
@@ -212,31 +216,168 @@ bgp_nexthop_onlink (afi_t afi, struct attr *attr)
   return 0;
 }
 
+/* Whether zebra tells us when nexthops change. */
+static int
+bgp_nexthop_tracking (void)
+{
+  return zclient && zclient->sock >= 0;
+}
+
+static struct bgp_table *
+bgp_nexthop_cache_table_get (struct prefix *p)
+{
+#ifdef HAVE_IPV6
+  if (p->family == AF_INET6)
+    return bgp_nexthop_cache_table[AFI_IP6];
+#endif /* HAVE_IPV6 */
+  return bgp_nexthop_cache_table[AFI_IP];
+}
+
+/* Ask zebra how the nexthop address P resolves now. */
+static struct bgp_nexthop_cache *
+bgp_nexthop_query (struct prefix *p)
+{
+  struct bgp_nexthop_cache *new;
+
+#ifdef HAVE_IPV6
+  if (p->family == AF_INET6)
+    new = zlookup_query_ipv6 (&p->u.prefix6);
+  else
+#endif /* HAVE_IPV6 */
+    new = zlookup_query (p->u.prefix4);
+
+  return new ? new : bnc_new ();
+}
+
+static void
+bgp_nexthop_register (struct bgp_nexthop_cache *bnc)
+{
+  if (! bgp_nexthop_tracking ())
+    return;
+
+  if (zebra_nexthop_register_send (ZEBRA_NEXTHOP_REGISTER, zclient,
+				   &bnc->node->p) == 0)
+    bnc->registered = 1;
+}
+
+/* (Re)register every cached nexthop with zebra, e.g. when the
+   connection to it comes up. */
+void
+bgp_nexthop_register_all (struct zclient *zclient)
+{
+  struct bgp_node *rn;
+  struct bgp_nexthop_cache *bnc;
+  afi_t afi;
+
+  for (afi = AFI_IP; afi < AFI_MAX; afi++)
+    if (bgp_nexthop_cache_table[afi])
+      for (rn = bgp_table_top (bgp_nexthop_cache_table[afi]); rn;
+	   rn = bgp_route_next (rn))
+	if ((bnc = rn->info) != NULL)
+	  {
+	    bnc->registered = 0;
+	    bgp_nexthop_register (bnc);
+	  }
+}
+
+/* Make RI one of the paths depending on BNC. */
+static void
+bgp_nexthop_path_link (struct bgp_nexthop_cache *bnc, struct bgp_info *ri)
+{
+  if (ri->nexthop == bnc)
+    return;
+
+  bgp_nexthop_path_unlink (ri);
+
+  ri->nexthop = bnc;
+  ri->nh_prev = NULL;
+  ri->nh_next = bnc->paths;
+  if (bnc->paths)
+    bnc->paths->nh_prev = ri;
+  bnc->paths = ri;
+  bnc->path_count++;
+}
+
+/* RI no longer depends on a nexthop.  Cache entries no path depends on
+   are dropped, and zebra told to stop tracking them. */
+void
+bgp_nexthop_path_unlink (struct bgp_info *ri)
+{
+  struct bgp_nexthop_cache *bnc = ri->nexthop;
+  struct bgp_node *rn;
+
+  if (! bnc)
+    return;
+
+  if (ri->nh_next)
+    ri->nh_next->nh_prev = ri->nh_prev;
+  if (ri->nh_prev)
+    ri->nh_prev->nh_next = ri->nh_next;
+  else
+    bnc->paths = ri->nh_next;
+  ri->nexthop = NULL;
+  ri->nh_next = ri->nh_prev = NULL;
+
+  if (--bnc->path_count)
+    return;
+
+  rn = bnc->node;
+  if (bnc->registered && bgp_nexthop_tracking ())
+    zebra_nexthop_register_send (ZEBRA_NEXTHOP_UNREGISTER, zclient, &rn->p);
+  bnc_free (bnc);
+  rn->info = NULL;
+  bgp_unlock_node (rn);
+}
+
+/* Find or make the cache entry for the nexthop address P, and make RI
+   one of the paths depending on it. */
+static struct bgp_nexthop_cache *
+bgp_nexthop_cache_get (struct prefix *p, struct bgp_info *ri)
+{
+  struct bgp_node *rn;
+  struct bgp_nexthop_cache *bnc;
+
+  rn = bgp_node_get (bgp_nexthop_cache_table_get (p), p);
+
+  if (rn->info)
+    {
+      bnc = rn->info;
+      bgp_unlock_node (rn);
+    }
+  else
+    {
+      /* Resolve it now; zebra sends changes after that.  The entry
+	 keeps the node lock. */
+      bnc = bgp_nexthop_query (p);
+      bnc->node = rn;
+      rn->info = bnc;
+
+      bgp_nexthop_register (bnc);
+    }
+
+  bgp_nexthop_path_link (bnc, ri);
+  return bnc;
+}
+
 #ifdef HAVE_IPV6
 /* Check specified next-hop is reachable or not. */
 static int
 bgp_nexthop_lookup_ipv6 (struct peer *peer, struct bgp_info *ri, int *changed,
 			 int *metricchanged)
 {
-  struct bgp_node *rn;
   struct prefix p;
   struct bgp_nexthop_cache *bnc;
   struct attr *attr;
   
-  /* If lookup is not enabled, return valid. */
-  if (zlookup->sock < 0)
-    {
-      if (ri->extra)
-        ri->extra->igpmetric = 0;
-      return 1;
-    }
-  
   /* Only check IPv6 global address only nexthop. */
   attr = ri->attr;
 
   if (attr->extra->mp_nexthop_len != 16 
       || IN6_IS_ADDR_LINKLOCAL (&attr->extra->mp_nexthop_global))
-    return 1;
+    {
+      bgp_nexthop_path_unlink (ri);
+      return 1;
+    }
 
   memset (&p, 0, sizeof (struct prefix));
   p.family = AF_INET6;
@@ -244,45 +385,7 @@ bgp_nexthop_lookup_ipv6 (struct peer *peer, struct bgp_info *ri, int *changed,
   p.u.prefix6 = attr->extra->mp_nexthop_global;
 
   /* IBGP or ebgp-multihop */
-  rn = bgp_node_get (bgp_nexthop_cache_table[AFI_IP6], &p);
-
-  if (rn->info)
-    {
-      bnc = rn->info;
-      bgp_unlock_node (rn);
-    }
-  else
-    {
-      if (NULL == (bnc = zlookup_query_ipv6 (&attr->extra->mp_nexthop_global)))
-	bnc = bnc_new ();
-      else
-	{
-	  if (changed)
-	    {
-	      struct bgp_table *old;
-	      struct bgp_node *oldrn;
-
-	      if (bgp_nexthop_cache_table[AFI_IP6] == cache1_table[AFI_IP6])
-		old = cache2_table[AFI_IP6];
-	      else
-		old = cache1_table[AFI_IP6];
-
-	      oldrn = bgp_node_lookup (old, &p);
-	      if (oldrn)
-		{
-		  struct bgp_nexthop_cache *oldbnc = oldrn->info;
-
-		  bnc->changed = bgp_nexthop_cache_different (bnc, oldbnc);
-
-		  if (bnc->metric != oldbnc->metric)
-		    bnc->metricchanged = 1;
-
-                  bgp_unlock_node (oldrn);
-		}
-	    }
-	}
-      rn->info = bnc;
-    }
+  bnc = bgp_nexthop_cache_get (&p, ri);
 
   if (changed)
     *changed = bnc->changed;
@@ -304,14 +407,13 @@ int
 bgp_nexthop_lookup (afi_t afi, struct peer *peer, struct bgp_info *ri,
 		    int *changed, int *metricchanged)
 {
-  struct bgp_node *rn;
   struct prefix p;
   struct bgp_nexthop_cache *bnc;
-  struct in_addr addr;
   
   /* If lookup is not enabled, return valid. */
   if (zlookup->sock < 0)
     {
+      bgp_nexthop_path_unlink (ri);
       if (ri->extra)
         ri->extra->igpmetric = 0;
       return 1;
@@ -322,66 +424,218 @@ bgp_nexthop_lookup (afi_t afi, struct peer *peer, struct bgp_info *ri,
     return bgp_nexthop_lookup_ipv6 (peer, ri, changed, metricchanged);
 #endif /* HAVE_IPV6 */
 
-  addr = ri->attr->nexthop;
-
   memset (&p, 0, sizeof (struct prefix));
   p.family = AF_INET;
   p.prefixlen = IPV4_MAX_BITLEN;
-  p.u.prefix4 = addr;
+  p.u.prefix4 = ri->attr->nexthop;
 
   /* IBGP or ebgp-multihop */
-  rn = bgp_node_get (bgp_nexthop_cache_table[AFI_IP], &p);
+  bnc = bgp_nexthop_cache_get (&p, ri);
 
-  if (rn->info)
+  if (changed)
+    *changed = bnc->changed;
+
+  if (metricchanged)
+    *metricchanged = bnc->metricchanged;
+
+  if (bnc->valid && bnc->metric)
+    (bgp_info_extra_get(ri))->igpmetric = bnc->metric;
+  else if (ri->extra)
+    ri->extra->igpmetric = 0;
+
+  return bnc->valid;
+}
+
+/* BNC now resolves as NEW says.  Re-evaluate the paths depending on it
+   if that makes any difference.  NEW is freed. */
+static void
+bgp_nexthop_cache_apply (struct bgp_nexthop_cache *bnc,
+			 struct bgp_nexthop_cache *new, afi_t afi)
+{
+  struct bgp_info *ri, *next;
+  struct bgp_node *rn;
+  struct bgp *bgp;
+  safi_t safi;
+  int current;
+
+  bnc->changed = bgp_nexthop_cache_different (bnc, new);
+  bnc->metricchanged = (bnc->metric != new->metric);
+
+  if (! bnc->changed && ! bnc->metricchanged && bnc->valid == new->valid)
     {
-      bnc = rn->info;
-      bgp_unlock_node (rn);
+      bnc_free (new);
+      return;
     }
-  else
+
+  bnc_nexthop_free (bnc);
+  bnc->nexthop = new->nexthop;
+  bnc->nexthop_num = new->nexthop_num;
+  bnc->metric = new->metric;
+  bnc->valid = new->valid;
+  bnc->updates++;
+  new->nexthop = NULL;
+  bnc_free (new);
+
+  if (BGP_DEBUG (events, EVENTS))
     {
-      if (NULL == (bnc = zlookup_query (addr)))
-	bnc = bnc_new ();
-      else
+      char buf[INET6_ADDRSTRLEN];
+
+      zlog_debug ("nexthop %s is %s, metric %u, re-evaluating %lu path(s)",
+		  inet_ntop (bnc->node->p.family, &bnc->node->p.u.prefix,
+			     buf, sizeof (buf)),
+		  bnc->valid ? "reachable" : "unreachable", bnc->metric,
+		  bnc->path_count);
+    }
+
+  for (ri = bnc->paths; ri; ri = next)
+    {
+      next = ri->nh_next;
+      rn = ri->net;
+
+      if (! rn || CHECK_FLAG (ri->flags, BGP_INFO_REMOVED))
+	continue;
+
+      bgp = ri->peer->bgp;
+      safi = rn->table->safi;
+
+      if (bnc->valid && bnc->metric)
+	(bgp_info_extra_get (ri))->igpmetric = bnc->metric;
+      else if (ri->extra)
+	ri->extra->igpmetric = 0;
+
+      if (bnc->changed)
+	SET_FLAG (ri->flags, BGP_INFO_IGP_CHANGED);
+
+      current = CHECK_FLAG (ri->flags, BGP_INFO_VALID) ? 1 : 0;
+      if (bnc->valid != current)
 	{
-	  if (changed)
+	  if (current)
+	    {
+	      bgp_aggregate_decrement (bgp, &rn->p, ri, afi, safi);
+	      bgp_info_unset_flag (rn, ri, BGP_INFO_VALID);
+	    }
+	  else
 	    {
-	      struct bgp_table *old;
-	      struct bgp_node *oldrn;
+	      bgp_info_set_flag (rn, ri, BGP_INFO_VALID);
+	      bgp_aggregate_increment (bgp, &rn->p, ri, afi, safi);
+	    }
+	}
 
-	      if (bgp_nexthop_cache_table[AFI_IP] == cache1_table[AFI_IP])
-		old = cache2_table[AFI_IP];
-	      else
-		old = cache1_table[AFI_IP];
+      bgp_process (bgp, rn, afi, safi);
+    }
 
-	      oldrn = bgp_node_lookup (old, &p);
-	      if (oldrn)
-		{
-		  struct bgp_nexthop_cache *oldbnc = oldrn->info;
+  bnc->changed = 0;
+  bnc->metricchanged = 0;
+}
+
+/* Read how a nexthop resolves, as zebra sends it after the address. */
+static struct bgp_nexthop_cache *
+bgp_nexthop_cache_read (struct stream *s)
+{
+  struct bgp_nexthop_cache *bnc;
+  struct nexthop *nexthop;
+  u_int32_t metric;
+  u_char nexthop_num;
+  int i;
 
-		  bnc->changed = bgp_nexthop_cache_different (bnc, oldbnc);
+  bnc = bnc_new ();
+  metric = stream_getl (s);
+  nexthop_num = stream_getc (s);
+  if (! nexthop_num)
+    return bnc;
 
-		  if (bnc->metric != oldbnc->metric)
-		    bnc->metricchanged = 1;
+  bnc->valid = 1;
+  bnc->metric = metric;
+  bnc->nexthop_num = nexthop_num;
 
-                  bgp_unlock_node (oldrn);
-		}
-	    }
+  for (i = 0; i < nexthop_num; i++)
+    {
+      nexthop = XCALLOC (MTYPE_NEXTHOP, sizeof (struct nexthop));
+      nexthop->type = stream_getc (s);
+      switch (nexthop->type)
+	{
+	case ZEBRA_NEXTHOP_IPV4:
+	  nexthop->gate.ipv4.s_addr = stream_get_ipv4 (s);
+	  break;
+	case ZEBRA_NEXTHOP_IPV4_IFINDEX:
+	  nexthop->gate.ipv4.s_addr = stream_get_ipv4 (s);
+	  nexthop->ifindex = stream_getl (s);
+	  break;
+	case ZEBRA_NEXTHOP_IFINDEX:
+	case ZEBRA_NEXTHOP_IFNAME:
+	  nexthop->ifindex = stream_getl (s);
+	  break;
+#ifdef HAVE_IPV6
+	case ZEBRA_NEXTHOP_IPV6:
+	  stream_get (&nexthop->gate.ipv6, s, 16);
+	  break;
+	case ZEBRA_NEXTHOP_IPV6_IFINDEX:
+	case ZEBRA_NEXTHOP_IPV6_IFNAME:
+	  stream_get (&nexthop->gate.ipv6, s, 16);
+	  nexthop->ifindex = stream_getl (s);
+	  break;
+#endif /* HAVE_IPV6 */
+	default:
+	  /* do nothing */
+	  break;
 	}
-      rn->info = bnc;
+      bnc_nexthop_add (bnc, nexthop);
     }
 
-  if (changed)
-    *changed = bnc->changed;
+  return bnc;
+}
 
-  if (metricchanged)
-    *metricchanged = bnc->metricchanged;
+/* Zebra says a registered nexthop resolves differently. */
+int
+bgp_nexthop_update (int command, struct zclient *zclient, uint16_t length)
+{
+  struct stream *s = zclient->ibuf;
+  struct bgp_nexthop_cache *bnc;
+  struct bgp_node *rn;
+  struct prefix p;
+  afi_t afi;
 
-  if (bnc->valid && bnc->metric)
-    (bgp_info_extra_get(ri))->igpmetric = bnc->metric;
-  else if (ri->extra)
-    ri->extra->igpmetric = 0;
+  memset (&p, 0, sizeof (struct prefix));
+  p.family = stream_getw (s);
+  p.prefixlen = stream_getc (s);
 
-  return bnc->valid;
+  if (p.family == AF_INET && p.prefixlen == IPV4_MAX_BITLEN)
+    afi = AFI_IP;
+#ifdef HAVE_IPV6
+  else if (p.family == AF_INET6 && p.prefixlen == IPV6_MAX_BITLEN)
+    afi = AFI_IP6;
+#endif /* HAVE_IPV6 */
+  else
+    return -1;
+
+  stream_get (&p.u.prefix, s, PSIZE (p.prefixlen));
+
+  rn = bgp_node_lookup (bgp_nexthop_cache_table[afi], &p);
+  if (! rn)
+    return 0;
+  bgp_unlock_node (rn);
+
+  if ((bnc = rn->info) == NULL)
+    return 0;
+
+  bgp_nexthop_cache_apply (bnc, bgp_nexthop_cache_read (s), afi);
+  return 0;
+}
+
+/* Without zebra sending changes, ask it about every cached nexthop. */
+static void
+bgp_nexthop_cache_refresh (afi_t afi)
+{
+  struct bgp_node *rn;
+  struct bgp_nexthop_cache *bnc;
+
+  if (zlookup->sock < 0)
+    return;
+
+  for (rn = bgp_table_top (bgp_nexthop_cache_table[afi]); rn;
+       rn = bgp_route_next (rn))
+    if ((bnc = rn->info) != NULL)
+      bgp_nexthop_cache_apply (bnc, bgp_nexthop_query (&rn->p), afi);
 }
 
 /* Reset and free all BGP nexthop cache. */
@@ -390,18 +644,29 @@ bgp_nexthop_cache_reset (struct bgp_table *table)
 {
   struct bgp_node *rn;
   struct bgp_nexthop_cache *bnc;
+  struct bgp_info *ri;
 
   for (rn = bgp_table_top (table); rn; rn = bgp_route_next (rn))
     if ((bnc = rn->info) != NULL)
       {
+	while ((ri = bnc->paths) != NULL)
+	  {
+	    bnc->paths = ri->nh_next;
+	    ri->nexthop = NULL;
+	    ri->nh_next = ri->nh_prev = NULL;
+	  }
 	bnc_free (bnc);
 	rn->info = NULL;
 	bgp_unlock_node (rn);
       }
 }
 
+/* Checks that need the BGP table walked: reachability of directly
+   connected EBGP peers' nexthops when CONNECTED is set, and dampening.
+   Nexthops looked up through zebra are kept up to date by the updates
+   it sends instead. */
 static void
-bgp_scan (afi_t afi, safi_t safi)
+bgp_scan (afi_t afi, safi_t safi, int connected)
 {
   struct bgp_node *rn;
   struct bgp *bgp;
@@ -409,16 +674,10 @@ bgp_scan (afi_t afi, safi_t safi)
   struct bgp_info *next;
   struct peer *peer;
   struct listnode *node, *nnode;
+  int dampening;
+  int process;
   int valid;
   int current;
-  int changed;
-  int metricchanged;
-
-  /* Change cache. */
-  if (bgp_nexthop_cache_table[afi] == cache1_table[afi])
-    bgp_nexthop_cache_table[afi] = cache2_table[afi];
-  else
-    bgp_nexthop_cache_table[afi] = cache1_table[afi];
 
   /* Get default bgp. */
   bgp = bgp_get_default ();
@@ -439,64 +698,63 @@ bgp_scan (afi_t afi, safi_t safi)
 	bgp_maximum_prefix_overflow (peer, afi, SAFI_MPLS_VPN, 1);
     }
 
+  if (! bgp_nexthop_tracking ())
+    bgp_nexthop_cache_refresh (afi);
+
+  dampening = CHECK_FLAG (bgp->af_flags[afi][SAFI_UNICAST],
+			  BGP_CONFIG_DAMPENING);
+  if (! connected && ! dampening)
+    return;
+
   for (rn = bgp_table_top (bgp->rib[afi][SAFI_UNICAST]); rn;
        rn = bgp_route_next (rn))
     {
+      process = 0;
+
       for (bi = rn->info; bi; bi = next)
 	{
 	  next = bi->next;
 
 	  if (bi->type == ZEBRA_ROUTE_BGP && bi->sub_type == BGP_ROUTE_NORMAL)
 	    {
-	      changed = 0;
-	      metricchanged = 0;
-
-	      if (peer_sort (bi->peer) == BGP_PEER_EBGP && bi->peer->ttl == 1)
-		valid = bgp_nexthop_onlink (afi, bi->attr);
-	      else
-		valid = bgp_nexthop_lookup (afi, bi->peer, bi,
-					    &changed, &metricchanged);
-
-	      current = CHECK_FLAG (bi->flags, BGP_INFO_VALID) ? 1 : 0;
-
-	      if (changed)
-		SET_FLAG (bi->flags, BGP_INFO_IGP_CHANGED);
-	      else
-		UNSET_FLAG (bi->flags, BGP_INFO_IGP_CHANGED);
-
-	      if (valid != current)
+	      if (connected && ! bi->nexthop
+		  && peer_sort (bi->peer) == BGP_PEER_EBGP
+		  && bi->peer->ttl == 1)
 		{
-		  if (CHECK_FLAG (bi->flags, BGP_INFO_VALID))
-		    {
-		      bgp_aggregate_decrement (bgp, &rn->p, bi,
-					       afi, SAFI_UNICAST);
-		      bgp_info_unset_flag (rn, bi, BGP_INFO_VALID);
-		    }
-		  else
+		  valid = bgp_nexthop_onlink (afi, bi->attr);
+		  current = CHECK_FLAG (bi->flags, BGP_INFO_VALID) ? 1 : 0;
+
+		  if (valid != current)
 		    {
-		      bgp_info_set_flag (rn, bi, BGP_INFO_VALID);
-		      bgp_aggregate_increment (bgp, &rn->p, bi,
-					       afi, SAFI_UNICAST);
+		      if (CHECK_FLAG (bi->flags, BGP_INFO_VALID))
+			{
+			  bgp_aggregate_decrement (bgp, &rn->p, bi,
+						   afi, SAFI_UNICAST);
+			  bgp_info_unset_flag (rn, bi, BGP_INFO_VALID);
+			}
+		      else
+			{
+			  bgp_info_set_flag (rn, bi, BGP_INFO_VALID);
+			  bgp_aggregate_increment (bgp, &rn->p, bi,
+						   afi, SAFI_UNICAST);
+			}
+		      process = 1;
 		    }
 		}
 
-              if (CHECK_FLAG (bgp->af_flags[afi][SAFI_UNICAST],
-		  BGP_CONFIG_DAMPENING)
-                  &&  bi->extra && bi->extra->damp_info )
-                if (bgp_damp_scan (bi, afi, SAFI_UNICAST))
-		  bgp_aggregate_increment (bgp, &rn->p, bi,
-					   afi, SAFI_UNICAST);
+              if (dampening && bi->extra && bi->extra->damp_info)
+		{
+		  process = 1;
+		  if (bgp_damp_scan (bi, afi, SAFI_UNICAST))
+		    bgp_aggregate_increment (bgp, &rn->p, bi,
+					     afi, SAFI_UNICAST);
+		}
 	    }
 	}
-      bgp_process (bgp, rn, afi, SAFI_UNICAST);
+      if (process)
+	bgp_process (bgp, rn, afi, SAFI_UNICAST);
     }
 
-  /* Flash old cache. */
-  if (bgp_nexthop_cache_table[afi] == cache1_table[afi])
-    bgp_nexthop_cache_reset (cache2_table[afi]);
-  else
-    bgp_nexthop_cache_reset (cache1_table[afi]);
-
   if (BGP_DEBUG (events, EVENTS))
     {
       if (afi == AFI_IP)
@@ -516,15 +774,40 @@ bgp_scan_timer (struct thread *t)
   if (BGP_DEBUG (events, EVENTS))
     zlog_debug ("Performing BGP general scanning");
 
-  bgp_scan (AFI_IP, SAFI_UNICAST);
+  bgp_scan (AFI_IP, SAFI_UNICAST, 0);
 
 #ifdef HAVE_IPV6
-  bgp_scan (AFI_IP6, SAFI_UNICAST);
+  bgp_scan (AFI_IP6, SAFI_UNICAST, 0);
 #endif /* HAVE_IPV6 */
 
   return 0;
 }
-
+
+/* Connected routes changed: check the nexthops of directly connected
+   peers again. */
+static int
+bgp_scan_connected (struct thread *t)
+{
+  bgp_connected_thread = NULL;
+
+  bgp_scan (AFI_IP, SAFI_UNICAST, 1);
+
+#ifdef HAVE_IPV6
+  bgp_scan (AFI_IP6, SAFI_UNICAST, 1);
+#endif /* HAVE_IPV6 */
+
+  return 0;
+}
+
+static void
+bgp_scan_connected_schedule (void)
+{
+  if (! bgp_connected_thread)
+    bgp_connected_thread =
+      thread_add_timer (master, bgp_scan_connected, NULL,
+			BGP_SCAN_CONNECTED_DELAY);
+}
+
 struct bgp_connected_ref
 {
   unsigned int refcnt;
@@ -549,6 +832,8 @@ bgp_connected_add (struct connected *ifc)
 
   addr = ifc->address;
 
+  bgp_scan_connected_schedule ();
+
   if (addr->family == AF_INET)
     {
       PREFIX_COPY_IPV4(&p, CONNECTED_PREFIX(ifc));
@@ -614,6 +899,8 @@ bgp_connected_delete (struct connected *ifc)
 
   addr = ifc->address;
 
+  bgp_scan_connected_schedule ();
+
   if (addr->family == AF_INET)
     {
       PREFIX_COPY_IPV4(&p, CONNECTED_PREFIX(ifc));
@@ -1192,13 +1479,17 @@ show_ip_bgp_scan_tables (struct vty *vty, const char detail)
   struct bgp_node *rn;
   struct bgp_nexthop_cache *bnc;
   char buf[INET6_ADDRSTRLEN];
-  u_char i;
+  struct nexthop *nexthop;
 
   if (bgp_scan_thread)
     vty_out (vty, "BGP scan is running%s", VTY_NEWLINE);
   else
     vty_out (vty, "BGP scan is not running%s", VTY_NEWLINE);
   vty_out (vty, "BGP scan interval is %d%s", bgp_scan_interval, VTY_NEWLINE);
+  if (bgp_nexthop_tracking ())
+    vty_out (vty, "Nexthops are tracked by zebra%s", VTY_NEWLINE);
+  else
+    vty_out (vty, "Nexthops are looked up again every scan%s", VTY_NEWLINE);
 
   vty_out (vty, "Current BGP nexthop cache:%s", VTY_NEWLINE);
   for (rn = bgp_table_top (bgp_nexthop_cache_table[AFI_IP]); rn; rn = bgp_route_next (rn))
@@ -1206,25 +1497,27 @@ show_ip_bgp_scan_tables (struct vty *vty, const char detail)
       {
 	if (bnc->valid)
 	{
-	  vty_out (vty, " %s valid [IGP metric %d]%s",
-		   inet_ntop (AF_INET, &rn->p.u.prefix4, buf, INET6_ADDRSTRLEN), bnc->metric, VTY_NEWLINE);
+	  vty_out (vty, " %s valid [IGP metric %d], %lu path(s), %lu change(s)%s",
+		   inet_ntop (AF_INET, &rn->p.u.prefix4, buf, INET6_ADDRSTRLEN), bnc->metric,
+		   bnc->path_count, bnc->updates, VTY_NEWLINE);
 	  if (detail)
-	    for (i = 0; i < bnc->nexthop_num; i++)
-	      switch (bnc->nexthop[i].type)
+	    for (nexthop = bnc->nexthop; nexthop; nexthop = nexthop->next)
+	      switch (nexthop->type)
 	      {
 	      case NEXTHOP_TYPE_IPV4:
-		vty_out (vty, "  gate %s%s", inet_ntop (AF_INET, &bnc->nexthop[i].gate.ipv4, buf, INET6_ADDRSTRLEN), VTY_NEWLINE);
+		vty_out (vty, "  gate %s%s", inet_ntop (AF_INET, &nexthop->gate.ipv4, buf, INET6_ADDRSTRLEN), VTY_NEWLINE);
 		break;
 	      case NEXTHOP_TYPE_IFINDEX:
-		vty_out (vty, "  ifidx %u%s", bnc->nexthop[i].ifindex, VTY_NEWLINE);
+		vty_out (vty, "  ifidx %u%s", nexthop->ifindex, VTY_NEWLINE);
 		break;
 	      default:
-		vty_out (vty, "  invalid nexthop type %u%s", bnc->nexthop[i].type, VTY_NEWLINE);
+		vty_out (vty, "  invalid nexthop type %u%s", nexthop->type, VTY_NEWLINE);
 	      }
 	}
 	else
-	  vty_out (vty, " %s invalid%s",
-		   inet_ntop (AF_INET, &rn->p.u.prefix4, buf, INET6_ADDRSTRLEN), VTY_NEWLINE);
+	  vty_out (vty, " %s invalid, %lu path(s), %lu change(s)%s",
+		   inet_ntop (AF_INET, &rn->p.u.prefix4, buf, INET6_ADDRSTRLEN),
+		   bnc->path_count, bnc->updates, VTY_NEWLINE);
       }
 
 #ifdef HAVE_IPV6
@@ -1236,27 +1529,27 @@ show_ip_bgp_scan_tables (struct vty *vty, const char detail)
 	{
 	  if (bnc->valid)
 	  {
-	    vty_out (vty, " %s valid [IGP metric %d]%s",
+	    vty_out (vty, " %s valid [IGP metric %d], %lu path(s), %lu change(s)%s",
 		     inet_ntop (AF_INET6, &rn->p.u.prefix6, buf, INET6_ADDRSTRLEN),
-		     bnc->metric, VTY_NEWLINE);
+		     bnc->metric, bnc->path_count, bnc->updates, VTY_NEWLINE);
 	    if (detail)
-	      for (i = 0; i < bnc->nexthop_num; i++)
-		switch (bnc->nexthop[i].type)
+	      for (nexthop = bnc->nexthop; nexthop; nexthop = nexthop->next)
+		switch (nexthop->type)
 		{
 		case NEXTHOP_TYPE_IPV6:
-		  vty_out (vty, "  gate %s%s", inet_ntop (AF_INET6, &bnc->nexthop[i].gate.ipv6, buf, INET6_ADDRSTRLEN), VTY_NEWLINE);
+		  vty_out (vty, "  gate %s%s", inet_ntop (AF_INET6, &nexthop->gate.ipv6, buf, INET6_ADDRSTRLEN), VTY_NEWLINE);
 		  break;
 		case NEXTHOP_TYPE_IFINDEX:
-		  vty_out (vty, "  ifidx %u%s", bnc->nexthop[i].ifindex, VTY_NEWLINE);
+		  vty_out (vty, "  ifidx %u%s", nexthop->ifindex, VTY_NEWLINE);
 		  break;
 		default:
-		  vty_out (vty, "  invalid nexthop type %u%s", bnc->nexthop[i].type, VTY_NEWLINE);
+		  vty_out (vty, "  invalid nexthop type %u%s", nexthop->type, VTY_NEWLINE);
 		}
 	  }
 	  else
-	    vty_out (vty, " %s invalid%s",
+	    vty_out (vty, " %s invalid, %lu path(s), %lu change(s)%s",
 		     inet_ntop (AF_INET6, &rn->p.u.prefix6, buf, INET6_ADDRSTRLEN),
-		     VTY_NEWLINE);
+		     bnc->path_count, bnc->updates, VTY_NEWLINE);
 	}
   }
 #endif /* HAVE_IPV6 */
@@ -1326,16 +1619,12 @@ bgp_scan_init (void)
   bgp_scan_interval = BGP_SCAN_INTERVAL_DEFAULT;
   bgp_import_interval = BGP_IMPORT_INTERVAL_DEFAULT;
 
-  cache1_table[AFI_IP] = bgp_table_init (AFI_IP, SAFI_UNICAST);
-  cache2_table[AFI_IP] = bgp_table_init (AFI_IP, SAFI_UNICAST);
-  bgp_nexthop_cache_table[AFI_IP] = cache1_table[AFI_IP];
+  bgp_nexthop_cache_table[AFI_IP] = bgp_table_init (AFI_IP, SAFI_UNICAST);
 
   bgp_connected_table[AFI_IP] = bgp_table_init (AFI_IP, SAFI_UNICAST);
 
 #ifdef HAVE_IPV6
-  cache1_table[AFI_IP6] = bgp_table_init (AFI_IP6, SAFI_UNICAST);
-  cache2_table[AFI_IP6] = bgp_table_init (AFI_IP6, SAFI_UNICAST);
-  bgp_nexthop_cache_table[AFI_IP6] = cache1_table[AFI_IP6];
+  bgp_nexthop_cache_table[AFI_IP6] = bgp_table_init (AFI_IP6, SAFI_UNICAST);
   bgp_connected_table[AFI_IP6] = bgp_table_init (AFI_IP6, SAFI_UNICAST);
 #endif /* HAVE_IPV6 */
 
@@ -1358,27 +1647,17 @@ bgp_scan_init (void)
 void
 bgp_scan_finish (void)
 {
-  /* Only the current one needs to be reset. */
   bgp_nexthop_cache_reset (bgp_nexthop_cache_table[AFI_IP]);
-
-  bgp_table_unlock (cache1_table[AFI_IP]);
-  cache1_table[AFI_IP] = NULL;
-
-  bgp_table_unlock (cache2_table[AFI_IP]);
-  cache2_table[AFI_IP] = NULL;
+  bgp_table_unlock (bgp_nexthop_cache_table[AFI_IP]);
+  bgp_nexthop_cache_table[AFI_IP] = NULL;
 
   bgp_table_unlock (bgp_connected_table[AFI_IP]);
   bgp_connected_table[AFI_IP] = NULL;
 
 #ifdef HAVE_IPV6
-  /* Only the current one needs to be reset. */
   bgp_nexthop_cache_reset (bgp_nexthop_cache_table[AFI_IP6]);
-
-  bgp_table_unlock (cache1_table[AFI_IP6]);
-  cache1_table[AFI_IP6] = NULL;
-
-  bgp_table_unlock (cache2_table[AFI_IP6]);
-  cache2_table[AFI_IP6] = NULL;
+  bgp_table_unlock (bgp_nexthop_cache_table[AFI_IP6]);
+  bgp_nexthop_cache_table[AFI_IP6] = NULL;
 
   bgp_table_unlock (bgp_connected_table[AFI_IP6]);
   bgp_connected_table[AFI_IP6] = NULL;
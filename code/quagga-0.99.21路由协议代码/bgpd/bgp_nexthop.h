@@ -22,10 +22,15 @@ Software Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
 #define _QUAGGA_BGP_NEXTHOP_H
 
 #include "if.h"
+#include "zclient.h"
 
 #define BGP_SCAN_INTERVAL_DEFAULT   60
 #define BGP_IMPORT_INTERVAL_DEFAULT 15
 
+/* Seconds to wait after a connected route change before checking
+   directly connected peers' nexthops again. */
+#define BGP_SCAN_CONNECTED_DELAY    1
+
 /* BGP nexthop cache value structure. */
 struct bgp_nexthop_cache
 {
@@ -44,12 +49,28 @@ struct bgp_nexthop_cache
   /* Nexthop number and nexthop linked list.*/
   u_char nexthop_num;
   struct nexthop *nexthop;
+
+  /* Node in the nexthop cache. */
+  struct bgp_node *node;
+
+  /* Zebra has been asked to send changes. */
+  u_char registered;
+
+  /* Paths depending on this nexthop, through bgp_info->nh_next. */
+  struct bgp_info *paths;
+  unsigned long path_count;
+
+  /* Number of changes zebra has sent. */
+  unsigned long updates;
 };
 
 extern void bgp_scan_init (void);
 extern void bgp_scan_finish (void);
 extern int bgp_nexthop_lookup (afi_t, struct peer *peer, struct bgp_info *,
 			int *, int *);
+extern void bgp_nexthop_path_unlink (struct bgp_info *);
+extern int bgp_nexthop_update (int, struct zclient *, uint16_t);
+extern void bgp_nexthop_register_all (struct zclient *);
 extern void bgp_connected_add (struct connected *c);
 extern void bgp_connected_delete (struct connected *c);
 extern int bgp_multiaccess_check_v4 (struct in_addr, char *);
@@ -45,6 +45,7 @@ Software Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
 #include "bgpd/bgp_ecommunity.h"
 #include "bgpd/bgp_network.h"
 #include "bgpd/bgp_mplsvpn.h"
+#include "bgpd/bgp_updgrp.h"
 #include "bgpd/bgp_advertise.h"
 #include "bgpd/bgp_vty.h"
 
@@ -147,6 +148,13 @@ bgp_update_packet (struct peer *peer, afi_t afi, safi_t safi)
   struct stream *packet;
   struct bgp_node *rn = NULL;
   struct bgp_info *binfo = NULL;
+  struct bgp_updgrp *group;
+  struct attr *attr = NULL;
+  struct peer *from = NULL;
+  static struct bgp_node *encoded[BGP_MAX_PACKET_SIZE];
+  unsigned int count = 0;
+  unsigned int shared = 0;
+  int full = 0;
   bgp_size_t total_attr_len = 0;
   unsigned long pos;
   char buf[BUFSIZ];
@@ -155,6 +163,12 @@ bgp_update_packet (struct peer *peer, afi_t afi, safi_t safi)
   stream_reset (s);
 
   adv = FIFO_HEAD (&peer->sync[afi][safi]->update);
+  if (! adv)
+    return NULL;
+
+  /* Another member of the update group may have sent the same. */
+  group = bgp_updgrp_check (peer, afi, safi);
+  packet = bgp_updgrp_packet_find (group, adv, &shared);
 
   while (adv)
     {
@@ -164,16 +178,24 @@ bgp_update_packet (struct peer *peer, afi_t afi, safi_t safi)
       if (adv->binfo)
         binfo = adv->binfo;
 
+      if (packet)
+	{
+	  /* Exactly the advertisements that went into the packet. */
+	  if (count == shared)
+	    break;
+	}
       /* When remaining space can't include NLRI and it's length.  */
-      if (STREAM_REMAIN (s) <= BGP_NLRI_LENGTH + PSIZE (rn->p.prefixlen))
-	break;
+      else if (STREAM_REMAIN (s) <= BGP_NLRI_LENGTH + PSIZE (rn->p.prefixlen))
+	{
+	  full = 1;
+	  break;
+	}
 
       /* If packet is empty, set attribute. */
-      if (stream_empty (s))
+      if (! packet && stream_empty (s))
 	{
 	  struct prefix_rd *prd = NULL;
 	  u_char *tag = NULL;
-	  struct peer *from = NULL;
 	  
 	  if (rn->prn)
 	    prd = (struct prefix_rd *) &rn->prn->p;
@@ -183,6 +205,7 @@ bgp_update_packet (struct peer *peer, afi_t afi, safi_t safi)
               if (binfo->extra)
                 tag = binfo->extra->tag;
             }
+          attr = adv->baa->attr;
           
 	  bgp_packet_set_marker (s, BGP_MSG_UPDATE);
 	  stream_putw (s, 0);		
@@ -195,8 +218,9 @@ bgp_update_packet (struct peer *peer, afi_t afi, safi_t safi)
 	  stream_putw_at (s, pos, total_attr_len);
 	}
 
-      if (afi == AFI_IP && safi == SAFI_UNICAST)
+      if (! packet && afi == AFI_IP && safi == SAFI_UNICAST)
 	stream_put_prefix (s, &rn->p);
+      encoded[count++] = rn;
       
       if (BGP_DEBUG (update, UPDATE_OUT))
 	zlog (peer->log, LOG_DEBUG, "%s send UPDATE %s/%d",
@@ -217,11 +241,20 @@ bgp_update_packet (struct peer *peer, afi_t afi, safi_t safi)
       if (! (afi == AFI_IP && safi == SAFI_UNICAST))
 	break;
     }
-	 
+
+  if (packet)
+    {
+      packet = stream_ref (packet);
+      bgp_packet_add (peer, packet);
+      BGP_WRITE_ON (peer->t_write, bgp_write, peer->fd);
+      return packet;
+    }
+
   if (! stream_empty (s))
     {
       bgp_packet_set_size (s);
-      packet = stream_dup (s);
+      packet = bgp_updgrp_packet_add (group, attr, from, encoded, count,
+                                      full, stream_dup (s));
       bgp_packet_add (peer, packet);
       BGP_WRITE_ON (peer->t_write, bgp_write, peer->fd);
       stream_reset (s);
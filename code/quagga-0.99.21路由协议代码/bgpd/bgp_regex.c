@@ -23,6 +23,7 @@ Software Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
 #include "log.h"
 #include "command.h"
 #include "memory.h"
+#include "jhash.h"
 
 #include "bgpd.h"
 #include "bgp_aspath.h"
@@ -82,7 +83,7 @@ bgp_regcomp (const char *regstr)
 int
 bgp_regexec (regex_t *regex, struct aspath *aspath)
 {
-  return regexec (regex, aspath->str, 0, NULL, 0);
+  return regexec (regex, aspath_print (aspath), 0, NULL, 0);
 }
 
 void
@@ -91,3 +92,59 @@ bgp_regex_free (regex_t *regex)
   regfree (regex);
   XFREE (MTYPE_BGP_REGEXP, regex);
 }
+
+static unsigned int
+bgp_regex_memo_index (void *attr)
+{
+  return jhash_1word ((uintptr_t) attr >> 4, 0) % BGP_REGEX_MEMO_SIZE;
+}
+
+/* Look ATTR up in *MEMO, which is allocated on first use.  Return 1
+   and set *MATCH if its result is there. */
+int
+bgp_regex_memo_lookup (struct bgp_regex_memo **memo, void *attr, int *match)
+{
+  unsigned int index;
+
+  if (*memo == NULL)
+    *memo = XCALLOC (MTYPE_BGP_REGEXP_MEMO, sizeof (struct bgp_regex_memo));
+
+  index = bgp_regex_memo_index (attr);
+  if ((*memo)->slot[index].attr != attr)
+    {
+      (*memo)->misses++;
+      return 0;
+    }
+
+  (*memo)->hits++;
+  *match = (*memo)->slot[index].match;
+  return 1;
+}
+
+/* Record the result for ATTR, on which the caller has taken a
+   reference for MEMO.  Return the attribute it displaces, if any, whose
+   reference the caller should drop. */
+void *
+bgp_regex_memo_store (struct bgp_regex_memo *memo, void *attr, int match)
+{
+  unsigned int index;
+  void *old;
+
+  index = bgp_regex_memo_index (attr);
+  old = memo->slot[index].attr;
+  memo->slot[index].attr = attr;
+  memo->slot[index].match = match;
+  return old;
+}
+
+/* Free MEMO, dropping the references it holds with RELEASE. */
+void
+bgp_regex_memo_free (struct bgp_regex_memo *memo, void (*release) (void *))
+{
+  int i;
+
+  for (i = 0; i < BGP_REGEX_MEMO_SIZE; i++)
+    if (memo->slot[i].attr)
+      (*release) (memo->slot[i].attr);
+  XFREE (MTYPE_BGP_REGEXP_MEMO, memo);
+}
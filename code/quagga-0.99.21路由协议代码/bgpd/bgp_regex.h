@@ -33,8 +33,31 @@ Software Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
 # endif /* HAVE_GNU_REGEX */
 #endif /* HAVE_LIBPCREPOSIX */
 
+/* A filter regexp's results for the interned attributes it was last
+   run against, so that one shared by many routes is matched once.  Each
+   slot holds a reference to its attribute, so the pointer cannot be
+   reused for another attribute while it is cached. */
+#define BGP_REGEX_MEMO_SIZE 256
+
+struct bgp_regex_memo
+{
+  struct
+  {
+    void *attr;
+    int match;
+  } slot[BGP_REGEX_MEMO_SIZE];
+
+  unsigned long hits;
+  unsigned long misses;
+};
+
 extern void bgp_regex_free (regex_t *regex);
 extern regex_t *bgp_regcomp (const char *str);
 extern int bgp_regexec (regex_t *regex, struct aspath *aspath);
 
+extern int bgp_regex_memo_lookup (struct bgp_regex_memo **, void *, int *);
+extern void *bgp_regex_memo_store (struct bgp_regex_memo *, void *, int);
+extern void bgp_regex_memo_free (struct bgp_regex_memo *,
+				 void (*) (void *));
+
 #endif /* _QUAGGA_BGP_REGEX_H */
@@ -59,6 +59,7 @@ Software Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
 /* Extern from bgp_dump.c */
 extern const char *bgp_origin_str[];
 extern const char *bgp_origin_long_str[];
+extern struct zclient *zclient;
 
 static struct bgp_node *
 bgp_afi_node_get (struct bgp_table *table, afi_t afi, safi_t safi, struct prefix *p,
@@ -142,6 +143,7 @@ bgp_info_free (struct bgp_info *binfo)
   
   bgp_info_extra_free (&binfo->extra);
   bgp_info_mpath_free (&binfo->mpath);
+  bgp_nexthop_path_unlink (binfo);
 
   peer_unlock (binfo->peer); /* bgp_info peer reference */
 
@@ -194,6 +196,7 @@ bgp_info_add (struct bgp_node *rn, struct bgp_info *ri)
   if (top)
     top->prev = ri;
   rn->info = ri;
+  ri->net = rn;
   
   bgp_info_lock (ri);
   bgp_lock_node (rn);
@@ -1568,6 +1571,7 @@ bgp_process_main (struct work_queue *wq, void *data)
 	      CHECK_FLAG (old_select->flags, BGP_INFO_MULTIPATH_CHG))
             bgp_zebra_announce (p, old_select, bgp, safi);
           
+	  UNSET_FLAG (old_select->flags, BGP_INFO_IGP_CHANGED);
 	  UNSET_FLAG (old_select->flags, BGP_INFO_MULTIPATH_CHG);
           UNSET_FLAG (rn->flags, BGP_NODE_PROCESS_SCHEDULED);
           return WQ_SUCCESS;
@@ -1580,6 +1584,7 @@ bgp_process_main (struct work_queue *wq, void *data)
     {
       bgp_info_set_flag (rn, new_select, BGP_INFO_SELECTED);
       bgp_info_unset_flag (rn, new_select, BGP_INFO_ATTR_CHANGED);
+      UNSET_FLAG (new_select->flags, BGP_INFO_IGP_CHANGED);
       UNSET_FLAG (new_select->flags, BGP_INFO_MULTIPATH_CHG);
     }
 
@@ -1628,6 +1633,15 @@ bgp_processq_del (struct work_queue *wq, void *data)
   XFREE (MTYPE_BGP_PROCESS_QUEUE, pq);
 }
 
+/* The routes processed have all been announced to zebra: write them out
+   now, rather than once the other threads ready to run have run. */
+static void
+bgp_processq_done (struct work_queue *wq)
+{
+  if (zclient)
+    zclient_flush (zclient);
+}
+
 static void
 bgp_process_queue_init (void)
 {
@@ -1644,6 +1658,7 @@ bgp_process_queue_init (void)
   
   bm->process_main_queue->spec.workfunc = &bgp_process_main;
   bm->process_main_queue->spec.del_item_data = &bgp_processq_del;
+  bm->process_main_queue->spec.completion_func = &bgp_processq_done;
   bm->process_main_queue->spec.max_retries = 0;
   bm->process_main_queue->spec.hold = 50;
   
@@ -2285,7 +2300,10 @@ bgp_update_main (struct peer *peer, struct prefix *p, struct attr *attr,
 	    bgp_info_unset_flag (rn, ri, BGP_INFO_VALID);
 	}
       else
-        bgp_info_set_flag (rn, ri, BGP_INFO_VALID);
+	{
+	  bgp_nexthop_path_unlink (ri);
+	  bgp_info_set_flag (rn, ri, BGP_INFO_VALID);
+	}
 
       /* Process change. */
       bgp_aggregate_increment (bgp, p, ri, afi, safi);
@@ -93,6 +93,15 @@ struct bgp_info
 #define BGP_ROUTE_STATIC       1
 #define BGP_ROUTE_AGGREGATE    2
 #define BGP_ROUTE_REDISTRIBUTE 3 
+
+  /* Node this is on. */
+  struct bgp_node *net;
+
+  /* Nexthop cache entry this path's reachability comes from, and the
+     other paths using it. */
+  struct bgp_nexthop_cache *nexthop;
+  struct bgp_info *nh_next;
+  struct bgp_info *nh_prev;
 };
 
 /* BGP static route configuration. */
@@ -364,7 +364,7 @@ route_match_ip_address_prefix_list (void *rule, struct prefix *prefix,
 
   if (type == RMAP_BGP)
     {
-      plist = prefix_list_lookup (AFI_IP, (char *) rule);
+      plist = ((struct prefix_list_ref *) rule)->plist;
       if (plist == NULL)
 	return RMAP_NOMATCH;
     
@@ -377,13 +377,13 @@ route_match_ip_address_prefix_list (void *rule, struct prefix *prefix,
 static void *
 route_match_ip_address_prefix_list_compile (const char *arg)
 {
-  return XSTRDUP (MTYPE_ROUTE_MAP_COMPILED, arg);
+  return prefix_list_ref_get (AFI_IP, arg);
 }
 
 static void
 route_match_ip_address_prefix_list_free (void *rule)
 {
-  XFREE (MTYPE_ROUTE_MAP_COMPILED, rule);
+  prefix_list_ref_put (rule);
 }
 
 struct route_map_rule_cmd route_match_ip_address_prefix_list_cmd =
@@ -411,7 +411,7 @@ route_match_ip_next_hop_prefix_list (void *rule, struct prefix *prefix,
       p.prefix = bgp_info->attr->nexthop;
       p.prefixlen = IPV4_MAX_BITLEN;
 
-      plist = prefix_list_lookup (AFI_IP, (char *) rule);
+      plist = ((struct prefix_list_ref *) rule)->plist;
       if (plist == NULL)
         return RMAP_NOMATCH;
 
@@ -424,13 +424,13 @@ route_match_ip_next_hop_prefix_list (void *rule, struct prefix *prefix,
 static void *
 route_match_ip_next_hop_prefix_list_compile (const char *arg)
 {
-  return XSTRDUP (MTYPE_ROUTE_MAP_COMPILED, arg);
+  return prefix_list_ref_get (AFI_IP, arg);
 }
 
 static void
 route_match_ip_next_hop_prefix_list_free (void *rule)
 {
-  XFREE (MTYPE_ROUTE_MAP_COMPILED, rule);
+  prefix_list_ref_put (rule);
 }
 
 struct route_map_rule_cmd route_match_ip_next_hop_prefix_list_cmd =
@@ -464,7 +464,7 @@ route_match_ip_route_source_prefix_list (void *rule, struct prefix *prefix,
       p.prefix = peer->su.sin.sin_addr;
       p.prefixlen = IPV4_MAX_BITLEN;
 
-      plist = prefix_list_lookup (AFI_IP, (char *) rule);
+      plist = ((struct prefix_list_ref *) rule)->plist;
       if (plist == NULL)
         return RMAP_NOMATCH;
 
@@ -477,13 +477,13 @@ route_match_ip_route_source_prefix_list (void *rule, struct prefix *prefix,
 static void *
 route_match_ip_route_source_prefix_list_compile (const char *arg)
 {
-  return XSTRDUP (MTYPE_ROUTE_MAP_COMPILED, arg);
+  return prefix_list_ref_get (AFI_IP, arg);
 }
 
 static void
 route_match_ip_route_source_prefix_list_free (void *rule)
 {
-  XFREE (MTYPE_ROUTE_MAP_COMPILED, rule);
+  prefix_list_ref_put (rule);
 }
 
 struct route_map_rule_cmd route_match_ip_route_source_prefix_list_cmd =
@@ -572,7 +572,7 @@ route_match_aspath (void *rule, struct prefix *prefix,
 
   if (type == RMAP_BGP)
     {
-      as_list = as_list_lookup ((char *) rule);
+      as_list = ((struct as_list_ref *) rule)->aslist;
       if (as_list == NULL)
 	return RMAP_NOMATCH;
     
@@ -588,14 +588,14 @@ route_match_aspath (void *rule, struct prefix *prefix,
 static void *
 route_match_aspath_compile (const char *arg)
 {
-  return XSTRDUP (MTYPE_ROUTE_MAP_COMPILED, arg);
+  return as_list_ref_get (arg);
 }
 
 /* Compile function for as-path match. */
 static void
 route_match_aspath_free (void *rule)
 {
-  XFREE (MTYPE_ROUTE_MAP_COMPILED, rule);
+  as_list_ref_put (rule);
 }
 
 /* Route map commands for aspath matching. */
@@ -1931,7 +1931,7 @@ route_match_ipv6_address_prefix_list (void *rule, struct prefix *prefix,
 
   if (type == RMAP_BGP)
     {
-      plist = prefix_list_lookup (AFI_IP6, (char *) rule);
+      plist = ((struct prefix_list_ref *) rule)->plist;
       if (plist == NULL)
 	return RMAP_NOMATCH;
     
@@ -1944,13 +1944,13 @@ route_match_ipv6_address_prefix_list (void *rule, struct prefix *prefix,
 static void *
 route_match_ipv6_address_prefix_list_compile (const char *arg)
 {
-  return XSTRDUP (MTYPE_ROUTE_MAP_COMPILED, arg);
+  return prefix_list_ref_get (AFI_IP6, arg);
 }
 
 static void
 route_match_ipv6_address_prefix_list_free (void *rule)
 {
-  XFREE (MTYPE_ROUTE_MAP_COMPILED, rule);
+  prefix_list_ref_put (rule);
 }
 
 struct route_map_rule_cmd route_match_ipv6_address_prefix_list_cmd =
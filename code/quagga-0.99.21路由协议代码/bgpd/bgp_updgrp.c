@@ -0,0 +1,473 @@
+/* BGP update groups
+ *
+ * This file is part of GNU Zebra.
+ *
+ * GNU Zebra is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2, or (at your option) any
+ * later version.
+ *
+ * GNU Zebra is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Zebra; see the file COPYING.  If not, write to the Free
+ * Software Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ */
+
+/* Peers whose outbound policy, capabilities and AS4 mode are the same
+ * get the same UPDATEs, byte for byte, for the same advertisements.
+ * Such peers are put in an update group.  Whichever member gets to
+ * send first encodes the UPDATE and leaves it with the group; members
+ * that come to send the same prefixes with the same attribute after it
+ * queue a reference to that packet instead of encoding it again.
+ *
+ * Members are kept in the group they belong in by bgp_updgrp_check(),
+ * which bgp_update_packet() calls before it builds anything, so a
+ * configuration change moves a peer on its next UPDATE.
+ */
+
+#include <zebra.h>
+
+#include "command.h"
+#include "linklist.h"
+#include "memory.h"
+#include "prefix.h"
+#include "stream.h"
+#include "plist.h"
+
+#include "bgpd/bgpd.h"
+#include "bgpd/bgp_table.h"
+#include "bgpd/bgp_attr.h"
+#include "bgpd/bgp_advertise.h"
+#include "bgpd/bgp_route.h"
+#include "bgpd/bgp_vty.h"
+#include "bgpd/bgp_updgrp.h"
+
+/* Per AF flags that make no difference to what a peer is sent. */
+#define BGP_UPDGRP_AF_FLAGS_INBOUND                     \
+  (PEER_FLAG_SOFT_RECONFIG | PEER_FLAG_ALLOWAS_IN       \
+   | PEER_FLAG_ORF_PREFIX_SM | PEER_FLAG_ORF_PREFIX_RM  \
+   | PEER_FLAG_MAX_PREFIX | PEER_FLAG_MAX_PREFIX_WARNING)
+
+static unsigned int bgp_updgrp_id;
+
+static void
+bgp_updgrp_key_make (struct peer *peer, afi_t afi, safi_t safi,
+                     struct bgp_updgrp_key *key)
+{
+  struct bgp_filter *filter = &peer->filter[afi][safi];
+
+  memset (key, 0, sizeof (struct bgp_updgrp_key));
+  key->afi = afi;
+  key->safi = safi;
+  key->sort = peer_sort (peer);
+  key->as4 = CHECK_FLAG (peer->cap, PEER_CAP_AS4_RCV) ? 1 : 0;
+  key->local_as = peer->local_as;
+  key->change_local_as = peer->change_local_as;
+  key->flags = peer->flags & PEER_FLAG_LOCAL_AS_NO_PREPEND;
+  key->af_flags = peer->af_flags[afi][safi] & ~BGP_UPDGRP_AF_FLAGS_INBOUND;
+  key->af_sflags = peer->af_sflags[afi][safi]
+                   & PEER_STATUS_DEFAULT_ORIGINATE;
+  key->nexthop = peer->nexthop;
+  key->shared_network = peer->shared_network;
+  key->orf_plist = peer->orf_plist[afi][safi];
+
+  key->dlist = filter->dlist[FILTER_OUT].name;
+  key->plist = filter->plist[FILTER_OUT].name;
+  key->aslist = filter->aslist[FILTER_OUT].name;
+  key->rmap = filter->map[RMAP_OUT].name;
+  key->usmap = filter->usmap.name;
+}
+
+static int
+bgp_updgrp_name_same (const char *a, const char *b)
+{
+  if (a == NULL || b == NULL)
+    return a == b;
+  return strcmp (a, b) == 0;
+}
+
+static int
+bgp_updgrp_key_same (struct bgp_updgrp_key *a, struct bgp_updgrp_key *b)
+{
+  return (a->afi == b->afi
+          && a->safi == b->safi
+          && a->sort == b->sort
+          && a->as4 == b->as4
+          && a->local_as == b->local_as
+          && a->change_local_as == b->change_local_as
+          && a->flags == b->flags
+          && a->af_flags == b->af_flags
+          && a->af_sflags == b->af_sflags
+          && a->nexthop.ifp == b->nexthop.ifp
+          && IPV4_ADDR_SAME (&a->nexthop.v4, &b->nexthop.v4)
+#ifdef HAVE_IPV6
+          && IPV6_ADDR_SAME (&a->nexthop.v6_global, &b->nexthop.v6_global)
+          && IPV6_ADDR_SAME (&a->nexthop.v6_local, &b->nexthop.v6_local)
+#endif /* HAVE_IPV6 */
+          && a->shared_network == b->shared_network
+          && a->orf_plist == b->orf_plist
+          && bgp_updgrp_name_same (a->dlist, b->dlist)
+          && bgp_updgrp_name_same (a->plist, b->plist)
+          && bgp_updgrp_name_same (a->aslist, b->aslist)
+          && bgp_updgrp_name_same (a->rmap, b->rmap)
+          && bgp_updgrp_name_same (a->usmap, b->usmap));
+}
+
+static char *
+bgp_updgrp_name_dup (const char *name)
+{
+  return name ? XSTRDUP (MTYPE_BGP_UPDGRP, name) : NULL;
+}
+
+static void
+bgp_updgrp_name_free (char *name)
+{
+  if (name)
+    XFREE (MTYPE_BGP_UPDGRP, name);
+}
+
+static unsigned int
+bgp_updgrp_hash_index (struct bgp_node *rn)
+{
+  return ((unsigned long) rn >> 4) % BGP_UPDGRP_HASH_SIZE;
+}
+
+static void
+bgp_updgrp_packet_free (struct bgp_updgrp *group,
+                        struct bgp_updgrp_packet *pkt)
+{
+  struct bgp_updgrp_packet **pp;
+  unsigned int i;
+
+  for (pp = &group->hash[bgp_updgrp_hash_index (pkt->rn[0])]; *pp;
+       pp = &(*pp)->hnext)
+    if (*pp == pkt)
+      {
+        *pp = pkt->hnext;
+        break;
+      }
+
+  for (i = 0; i < pkt->count; i++)
+    bgp_unlock_node (pkt->rn[i]);
+  bgp_attr_unintern (&pkt->attr);
+  stream_free (pkt->packet);
+  XFREE (MTYPE_BGP_UPDGRP_PACKET, pkt->rn);
+  XFREE (MTYPE_BGP_UPDGRP_PACKET, pkt);
+}
+
+/* Drop all the UPDATEs the group keeps. */
+static void
+bgp_updgrp_cache_flush (struct bgp_updgrp *group)
+{
+  unsigned int i;
+
+  for (i = 0; i < BGP_UPDGRP_CACHE_SIZE; i++)
+    if (group->cache[i])
+      {
+        bgp_updgrp_packet_free (group, group->cache[i]);
+        group->cache[i] = NULL;
+      }
+  group->cache_next = 0;
+}
+
+static struct bgp_updgrp *
+bgp_updgrp_new (struct bgp *bgp, struct bgp_updgrp_key *key)
+{
+  struct bgp_updgrp *group;
+
+  group = XCALLOC (MTYPE_BGP_UPDGRP, sizeof (struct bgp_updgrp));
+  group->id = ++bgp_updgrp_id;
+  group->bgp = bgp;
+  group->key = *key;
+  group->key.dlist = bgp_updgrp_name_dup (key->dlist);
+  group->key.plist = bgp_updgrp_name_dup (key->plist);
+  group->key.aslist = bgp_updgrp_name_dup (key->aslist);
+  group->key.rmap = bgp_updgrp_name_dup (key->rmap);
+  group->key.usmap = bgp_updgrp_name_dup (key->usmap);
+  group->peer = list_new ();
+
+  listnode_add (bgp->update_groups, group);
+  return group;
+}
+
+static void
+bgp_updgrp_free (struct bgp_updgrp *group)
+{
+  bgp_updgrp_cache_flush (group);
+  listnode_delete (group->bgp->update_groups, group);
+  list_delete (group->peer);
+  bgp_updgrp_name_free (group->key.dlist);
+  bgp_updgrp_name_free (group->key.plist);
+  bgp_updgrp_name_free (group->key.aslist);
+  bgp_updgrp_name_free (group->key.rmap);
+  bgp_updgrp_name_free (group->key.usmap);
+  XFREE (MTYPE_BGP_UPDGRP, group);
+}
+
+/* Take PEER out of its update group for AFI/SAFI. */
+void
+bgp_updgrp_leave (struct peer *peer, afi_t afi, safi_t safi)
+{
+  struct bgp_updgrp *group = peer->updgrp[afi][safi];
+
+  if (! group)
+    return;
+
+  peer->updgrp[afi][safi] = NULL;
+  listnode_delete (group->peer, peer);
+
+  if (listcount (group->peer) == 0)
+    bgp_updgrp_free (group);
+  else if (listcount (group->peer) == 1)
+    bgp_updgrp_cache_flush (group);
+}
+
+/* Take PEER out of all its update groups, and forget the UPDATEs
+   any group kept for routes from it. */
+void
+bgp_updgrp_leave_all (struct peer *peer)
+{
+  struct bgp_updgrp *group;
+  struct listnode *node;
+  afi_t afi;
+  safi_t safi;
+  unsigned int i;
+
+  for (afi = AFI_IP; afi < AFI_MAX; afi++)
+    for (safi = SAFI_UNICAST; safi < SAFI_MAX; safi++)
+      bgp_updgrp_leave (peer, afi, safi);
+
+  if (! peer->bgp)
+    return;
+
+  for (ALL_LIST_ELEMENTS_RO (peer->bgp->update_groups, node, group))
+    for (i = 0; i < BGP_UPDGRP_CACHE_SIZE; i++)
+      if (group->cache[i] && group->cache[i]->from == peer)
+        {
+          bgp_updgrp_packet_free (group, group->cache[i]);
+          group->cache[i] = NULL;
+        }
+}
+
+/* Return the update group PEER belongs in for AFI/SAFI, moving it
+   there if its configuration has changed. */
+struct bgp_updgrp *
+bgp_updgrp_check (struct peer *peer, afi_t afi, safi_t safi)
+{
+  struct bgp_updgrp_key key;
+  struct bgp_updgrp *group;
+  struct listnode *node;
+
+  bgp_updgrp_key_make (peer, afi, safi, &key);
+
+  group = peer->updgrp[afi][safi];
+  if (group && bgp_updgrp_key_same (&group->key, &key))
+    return group;
+
+  bgp_updgrp_leave (peer, afi, safi);
+
+  for (ALL_LIST_ELEMENTS_RO (peer->bgp->update_groups, node, group))
+    if (bgp_updgrp_key_same (&group->key, &key))
+      break;
+
+  if (! node)
+    group = bgp_updgrp_new (peer->bgp, &key);
+
+  listnode_add (group->peer, peer);
+  peer->updgrp[afi][safi] = group;
+  return group;
+}
+
+/* Look for an UPDATE another member encoded for the advertisements
+   starting at ADV, which bgp_update_packet() would put in one UPDATE:
+   ADV itself and then the others with the same attribute, in order.
+   If there is one, COUNT is set to how many advertisements it covers. */
+struct stream *
+bgp_updgrp_packet_find (struct bgp_updgrp *group, struct bgp_advertise *adv,
+                        unsigned int *count)
+{
+  struct bgp_updgrp_packet *pkt;
+  struct bgp_advertise *next;
+  struct peer *from;
+  unsigned int i;
+
+  if (listcount (group->peer) < 2 || group->key.safi == SAFI_MPLS_VPN)
+    return NULL;
+  if (! adv->baa || ! adv->baa->attr)
+    return NULL;
+
+  from = adv->binfo ? adv->binfo->peer : NULL;
+
+  for (pkt = group->hash[bgp_updgrp_hash_index (adv->rn)]; pkt;
+       pkt = pkt->hnext)
+    {
+      if (pkt->rn[0] != adv->rn || pkt->attr != adv->baa->attr
+          || pkt->from != from)
+        continue;
+
+      i = 1;
+      for (next = adv->baa->adv; next; next = next->next)
+        {
+          if (next == adv)
+            continue;
+          if (i == pkt->count || next->rn != pkt->rn[i])
+            break;
+          i++;
+        }
+
+      /* Same prefixes, and no more than would have fitted. */
+      if (i == pkt->count && (! next || pkt->full))
+        {
+          group->shared++;
+          group->prefix_shared += pkt->count;
+          *count = pkt->count;
+          return pkt->packet;
+        }
+    }
+
+  return NULL;
+}
+
+/* PACKET has just been encoded for a member of GROUP, from COUNT
+   advertisements of prefixes RN with attribute ATTR, for routes from
+   FROM.  Keep it for the other members if there are any.  Returns the
+   stream to queue on the member. */
+struct stream *
+bgp_updgrp_packet_add (struct bgp_updgrp *group, struct attr *attr,
+                       struct peer *from, struct bgp_node **rn,
+                       unsigned int count, int full, struct stream *packet)
+{
+  struct bgp_updgrp_packet *pkt;
+  unsigned int index;
+  unsigned int i;
+
+  group->encoded++;
+  group->prefix_encoded += count;
+
+  if (listcount (group->peer) < 2 || group->key.safi == SAFI_MPLS_VPN
+      || ! attr || count == 0)
+    return packet;
+
+  if (group->cache[group->cache_next])
+    bgp_updgrp_packet_free (group, group->cache[group->cache_next]);
+
+  pkt = XCALLOC (MTYPE_BGP_UPDGRP_PACKET, sizeof (struct bgp_updgrp_packet));
+  pkt->attr = bgp_attr_intern (attr);
+  pkt->from = from;
+  pkt->rn = XMALLOC (MTYPE_BGP_UPDGRP_PACKET,
+                     count * sizeof (struct bgp_node *));
+  for (i = 0; i < count; i++)
+    pkt->rn[i] = bgp_lock_node (rn[i]);
+  pkt->count = count;
+  pkt->full = full;
+  pkt->packet = packet;
+
+  index = bgp_updgrp_hash_index (rn[0]);
+  pkt->hnext = group->hash[index];
+  group->hash[index] = pkt;
+
+  group->cache[group->cache_next] = pkt;
+  group->cache_next = (group->cache_next + 1) % BGP_UPDGRP_CACHE_SIZE;
+
+  return stream_ref (packet);
+}
+
+static const char *
+bgp_updgrp_sort_str (int sort)
+{
+  switch (sort)
+    {
+    case BGP_PEER_IBGP:
+      return "internal";
+    case BGP_PEER_EBGP:
+      return "external";
+    case BGP_PEER_CONFED:
+      return "confederation";
+    default:
+      return "unknown";
+    }
+}
+
+static void
+bgp_updgrp_show_one (struct vty *vty, struct bgp_updgrp *group)
+{
+  struct bgp_updgrp_key *key = &group->key;
+  struct listnode *node;
+  struct peer *peer;
+  unsigned int cached = 0;
+  unsigned int i;
+  int col;
+
+  for (i = 0; i < BGP_UPDGRP_CACHE_SIZE; i++)
+    if (group->cache[i])
+      cached++;
+
+  vty_out (vty, "Update group %u, %s%s", group->id,
+           afi_safi_print (key->afi, key->safi), VTY_NEWLINE);
+  vty_out (vty, "  %s peers, %s AS, local AS %u", bgp_updgrp_sort_str (key->sort),
+           key->as4 ? "4-octet" : "2-octet", key->local_as);
+  if (key->change_local_as)
+    vty_out (vty, " (local-as %u)", key->change_local_as);
+  vty_out (vty, "%s", VTY_NEWLINE);
+  vty_out (vty, "  Next hop %s%s", inet_ntoa (key->nexthop.v4), VTY_NEWLINE);
+  if (key->rmap)
+    vty_out (vty, "  Outbound route-map %s%s", key->rmap, VTY_NEWLINE);
+  if (key->plist)
+    vty_out (vty, "  Outbound prefix-list %s%s", key->plist, VTY_NEWLINE);
+  if (key->dlist)
+    vty_out (vty, "  Outbound distribute-list %s%s", key->dlist, VTY_NEWLINE);
+  if (key->aslist)
+    vty_out (vty, "  Outbound filter-list %s%s", key->aslist, VTY_NEWLINE);
+  if (key->usmap)
+    vty_out (vty, "  Unsuppress-map %s%s", key->usmap, VTY_NEWLINE);
+  vty_out (vty, "  Packets encoded %lu (%lu prefixes), shared %lu (%lu prefixes), "
+           "%u kept%s", group->encoded, group->prefix_encoded,
+           group->shared, group->prefix_shared, cached, VTY_NEWLINE);
+  vty_out (vty, "  Members (%u):", listcount (group->peer));
+  col = 0;
+  for (ALL_LIST_ELEMENTS_RO (group->peer, node, peer))
+    {
+      if (col++ % 4 == 0)
+        vty_out (vty, "%s   ", VTY_NEWLINE);
+      vty_out (vty, " %-17s", peer->host);
+    }
+  vty_out (vty, "%s%s", VTY_NEWLINE, VTY_NEWLINE);
+}
+
+DEFUN (show_ip_bgp_update_groups,
+       show_ip_bgp_update_groups_cmd,
+       "show ip bgp update-groups",
+       SHOW_STR
+       IP_STR
+       BGP_STR
+       "Update groups\n")
+{
+  struct bgp *bgp;
+  struct bgp_updgrp *group;
+  struct listnode *node;
+
+  bgp = bgp_get_default ();
+  if (! bgp)
+    {
+      vty_out (vty, "No BGP process is configured%s", VTY_NEWLINE);
+      return CMD_WARNING;
+    }
+
+  for (ALL_LIST_ELEMENTS_RO (bgp->update_groups, node, group))
+    bgp_updgrp_show_one (vty, group);
+
+  return CMD_SUCCESS;
+}
+
+void
+bgp_updgrp_init (void)
+{
+  install_element (VIEW_NODE, &show_ip_bgp_update_groups_cmd);
+  install_element (RESTRICTED_NODE, &show_ip_bgp_update_groups_cmd);
+  install_element (ENABLE_NODE, &show_ip_bgp_update_groups_cmd);
+}
@@ -0,0 +1,107 @@
+/* BGP update groups
+ *
+ * This file is part of GNU Zebra.
+ *
+ * GNU Zebra is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2, or (at your option) any
+ * later version.
+ *
+ * GNU Zebra is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Zebra; see the file COPYING.  If not, write to the Free
+ * Software Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ */
+
+#ifndef _QUAGGA_BGP_UPDGRP_H
+#define _QUAGGA_BGP_UPDGRP_H
+
+/* Number of encoded UPDATEs a group keeps for its members. */
+#define BGP_UPDGRP_CACHE_SIZE 256
+#define BGP_UPDGRP_HASH_SIZE  256
+
+struct bgp_advertise;
+
+/* Everything about a peer that goes into encoding UPDATEs for it or
+   deciding what to announce to it.  Peers with equal keys are in the
+   same update group. */
+struct bgp_updgrp_key
+{
+  afi_t afi;
+  safi_t safi;
+  int sort;
+  int as4;
+  as_t local_as;
+  as_t change_local_as;
+  u_int32_t flags;
+  u_int32_t af_flags;
+  u_int16_t af_sflags;
+  struct bgp_nexthop nexthop;
+  int shared_network;
+
+  /* Outbound policy, and the prefix-list the peer sent by ORF. */
+  struct prefix_list *orf_plist;
+  char *dlist;
+  char *plist;
+  char *aslist;
+  char *rmap;
+  char *usmap;
+};
+
+/* An UPDATE encoded for one member, kept for the others. */
+struct bgp_updgrp_packet
+{
+  struct bgp_updgrp_packet *hnext;
+
+  /* What went into it: the attribute, where the route came from and
+     the prefixes, in order. */
+  struct attr *attr;
+  struct peer *from;
+  struct bgp_node **rn;
+  unsigned int count;
+
+  /* Whether it ran out of space, rather than prefixes. */
+  int full;
+
+  struct stream *packet;
+};
+
+struct bgp_updgrp
+{
+  unsigned int id;
+  struct bgp *bgp;
+  struct bgp_updgrp_key key;
+
+  /* Member peers. */
+  struct list *peer;
+
+  /* Recently encoded UPDATEs, by first prefix and in age order. */
+  struct bgp_updgrp_packet *hash[BGP_UPDGRP_HASH_SIZE];
+  struct bgp_updgrp_packet *cache[BGP_UPDGRP_CACHE_SIZE];
+  unsigned int cache_next;
+
+  /* Statistics. */
+  unsigned long encoded;
+  unsigned long shared;
+  unsigned long prefix_encoded;
+  unsigned long prefix_shared;
+};
+
+extern struct bgp_updgrp *bgp_updgrp_check (struct peer *, afi_t, safi_t);
+extern void bgp_updgrp_leave (struct peer *, afi_t, safi_t);
+extern void bgp_updgrp_leave_all (struct peer *);
+extern struct stream *bgp_updgrp_packet_find (struct bgp_updgrp *,
+                                              struct bgp_advertise *,
+                                              unsigned int *);
+extern struct stream *bgp_updgrp_packet_add (struct bgp_updgrp *,
+                                             struct attr *, struct peer *,
+                                             struct bgp_node **, unsigned int,
+                                             int, struct stream *);
+extern void bgp_updgrp_init (void);
+
+#endif /* _QUAGGA_BGP_UPDGRP_H */
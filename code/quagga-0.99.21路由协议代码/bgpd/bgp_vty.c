@@ -51,6 +51,7 @@ Software Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
 #include "bgpd/bgp_mpath.h"
 
 extern struct in_addr router_id_zebra;
+extern struct zclient *zclient;
 
 /* Utility function to get address family from current node.  */
 afi_t
@@ -6845,11 +6846,6 @@ DEFUN (show_bgp_memory,
              mtype_memstr (memstrbuf, sizeof (memstrbuf),
                            count * sizeof (struct hash)),
              VTY_NEWLINE);
-  if ((count = mtype_stats_alloc (MTYPE_HASH_BACKET)))
-    vty_out (vty, "%ld hash buckets, using %s of memory%s", count,
-             mtype_memstr (memstrbuf, sizeof (memstrbuf),
-                           count * sizeof (struct hash_backet)),
-             VTY_NEWLINE);
   if ((count = mtype_stats_alloc (MTYPE_BGP_REGEXP)))
     vty_out (vty, "%ld compiled regexes, using %s of memory%s", count,
              mtype_memstr (memstrbuf, sizeof (memstrbuf),
@@ -6912,6 +6908,10 @@ bgp_show_summary (struct vty *vty, struct bgp *bgp, int afi, int safi)
                                        ents * sizeof (struct peer_group)),
                          VTY_NEWLINE);
 
+              if (zclient && zclient->messages)
+                vty_out (vty, "Zebra messages %lu, written in %lu flushes%s",
+                         zclient->messages, zclient->flushes, VTY_NEWLINE);
+
               if (CHECK_FLAG (bgp->af_flags[afi][safi], BGP_CONFIG_DAMPENING))
                 vty_out (vty, "Dampening enabled.%s", VTY_NEWLINE);
               vty_out (vty, "%s", VTY_NEWLINE);
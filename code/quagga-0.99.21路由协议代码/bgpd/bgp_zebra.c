@@ -1081,6 +1081,8 @@ bgp_zebra_init (void)
   zclient->ipv6_route_add = zebra_read_ipv6;
   zclient->ipv6_route_delete = zebra_read_ipv6;
 #endif /* HAVE_IPV6 */
+  zclient->nexthop_update = bgp_nexthop_update;
+  zclient->zebra_connected = bgp_nexthop_register_all;
 
   /* Interface related init. */
   if_init ();
@@ -58,6 +58,7 @@ Software Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
 #include "bgpd/bgp_network.h"
 #include "bgpd/bgp_vty.h"
 #include "bgpd/bgp_mpath.h"
+#include "bgpd/bgp_updgrp.h"
 #ifdef HAVE_SNMP
 #include "bgpd/bgp_snmp.h"
 #endif /* HAVE_SNMP */
@@ -701,6 +702,7 @@ peer_free (struct peer *peer)
 {
   assert (peer->status == Deleted);
 
+  bgp_updgrp_leave_all (peer);
   bgp_unlock(peer->bgp);
 
   /* this /ought/ to have been done already through bgp_stop earlier,
@@ -1942,6 +1944,8 @@ bgp_create (as_t *as, const char *name)
   bgp->rsclient = list_new ();
   bgp->rsclient->cmp = (int (*)(void*, void*)) peer_cmp;
 
+  bgp->update_groups = list_new ();
+
   for (afi = AFI_IP; afi < AFI_MAX; afi++)
     for (safi = SAFI_UNICAST; safi < SAFI_MAX; safi++)
       {
@@ -2137,6 +2141,7 @@ bgp_free (struct bgp *bgp)
   list_delete (bgp->group);
   list_delete (bgp->peer);
   list_delete (bgp->rsclient);
+  list_delete (bgp->update_groups);
 
   if (bgp->name)
     free (bgp->name);
@@ -5358,6 +5363,7 @@ bgp_init (void)
   bgp_route_map_init ();
   bgp_scan_init ();
   bgp_mplsvpn_init ();
+  bgp_updgrp_init ();
 
   /* Access list initialize. */
   access_list_init ();
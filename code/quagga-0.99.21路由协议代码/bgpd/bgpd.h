@@ -85,6 +85,9 @@ struct bgp
   /* BGP route-server-clients. */
   struct list *rsclient;
 
+  /* BGP update groups. */
+  struct list *update_groups;
+
   /* BGP configuration.  */
   u_int16_t config;
 #define BGP_CONFIG_ROUTER_ID              (1 << 0)
@@ -483,6 +486,9 @@ struct peer
   struct bgp_synchronize *sync[AFI_MAX][SAFI_MAX];
   time_t synctime;
 
+  /* Update group.  */
+  struct bgp_updgrp *updgrp[AFI_MAX][SAFI_MAX];
+
   /* Send prefix count. */
   unsigned long scount[AFI_MAX][SAFI_MAX];
 
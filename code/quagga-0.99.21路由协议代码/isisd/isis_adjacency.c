@@ -222,6 +222,8 @@ isis_adj_state_change (struct isis_adjacency *adj, enum isis_adj_state new_state
         if (new_state == ISIS_ADJ_UP)
         {
           circuit->upadjcount[level - 1]++;
+          if (circuit->upadjcount[level - 1] == 1)
+            lsp_queue_flagged (circuit, level);
           isis_event_adjacency_state_change (adj, new_state);
           /* update counter & timers for debugging purposes */
           adj->last_flap = time (NULL);
@@ -230,13 +232,9 @@ isis_adj_state_change (struct isis_adjacency *adj, enum isis_adj_state new_state
         else if (new_state == ISIS_ADJ_DOWN)
         {
           listnode_delete (circuit->u.bc.adjdb[level - 1], adj);
+          /* send_lsp () drops what is queued for the level, if this
+           * was the last adjacency up on it */
           circuit->upadjcount[level - 1]--;
-          if (circuit->upadjcount[level - 1] == 0)
-            {
-              /* Clean lsp_queue when no adj is up. */
-              if (circuit->lsp_queue)
-                list_delete_all_node (circuit->lsp_queue);
-            }
           isis_event_adjacency_state_change (adj, new_state);
           isis_delete_adj (adj);
         }
@@ -262,6 +260,8 @@ isis_adj_state_change (struct isis_adjacency *adj, enum isis_adj_state new_state
         if (new_state == ISIS_ADJ_UP)
         {
           circuit->upadjcount[level - 1]++;
+          if (circuit->upadjcount[level - 1] == 1)
+            lsp_queue_flagged (circuit, level);
           isis_event_adjacency_state_change (adj, new_state);
 
           if (adj->sys_type == ISIS_SYSTYPE_UNKNOWN)
@@ -279,13 +279,9 @@ isis_adj_state_change (struct isis_adjacency *adj, enum isis_adj_state new_state
         {
           if (adj->circuit->u.p2p.neighbor == adj)
             adj->circuit->u.p2p.neighbor = NULL;
+          /* send_lsp () drops what is queued for the level, if this
+           * was the last adjacency up on it */
           circuit->upadjcount[level - 1]--;
-          if (circuit->upadjcount[level - 1] == 0)
-            {
-              /* Clean lsp_queue when no adj is up. */
-              if (circuit->lsp_queue)
-                list_delete_all_node (circuit->lsp_queue);
-            }
           isis_event_adjacency_state_change (adj, new_state);
           isis_delete_adj (adj);
         }
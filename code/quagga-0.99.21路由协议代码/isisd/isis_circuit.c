@@ -562,7 +562,7 @@ isis_circuit_update_all_srmflags (struct isis_circuit *circuit, int is_set)
                   lsp = dnode_get (dnode);
                   if (is_set)
                     {
-                      ISIS_SET_FLAG (lsp->SRMflags, circuit);
+                      lsp_set_srmflag (lsp, circuit);
                     }
                   else
                     {
@@ -699,7 +699,7 @@ isis_circuit_up (struct isis_circuit *circuit)
 #endif
 
   circuit->lsp_queue = list_new ();
-  circuit->lsp_queue_last_cleared = time (NULL);
+  circuit->lsp_retransmit = list_new ();
 
   return ISIS_OK;
 }
@@ -776,9 +776,11 @@ isis_circuit_down (struct isis_circuit *circuit)
 
   if (circuit->lsp_queue)
     {
-      circuit->lsp_queue->del = NULL;
+      lsp_queue_clear (circuit);
       list_delete (circuit->lsp_queue);
       circuit->lsp_queue = NULL;
+      list_delete (circuit->lsp_retransmit);
+      circuit->lsp_retransmit = NULL;
     }
 
   /* send one gratuitous hello to spead up convergence */
@@ -76,10 +76,9 @@ struct isis_circuit
   struct thread *t_send_csnp[2];
   struct thread *t_send_psnp[2];
   struct list *lsp_queue;	/* LSPs to be txed (both levels) */
-  time_t lsp_queue_last_cleared;/* timestamp used to enforce transmit interval;
-                                 * for scalability, use one timestamp per 
-                                 * circuit, instead of one per lsp per circuit
-                                 */
+  struct list *lsp_retransmit;	/* LSPs txed on P2P, until acknowledged */
+  struct thread *t_send_lsp;	/* sends the head of lsp_queue */
+  struct thread *t_retransmit_lsp; /* requeues lsp_retransmit */
   /* there is no real point in two streams, just for programming kicker */
   int (*rx) (struct isis_circuit * circuit, u_char * ssnpa);
   struct stream *rcv_stream;	/* Stream for receiving */
@@ -62,6 +62,7 @@ static int lsp_l1_refresh (struct thread *thread);
 static int lsp_l2_refresh (struct thread *thread);
 static int lsp_l1_refresh_pseudo (struct thread *thread);
 static int lsp_l2_refresh_pseudo (struct thread *thread);
+static void lsp_set_expire (struct isis_lsp *lsp);
 
 int
 lsp_id_cmp (u_char * id1, u_char * id2)
@@ -128,23 +129,23 @@ lsp_clear_data (struct isis_lsp *lsp)
 static void
 lsp_destroy (struct isis_lsp *lsp)
 {
-  struct listnode *cnode, *lnode, *lnnode;
-  struct isis_lsp *lsp_in_list;
+  struct listnode *cnode;
   struct isis_circuit *circuit;
 
   if (!lsp)
     return;
 
+  THREAD_TIMER_OFF (lsp->t_lsp_expire);
   for (ALL_LIST_ELEMENTS_RO (lsp->area->circuit_list, cnode, circuit))
     {
-      if (circuit->lsp_queue == NULL)
+      if (!ISIS_CHECK_FLAG (lsp->SRMqueued, circuit))
         continue;
-      for (ALL_LIST_ELEMENTS (circuit->lsp_queue, lnode, lnnode, lsp_in_list))
-        if (lsp_in_list == lsp)
-          list_delete_node(circuit->lsp_queue, lnode);
+      listnode_delete (circuit->lsp_queue, lsp);
+      listnode_delete (circuit->lsp_retransmit, lsp);
     }
   ISIS_FLAGS_CLEAR_ALL (lsp->SSNflags);
   ISIS_FLAGS_CLEAR_ALL (lsp->SRMflags);
+  ISIS_FLAGS_CLEAR_ALL (lsp->SRMqueued);
 
   lsp_clear_data (lsp);
 
@@ -624,6 +625,7 @@ void
 lsp_insert (struct isis_lsp *lsp, dict_t * lspdb)
 {
   dict_alloc_insert (lspdb, lsp->lsp_header->lsp_id, lsp);
+  lsp_set_expire (lsp);
   if (lsp->lsp_header->seq_num != 0)
     {
       isis_spf_schedule (lsp->area, lsp->level);
@@ -684,6 +686,7 @@ lsp_build_list (u_char * start_id, u_char * stop_id, u_char num_lsps,
 
   curr = first;
 
+  lsp_set_time (first->dict_data);
   listnode_add (list, first->dict_data);
   count = 1;
 
@@ -692,6 +695,7 @@ lsp_build_list (u_char * start_id, u_char * stop_id, u_char num_lsps,
       curr = dict_next (lspdb, curr);
       if (curr)
         {
+          lsp_set_time (curr->dict_data);
           listnode_add (list, curr->dict_data);
           count++;
         }
@@ -720,6 +724,7 @@ lsp_build_list_ssn (struct isis_circuit *circuit, u_char num_lsps,
       lsp = dnode_get (dnode);
       if (ISIS_CHECK_FLAG (lsp->SSNflags, circuit))
         {
+          lsp_set_time (lsp);
           listnode_add (list, lsp);
           ++count;
         }
@@ -731,20 +736,99 @@ lsp_build_list_ssn (struct isis_circuit *circuit, u_char num_lsps,
   return;
 }
 
-static void
+/*
+ * Bring the remaining lifetime in the header, or the ZeroAgeLifetime
+ * left once that is zero, up to date with the aging timer.  They are not
+ * counted down every second, so this must be done before either is shown
+ * or sent.
+ */
+void
 lsp_set_time (struct isis_lsp *lsp)
 {
+  unsigned long remain;
+
   assert (lsp);
 
+  if (lsp->t_lsp_expire == NULL)
+    return;
+
+  remain = thread_timer_remain_second (lsp->t_lsp_expire);
   if (lsp->lsp_header->rem_lifetime == 0)
+    lsp->age_out = remain;
+  else
+    lsp->lsp_header->rem_lifetime = htons (MAX (remain, 1));
+}
+
+/*
+ * Runs when the remaining lifetime of an LSP reaches zero, and again
+ * ZeroAgeLifetime later, when the LSP is removed.
+ */
+static int
+lsp_expire (struct thread *thread)
+{
+  struct isis_lsp *lsp;
+  struct isis_area *area;
+  dnode_t *dnode;
+  int level;
+
+  lsp = THREAD_ARG (thread);
+  assert (lsp);
+  lsp->t_lsp_expire = NULL;
+  area = lsp->area;
+  level = lsp->level;
+
+  if (lsp->lsp_header->rem_lifetime != 0)
     {
-      if (lsp->age_out > 0)
-        lsp->age_out--;
-      return;
+      lsp->lsp_header->rem_lifetime = 0;
+      /*
+       * Schedule may run spf which should be done only after
+       * the lsp rem_lifetime becomes 0 for the first time.
+       * ISO 10589 - 7.3.16.4 first paragraph.
+       */
+      if (lsp->lsp_header->seq_num != 0)
+        {
+          /* 7.3.16.4 a) set SRM flags on all */
+          lsp_set_all_srmflags (lsp);
+          /* 7.3.16.4 b) retain only the header FIXME  */
+          /* 7.3.16.4 c) record the time to purge FIXME */
+          /* run/schedule spf */
+          /* isis_spf_schedule is called inside lsp_destroy() below;
+           * so it is not needed here. */
+          /* isis_spf_schedule (lsp->area, lsp->level); */
+        }
+      lsp_set_expire (lsp);
+      return ISIS_OK;
     }
 
-  lsp->lsp_header->rem_lifetime =
-    htons (ntohs (lsp->lsp_header->rem_lifetime) - 1);
+  zlog_debug ("ISIS-Upd (%s): L%u LSP %s seq 0x%08x aged out",
+              area->area_tag,
+              level,
+              rawlspid_print (lsp->lsp_header->lsp_id),
+              ntohl (lsp->lsp_header->seq_num));
+#ifdef TOPOLOGY_GENERATE
+  if (lsp->from_topology)
+    THREAD_TIMER_OFF (lsp->t_lsp_top_ref);
+#endif /* TOPOLOGY_GENERATE */
+  dnode = dict_lookup (area->lspdb[level - 1], lsp->lsp_header->lsp_id);
+  lsp_destroy (lsp);
+  if (dnode)
+    dict_delete_free (area->lspdb[level - 1], dnode);
+
+  return ISIS_OK;
+}
+
+/*
+ * (Re)start aging from the remaining lifetime now in the header, or
+ * from age_out if that is zero.  Called whenever either is set.
+ */
+static void
+lsp_set_expire (struct isis_lsp *lsp)
+{
+  u_int16_t rem_lifetime = ntohs (lsp->lsp_header->rem_lifetime);
+
+  THREAD_TIMER_OFF (lsp->t_lsp_expire);
+  THREAD_TIMER_ON (master, lsp->t_lsp_expire, lsp_expire, lsp,
+                   rem_lifetime ? rem_lifetime : lsp->age_out);
 }
 
 static void
@@ -801,6 +885,7 @@ lsp_print (struct isis_lsp *lsp, struct vty *vty, char dynhost)
   u_char LSPid[255];
   char age_out[8];
 
+  lsp_set_time (lsp);
   lspid_print (lsp->lsp_header->lsp_id, LSPid, dynhost, 1);
   vty_out (vty, "%-21s%c  ", LSPid, lsp->own_lsp ? '*' : ' ');
   vty_out (vty, "%5u   ", ntohs (lsp->lsp_header->pdu_len));
@@ -1657,6 +1742,7 @@ lsp_regenerate (struct isis_area *area, int level)
   lsp->lsp_header->lsp_bits = lsp_bits_generate (level, area->overload_bit);
   rem_lifetime = lsp_rem_lifetime (area, level);
   lsp->lsp_header->rem_lifetime = htons (rem_lifetime);
+  lsp_set_expire (lsp);
   lsp_seqnum_update (lsp);
 
   lsp->last_generated = time (NULL);
@@ -1669,6 +1755,7 @@ lsp_regenerate (struct isis_area *area, int level)
        * so that no fragment expires before the lsp is refreshed.
        */
       frag->lsp_header->rem_lifetime = htons (rem_lifetime);
+      lsp_set_expire (frag);
       lsp_set_all_srmflags (frag);
     }
 
@@ -2013,6 +2100,7 @@ lsp_regenerate_pseudo (struct isis_circuit *circuit, int level)
   lsp->lsp_header->lsp_bits = lsp_bits_generate (level, 0);
   rem_lifetime = lsp_rem_lifetime (circuit->area, level);
   lsp->lsp_header->rem_lifetime = htons (rem_lifetime);
+  lsp_set_expire (lsp);
   lsp_inc_seqnum (lsp, 0);
   lsp->last_generated = time (NULL);
   lsp_set_all_srmflags (lsp);
@@ -2151,125 +2239,6 @@ lsp_regenerate_schedule_pseudo (struct isis_circuit *circuit, int level)
   return ISIS_OK;
 }
 
-/*
- * Walk through LSPs for an area
- *  - set remaining lifetime
- *  - set LSPs with SRMflag set for sending
- */
-int
-lsp_tick (struct thread *thread)
-{
-  struct isis_area *area;
-  struct isis_circuit *circuit;
-  struct isis_lsp *lsp;
-  struct list *lsp_list;
-  struct listnode *lspnode, *cnode;
-  dnode_t *dnode, *dnode_next;
-  int level;
-  u_int16_t rem_lifetime;
-
-  lsp_list = list_new ();
-
-  area = THREAD_ARG (thread);
-  assert (area);
-  area->t_tick = NULL;
-  THREAD_TIMER_ON (master, area->t_tick, lsp_tick, area, 1);
-
-  /*
-   * Build a list of LSPs with (any) SRMflag set
-   * and removed the ones that have aged out
-   */
-  for (level = 0; level < ISIS_LEVELS; level++)
-    {
-      if (area->lspdb[level] && dict_count (area->lspdb[level]) > 0)
-        {
-          for (dnode = dict_first (area->lspdb[level]);
-               dnode != NULL; dnode = dnode_next)
-            {
-              dnode_next = dict_next (area->lspdb[level], dnode);
-              lsp = dnode_get (dnode);
-
-              /*
-               * The lsp rem_lifetime is kept at 0 for MaxAge or
-               * ZeroAgeLifetime depending on explicit purge or
-               * natural age out. So schedule spf only once when
-               * the first time rem_lifetime becomes 0.
-               */
-              rem_lifetime = ntohs(lsp->lsp_header->rem_lifetime);
-              lsp_set_time (lsp);
-
-              /*
-               * Schedule may run spf which should be done only after
-               * the lsp rem_lifetime becomes 0 for the first time.
-               * ISO 10589 - 7.3.16.4 first paragraph.
-               */
-              if (rem_lifetime == 1 && lsp->lsp_header->seq_num != 0)
-                {
-                  /* 7.3.16.4 a) set SRM flags on all */
-                  lsp_set_all_srmflags (lsp);
-                  /* 7.3.16.4 b) retain only the header FIXME  */
-                  /* 7.3.16.4 c) record the time to purge FIXME */
-                  /* run/schedule spf */
-                  /* isis_spf_schedule is called inside lsp_destroy() below;
-                   * so it is not needed here. */
-                  /* isis_spf_schedule (lsp->area, lsp->level); */
-                }
-
-              if (lsp->age_out == 0)
-                {
-                  zlog_debug ("ISIS-Upd (%s): L%u LSP %s seq 0x%08x aged out",
-                              area->area_tag,
-                              lsp->level,
-                              rawlspid_print (lsp->lsp_header->lsp_id),
-                              ntohl (lsp->lsp_header->seq_num));
-#ifdef TOPOLOGY_GENERATE
-                  if (lsp->from_topology)
-                    THREAD_TIMER_OFF (lsp->t_lsp_top_ref);
-#endif /* TOPOLOGY_GENERATE */
-                  lsp_destroy (lsp);
-                  lsp = NULL;
-                  dict_delete_free (area->lspdb[level], dnode);
-                }
-              else if (flags_any_set (lsp->SRMflags))
-                listnode_add (lsp_list, lsp);
-            }
-
-          /*
-           * Send LSPs on circuits indicated by the SRMflags
-           */
-          if (listcount (lsp_list) > 0)
-            {
-              for (ALL_LIST_ELEMENTS_RO (area->circuit_list, cnode, circuit))
-                {
-                  int diff = time (NULL) - circuit->lsp_queue_last_cleared;
-                  if (circuit->lsp_queue == NULL ||
-                      diff < MIN_LSP_TRANS_INTERVAL)
-                    continue;
-                  for (ALL_LIST_ELEMENTS_RO (lsp_list, lspnode, lsp))
-                    {
-                      if (circuit->upadjcount[lsp->level - 1] &&
-                          ISIS_CHECK_FLAG (lsp->SRMflags, circuit))
-                        {
-                          /* Add the lsp only if it is not already in lsp
-                           * queue */
-                          if (! listnode_lookup (circuit->lsp_queue, lsp))
-                            {
-                              listnode_add (circuit->lsp_queue, lsp);
-                              thread_add_event (master, send_lsp, circuit, 0);
-                            }
-                        }
-                    }
-                }
-              list_delete_all_node (lsp_list);
-            }
-        }
-    }
-
-  list_delete (lsp_list);
-
-  return ISIS_OK;
-}
-
 void
 lsp_purge_pseudo (u_char * id, struct isis_circuit *circuit, int level)
 {
@@ -2298,6 +2267,7 @@ lsp_purge_pseudo (u_char * id, struct isis_circuit *circuit, int level)
   lsp->lsp_header->lsp_bits = lsp_bits;
   lsp->level = level;
   lsp->age_out = lsp->area->max_lsp_lifetime[level-1];
+  lsp_set_expire (lsp);
   stream_forward_endp (lsp->pdu, ISIS_FIXED_HDR_LEN + ISIS_LSP_HDR_LEN);
 
   /*
@@ -2345,6 +2315,7 @@ lsp_purge_non_exist (struct isis_link_state_hdr *lsp_hdr,
    * Set the remaining lifetime to 0
    */
   lsp->lsp_header->rem_lifetime = 0;
+  lsp->age_out = ZERO_AGE_LIFETIME;
 
   /*
    * Add and update the authentication info if its present
@@ -2384,11 +2355,76 @@ void lsp_set_all_srmflags (struct isis_lsp *lsp)
       struct list *circuit_list = lsp->area->circuit_list;
       for (ALL_LIST_ELEMENTS_RO (circuit_list, node, circuit))
         {
-          ISIS_SET_FLAG(lsp->SRMflags, circuit);
+          lsp_set_srmflag (lsp, circuit);
         }
     }
 }
 
+/*
+ * Set the SRMflag of an LSP for a circuit and queue the LSP for sending
+ * on it, if the circuit has an adjacency up on the LSP's level.  The
+ * queues are not pruned when an SRMflag is cleared; send_lsp () skips
+ * the LSP instead.
+ */
+void
+lsp_set_srmflag (struct isis_lsp *lsp, struct isis_circuit *circuit)
+{
+  ISIS_SET_FLAG (lsp->SRMflags, circuit);
+
+  if (circuit->lsp_queue == NULL ||
+      ISIS_CHECK_FLAG (lsp->SRMqueued, circuit) ||
+      !(lsp->level & circuit->is_type) ||
+      circuit->upadjcount[lsp->level - 1] == 0)
+    return;
+
+  ISIS_SET_FLAG (lsp->SRMqueued, circuit);
+  listnode_add (circuit->lsp_queue, lsp);
+  if (circuit->t_send_lsp == NULL)
+    circuit->t_send_lsp = thread_add_event (master, send_lsp, circuit, 0);
+}
+
+/*
+ * Queue the LSPs whose SRMflag was set while the circuit had no
+ * adjacency up on the level, now that it has one.
+ */
+void
+lsp_queue_flagged (struct isis_circuit *circuit, int level)
+{
+  dnode_t *dnode;
+  struct isis_lsp *lsp;
+
+  for (dnode = dict_first (circuit->area->lspdb[level - 1]); dnode;
+       dnode = dict_next (circuit->area->lspdb[level - 1], dnode))
+    {
+      lsp = dnode_get (dnode);
+      if (ISIS_CHECK_FLAG (lsp->SRMflags, circuit))
+        lsp_set_srmflag (lsp, circuit);
+    }
+}
+
+/* Empty the circuit's queues, leaving the SRMflags as they are. */
+void
+lsp_queue_clear (struct isis_circuit *circuit)
+{
+  struct listnode *node;
+  struct isis_lsp *lsp;
+
+  THREAD_OFF (circuit->t_send_lsp);
+  THREAD_TIMER_OFF (circuit->t_retransmit_lsp);
+  if (circuit->lsp_queue)
+    {
+      for (ALL_LIST_ELEMENTS_RO (circuit->lsp_queue, node, lsp))
+        ISIS_CLEAR_FLAG (lsp->SRMqueued, circuit);
+      list_delete_all_node (circuit->lsp_queue);
+    }
+  if (circuit->lsp_retransmit)
+    {
+      for (ALL_LIST_ELEMENTS_RO (circuit->lsp_retransmit, node, lsp))
+        ISIS_CLEAR_FLAG (lsp->SRMqueued, circuit);
+      list_delete_all_node (circuit->lsp_retransmit);
+    }
+}
+
 #ifdef TOPOLOGY_GENERATE
 static int
 top_lsp_refresh (struct thread *thread)
@@ -2413,10 +2449,11 @@ top_lsp_refresh (struct thread *thread)
   isis_dynhn_insert (lsp->lsp_header->lsp_id, lsp->tlv_data.hostname,
 		     IS_LEVEL_1);
 
-  lsp->lsp_header->lsp_bits = lsp_bits_generate (level,
+  lsp->lsp_header->lsp_bits = lsp_bits_generate (IS_LEVEL_1,
                                                  lsp->area->overload_bit);
   rem_lifetime = lsp_rem_lifetime (lsp->area, IS_LEVEL_1);
   lsp->lsp_header->rem_lifetime = htons (rem_lifetime);
+  lsp_set_expire (lsp);
 
   refresh_time = lsp_refresh_time (lsp, rem_lifetime);
   THREAD_TIMER_ON (master, lsp->t_lsp_top_ref, top_lsp_refresh, lsp,
@@ -41,6 +41,8 @@ struct isis_lsp
   u_int32_t auth_tlv_offset;    /* authentication TLV position in the pdu */
   u_int32_t SRMflags[ISIS_MAX_CIRCUITS];
   u_int32_t SSNflags[ISIS_MAX_CIRCUITS];
+  u_int32_t SRMqueued[ISIS_MAX_CIRCUITS]; /* on the circuit's lsp_queue
+                                           * or lsp_retransmit */
   int level;			/* L1 or L2? */
   int scheduled;		/* scheduled for sending */
   time_t installed;
@@ -52,13 +54,15 @@ struct isis_lsp
 #endif
   /* used for 60 second counting when rem_lifetime is zero */
   int age_out;
+  /* runs out with rem_lifetime, then with age_out; both are only
+   * brought up to date by lsp_set_time () */
+  struct thread *t_lsp_expire;
   struct isis_area *area;
   struct tlvs tlv_data;		/* Simplifies TLV access */
 };
 
 dict_t *lsp_db_init (void);
 void lsp_db_destroy (dict_t * lspdb);
-int lsp_tick (struct thread *thread);
 
 int lsp_generate (struct isis_area *area, int level);
 int lsp_regenerate_schedule (struct isis_area *area, int level,
@@ -111,8 +115,13 @@ int lsp_print_all (struct vty *vty, dict_t * lspdb, char detail,
 		   char dynhost);
 const char *lsp_bits2string (u_char *);
 
+void lsp_set_time (struct isis_lsp *lsp);
+
 /* sets SRMflags for all active circuits of an lsp */
 void lsp_set_all_srmflags (struct isis_lsp *lsp);
+void lsp_set_srmflag (struct isis_lsp *lsp, struct isis_circuit *circuit);
+void lsp_queue_flagged (struct isis_circuit *circuit, int level);
+void lsp_queue_clear (struct isis_circuit *circuit);
 
 #ifdef TOPOLOGY_GENERATE
 void generate_topology_lsps (struct isis_area *area);
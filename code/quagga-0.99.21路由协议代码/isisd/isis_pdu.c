@@ -1394,7 +1394,7 @@ dontcheckadj:
 		}		/* 7.3.16.4 b) 3) */
 	      else
 		{
-		  ISIS_SET_FLAG (lsp->SRMflags, circuit);
+		  lsp_set_srmflag (lsp, circuit);
 		  ISIS_CLEAR_FLAG (lsp->SSNflags, circuit);
 		}
 	    }
@@ -1408,7 +1408,7 @@ dontcheckadj:
                 }
               else
                 {
-                  ISIS_SET_FLAG (lsp->SRMflags, circuit);
+                  lsp_set_srmflag (lsp, circuit);
                   ISIS_CLEAR_FLAG (lsp->SSNflags, circuit);
                 }
               if (isis->debugs & DEBUG_UPDATE_PACKETS)
@@ -1504,7 +1504,7 @@ dontcheckadj:
       /* 7.3.15.1 e) 3) LSP older than the one in db */
       else
 	{
-	  ISIS_SET_FLAG (lsp->SRMflags, circuit);
+	  lsp_set_srmflag (lsp, circuit);
 	  ISIS_CLEAR_FLAG (lsp->SSNflags, circuit);
 	}
     }
@@ -1740,7 +1740,7 @@ process_snp (int snp_type, int level, struct isis_circuit *circuit,
 	    else if (cmp == LSP_OLDER)
 	      {
 		ISIS_CLEAR_FLAG (lsp->SSNflags, circuit);
-		ISIS_SET_FLAG (lsp->SRMflags, circuit);
+		lsp_set_srmflag (lsp, circuit);
 	      }
 	    /* 7.3.15.2 b) 4) if it is newer, set SSN and clear SRM on p2p */
 	    else
@@ -1748,7 +1748,7 @@ process_snp (int snp_type, int level, struct isis_circuit *circuit,
 		if (own_lsp)
 		  {
 		    lsp_inc_seqnum (lsp, ntohl (entry->seq_num));
-		    ISIS_SET_FLAG (lsp->SRMflags, circuit);
+		    lsp_set_srmflag (lsp, circuit);
 		  }
 		else
 		  {
@@ -1804,7 +1804,7 @@ process_snp (int snp_type, int level, struct isis_circuit *circuit,
 	}
       /* on remaining LSPs we set SRM (neighbor knew not of) */
       for (ALL_LIST_ELEMENTS_RO (lsp_list, node, lsp))
-	ISIS_SET_FLAG (lsp->SRMflags, circuit);
+	lsp_set_srmflag (lsp, circuit);
       /* lets free it */
       list_delete (lsp_list);
 
@@ -3012,6 +3012,36 @@ send_l2_psnp (struct thread *thread)
   return retval;
 }
 
+/*
+ * Requeue the LSPs sent on a P2P circuit that are still not acknowledged,
+ * minimumLSPTransmissionInterval after they were first due.
+ */
+static int
+retransmit_lsp (struct thread *thread)
+{
+  struct isis_circuit *circuit;
+  struct listnode *node, *nnode;
+  struct isis_lsp *lsp;
+
+  circuit = THREAD_ARG (thread);
+  assert (circuit);
+  circuit->t_retransmit_lsp = NULL;
+
+  for (ALL_LIST_ELEMENTS (circuit->lsp_retransmit, node, nnode, lsp))
+    {
+      list_delete_node (circuit->lsp_retransmit, node);
+      if (ISIS_CHECK_FLAG (lsp->SRMflags, circuit))
+        listnode_add (circuit->lsp_queue, lsp);
+      else
+        ISIS_CLEAR_FLAG (lsp->SRMqueued, circuit);
+    }
+
+  if (!list_isempty (circuit->lsp_queue) && circuit->t_send_lsp == NULL)
+    circuit->t_send_lsp = thread_add_event (master, send_lsp, circuit, 0);
+
+  return ISIS_OK;
+}
+
 /*
  * ISO 10589 - 7.3.14.3
  */
@@ -3025,33 +3055,38 @@ send_lsp (struct thread *thread)
 
   circuit = THREAD_ARG (thread);
   assert (circuit);
+  circuit->t_send_lsp = NULL;
 
   if (circuit->state != C_STATE_UP || circuit->is_passive == 1)
   {
     return retval;
   }
 
-  lsp = listgetdata ((node = listhead (circuit->lsp_queue)));
+  node = listhead (circuit->lsp_queue);
+  if (node == NULL)
+    return retval;
+  lsp = listgetdata (node);
+  list_delete_node (circuit->lsp_queue, node);
 
-  /*
-   * Do not send if levels do not match
-   */
-  if (!(lsp->level & circuit->is_type))
-    {
-      list_delete_node (circuit->lsp_queue, node);
-      return retval;
-    }
+  /* One LSP at a time, so as not to hog the daemon */
+  if (!list_isempty (circuit->lsp_queue))
+    circuit->t_send_lsp = thread_add_event (master, send_lsp, circuit, 0);
 
   /*
-   * Do not send if we do not have adjacencies in state up on the circuit
+   * Do not send if the SRMflag was cleared since the LSP was queued,
+   * if levels do not match, or if we do not have adjacencies in state
+   * up on the circuit
    */
-  if (circuit->upadjcount[lsp->level - 1] == 0)
+  if (!ISIS_CHECK_FLAG (lsp->SRMflags, circuit) ||
+      !(lsp->level & circuit->is_type) ||
+      circuit->upadjcount[lsp->level - 1] == 0)
     {
-      list_delete_node (circuit->lsp_queue, node);
+      ISIS_CLEAR_FLAG (lsp->SRMqueued, circuit);
       return retval;
     }
 
   /* copy our lsp to the send buffer */
+  lsp_set_time (lsp);
   stream_copy (circuit->snd_stream, lsp->pdu);
 
   if (isis->debugs & DEBUG_UPDATE_PACKETS)
@@ -3075,26 +3110,24 @@ send_lsp (struct thread *thread)
       zlog_err ("ISIS-Upd (%s): Send L%d LSP on %s failed",
                 circuit->area->area_tag, lsp->level,
                 circuit->interface->name);
-      return retval;
     }
-
   /*
-   * If the sending succeeded, we can del the lsp from circuits
-   * lsp_queue
+   * On broadcast circuits also the SRMflag can be cleared
    */
-  list_delete_node (circuit->lsp_queue, node);
-
-  /* Set the last-cleared time if the queue is empty. */
-  /* TODO: Is is possible that new lsps keep being added to the queue
-   * that the queue is never empty? */
-  if (list_isempty (circuit->lsp_queue))
-    circuit->lsp_queue_last_cleared = time (NULL);
+  else if (circuit->circ_type == CIRCUIT_T_BROADCAST)
+    {
+      ISIS_CLEAR_FLAG (lsp->SRMflags, circuit);
+      ISIS_CLEAR_FLAG (lsp->SRMqueued, circuit);
+      return retval;
+    }
 
   /*
-   * On broadcast circuits also the SRMflag can be cleared
+   * Otherwise keep it until it is acknowledged, or to retry
    */
-  if (circuit->circ_type == CIRCUIT_T_BROADCAST)
-    ISIS_CLEAR_FLAG (lsp->SRMflags, circuit);
+  listnode_add (circuit->lsp_retransmit, lsp);
+  if (circuit->t_retransmit_lsp == NULL)
+    THREAD_TIMER_ON (master, circuit->t_retransmit_lsp, retransmit_lsp,
+                     circuit, MIN_LSP_TRANS_INTERVAL);
 
   return retval;
 }
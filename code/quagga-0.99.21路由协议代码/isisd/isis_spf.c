@@ -31,6 +31,8 @@
 #include "memory.h"
 #include "prefix.h"
 #include "hash.h"
+#include "jhash.h"
+#include "pqueue.h"
 #include "if.h"
 #include "table.h"
 
@@ -183,18 +185,10 @@ vid2string (struct isis_vertex *vertex, u_char * buff)
   return (char *) buff;
 }
 
-static struct isis_vertex *
-isis_vertex_new (void *id, enum vertextype vtype)
+static void
+isis_vertex_id_init (struct isis_vertex *vertex, void *id,
+		     enum vertextype vtype)
 {
-  struct isis_vertex *vertex;
-
-  vertex = XCALLOC (MTYPE_ISIS_VERTEX, sizeof (struct isis_vertex));
-  if (vertex == NULL)
-    {
-      zlog_err ("isis_vertex_new Out of memory!");
-      return NULL;
-    }
-
   vertex->type = vtype;
   switch (vtype)
     {
@@ -220,7 +214,22 @@ isis_vertex_new (void *id, enum vertextype vtype)
     default:
       zlog_err ("WTF!");
     }
+}
+
+static struct isis_vertex *
+isis_vertex_new (void *id, enum vertextype vtype)
+{
+  struct isis_vertex *vertex;
+
+  vertex = XCALLOC (MTYPE_ISIS_VERTEX, sizeof (struct isis_vertex));
+  if (vertex == NULL)
+    {
+      zlog_err ("isis_vertex_new Out of memory!");
+      return NULL;
+    }
 
+  isis_vertex_id_init (vertex, id, vtype);
+  vertex->tent_index = -1;
   vertex->Adj_N = list_new ();
   vertex->parents = list_new ();
   vertex->children = list_new ();
@@ -259,6 +268,84 @@ isis_vertex_adj_del (struct isis_vertex *vertex, struct isis_adjacency *adj)
   return;
 }
 
+static unsigned int
+isis_vertex_hash_key (void *arg)
+{
+  struct isis_vertex *vertex = arg;
+  struct prefix *p;
+
+  switch (vertex->type)
+    {
+    case VTYPE_ES:
+    case VTYPE_NONPSEUDO_IS:
+    case VTYPE_NONPSEUDO_TE_IS:
+      return jhash (vertex->N.id, ISIS_SYS_ID_LEN, vertex->type);
+    case VTYPE_PSEUDO_IS:
+    case VTYPE_PSEUDO_TE_IS:
+      return jhash (vertex->N.id, ISIS_SYS_ID_LEN + 1, vertex->type);
+    default:
+      p = &vertex->N.prefix;
+      return jhash (&p->u.prefix, PSIZE (p->prefixlen),
+		    (p->family << 16) | (p->prefixlen << 8) | vertex->type);
+    }
+}
+
+static int
+isis_vertex_hash_cmp (const void *a, const void *b)
+{
+  const struct isis_vertex *va = a, *vb = b;
+  const struct prefix *p1, *p2;
+
+  if (va->type != vb->type)
+    return 0;
+  switch (va->type)
+    {
+    case VTYPE_ES:
+    case VTYPE_NONPSEUDO_IS:
+    case VTYPE_NONPSEUDO_TE_IS:
+      return memcmp (va->N.id, vb->N.id, ISIS_SYS_ID_LEN) == 0;
+    case VTYPE_PSEUDO_IS:
+    case VTYPE_PSEUDO_TE_IS:
+      return memcmp (va->N.id, vb->N.id, ISIS_SYS_ID_LEN + 1) == 0;
+    default:
+      p1 = &va->N.prefix;
+      p2 = &vb->N.prefix;
+      return (p1->family == p2->family && p1->prefixlen == p2->prefixlen
+	      && memcmp (&p1->u.prefix, &p2->u.prefix,
+			 PSIZE (p1->prefixlen)) == 0);
+    }
+}
+
+/* TENT is kept sorted by cost, then by vertextype on tie break, then in
+ * the order vertices were added. */
+static int
+isis_vertex_queue_cmp (void *a, void *b)
+{
+  struct isis_vertex *va = a, *vb = b;
+
+  if (va->d_N != vb->d_N)
+    return va->d_N < vb->d_N ? -1 : 1;
+  if (va->type != vb->type)
+    return va->type < vb->type ? -1 : 1;
+  return va->tent_order < vb->tent_order ? -1 : 1;
+}
+
+static void
+isis_vertex_queue_update (void *node, int actual_position)
+{
+  ((struct isis_vertex *) node)->tent_index = actual_position;
+}
+
+static void
+init_spt (struct isis_spftree *spftree)
+{
+  hash_clean (spftree->vertices, (void (*)(void *)) isis_vertex_del);
+  spftree->tents->size = 0;
+  list_delete_all_node (spftree->paths);
+  spftree->tent_order = 0;
+  return;
+}
+
 struct isis_spftree *
 isis_spftree_new (struct isis_area *area)
 {
@@ -271,7 +358,11 @@ isis_spftree_new (struct isis_area *area)
       return NULL;
     }
 
-  tree->tents = list_new ();
+  tree->tents = pqueue_create ();
+  tree->tents->cmp = isis_vertex_queue_cmp;
+  tree->tents->update = isis_vertex_queue_update;
+  tree->vertices = hash_create (isis_vertex_hash_key, isis_vertex_hash_cmp,
+				"IS-IS SPF vertices");
   tree->paths = list_new ();
   tree->area = area;
   tree->last_run_timestamp = 0;
@@ -286,11 +377,11 @@ isis_spftree_del (struct isis_spftree *spftree)
 {
   THREAD_TIMER_OFF (spftree->t_spf);
 
-  spftree->tents->del = (void (*)(void *)) isis_vertex_del;
-  list_delete (spftree->tents);
+  init_spt (spftree);
+  pqueue_delete (spftree->tents);
   spftree->tents = NULL;
-
-  spftree->paths->del = (void (*)(void *)) isis_vertex_del;
+  hash_free (spftree->vertices);
+  spftree->vertices = NULL;
   list_delete (spftree->paths);
   spftree->paths = NULL;
 
@@ -303,10 +394,11 @@ void
 isis_spftree_adj_del (struct isis_spftree *spftree, struct isis_adjacency *adj)
 {
   struct listnode *node;
+  int i;
   if (!adj)
     return;
-  for (node = listhead (spftree->tents); node; node = listnextnode (node))
-    isis_vertex_adj_del (listgetdata (node), adj);
+  for (i = 0; i < spftree->tents->size; i++)
+    isis_vertex_adj_del (spftree->tents->array[i], adj);
   for (node = listhead (spftree->paths); node; node = listnextnode (node))
     isis_vertex_adj_del (listgetdata (node), adj);
   return;
@@ -442,6 +534,7 @@ isis_spf_add_root (struct isis_spftree *spftree, int level, u_char *sysid)
   else
     vertex = isis_vertex_new (sysid, VTYPE_NONPSEUDO_IS);
 
+  hash_get (spftree->vertices, vertex, hash_alloc_intern);
   listnode_add (spftree->paths, vertex);
 
 #ifdef EXTREME_DEBUG
@@ -453,48 +546,30 @@ isis_spf_add_root (struct isis_spftree *spftree, int level, u_char *sysid)
   return vertex;
 }
 
+/* Find a vertex in TENT or PATHS; tent_index tells which. */
 static struct isis_vertex *
-isis_find_vertex (struct list *list, void *id, enum vertextype vtype)
+isis_find_vertex (struct isis_spftree *spftree, void *id,
+		  enum vertextype vtype)
 {
-  struct listnode *node;
-  struct isis_vertex *vertex;
-  struct prefix *p1, *p2;
+  struct isis_vertex key;
 
-  for (ALL_LIST_ELEMENTS_RO (list, node, vertex))
-    {
-      if (vertex->type != vtype)
-	continue;
-      switch (vtype)
-	{
-	case VTYPE_ES:
-	case VTYPE_NONPSEUDO_IS:
-	case VTYPE_NONPSEUDO_TE_IS:
-	  if (memcmp ((u_char *) id, vertex->N.id, ISIS_SYS_ID_LEN) == 0)
-	    return vertex;
-	  break;
-	case VTYPE_PSEUDO_IS:
-	case VTYPE_PSEUDO_TE_IS:
-	  if (memcmp ((u_char *) id, vertex->N.id, ISIS_SYS_ID_LEN + 1) == 0)
-	    return vertex;
-	  break;
-	case VTYPE_IPREACH_INTERNAL:
-	case VTYPE_IPREACH_EXTERNAL:
-	case VTYPE_IPREACH_TE:
-#ifdef HAVE_IPV6
-	case VTYPE_IP6REACH_INTERNAL:
-	case VTYPE_IP6REACH_EXTERNAL:
-#endif /* HAVE_IPV6 */
-	  p1 = (struct prefix *) id;
-	  p2 = (struct prefix *) &vertex->N.id;
-	  if (p1->family == p2->family && p1->prefixlen == p2->prefixlen &&
-	      memcmp (&p1->u.prefix, &p2->u.prefix,
-		      PSIZE (p1->prefixlen)) == 0)
-	    return vertex;
-	  break;
-	}
-    }
+  isis_vertex_id_init (&key, id, vtype);
+  return hash_lookup (spftree->vertices, &key);
+}
 
-  return NULL;
+/* Take a vertex out of TENT, to be replaced by a nearer one. */
+static void
+isis_tent_del (struct isis_spftree *spftree, struct isis_vertex *vertex)
+{
+  struct listnode *pnode, *pnextnode;
+  struct isis_vertex *pvertex;
+
+  pqueue_remove_at (vertex->tent_index, spftree->tents);
+  hash_release (spftree->vertices, vertex);
+  assert (listcount (vertex->children) == 0);
+  for (ALL_LIST_ELEMENTS (vertex->parents, pnode, pnextnode, pvertex))
+    listnode_delete(pvertex->children, vertex);
+  isis_vertex_del (vertex);
 }
 
 /*
@@ -505,15 +580,14 @@ isis_spf_add2tent (struct isis_spftree *spftree, enum vertextype vtype,
 		   void *id, uint32_t cost, int depth, int family,
 		   struct isis_adjacency *adj, struct isis_vertex *parent)
 {
-  struct isis_vertex *vertex, *v;
+  struct isis_vertex *vertex;
   struct listnode *node;
   struct isis_adjacency *parent_adj;
 #ifdef EXTREME_DEBUG
   u_char buff[BUFSIZ];
 #endif
 
-  assert (isis_find_vertex (spftree->paths, id, vtype) == NULL);
-  assert (isis_find_vertex (spftree->tents, id, vtype) == NULL);
+  assert (isis_find_vertex (spftree, id, vtype) == NULL);
   vertex = isis_vertex_new (id, vtype);
   vertex->d_N = cost;
   vertex->depth = depth;
@@ -538,31 +612,9 @@ isis_spf_add2tent (struct isis_spftree *spftree, enum vertextype vtype,
 	      vertex->depth, vertex->d_N, listcount(vertex->Adj_N));
 #endif /* EXTREME_DEBUG */
 
-  if (list_isempty (spftree->tents))
-    {
-      listnode_add (spftree->tents, vertex);
-      return vertex;
-    }
-
-  /* XXX: This cant use the standard ALL_LIST_ELEMENTS macro */
-  for (node = listhead (spftree->tents); node; node = listnextnode (node))
-    {
-      v = listgetdata (node);
-      if (v->d_N > vertex->d_N)
-	{
-	  list_add_node_prev (spftree->tents, node, vertex);
-	  break;
-	}
-      else if (v->d_N == vertex->d_N && v->type > vertex->type)
-	{
-	  /*  Tie break, add according to type */
-          list_add_node_prev (spftree->tents, node, vertex);
-	  break;
-	}
-    }
-
-  if (node == NULL)
-      listnode_add (spftree->tents, vertex);
+  vertex->tent_order = spftree->tent_order++;
+  hash_get (spftree->vertices, vertex, hash_alloc_intern);
+  pqueue_enqueue (vertex, spftree->tents);
 
   return vertex;
 }
@@ -574,9 +626,9 @@ isis_spf_add_local (struct isis_spftree *spftree, enum vertextype vtype,
 {
   struct isis_vertex *vertex;
 
-  vertex = isis_find_vertex (spftree->tents, id, vtype);
+  vertex = isis_find_vertex (spftree, id, vtype);
 
-  if (vertex)
+  if (vertex && vertex->tent_index >= 0)
     {
       /* C.2.5   c) */
       if (vertex->d_N == cost)
@@ -599,13 +651,7 @@ isis_spf_add_local (struct isis_spftree *spftree, enum vertextype vtype,
 	}
       else {  /* vertex->d_N > cost */
 	  /*         f) */
-	  struct listnode *pnode, *pnextnode;
-	  struct isis_vertex *pvertex;
-	  listnode_delete (spftree->tents, vertex);
-	  assert (listcount (vertex->children) == 0);
-	  for (ALL_LIST_ELEMENTS (vertex->parents, pnode, pnextnode, pvertex))
-	    listnode_delete(pvertex->children, vertex);
-	  isis_vertex_del (vertex);
+	  isis_tent_del (spftree, vertex);
       }
     }
 
@@ -639,8 +685,8 @@ process_N (struct isis_spftree *spftree, enum vertextype vtype, void *id,
     }
 
   /*       c)    */
-  vertex = isis_find_vertex (spftree->paths, id, vtype);
-  if (vertex)
+  vertex = isis_find_vertex (spftree, id, vtype);
+  if (vertex && vertex->tent_index < 0)
     {
 #ifdef EXTREME_DEBUG
       zlog_debug ("ISIS-Spf: process_N %s %s %s dist %d already found from PATH",
@@ -651,7 +697,6 @@ process_N (struct isis_spftree *spftree, enum vertextype vtype, void *id,
       return;
     }
 
-  vertex = isis_find_vertex (spftree->tents, id, vtype);
   /*       d)    */
   if (vertex)
     {
@@ -687,13 +732,7 @@ process_N (struct isis_spftree *spftree, enum vertextype vtype, void *id,
 	}
       else
 	{
-	  struct listnode *pnode, *pnextnode;
-	  struct isis_vertex *pvertex;
-	  listnode_delete (spftree->tents, vertex);
-	  assert (listcount (vertex->children) == 0);
-	  for (ALL_LIST_ELEMENTS (vertex->parents, pnode, pnextnode, pvertex))
-	    listnode_delete(pvertex->children, vertex);
-	  isis_vertex_del (vertex);
+	  isis_tent_del (spftree, vertex);
 	}
     }
 
@@ -1125,13 +1164,13 @@ isis_spf_preload_tent (struct isis_spftree *spftree, int level,
  * now we just put the child pointer(s) in place
  */
 static void
-add_to_paths (struct isis_spftree *spftree, struct isis_vertex *vertex,
-	      int level)
+add_to_paths (struct isis_spftree *spftree, struct isis_vertex *vertex)
 {
+#ifdef EXTREME_DEBUG
   u_char buff[BUFSIZ];
+#endif /* EXTREME_DEBUG */
 
-  if (isis_find_vertex (spftree->paths, vertex->N.id, vertex->type))
-    return;
+  vertex->tent_index = -1;
   listnode_add (spftree->paths, vertex);
 
 #ifdef EXTREME_DEBUG
@@ -1141,8 +1180,21 @@ add_to_paths (struct isis_spftree *spftree, struct isis_vertex *vertex,
 	      vertex->depth, vertex->d_N);
 #endif /* EXTREME_DEBUG */
 
-  if (vertex->type > VTYPE_ES)
+  return;
+}
+
+/* Create a route for every prefix in PATHS, nearest first. */
+static void
+isis_spf_create_routes (struct isis_spftree *spftree, int level)
+{
+  struct listnode *node;
+  struct isis_vertex *vertex;
+  u_char buff[BUFSIZ];
+
+  for (ALL_LIST_ELEMENTS_RO (spftree->paths, node, vertex))
     {
+      if (vertex->type <= VTYPE_ES)
+	continue;
       if (listcount (vertex->Adj_N) > 0)
 	isis_route_create ((struct prefix *) &vertex->N.prefix, vertex->d_N,
 			   vertex->depth, vertex->Adj_N, spftree->area, level);
@@ -1151,38 +1203,87 @@ add_to_paths (struct isis_spftree *spftree, struct isis_vertex *vertex,
                     "%s depth %d dist %d", vid2string (vertex, buff),
                     vertex->depth, vertex->d_N);
     }
+}
 
-  return;
+/* Microseconds on a clock that can't roll backwards. */
+static unsigned long long
+isis_spf_usec (void)
+{
+  struct timespec time_now;
+
+  clock_gettime (CLOCK_MONOTONIC, &time_now);
+  return (unsigned long long) time_now.tv_sec * 1000000
+         + time_now.tv_nsec / 1000;
 }
 
+/*
+ * C.2.7 Step 2
+ */
 static void
-init_spt (struct isis_spftree *spftree)
+isis_spf_loop (struct isis_spftree *spftree, int level, int family,
+               u_char *sysid)
 {
-  spftree->tents->del = spftree->paths->del = (void (*)(void *)) isis_vertex_del;
-  list_delete_all_node (spftree->tents);
-  list_delete_all_node (spftree->paths);
-  spftree->tents->del = spftree->paths->del = NULL;
-  return;
+  struct isis_vertex *vertex;
+  u_char lsp_id[ISIS_SYS_ID_LEN + 2];
+  struct isis_lsp *lsp;
+
+  while (spftree->tents->size > 0)
+    {
+      vertex = pqueue_dequeue (spftree->tents);
+
+#ifdef EXTREME_DEBUG
+  zlog_debug ("ISIS-Spf: get TENT node %s %s depth %d dist %d to PATHS",
+              print_sys_hostname (vertex->N.id),
+	      vtype2string (vertex->type), vertex->depth, vertex->d_N);
+#endif /* EXTREME_DEBUG */
+
+      /* Remove from tent list and add to paths list */
+      add_to_paths (spftree, vertex);
+      switch (vertex->type)
+        {
+	case VTYPE_PSEUDO_IS:
+	case VTYPE_NONPSEUDO_IS:
+	case VTYPE_PSEUDO_TE_IS:
+	case VTYPE_NONPSEUDO_TE_IS:
+	  memcpy (lsp_id, vertex->N.id, ISIS_SYS_ID_LEN + 1);
+	  LSP_FRAGMENT (lsp_id) = 0;
+	  lsp = lsp_search (lsp_id, spftree->area->lspdb[level - 1]);
+	  if (lsp && lsp->lsp_header->rem_lifetime != 0)
+	    {
+	      if (LSP_PSEUDO_ID (lsp_id))
+		{
+		  isis_spf_process_pseudo_lsp (spftree, lsp, vertex->d_N,
+					       vertex->depth, family, sysid,
+					       vertex);
+		}
+	      else
+		{
+		  isis_spf_process_lsp (spftree, lsp, vertex->d_N,
+					vertex->depth, family, sysid, vertex);
+		}
+	    }
+	  else
+	    {
+	      zlog_warn ("ISIS-Spf: No LSP found for %s",
+			 rawlspid_print (lsp_id));
+	    }
+	  break;
+	default:;
+	}
+    }
 }
 
 static int
 isis_run_spf (struct isis_area *area, int level, int family, u_char *sysid)
 {
   int retval = ISIS_OK;
-  struct listnode *node;
-  struct isis_vertex *vertex;
   struct isis_vertex *root_vertex;
   struct isis_spftree *spftree = NULL;
-  u_char lsp_id[ISIS_SYS_ID_LEN + 2];
-  struct isis_lsp *lsp;
   struct route_table *table = NULL;
-  struct timespec time_now;
-  unsigned long long start_time, end_time;
+  struct isis_spf_log *log;
+  unsigned long long start_time, preload_time, run_time, end_time;
 
-  /* Get time that can't roll backwards. */
-  clock_gettime(CLOCK_MONOTONIC, &time_now);
-  start_time = time_now.tv_sec;
-  start_time = (start_time * 1000000) + (time_now.tv_nsec / 1000);
+  start_time = isis_spf_usec ();
 
   if (family == AF_INET)
     spftree = area->spftree[level - 1];
@@ -1211,79 +1312,41 @@ isis_run_spf (struct isis_area *area, int level, int family, u_char *sysid)
   root_vertex = isis_spf_add_root (spftree, level, sysid);
   /*              b) */
   retval = isis_spf_preload_tent (spftree, level, family, sysid, root_vertex);
+  preload_time = run_time = isis_spf_usec ();
   if (retval != ISIS_OK)
     {
       zlog_warn ("ISIS-Spf: failed to load TENT SPF-root:%s", print_sys_hostname(sysid));
       goto out;
     }
 
-  /*
-   * C.2.7 Step 2
-   */
-  if (listcount (spftree->tents) == 0)
+  if (spftree->tents->size == 0)
     {
       zlog_warn ("ISIS-Spf: TENT is empty SPF-root:%s", print_sys_hostname(sysid));
       goto out;
     }
 
-  while (listcount (spftree->tents) > 0)
-    {
-      node = listhead (spftree->tents);
-      vertex = listgetdata (node);
-
-#ifdef EXTREME_DEBUG
-  zlog_debug ("ISIS-Spf: get TENT node %s %s depth %d dist %d to PATHS",
-              print_sys_hostname (vertex->N.id),
-	      vtype2string (vertex->type), vertex->depth, vertex->d_N);
-#endif /* EXTREME_DEBUG */
-
-      /* Remove from tent list and add to paths list */
-      list_delete_node (spftree->tents, node);
-      add_to_paths (spftree, vertex, level);
-      switch (vertex->type)
-        {
-	case VTYPE_PSEUDO_IS:
-	case VTYPE_NONPSEUDO_IS:
-	case VTYPE_PSEUDO_TE_IS:
-	case VTYPE_NONPSEUDO_TE_IS:
-	  memcpy (lsp_id, vertex->N.id, ISIS_SYS_ID_LEN + 1);
-	  LSP_FRAGMENT (lsp_id) = 0;
-	  lsp = lsp_search (lsp_id, area->lspdb[level - 1]);
-	  if (lsp && lsp->lsp_header->rem_lifetime != 0)
-	    {
-	      if (LSP_PSEUDO_ID (lsp_id))
-		{
-		  isis_spf_process_pseudo_lsp (spftree, lsp, vertex->d_N,
-					       vertex->depth, family, sysid,
-					       vertex);
-		}
-	      else
-		{
-		  isis_spf_process_lsp (spftree, lsp, vertex->d_N,
-					vertex->depth, family, sysid, vertex);
-		}
-	    }
-	  else
-	    {
-	      zlog_warn ("ISIS-Spf: No LSP found for %s",
-			 rawlspid_print (lsp_id));
-	    }
-	  break;
-	default:;
-	}
-    }
+  isis_spf_loop (spftree, level, family, sysid);
+  run_time = isis_spf_usec ();
 
 out:
+  /* Routes are only made once PATHS is complete, so that the time spent
+   * on them shows apart from the algorithm's own. */
+  isis_spf_create_routes (spftree, level);
   isis_route_validate (area);
+  end_time = isis_spf_usec ();
+
+  log = &spftree->log[spftree->runcount % ISIS_SPF_LOG_SIZE];
+  log->timestamp = time (NULL);
+  log->vertices = listcount (spftree->paths);
+  log->preload = preload_time - start_time;
+  log->run = run_time - preload_time;
+  log->routes = end_time - run_time;
+
   spftree->pending = 0;
   spftree->runcount++;
-  spftree->last_run_timestamp = time (NULL);
-  clock_gettime(CLOCK_MONOTONIC, &time_now);
-  end_time = time_now.tv_sec;
-  end_time = (end_time * 1000000) + (time_now.tv_nsec / 1000);
+  spftree->last_run_timestamp = log->timestamp;
   spftree->last_run_duration = end_time - start_time;
 
-
   return retval;
 }
 
@@ -1481,6 +1544,63 @@ isis_spf_schedule6 (struct isis_area *area, int level)
 }
 #endif
 
+#ifdef TOPOLOGY_GENERATE
+/*
+ * Time SPF over the generated topology.  The runs are rooted at the
+ * first generated IS and load TENT from its LSP, so they need no
+ * adjacency, and use a tree of their own, so our routes are left alone.
+ */
+int
+isis_spf_benchmark (struct vty *vty, struct isis_area *area, int runs)
+{
+  struct isis_spftree *spftree;
+  struct isis_vertex *root_vertex;
+  struct isis_lsp *lsp;
+  u_char sysid[ISIS_SYS_ID_LEN];
+  unsigned long long start_time, preload_time, end_time;
+  unsigned long long preload = 0, run = 0, fastest = 0;
+  int i;
+
+  memcpy (sysid, area->topology_baseis, ISIS_SYS_ID_LEN);
+  sysid[ISIS_SYS_ID_LEN - 1] = 1;
+  sysid[ISIS_SYS_ID_LEN - 2] = 0;
+  lsp = isis_root_system_lsp (area, IS_LEVEL_1, sysid);
+  if (lsp == NULL)
+    {
+      vty_out (vty, "%% No generated topology%s", VTY_NEWLINE);
+      return CMD_WARNING;
+    }
+
+  spftree = isis_spftree_new (area);
+  for (i = 0; i < runs; i++)
+    {
+      start_time = isis_spf_usec ();
+      init_spt (spftree);
+      root_vertex = isis_spf_add_root (spftree, IS_LEVEL_1, sysid);
+      isis_spf_process_lsp (spftree, lsp, 0, 0, AF_INET, sysid, root_vertex);
+      preload_time = isis_spf_usec ();
+      isis_spf_loop (spftree, IS_LEVEL_1, AF_INET, sysid);
+      end_time = isis_spf_usec ();
+
+      preload += preload_time - start_time;
+      run += end_time - preload_time;
+      if (i == 0 || end_time - start_time < fastest)
+	fastest = end_time - start_time;
+    }
+
+  vty_out (vty, "%d runs from %s, %u vertices in PATHS%s", runs,
+	   print_sys_hostname (sysid), listcount (spftree->paths),
+	   VTY_NEWLINE);
+  vty_out (vty, "  average preload : %llu usec%s", preload / runs,
+	   VTY_NEWLINE);
+  vty_out (vty, "  average run     : %llu usec%s", run / runs, VTY_NEWLINE);
+  vty_out (vty, "  fastest total   : %llu usec%s", fastest, VTY_NEWLINE);
+
+  isis_spftree_del (spftree);
+  return CMD_SUCCESS;
+}
+#endif /* TOPOLOGY_GENERATE */
+
 static void
 isis_print_paths (struct vty *vty, struct list *paths, u_char *root_sysid)
 {
@@ -59,18 +59,35 @@ struct isis_vertex
   struct list *Adj_N;		/* {Adj(N)} next hop or neighbor list */
   struct list *parents;         /* list of parents for ECMP */
   struct list *children;        /* list of children used for tree dump */
+  int tent_index;               /* position in TENT, -1 once in PATHS */
+  unsigned int tent_order;      /* order of adding to TENT, for ties */
+};
+
+/* The last SPF runs, for show isis spf-log. */
+#define ISIS_SPF_LOG_SIZE 16
+
+struct isis_spf_log
+{
+  time_t timestamp;             /* when the run ended */
+  unsigned int vertices;        /* size of PATHS */
+  unsigned long preload;        /* usec loading TENT from adjacencies */
+  unsigned long run;            /* usec moving TENT to PATHS */
+  unsigned long routes;         /* usec creating and validating routes */
 };
 
 struct isis_spftree
 {
   struct thread *t_spf;		/* spf threads */
   struct list *paths;		/* the SPT */
-  struct list *tents;		/* TENT */
+  struct pqueue *tents;		/* TENT, nearest vertex first */
+  struct hash *vertices;	/* TENT and PATHS, by type and ID */
+  unsigned int tent_order;	/* vertices added to TENT this run */
   struct isis_area *area;       /* back pointer to area */
   int pending;			/* already scheduled */
   unsigned int runcount;        /* number of runs since uptime */
   time_t last_run_timestamp;    /* last run timestamp for scheduling */
-  time_t last_run_duration;     /* last run duration in msec */
+  time_t last_run_duration;     /* last run duration in usec */
+  struct isis_spf_log log[ISIS_SPF_LOG_SIZE]; /* indexed by runcount */
 };
 
 struct isis_spftree * isis_spftree_new (struct isis_area *area);
@@ -83,6 +100,9 @@ void spftree_area_adj_del (struct isis_area *area,
                            struct isis_adjacency *adj);
 int isis_spf_schedule (struct isis_area *area, int level);
 void isis_spf_cmds_init (void);
+#ifdef TOPOLOGY_GENERATE
+int isis_spf_benchmark (struct vty *vty, struct isis_area *area, int runs);
+#endif /* TOPOLOGY_GENERATE */
 #ifdef HAVE_IPV6
 int isis_spf_schedule6 (struct isis_area *area, int level);
 #endif
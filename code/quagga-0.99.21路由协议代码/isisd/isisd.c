@@ -140,7 +140,6 @@ isis_area_create (const char *area_tag)
 
   area->circuit_list = list_new ();
   area->area_addrs = list_new ();
-  THREAD_TIMER_ON (master, area->t_tick, lsp_tick, area, 1);
   flags_initialize (&area->flags);
 
   /*
@@ -289,7 +288,6 @@ isis_area_destroy (struct vty *vty, const char *area_tag)
     }
   area->area_addrs = NULL;
 
-  THREAD_TIMER_OFF (area->t_tick);
   THREAD_TIMER_OFF (area->t_lsp_refresh[0]);
   THREAD_TIMER_OFF (area->t_lsp_refresh[1]);
 
@@ -1310,6 +1308,69 @@ DEFUN (show_isis_summary,
   return CMD_SUCCESS;
 }
 
+static void
+vty_out_spf_log (struct vty *vty, struct isis_spftree *spftree)
+{
+  struct isis_spf_log *log;
+  unsigned int i, count;
+
+  count = MIN (spftree->runcount, ISIS_SPF_LOG_SIZE);
+  if (count == 0)
+    return;
+
+  vty_out (vty, "      %-16s %8s %10s %10s %10s%s", "When", "Vertices",
+           "Preload", "Run", "Routes", VTY_NEWLINE);
+  for (i = 1; i <= count; i++)
+  {
+    log = &spftree->log[(spftree->runcount - i) % ISIS_SPF_LOG_SIZE];
+    vty_out (vty, "      ");
+    vty_out_timestr (vty, log->timestamp);
+    vty_out (vty, "     %8u %10lu %10lu %10lu%s", log->vertices,
+             log->preload, log->run, log->routes, VTY_NEWLINE);
+  }
+}
+
+DEFUN (show_isis_spf_log,
+       show_isis_spf_log_cmd,
+       "show isis spf-log",
+       SHOW_STR
+       "IS-IS information\n"
+       "IS-IS SPF runs, newest first, times in usec\n")
+{
+  struct listnode *node;
+  struct isis_area *area;
+  int level;
+
+  if (isis == NULL)
+  {
+    vty_out (vty, "ISIS is not running%s", VTY_NEWLINE);
+    return CMD_SUCCESS;
+  }
+
+  for (ALL_LIST_ELEMENTS_RO (isis->area_list, node, area))
+  {
+    vty_out (vty, "Area %s:%s", area->area_tag ? area->area_tag : "null",
+        VTY_NEWLINE);
+
+    for (level = ISIS_LEVEL1; level <= ISIS_LEVELS; level++)
+    {
+      if ((area->is_type & level) == 0)
+        continue;
+
+      vty_out (vty, "  Level-%d:%s", level, VTY_NEWLINE);
+      vty_out (vty, "    IPv4 SPF:%s", VTY_NEWLINE);
+      vty_out_spf_log (vty, area->spftree[level - 1]);
+#ifdef HAVE_IPV6
+      vty_out (vty, "    IPv6 SPF:%s", VTY_NEWLINE);
+      vty_out_spf_log (vty, area->spftree6[level - 1]);
+#endif
+    }
+  }
+  vty_out (vty, "%s", VTY_NEWLINE);
+
+  return CMD_SUCCESS;
+}
+
 /*
  * This function supports following display options:
  * [ show isis database [detail] ]
@@ -2810,6 +2871,21 @@ DEFUN (topology_basedynh,
   return CMD_SUCCESS;
 }
 
+DEFUN (topology_spf_benchmark,
+       topology_spf_benchmark_cmd,
+       "topology spf-benchmark <1-10000>",
+       "Topology generation for IS-IS\n"
+       "Time SPF over the generated topology\n"
+       "Number of runs\n")
+{
+  struct isis_area *area;
+
+  area = vty->index;
+  assert (area);
+
+  return isis_spf_benchmark (vty, area, atoi (argv[0]));
+}
+
 #endif /* TOPOLOGY_GENERATE */
 
 /* IS-IS configuration write function */
@@ -3081,6 +3157,7 @@ isis_init ()
   install_node (&isis_node, isis_config_write);
 
   install_element (VIEW_NODE, &show_isis_summary_cmd);
+  install_element (VIEW_NODE, &show_isis_spf_log_cmd);
 
   install_element (VIEW_NODE, &show_isis_interface_cmd);
   install_element (VIEW_NODE, &show_isis_interface_detail_cmd);
@@ -3100,6 +3177,7 @@ isis_init ()
   install_element (VIEW_NODE, &show_database_detail_arg_cmd);
 
   install_element (ENABLE_NODE, &show_isis_summary_cmd);
+  install_element (ENABLE_NODE, &show_isis_spf_log_cmd);
 
   install_element (ENABLE_NODE, &show_isis_interface_cmd);
   install_element (ENABLE_NODE, &show_isis_interface_detail_cmd);
@@ -3250,6 +3328,7 @@ isis_init ()
   install_element (ISIS_NODE, &topology_generate_grid_cmd);
   install_element (ISIS_NODE, &topology_baseis_cmd);
   install_element (ISIS_NODE, &topology_basedynh_cmd);
+  install_element (ISIS_NODE, &topology_spf_benchmark_cmd);
   install_element (ISIS_NODE, &no_topology_baseis_cmd);
   install_element (ISIS_NODE, &no_topology_baseis_noid_cmd);
   install_element (VIEW_NODE, &show_isis_generated_topology_cmd);
@@ -94,7 +94,6 @@ struct isis_area
   unsigned int min_bcast_mtu;
   struct list *circuit_list;	/* IS-IS circuits */
   struct flags flags;
-  struct thread *t_tick;	/* LSP walker */
   struct thread *t_lsp_refresh[ISIS_LEVELS];
   int lsp_regenerate_pending[ISIS_LEVELS];
 
@@ -9,56 +9,160 @@
 #include <zebra.h>
 #include "checksum.h"
 
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif /* __SSE2__ */
+
 int			/* return checksum in low-order 16 bits */
 in_cksum(void *parg, int nbytes)
 {
-	u_short *ptr = parg;
-	register long		sum;		/* assumes long == 32 bits */
-	u_short			oddbyte;
-	register u_short	answer;		/* assumes u_short == 16 bits */
+	const u_char *p = parg;
+	u_int64_t	sum;
+	u_int64_t	w0, w1;
+	u_int32_t	w;
+	u_int16_t	half;
 
 	/*
-	 * Our algorithm is simple, using a 32-bit accumulator (sum),
-	 * we add sequential 16-bit words to it, and at the end, fold back
-	 * all the carry bits from the top 16 bits into the lower 16 bits.
+	 * The ones-complement sum does not depend on how the data is cut
+	 * into words (RFC 1071, section 2), so we add 32-bit words into a
+	 * 64-bit accumulator, which cannot overflow for any int length,
+	 * and fold it down to 16 bits at the end.  memcpy() keeps the
+	 * loads safe on strict-alignment machines; compilers turn it into
+	 * a plain load.
 	 */
 
 	sum = 0;
-	while (nbytes > 1)  {
-		sum += *ptr++;
+#ifdef __SSE2__
+	if (nbytes >= 32) {
+		const __m128i zero = _mm_setzero_si128 ();
+		__m128i acc = zero, v;
+		u_int64_t lanes[2];
+
+		for (; nbytes >= 16; nbytes -= 16, p += 16) {
+			v = _mm_loadu_si128 ((const __m128i *) p);
+			acc = _mm_add_epi64 (acc, _mm_unpacklo_epi32 (v, zero));
+			acc = _mm_add_epi64 (acc, _mm_unpackhi_epi32 (v, zero));
+		}
+		_mm_storeu_si128 ((__m128i *) lanes, acc);
+		sum = (lanes[0] & 0xffffffff) + (lanes[0] >> 32)
+		    + (lanes[1] & 0xffffffff) + (lanes[1] >> 32);
+	}
+#endif /* __SSE2__ */
+	for (; nbytes >= 16; nbytes -= 16, p += 16) {
+		memcpy (&w0, p, 8);
+		memcpy (&w1, p + 8, 8);
+		sum += (w0 & 0xffffffff) + (w0 >> 32)
+		     + (w1 & 0xffffffff) + (w1 >> 32);
+	}
+	for (; nbytes >= 4; nbytes -= 4, p += 4) {
+		memcpy (&w, p, 4);
+		sum += w;
+	}
+	if (nbytes >= 2) {
+		memcpy (&half, p, 2);
+		sum += half;
+		p += 2;
 		nbytes -= 2;
 	}
-
 				/* mop up an odd byte, if necessary */
 	if (nbytes == 1) {
-		oddbyte = 0;		/* make sure top half is zero */
-		*((u_char *) &oddbyte) = *(u_char *)ptr;   /* one byte only */
-		sum += oddbyte;
+		half = 0;		/* make sure top half is zero */
+		*((u_char *) &half) = *p;	/* one byte only */
+		sum += half;
 	}
 
 	/*
-	 * Add back carry outs from top 16 bits to low 16 bits.
+	 * Fold the carries back in until the sum fits in 16 bits.
 	 */
 
-	sum  = (sum >> 16) + (sum & 0xffff);	/* add high-16 to low-16 */
-	sum += (sum >> 16);			/* add carry */
-	answer = ~sum;		/* ones-complement, then truncate to 16 bits */
-	return(answer);
+	sum = (sum >> 32) + (sum & 0xffffffff);
+	sum = (sum >> 32) + (sum & 0xffffffff);
+	sum = (sum >> 16) + (sum & 0xffff);
+	sum = (sum >> 16) + (sum & 0xffff);
+	sum = (sum >> 16) + (sum & 0xffff);
+	return (u_int16_t) ~sum;	/* ones-complement, truncated */
 }
 
 /* Fletcher Checksum -- Refer to RFC1008. */
 #define MODX                 4102   /* 5802 should be fine */
 
+/* Sum LEN bytes into the two Fletcher accumulators, each reduced mod 255.
+ * Over a run of n bytes b[0..n-1], c0 gains the plain sum and c1 gains
+ * n * c0 plus the sum of (n - i) * b[i], so a block of bytes can be
+ * added at once rather than one byte after the other.  The running sums
+ * are only reduced every MODX bytes, which keeps c1 within 32 bits.
+ */
+static void
+fletcher_accumulate (const u_char *p, size_t len, int *c0p, int *c1p)
+{
+  u_int32_t c0 = 0, c1 = 0;
+  size_t n;
+
+  while (len != 0)
+    {
+      n = MIN (len, MODX);
+      len -= n;
+
+#ifdef __SSE2__
+      if (n >= 16)
+	{
+	  const __m128i zero = _mm_setzero_si128 ();
+	  const __m128i wlo = _mm_set_epi16 (9, 10, 11, 12, 13, 14, 15, 16);
+	  const __m128i whi = _mm_set_epi16 (1, 2, 3, 4, 5, 6, 7, 8);
+	  __m128i vs = zero, vp = zero, vw = zero, v;
+	  size_t k = n / 16;
+	  u_int32_t t[4];
+
+	  /* vs: byte sums; vp: vs before each 16 bytes, i.e. what the
+	   * bytes before them add to c1; vw: the (16 - i) * b[i] terms. */
+	  c1 += (u_int32_t) (k * 16) * c0;
+	  n -= k * 16;
+	  for (; k; k--, p += 16)
+	    {
+	      v = _mm_loadu_si128 ((const __m128i *) p);
+	      vp = _mm_add_epi32 (vp, vs);
+	      vs = _mm_add_epi32 (vs, _mm_sad_epu8 (v, zero));
+	      vw = _mm_add_epi32 (vw, _mm_madd_epi16 (_mm_unpacklo_epi8 (v, zero),
+						      wlo));
+	      vw = _mm_add_epi32 (vw, _mm_madd_epi16 (_mm_unpackhi_epi8 (v, zero),
+						      whi));
+	    }
+	  vw = _mm_add_epi32 (vw, _mm_slli_epi32 (vp, 4));
+	  _mm_storeu_si128 ((__m128i *) t, vw);
+	  c1 += t[0] + t[1] + t[2] + t[3];
+	  _mm_storeu_si128 ((__m128i *) t, vs);
+	  c0 += t[0] + t[2];
+	}
+#endif /* __SSE2__ */
+
+      for (; n >= 8; n -= 8, p += 8)
+	{
+	  c1 += 8 * c0 + 8 * p[0] + 7 * p[1] + 6 * p[2] + 5 * p[3]
+		+ 4 * p[4] + 3 * p[5] + 2 * p[6] + p[7];
+	  c0 += p[0] + p[1] + p[2] + p[3] + p[4] + p[5] + p[6] + p[7];
+	}
+      for (; n != 0; n--)
+	{
+	  c0 += *p++;
+	  c1 += c0;
+	}
+
+      c0 = c0 % 255;
+      c1 = c1 % 255;
+    }
+
+  *c0p = c0;
+  *c1p = c1;
+}
+
 /* To be consistent, offset is 0-based index, rather than the 1-based 
    index required in the specification ISO 8473, Annex C.1 */
 u_int16_t
 fletcher_checksum(u_char * buffer, const size_t len, const uint16_t offset)
 {
-  u_int8_t *p;
   int x, y, c0, c1;
   u_int16_t checksum;
   u_int16_t *csum;
-  size_t partial_len, i, left = len;
   
   checksum = 0;
 
@@ -70,26 +174,8 @@ fletcher_checksum(u_char * buffer, const size_t len, const uint16_t offset)
   csum = (u_int16_t *) (buffer + offset);
   *(csum) = 0;
 
-  p = buffer;
-  c0 = 0;
-  c1 = 0;
-
-  while (left != 0)
-    {
-      partial_len = MIN(left, MODX);
-
-      for (i = 0; i < partial_len; i++)
-	{
-	  c0 = c0 + *(p++);
-	  c1 += c0;
-	}
+  fletcher_accumulate (buffer, len, &c0, &c1);
 
-      c0 = c0 % 255;
-      c1 = c1 % 255;
-
-      left -= partial_len;
-    }
-  
   /* The cast is important, to ensure the mod is taken as a signed value. */
   x = (int)((len - offset - 1) * c0 - c1) % 255;
 
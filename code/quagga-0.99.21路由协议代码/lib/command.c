@@ -30,6 +30,7 @@ Boston, MA 02111-1307, USA.  */
 #include "vty.h"
 #include "command.h"
 #include "workqueue.h"
+#include "hash.h"
 
 /* Command vector which includes some level of command lists. Normally
    each daemon maintains each own cmdvec. */
@@ -186,6 +187,191 @@ argv_concat (const char **argv, int argc, int shift)
   return str;
 }
 
+/* The commands of a node, merged on their leading tokens.  A tree node
+   at depth n stands for the commands whose first n tokens take the same
+   alternatives, so that matching a line walks its words down from the
+   root instead of filtering every command of the node by every word. */
+struct cmd_tree
+{
+  /* Alternatives of the token leading here, NULL at the root. */
+  vector descvec;
+
+  /* All children, and those whose token takes more than keywords,
+     which every word has to be tried against. */
+  vector children;
+  vector others;
+
+  /* The keywords of the other children, sorted, so that those a word
+     is a prefix of are found by binary search. */
+  struct cmd_keyword *keywords;
+  unsigned int keywords_count;
+  unsigned int keywords_max;
+
+  /* Commands through here, and how many of them have all their
+     mandatory tokens at this depth; one of each. */
+  unsigned int count;
+  unsigned int complete;
+  struct cmd_element *cmd;
+  struct cmd_element *complete_cmd;
+
+  /* Last cmd_tree_filter () pass that tried this node. */
+  unsigned int mark;
+};
+
+struct cmd_keyword
+{
+  const char *word;
+  struct cmd_tree *tree;
+};
+
+static struct cmd_tree *
+cmd_tree_new (vector descvec)
+{
+  struct cmd_tree *tree;
+
+  tree = XCALLOC (MTYPE_CMD_TREE, sizeof (struct cmd_tree));
+  tree->descvec = descvec;
+  tree->children = vector_init (VECTOR_MIN_SIZE);
+  tree->others = vector_init (VECTOR_MIN_SIZE);
+  return tree;
+}
+
+static void
+cmd_tree_free (struct cmd_tree *tree)
+{
+  unsigned int i;
+
+  for (i = 0; i < vector_active (tree->children); i++)
+    cmd_tree_free (vector_slot (tree->children, i));
+  vector_free (tree->children);
+  vector_free (tree->others);
+  if (tree->keywords)
+    XFREE (MTYPE_CMD_TREE, tree->keywords);
+  XFREE (MTYPE_CMD_TREE, tree);
+}
+
+/* Is str a keyword, which a word matches by being a prefix of it? */
+static int
+cmd_desc_keyword (const char *str)
+{
+  return ! (CMD_VARARG (str) || CMD_RANGE (str)
+#ifdef HAVE_IPV6
+	    || CMD_IPV6 (str) || CMD_IPV6_PREFIX (str)
+#endif /* HAVE_IPV6 */
+	    || CMD_IPV4 (str) || CMD_IPV4_PREFIX (str)
+	    || CMD_OPTION (str) || CMD_VARIABLE (str));
+}
+
+/* Do two tokens take the same alternatives, in whatever order? */
+static int
+cmd_descvec_same (vector a, vector b)
+{
+  unsigned int i, j;
+  struct desc *da, *db;
+
+  if (vector_active (a) != vector_active (b))
+    return 0;
+
+  for (i = 0; i < vector_active (a); i++)
+    {
+      da = vector_slot (a, i);
+      for (j = 0; j < vector_active (b); j++)
+	{
+	  db = vector_slot (b, j);
+	  if (strcmp (da->cmd, db->cmd) == 0)
+	    break;
+	}
+      if (j == vector_active (b))
+	return 0;
+    }
+  return 1;
+}
+
+/* Index of the first keyword of tree not sorting before word. */
+static unsigned int
+cmd_tree_keyword_find (struct cmd_tree *tree, const char *word)
+{
+  unsigned int low = 0, high = tree->keywords_count, mid;
+
+  while (low < high)
+    {
+      mid = (low + high) / 2;
+      if (strcmp (tree->keywords[mid].word, word) < 0)
+	low = mid + 1;
+      else
+	high = mid;
+    }
+  return low;
+}
+
+static struct cmd_tree *
+cmd_tree_child (struct cmd_tree *tree, vector descvec)
+{
+  struct cmd_tree *child;
+  struct desc *desc;
+  unsigned int i, k;
+
+  for (i = 0; i < vector_active (tree->children); i++)
+    {
+      child = vector_slot (tree->children, i);
+      if (cmd_descvec_same (child->descvec, descvec))
+	return child;
+    }
+
+  child = cmd_tree_new (descvec);
+  vector_set_index (tree->children, vector_active (tree->children), child);
+
+  for (i = 0; i < vector_active (descvec); i++)
+    {
+      desc = vector_slot (descvec, i);
+      if (! cmd_desc_keyword (desc->cmd))
+	{
+	  vector_set_index (tree->others, vector_active (tree->others), child);
+	  return child;
+	}
+    }
+
+  for (i = 0; i < vector_active (descvec); i++)
+    {
+      desc = vector_slot (descvec, i);
+      if (tree->keywords_count == tree->keywords_max)
+	{
+	  tree->keywords_max = tree->keywords_max ? tree->keywords_max * 2 : 4;
+	  tree->keywords = XREALLOC (MTYPE_CMD_TREE, tree->keywords,
+				     tree->keywords_max
+				     * sizeof (struct cmd_keyword));
+	}
+      k = cmd_tree_keyword_find (tree, desc->cmd);
+      memmove (&tree->keywords[k + 1], &tree->keywords[k],
+	       (tree->keywords_count - k) * sizeof (struct cmd_keyword));
+      tree->keywords[k].word = desc->cmd;
+      tree->keywords[k].tree = child;
+      tree->keywords_count++;
+    }
+  return child;
+}
+
+/* Add a command to the tree of a node it is installed in. */
+static void
+cmd_tree_add (struct cmd_tree *tree, struct cmd_element *cmd)
+{
+  unsigned int depth;
+
+  for (depth = 0; ; depth++)
+    {
+      tree->count++;
+      tree->cmd = cmd;
+      if (cmd->cmdsize <= depth)
+	{
+	  tree->complete++;
+	  tree->complete_cmd = cmd;
+	}
+      if (depth == vector_active (cmd->strvec))
+	break;
+      tree = cmd_tree_child (tree, vector_slot (cmd->strvec, depth));
+    }
+}
+
 /* Install top node of command vector. */
 void
 install_node (struct cmd_node *node, 
@@ -194,6 +380,7 @@ install_node (struct cmd_node *node,
   vector_set_index (cmdvec, node->node, node);
   node->func = func;
   node->cmd_vector = vector_init (VECTOR_MIN_SIZE);
+  node->cmd_tree = cmd_tree_new (NULL);
 }
 
 /* Compare two command's string.  Used in sort_node (). */
@@ -502,6 +689,7 @@ install_element (enum node_type ntype, struct cmd_element *cmd)
     cmd->strvec = cmd_make_descvec (cmd->string, cmd->doc);
 
   cmd->cmdsize = cmd_cmdsize (cmd->strvec);
+  cmd_tree_add (cnode->cmd_tree, cmd);
 }
 
 static const unsigned char itoa64[] =
@@ -607,6 +795,11 @@ config_write_host (struct vty *vty)
     vty_out (vty, "log timestamp precision %d%s",
 	     zlog_default->timestamp_precision, VTY_NEWLINE);
 
+  if (zlog_default->async != ZLOG_ASYNC_OFF)
+    vty_out (vty, "log asynchronous %s%s",
+	     zlog_default->async == ZLOG_ASYNC_DROP ? "drop" : "block",
+	     VTY_NEWLINE);
+
   if (host.advanced)
     vty_out (vty, "service advanced-vty%s", VTY_NEWLINE);
 
@@ -1130,131 +1323,113 @@ cmd_range_match (const char *range, const char *str)
   return 1;
 }
 
-/* Make completion match and return match type flag. */
-static enum match_type
-cmd_filter_by_completion (char *command, vector v, unsigned int index)
+/* Match command against the alternatives a command takes at one
+   position, for completion.  Raise *best to the best match found and
+   return how many alternatives matched. */
+static int
+cmd_match_by_completion (char *command, vector descvec,
+			 enum match_type *best)
 {
-  unsigned int i;
+  unsigned int j;
   const char *str;
-  struct cmd_element *cmd_element;
-  enum match_type match_type;
-  vector descvec;
+  enum match_type match_type = *best;
   struct desc *desc;
+  int matched = 0;
 
-  match_type = no_match;
-
-  /* If command and cmd_element string does not match set NULL to vector */
-  for (i = 0; i < vector_active (v); i++)
-    if ((cmd_element = vector_slot (v, i)) != NULL)
+  for (j = 0; j < vector_active (descvec); j++)
+    if ((desc = vector_slot (descvec, j)))
       {
-	if (index >= vector_active (cmd_element->strvec))
-	  vector_slot (v, i) = NULL;
-	else
-	  {
-	    unsigned int j;
-	    int matched = 0;
+	str = desc->cmd;
 
-	    descvec = vector_slot (cmd_element->strvec, index);
-
-	    for (j = 0; j < vector_active (descvec); j++)
-	      if ((desc = vector_slot (descvec, j)))
-		{
-		  str = desc->cmd;
-		  
-		  if (CMD_VARARG (str))
-		    {
-		      if (match_type < vararg_match)
-			match_type = vararg_match;
-		      matched++;
-		    }
-		  else if (CMD_RANGE (str))
-		    {
-		      if (cmd_range_match (str, command))
-			{
-			  if (match_type < range_match)
-			    match_type = range_match;
+	if (CMD_VARARG (str))
+	  {
+	    if (match_type < vararg_match)
+	      match_type = vararg_match;
+	    matched++;
+	  }
+	else if (CMD_RANGE (str))
+	  {
+	    if (cmd_range_match (str, command))
+	      {
+		if (match_type < range_match)
+		  match_type = range_match;
 
-			  matched++;
-			}
-		    }
+		matched++;
+	      }
+	  }
 #ifdef HAVE_IPV6
-		  else if (CMD_IPV6 (str))
-		    {
-		      if (cmd_ipv6_match (command))
-			{
-			  if (match_type < ipv6_match)
-			    match_type = ipv6_match;
+	else if (CMD_IPV6 (str))
+	  {
+	    if (cmd_ipv6_match (command))
+	      {
+		if (match_type < ipv6_match)
+		  match_type = ipv6_match;
 
-			  matched++;
-			}
-		    }
-		  else if (CMD_IPV6_PREFIX (str))
-		    {
-		      if (cmd_ipv6_prefix_match (command))
-			{
-			  if (match_type < ipv6_prefix_match)
-			    match_type = ipv6_prefix_match;
+		matched++;
+	      }
+	  }
+	else if (CMD_IPV6_PREFIX (str))
+	  {
+	    if (cmd_ipv6_prefix_match (command))
+	      {
+		if (match_type < ipv6_prefix_match)
+		  match_type = ipv6_prefix_match;
 
-			  matched++;
-			}
-		    }
+		matched++;
+	      }
+	  }
 #endif /* HAVE_IPV6  */
-		  else if (CMD_IPV4 (str))
-		    {
-		      if (cmd_ipv4_match (command))
-			{
-			  if (match_type < ipv4_match)
-			    match_type = ipv4_match;
+	else if (CMD_IPV4 (str))
+	  {
+	    if (cmd_ipv4_match (command))
+	      {
+		if (match_type < ipv4_match)
+		  match_type = ipv4_match;
 
-			  matched++;
-			}
-		    }
-		  else if (CMD_IPV4_PREFIX (str))
-		    {
-		      if (cmd_ipv4_prefix_match (command))
-			{
-			  if (match_type < ipv4_prefix_match)
-			    match_type = ipv4_prefix_match;
-			  matched++;
-			}
-		    }
-		  else
-		    /* Check is this point's argument optional ? */
-		  if (CMD_OPTION (str) || CMD_VARIABLE (str))
-		    {
-		      if (match_type < extend_match)
-			match_type = extend_match;
-		      matched++;
-		    }
-		  else if (strncmp (command, str, strlen (command)) == 0)
-		    {
-		      if (strcmp (command, str) == 0)
-			match_type = exact_match;
-		      else
-			{
-			  if (match_type < partly_match)
-			    match_type = partly_match;
-			}
-		      matched++;
-		    }
-		}
-	    if (!matched)
-	      vector_slot (v, i) = NULL;
+		matched++;
+	      }
+	  }
+	else if (CMD_IPV4_PREFIX (str))
+	  {
+	    if (cmd_ipv4_prefix_match (command))
+	      {
+		if (match_type < ipv4_prefix_match)
+		  match_type = ipv4_prefix_match;
+		matched++;
+	      }
+	  }
+	else
+	  /* Check is this point's argument optional ? */
+	if (CMD_OPTION (str) || CMD_VARIABLE (str))
+	  {
+	    if (match_type < extend_match)
+	      match_type = extend_match;
+	    matched++;
+	  }
+	else if (strncmp (command, str, strlen (command)) == 0)
+	  {
+	    if (strcmp (command, str) == 0)
+	      match_type = exact_match;
+	    else
+	      {
+		if (match_type < partly_match)
+		  match_type = partly_match;
+	      }
+	    matched++;
 	  }
       }
-  return match_type;
+
+  *best = match_type;
+  return matched;
 }
 
-/* Filter vector by command character with index. */
+/* Make completion match and return match type flag. */
 static enum match_type
-cmd_filter_by_string (char *command, vector v, unsigned int index)
+cmd_filter_by_completion (char *command, vector v, unsigned int index)
 {
   unsigned int i;
-  const char *str;
   struct cmd_element *cmd_element;
   enum match_type match_type;
-  vector descvec;
-  struct desc *desc;
 
   match_type = no_match;
 
@@ -1262,95 +1437,198 @@ cmd_filter_by_string (char *command, vector v, unsigned int index)
   for (i = 0; i < vector_active (v); i++)
     if ((cmd_element = vector_slot (v, i)) != NULL)
       {
-	/* If given index is bigger than max string vector of command,
-	   set NULL */
 	if (index >= vector_active (cmd_element->strvec))
 	  vector_slot (v, i) = NULL;
+	else if (! cmd_match_by_completion (command,
+					    vector_slot (cmd_element->strvec,
+							 index),
+					    &match_type))
+	  vector_slot (v, i) = NULL;
+      }
+  return match_type;
+}
+
+/* Match command exactly against the alternatives a command takes at one
+   position, as configuration files are read.  Raise *best to the best
+   match found and return how many alternatives matched. */
+static int
+cmd_match_by_string (char *command, vector descvec, enum match_type *best)
+{
+  unsigned int j;
+  const char *str;
+  enum match_type match_type = *best;
+  struct desc *desc;
+  int matched = 0;
+
+  for (j = 0; j < vector_active (descvec); j++)
+    if ((desc = vector_slot (descvec, j)))
+      {
+	str = desc->cmd;
+
+	if (CMD_VARARG (str))
+	  {
+	    if (match_type < vararg_match)
+	      match_type = vararg_match;
+	    matched++;
+	  }
+	else if (CMD_RANGE (str))
+	  {
+	    if (cmd_range_match (str, command))
+	      {
+		if (match_type < range_match)
+		  match_type = range_match;
+		matched++;
+	      }
+	  }
+#ifdef HAVE_IPV6
+	else if (CMD_IPV6 (str))
+	  {
+	    if (cmd_ipv6_match (command) == exact_match)
+	      {
+		if (match_type < ipv6_match)
+		  match_type = ipv6_match;
+		matched++;
+	      }
+	  }
+	else if (CMD_IPV6_PREFIX (str))
+	  {
+	    if (cmd_ipv6_prefix_match (command) == exact_match)
+	      {
+		if (match_type < ipv6_prefix_match)
+		  match_type = ipv6_prefix_match;
+		matched++;
+	      }
+	  }
+#endif /* HAVE_IPV6  */
+	else if (CMD_IPV4 (str))
+	  {
+	    if (cmd_ipv4_match (command) == exact_match)
+	      {
+		if (match_type < ipv4_match)
+		  match_type = ipv4_match;
+		matched++;
+	      }
+	  }
+	else if (CMD_IPV4_PREFIX (str))
+	  {
+	    if (cmd_ipv4_prefix_match (command) == exact_match)
+	      {
+		if (match_type < ipv4_prefix_match)
+		  match_type = ipv4_prefix_match;
+		matched++;
+	      }
+	  }
+	else if (CMD_OPTION (str) || CMD_VARIABLE (str))
+	  {
+	    if (match_type < extend_match)
+	      match_type = extend_match;
+	    matched++;
+	  }
 	else
 	  {
-	    unsigned int j;
-	    int matched = 0;
+	    if (strcmp (command, str) == 0)
+	      {
+		match_type = exact_match;
+		matched++;
+	      }
+	  }
+      }
 
-	    descvec = vector_slot (cmd_element->strvec, index);
+  *best = match_type;
+  return matched;
+}
 
-	    for (j = 0; j < vector_active (descvec); j++)
-	      if ((desc = vector_slot (descvec, j)))
-		{
-		  str = desc->cmd;
+/* Check the alternatives a command takes at one position for an
+   ambiguous match of the given type, against the alternative *matched
+   that earlier commands matched.  Return 1 if the match is ambiguous, 2
+   if it is incomplete, and otherwise 0 with the number of alternatives
+   matched in *match. */
+static int
+cmd_ambiguous_desc (char *command, vector descvec, enum match_type type,
+		    const char **matchedp, int *matchp)
+{
+  unsigned int j;
+  const char *str = NULL;
+  const char *matched = *matchedp;
+  struct desc *desc;
+  int match = 0;
 
-		  if (CMD_VARARG (str))
-		    {
-		      if (match_type < vararg_match)
-			match_type = vararg_match;
-		      matched++;
-		    }
-		  else if (CMD_RANGE (str))
-		    {
-		      if (cmd_range_match (str, command))
-			{
-			  if (match_type < range_match)
-			    match_type = range_match;
-			  matched++;
-			}
-		    }
+  for (j = 0; j < vector_active (descvec); j++)
+    if ((desc = vector_slot (descvec, j)))
+      {
+	enum match_type ret;
+
+	str = desc->cmd;
+
+	switch (type)
+	  {
+	  case exact_match:
+	    if (!(CMD_OPTION (str) || CMD_VARIABLE (str))
+		&& strcmp (command, str) == 0)
+	      match++;
+	    break;
+	  case partly_match:
+	    if (!(CMD_OPTION (str) || CMD_VARIABLE (str))
+		&& strncmp (command, str, strlen (command)) == 0)
+	      {
+		if (matched && strcmp (matched, str) != 0)
+		  return 1;	/* There is ambiguous match. */
+		else
+		  matched = str;
+		match++;
+	      }
+	    break;
+	  case range_match:
+	    if (cmd_range_match (str, command))
+	      {
+		if (matched && strcmp (matched, str) != 0)
+		  return 1;
+		else
+		  matched = str;
+		match++;
+	      }
+	    break;
 #ifdef HAVE_IPV6
-		  else if (CMD_IPV6 (str))
-		    {
-		      if (cmd_ipv6_match (command) == exact_match)
-			{
-			  if (match_type < ipv6_match)
-			    match_type = ipv6_match;
-			  matched++;
-			}
-		    }
-		  else if (CMD_IPV6_PREFIX (str))
-		    {
-		      if (cmd_ipv6_prefix_match (command) == exact_match)
-			{
-			  if (match_type < ipv6_prefix_match)
-			    match_type = ipv6_prefix_match;
-			  matched++;
-			}
-		    }
-#endif /* HAVE_IPV6  */
-		  else if (CMD_IPV4 (str))
-		    {
-		      if (cmd_ipv4_match (command) == exact_match)
-			{
-			  if (match_type < ipv4_match)
-			    match_type = ipv4_match;
-			  matched++;
-			}
-		    }
-		  else if (CMD_IPV4_PREFIX (str))
-		    {
-		      if (cmd_ipv4_prefix_match (command) == exact_match)
-			{
-			  if (match_type < ipv4_prefix_match)
-			    match_type = ipv4_prefix_match;
-			  matched++;
-			}
-		    }
-		  else if (CMD_OPTION (str) || CMD_VARIABLE (str))
-		    {
-		      if (match_type < extend_match)
-			match_type = extend_match;
-		      matched++;
-		    }
-		  else
-		    {
-		      if (strcmp (command, str) == 0)
-			{
-			  match_type = exact_match;
-			  matched++;
-			}
-		    }
-		}
-	    if (!matched)
-	      vector_slot (v, i) = NULL;
+	  case ipv6_match:
+	    if (CMD_IPV6 (str))
+	      match++;
+	    break;
+	  case ipv6_prefix_match:
+	    if ((ret = cmd_ipv6_prefix_match (command)) != no_match)
+	      {
+		if (ret == partly_match)
+		  return 2;	/* There is incomplete match. */
+
+		match++;
+	      }
+	    break;
+#endif /* HAVE_IPV6 */
+	  case ipv4_match:
+	    if (CMD_IPV4 (str))
+	      match++;
+	    break;
+	  case ipv4_prefix_match:
+	    if ((ret = cmd_ipv4_prefix_match (command)) != no_match)
+	      {
+		if (ret == partly_match)
+		  return 2;	/* There is incomplete match. */
+
+		match++;
+	      }
+	    break;
+	  case extend_match:
+	    if (CMD_OPTION (str) || CMD_VARIABLE (str))
+	      match++;
+	    break;
+	  case no_match:
+	  default:
+	    break;
 	  }
       }
-  return match_type;
+
+  *matchedp = matched;
+  *matchp = match;
+  return 0;
 }
 
 /* Check ambiguous match */
@@ -1358,98 +1636,215 @@ static int
 is_cmd_ambiguous (char *command, vector v, int index, enum match_type type)
 {
   unsigned int i;
-  unsigned int j;
-  const char *str = NULL;
   struct cmd_element *cmd_element;
   const char *matched = NULL;
-  vector descvec;
-  struct desc *desc;
+  int match, ret;
 
   for (i = 0; i < vector_active (v); i++)
     if ((cmd_element = vector_slot (v, i)) != NULL)
       {
-	int match = 0;
+	ret = cmd_ambiguous_desc (command, vector_slot (cmd_element->strvec,
+							index),
+				  type, &matched, &match);
+	if (ret)
+	  return ret;
+	if (!match)
+	  vector_slot (v, i) = NULL;
+      }
+  return 0;
+}
 
-	descvec = vector_slot (cmd_element->strvec, index);
+/* Filter the children of the tree nodes in v by command, as
+   cmd_filter_by_completion() or, if strict, cmd_match_by_string() does
+   for the commands below them, and leave those that match in
+   next.  Only the keyword children command is a prefix of, or equal to
+   if strict, have to be tried, besides the others. */
+static enum match_type
+cmd_tree_filter (char *command, vector v, vector next, int strict)
+{
+  static unsigned int mark;
+  unsigned int i, k;
+  size_t len = strlen (command);
+  struct cmd_tree *tree, *child;
+  enum match_type match_type = no_match;
+  int matched;
 
-	for (j = 0; j < vector_active (descvec); j++)
-	  if ((desc = vector_slot (descvec, j)))
-	    {
-	      enum match_type ret;
-	      
-	      str = desc->cmd;
+  mark++;
+  next->active = 0;
 
-	      switch (type)
-		{
-		case exact_match:
-		  if (!(CMD_OPTION (str) || CMD_VARIABLE (str))
-		      && strcmp (command, str) == 0)
-		    match++;
-		  break;
-		case partly_match:
-		  if (!(CMD_OPTION (str) || CMD_VARIABLE (str))
-		      && strncmp (command, str, strlen (command)) == 0)
-		    {
-		      if (matched && strcmp (matched, str) != 0)
-			return 1;	/* There is ambiguous match. */
-		      else
-			matched = str;
-		      match++;
-		    }
-		  break;
-		case range_match:
-		  if (cmd_range_match (str, command))
-		    {
-		      if (matched && strcmp (matched, str) != 0)
-			return 1;
-		      else
-			matched = str;
-		      match++;
-		    }
-		  break;
-#ifdef HAVE_IPV6
-		case ipv6_match:
-		  if (CMD_IPV6 (str))
-		    match++;
-		  break;
-		case ipv6_prefix_match:
-		  if ((ret = cmd_ipv6_prefix_match (command)) != no_match)
-		    {
-		      if (ret == partly_match)
-			return 2;	/* There is incomplete match. */
+  for (i = 0; i < vector_active (v); i++)
+    {
+      tree = vector_slot (v, i);
 
-		      match++;
-		    }
-		  break;
-#endif /* HAVE_IPV6 */
-		case ipv4_match:
-		  if (CMD_IPV4 (str))
-		    match++;
-		  break;
-		case ipv4_prefix_match:
-		  if ((ret = cmd_ipv4_prefix_match (command)) != no_match)
-		    {
-		      if (ret == partly_match)
-			return 2;	/* There is incomplete match. */
+      for (k = cmd_tree_keyword_find (tree, command);
+	   k < tree->keywords_count; k++)
+	{
+	  if (strncmp (command, tree->keywords[k].word, len) != 0
+	      || (strict && tree->keywords[k].word[len] != '\0'))
+	    break;
+
+	  /* A child is indexed under each of its keywords. */
+	  child = tree->keywords[k].tree;
+	  if (child->mark == mark)
+	    continue;
+	  child->mark = mark;
+
+	  if (strict)
+	    matched = cmd_match_by_string (command, child->descvec,
+					   &match_type);
+	  else
+	    matched = cmd_match_by_completion (command, child->descvec,
+					       &match_type);
+	  if (matched)
+	    vector_set_index (next, vector_active (next), child);
+	}
 
-		      match++;
-		    }
-		  break;
-		case extend_match:
-		  if (CMD_OPTION (str) || CMD_VARIABLE (str))
-		    match++;
-		  break;
-		case no_match:
-		default:
-		  break;
-		}
-	    }
-	if (!match)
-	  vector_slot (v, i) = NULL;
-      }
+      for (k = 0; k < vector_active (tree->others); k++)
+	{
+	  child = vector_slot (tree->others, k);
+	  if (strict)
+	    matched = cmd_match_by_string (command, child->descvec,
+					   &match_type);
+	  else
+	    matched = cmd_match_by_completion (command, child->descvec,
+					       &match_type);
+	  if (matched)
+	    vector_set_index (next, vector_active (next), child);
+	}
+    }
+  return match_type;
+}
+
+/* Check the tree nodes in v for an ambiguous match, as is_cmd_ambiguous()
+   does the commands below them, and drop those that do not match. */
+static int
+cmd_tree_ambiguous (char *command, vector v, enum match_type type)
+{
+  unsigned int i, n;
+  struct cmd_tree *tree;
+  const char *matched = NULL;
+  int match, ret;
+
+  for (i = n = 0; i < vector_active (v); i++)
+    {
+      tree = vector_slot (v, i);
+      ret = cmd_ambiguous_desc (command, tree->descvec, type,
+				&matched, &match);
+      if (ret)
+	return ret;
+      if (match)
+	vector_slot (v, n++) = tree;
+    }
+  v->active = n;
   return 0;
 }
 
+/* Find the command of a node vline matches, walking the node's command
+   tree a word at a time; the result is the one filtering a copy of the
+   node's command vector by every word would give.  Return CMD_SUCCESS
+   with the command in *matched, or why there is none. */
+static int
+cmd_tree_match (vector vline, enum node_type ntype, int strict,
+		struct cmd_element **matched)
+{
+  unsigned int i, index;
+  struct cmd_node *cnode;
+  struct cmd_tree *tree;
+  struct cmd_element *matched_element;
+  unsigned int matched_count, incomplete_count;
+  enum match_type match = 0;
+  vector v, next, swap;
+  char *command;
+
+  cnode = vector_slot (cmdvec, ntype);
+  v = vector_init (VECTOR_MIN_SIZE);
+  next = vector_init (VECTOR_MIN_SIZE);
+  vector_set_index (v, 0, cnode->cmd_tree);
+
+  for (index = 0; index < vector_active (vline); index++)
+    {
+      int ret = 0;
+
+      command = vector_slot (vline, index);
+      if (command == NULL)
+	{
+	  /* A missing word matches whatever comes next. */
+	  next->active = 0;
+	  for (i = 0; i < vector_active (v); i++)
+	    {
+	      unsigned int k;
+
+	      tree = vector_slot (v, i);
+	      for (k = 0; k < vector_active (tree->children); k++)
+		vector_set_index (next, vector_active (next),
+				  vector_slot (tree->children, k));
+	    }
+	}
+      else
+	match = cmd_tree_filter (command, v, next, strict);
+
+      swap = v;
+      v = next;
+      next = swap;
+
+      if (command == NULL)
+	continue;
+
+      /* If command meets '.VARARG' then finish matching. */
+      if (match == vararg_match)
+	break;
+
+      ret = cmd_tree_ambiguous (command, v, match);
+      if (ret)
+	{
+	  vector_free (v);
+	  vector_free (next);
+	  return ret == 1 ? CMD_ERR_AMBIGUOUS : CMD_ERR_NO_MATCH;
+	}
+    }
+
+  /* Check matched count.  Past a '.VARARG' every command left matches,
+     otherwise those with all their mandatory words. */
+  matched_element = NULL;
+  matched_count = 0;
+  incomplete_count = 0;
+
+  for (i = 0; i < vector_active (v); i++)
+    {
+      tree = vector_slot (v, i);
+      if (match == vararg_match)
+	{
+	  matched_element = tree->cmd;
+	  matched_count += tree->count;
+	}
+      else
+	{
+	  if (tree->complete)
+	    matched_element = tree->complete_cmd;
+	  matched_count += tree->complete;
+	  incomplete_count += tree->count - tree->complete;
+	}
+    }
+
+  vector_free (v);
+  vector_free (next);
+
+  /* To execute command, matched_count must be 1. */
+  if (matched_count == 0)
+    {
+      if (incomplete_count)
+	return CMD_ERR_INCOMPLETE;
+      else
+	return CMD_ERR_NO_MATCH;
+    }
+
+  if (matched_count > 1)
+    return CMD_ERR_AMBIGUOUS;
+
+  *matched = matched_element;
+  return CMD_SUCCESS;
+}
+
 /* If src matches dst return dst string, otherwise return NULL */
 static const char *
 cmd_entry_function (const char *src, const char *dst)
@@ -2005,80 +2400,15 @@ cmd_execute_command_real (vector vline, struct vty *vty,
 			  struct cmd_element **cmd)
 {
   unsigned int i;
-  unsigned int index;
-  vector cmd_vector;
-  struct cmd_element *cmd_element;
   struct cmd_element *matched_element;
-  unsigned int matched_count, incomplete_count;
   int argc;
   const char *argv[CMD_ARGC_MAX];
-  enum match_type match = 0;
   int varflag;
-  char *command;
-
-  /* Make copy of command elements. */
-  cmd_vector = vector_copy (cmd_node_vector (cmdvec, vty->node));
-
-  for (index = 0; index < vector_active (vline); index++)
-    if ((command = vector_slot (vline, index)))
-      {
-	int ret;
-
-	match = cmd_filter_by_completion (command, cmd_vector, index);
-
-	if (match == vararg_match)
-	  break;
-        
-	ret = is_cmd_ambiguous (command, cmd_vector, index, match);
-
-	if (ret == 1)
-	  {
-	    vector_free (cmd_vector);
-	    return CMD_ERR_AMBIGUOUS;
-	  }
-	else if (ret == 2)
-	  {
-	    vector_free (cmd_vector);
-	    return CMD_ERR_NO_MATCH;
-	  }
-      }
-
-  /* Check matched count. */
-  matched_element = NULL;
-  matched_count = 0;
-  incomplete_count = 0;
-
-  for (i = 0; i < vector_active (cmd_vector); i++)
-    if ((cmd_element = vector_slot (cmd_vector, i)))
-      {
-	if (match == vararg_match || index >= cmd_element->cmdsize)
-	  {
-	    matched_element = cmd_element;
-#if 0
-	    printf ("DEBUG: %s\n", cmd_element->string);
-#endif
-	    matched_count++;
-	  }
-	else
-	  {
-	    incomplete_count++;
-	  }
-      }
-
-  /* Finish of using cmd_vector. */
-  vector_free (cmd_vector);
-
-  /* To execute command, matched_count must be 1. */
-  if (matched_count == 0)
-    {
-      if (incomplete_count)
-	return CMD_ERR_INCOMPLETE;
-      else
-	return CMD_ERR_NO_MATCH;
-    }
+  int ret;
 
-  if (matched_count > 1)
-    return CMD_ERR_AMBIGUOUS;
+  ret = cmd_tree_match (vline, vty->node, 0, &matched_element);
+  if (ret != CMD_SUCCESS)
+    return ret;
 
   /* Argument treatment */
   varflag = 0;
@@ -2184,77 +2514,16 @@ cmd_execute_command_strict (vector vline, struct vty *vty,
 			    struct cmd_element **cmd)
 {
   unsigned int i;
-  unsigned int index;
-  vector cmd_vector;
-  struct cmd_element *cmd_element;
   struct cmd_element *matched_element;
-  unsigned int matched_count, incomplete_count;
   int argc;
   const char *argv[CMD_ARGC_MAX];
   int varflag;
-  enum match_type match = 0;
-  char *command;
-
-  /* Make copy of command element */
-  cmd_vector = vector_copy (cmd_node_vector (cmdvec, vty->node));
-
-  for (index = 0; index < vector_active (vline); index++)
-    if ((command = vector_slot (vline, index)))
-      {
-	int ret;
-	
-	match = cmd_filter_by_string (vector_slot (vline, index),
-				      cmd_vector, index);
-
-	/* If command meets '.VARARG' then finish matching. */
-	if (match == vararg_match)
-	  break;
-        
-	ret = is_cmd_ambiguous (command, cmd_vector, index, match);
-	if (ret == 1)
-	  {
-	    vector_free (cmd_vector);
-	    return CMD_ERR_AMBIGUOUS;
-	  }
-	if (ret == 2)
-	  {
-	    vector_free (cmd_vector);
-	    return CMD_ERR_NO_MATCH;
-	  }
-      }
-
-  /* Check matched count. */
-  matched_element = NULL;
-  matched_count = 0;
-  incomplete_count = 0;
-  for (i = 0; i < vector_active (cmd_vector); i++)
-    if (vector_slot (cmd_vector, i) != NULL)
-      {
-	cmd_element = vector_slot (cmd_vector, i);
-
-	if (match == vararg_match || index >= cmd_element->cmdsize)
-	  {
-	    matched_element = cmd_element;
-	    matched_count++;
-	  }
-	else
-	  incomplete_count++;
-      }
-
-  /* Finish of using cmd_vector. */
-  vector_free (cmd_vector);
-
-  /* To execute command, matched_count must be 1. */
-  if (matched_count == 0)
-    {
-      if (incomplete_count)
-	return CMD_ERR_INCOMPLETE;
-      else
-	return CMD_ERR_NO_MATCH;
-    }
+  int ret;
 
-  if (matched_count > 1)
-    return CMD_ERR_AMBIGUOUS;
+  /* Configuration is read with keywords in full. */
+  ret = cmd_tree_match (vline, vty->node, 1, &matched_element);
+  if (ret != CMD_SUCCESS)
+    return ret;
 
   /* Argument treatment */
   varflag = 0;
@@ -3111,6 +3380,13 @@ DEFUN (show_logging,
   	   (zl->record_priority ? "enabled" : "disabled"), VTY_NEWLINE);
   vty_out (vty, "Timestamp precision: %d%s",
 	   zl->timestamp_precision, VTY_NEWLINE);
+  vty_out (vty, "Asynchronous logging: ");
+  if (zl->async == ZLOG_ASYNC_OFF)
+    vty_out (vty, "disabled");
+  else
+    vty_out (vty, "%s when full, %lu messages dropped",
+	     zl->async == ZLOG_ASYNC_DROP ? "drop" : "block", zl->dropped);
+  vty_out (vty, "%s", VTY_NEWLINE);
 
   return CMD_SUCCESS;
 }
@@ -3466,6 +3742,46 @@ DEFUN (no_config_log_timestamp_precision,
   return CMD_SUCCESS;
 }
 
+DEFUN (config_log_async,
+       config_log_async_cmd,
+       "log asynchronous (drop|block)",
+       "Logging control\n"
+       "Queue messages for a thread of their own to write out\n"
+       "Drop messages that find the queue full\n"
+       "Wait for room when the queue is full\n")
+{
+  zlog_async_t policy;
+
+  policy = (argv[0][0] == 'd') ? ZLOG_ASYNC_DROP : ZLOG_ASYNC_BLOCK;
+  if (! zlog_set_async (NULL, policy))
+    {
+      vty_out (vty, "%% Asynchronous logging is not available%s",
+	       VTY_NEWLINE);
+      return CMD_WARNING;
+    }
+  return CMD_SUCCESS;
+}
+
+DEFUN (no_config_log_async,
+       no_config_log_async_cmd,
+       "no log asynchronous",
+       NO_STR
+       "Logging control\n"
+       "Write every message as it is logged\n")
+{
+  zlog_set_async (NULL, ZLOG_ASYNC_OFF);
+  return CMD_SUCCESS;
+}
+
+ALIAS (no_config_log_async,
+       no_config_log_async_policy_cmd,
+       "no log asynchronous (drop|block)",
+       NO_STR
+       "Logging control\n"
+       "Write every message as it is logged\n"
+       "Drop messages that find the queue full\n"
+       "Wait for room when the queue is full\n")
+
 DEFUN (banner_motd_file,
        banner_motd_file_cmd,
        "banner motd file [FILE]",
@@ -3639,6 +3955,9 @@ cmd_init (int terminal)
       install_element (CONFIG_NODE, &no_config_log_record_priority_cmd);
       install_element (CONFIG_NODE, &config_log_timestamp_precision_cmd);
       install_element (CONFIG_NODE, &no_config_log_timestamp_precision_cmd);
+      install_element (CONFIG_NODE, &config_log_async_cmd);
+      install_element (CONFIG_NODE, &no_config_log_async_cmd);
+      install_element (CONFIG_NODE, &no_config_log_async_policy_cmd);
       install_element (CONFIG_NODE, &service_password_encrypt_cmd);
       install_element (CONFIG_NODE, &no_service_password_encrypt_cmd);
       install_element (CONFIG_NODE, &banner_motd_default_cmd);
@@ -3654,6 +3973,8 @@ cmd_init (int terminal)
       install_element (ENABLE_NODE, &clear_thread_cpu_cmd);
       install_element (VIEW_NODE, &show_work_queues_cmd);
       install_element (ENABLE_NODE, &show_work_queues_cmd);
+      install_element (VIEW_NODE, &show_hashtable_cmd);
+      install_element (ENABLE_NODE, &show_hashtable_cmd);
     }
   srand(time(NULL));
 }
@@ -3701,6 +4022,7 @@ cmd_terminate ()
                 }
 
             vector_free (cmd_node_v);
+            cmd_tree_free (cmd_node->cmd_tree);
           }
 
       vector_free (cmdvec);
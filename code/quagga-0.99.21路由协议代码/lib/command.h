@@ -123,6 +123,9 @@ struct cmd_node
 
   /* Vector of this node's command list. */
   vector cmd_vector;	
+
+  /* The same commands, merged on their leading tokens for matching. */
+  struct cmd_tree *cmd_tree;
 };
 
 enum
@@ -634,7 +634,7 @@ config_show_distribute (struct vty *vty)
     vty_out (vty, "  Outgoing update filter list for all interface is not set%s", VTY_NEWLINE);
 
   for (i = 0; i < disthash->size; i++)
-    for (mp = disthash->index[i]; mp; mp = mp->next)
+    if ((mp = hash_backet_at (disthash, i)) != NULL)
       {
 	dist = mp->data;
 	if (dist->ifname)
@@ -669,7 +669,7 @@ config_show_distribute (struct vty *vty)
     vty_out (vty, "  Incoming update filter list for all interface is not set%s", VTY_NEWLINE);
 
   for (i = 0; i < disthash->size; i++)
-    for (mp = disthash->index[i]; mp; mp = mp->next)
+    if ((mp = hash_backet_at (disthash, i)) != NULL)
       {
 	dist = mp->data;
 	if (dist->ifname)
@@ -697,7 +697,7 @@ config_write_distribute (struct vty *vty)
   int write = 0;
 
   for (i = 0; i < disthash->size; i++)
-    for (mp = disthash->index[i]; mp; mp = mp->next)
+    if ((mp = hash_backet_at (disthash, i)) != NULL)
       {
 	struct distribute *dist;
 
@@ -755,7 +755,8 @@ void
 distribute_list_init (int node)
 {
   disthash = hash_create (distribute_hash_make,
-                          (int (*) (const void *, const void *)) distribute_cmp);
+                          (int (*) (const void *, const void *)) distribute_cmp,
+                          "Distribute lists");
 
   if(node==RIP_NODE) {
     install_element (node, &distribute_list_all_cmd);
@@ -224,21 +224,14 @@ access_list_free (struct access_list *access)
   XFREE (MTYPE_ACCESS_LIST, access);
 }
 
-/* Delete access_list from access_master and free it. */
+/* Take access_list out of access_master, so that lookups no longer
+   find it. */
 static void
-access_list_delete (struct access_list *access)
+access_list_unlink (struct access_list *access)
 {
-  struct filter *filter;
-  struct filter *next;
   struct access_list_list *list;
   struct access_master *master;
 
-  for (filter = access->head; filter; filter = next)
-    {
-      next = filter->next;
-      filter_free (filter);
-    }
-
   master = access->master;
 
   if (access->type == ACCESS_TYPE_NUMBER)
@@ -256,6 +249,25 @@ access_list_delete (struct access_list *access)
   else
     list->head = access->next;
 
+  access->master = NULL;
+}
+
+/* Delete access_list from access_master and free it. */
+static void
+access_list_delete (struct access_list *access)
+{
+  struct filter *filter;
+  struct filter *next;
+
+  for (filter = access->head; filter; filter = next)
+    {
+      next = filter->next;
+      filter_free (filter);
+    }
+
+  if (access->master)
+    access_list_unlink (access);
+
   if (access->name)
     XFREE (MTYPE_ACCESS_LIST_STR, access->name);
 
@@ -1337,6 +1349,10 @@ DEFUN (no_access_list_all,
 
   master = access->master;
 
+  /* Take it out first: hook functions look access-lists up again by
+     name, and must not find it. */
+  access_list_unlink (access);
+
   /* Run hook function. */
   if (master->delete_hook)
     (*master->delete_hook) (access);
@@ -1508,6 +1524,10 @@ DEFUN (no_ipv6_access_list_all,
 
   master = access->master;
 
+  /* Take it out first: hook functions look access-lists up again by
+     name, and must not find it. */
+  access_list_unlink (access);
+
   /* Run hook function. */
   if (master->delete_hook)
     (*master->delete_hook) (access);
@@ -23,21 +23,80 @@
 
 #include "hash.h"
 #include "memory.h"
+#include "linklist.h"
+#include "command.h"
 
-/* Allocate a new hash.  */
+/* All hash tables, for show hashtable. */
+static struct list *hashes;
+
+/* Data of a slot whose entry has been released.  Lookups probe past
+   it, inserts may take it over. */
+static char hash_deleted_mark;
+#define HASH_DELETED ((void *) &hash_deleted_mark)
+
+#define HASH_BACKET_USED(B) ((B)->data && (B)->data != HASH_DELETED)
+
+/* Home slot of KEY.  Some keys only vary in their high bits, so mix
+   them before masking down to the table size. */
+static unsigned int
+hash_slot (struct hash *hash, unsigned int key)
+{
+  key ^= key >> 16;
+  key *= 0x45d9f3b;
+  key ^= key >> 16;
+  return key & (hash->size - 1);
+}
+
+/* Rebuild the table with SIZE slots, which also clears out the slots
+   of released entries. */
+static void
+hash_resize (struct hash *hash, unsigned int size)
+{
+  struct hash_backet *index = hash->index;
+  unsigned int old_size = hash->size;
+  unsigned int i, j;
+
+  hash->index = XCALLOC (MTYPE_HASH_INDEX, sizeof (struct hash_backet) * size);
+  hash->size = size;
+  hash->deleted = 0;
+  if (size != old_size)
+    hash->resizes++;
+
+  for (i = 0; i < old_size; i++)
+    if (HASH_BACKET_USED (&index[i]))
+      {
+	for (j = hash_slot (hash, index[i].key); hash->index[j].data;
+	     j = (j + 1) & (size - 1))
+	  ;
+	hash->index[j] = index[i];
+      }
+
+  XFREE (MTYPE_HASH_INDEX, index);
+}
+
+/* Allocate a new hash.  SIZE is a hint of how many entries to expect;
+   the table is never shrunk below it.  */
 struct hash *
 hash_create_size (unsigned int size, unsigned int (*hash_key) (void *),
-                                     int (*hash_cmp) (const void *, const void *))
+                                     int (*hash_cmp) (const void *, const void *),
+		  const char *name)
 {
   struct hash *hash;
 
-  hash = XMALLOC (MTYPE_HASH, sizeof (struct hash));
+  hash = XCALLOC (MTYPE_HASH, sizeof (struct hash));
+  for (hash->size = 8; hash->size < size; hash->size <<= 1)
+    ;
+  hash->min_size = hash->size;
   hash->index = XCALLOC (MTYPE_HASH_INDEX,
-			 sizeof (struct hash_backet *) * size);
-  hash->size = size;
+			 sizeof (struct hash_backet) * hash->size);
   hash->hash_key = hash_key;
   hash->hash_cmp = hash_cmp;
   hash->count = 0;
+  hash->name = name;
+
+  if (hashes == NULL)
+    hashes = list_new ();
+  listnode_add (hashes, hash);
 
   return hash;
 }
@@ -45,9 +104,10 @@ hash_create_size (unsigned int size, unsigned int (*hash_key) (void *),
 /* Allocate a new hash with default hash size.  */
 struct hash *
 hash_create (unsigned int (*hash_key) (void *), 
-             int (*hash_cmp) (const void *, const void *))
+             int (*hash_cmp) (const void *, const void *),
+	     const char *name)
 {
-  return hash_create_size (HASHTABSIZE, hash_key, hash_cmp);
+  return hash_create_size (HASHTABSIZE, hash_key, hash_cmp, name);
 }
 
 /* Utility function for hash_get().  When this function is specified
@@ -69,13 +129,21 @@ hash_get (struct hash *hash, void *data, void * (*alloc_func) (void *))
   unsigned int index;
   void *newdata;
   struct hash_backet *backet;
+  struct hash_backet *reuse = NULL;
 
   key = (*hash->hash_key) (data);
-  index = key % hash->size;
 
-  for (backet = hash->index[index]; backet != NULL; backet = backet->next) 
-    if (backet->key == key && (*hash->hash_cmp) (backet->data, data))
-      return backet->data;
+  for (index = hash_slot (hash, key); (backet = &hash->index[index])->data;
+       index = (index + 1) & (hash->size - 1))
+    {
+      if (backet->data == HASH_DELETED)
+	{
+	  if (! reuse)
+	    reuse = backet;
+	}
+      else if (backet->key == key && (*hash->hash_cmp) (backet->data, data))
+	return backet->data;
+    }
 
   if (alloc_func)
     {
@@ -83,11 +151,28 @@ hash_get (struct hash *hash, void *data, void * (*alloc_func) (void *))
       if (newdata == NULL)
 	return NULL;
 
-      backet = XMALLOC (MTYPE_HASH_BACKET, sizeof (struct hash_backet));
+      if (reuse)
+	{
+	  backet = reuse;
+	  hash->deleted--;
+	}
+      /* Keep at least a quarter of the slots free, so probe sequences
+	 stay short.  While the table is being iterated over, it is only
+	 rebuilt if it would otherwise fill up. */
+      else if ((hash->count + hash->deleted + 1) * 4 > hash->size * 3
+	       && (! hash->iterating
+		   || hash->count + hash->deleted + 2 > hash->size))
+	{
+	  hash_resize (hash, (hash->count + 1) * 2 > hash->size
+			     ? hash->size * 2 : hash->size);
+	  for (index = hash_slot (hash, key); hash->index[index].data;
+	       index = (index + 1) & (hash->size - 1))
+	    ;
+	  backet = &hash->index[index];
+	}
+
       backet->data = newdata;
       backet->key = key;
-      backet->next = hash->index[index];
-      hash->index[index] = backet;
       hash->count++;
       return backet->data;
     }
@@ -112,6 +197,15 @@ unsigned int string_hash_make (const char *str)
   return hash;
 }
 
+/* Halve a table that has become mostly empty. */
+static void
+hash_shrink (struct hash *hash)
+{
+  if (! hash->iterating && hash->size > hash->min_size
+      && hash->count * 8 < hash->size)
+    hash_resize (hash, hash->size / 2);
+}
+
 /* This function release registered value from specified hash.  When
    release is successfully finished, return the data pointer in the
    hash backet.  */
@@ -121,49 +215,69 @@ hash_release (struct hash *hash, void *data)
   void *ret;
   unsigned int key;
   unsigned int index;
+  unsigned int mask = hash->size - 1;
   struct hash_backet *backet;
-  struct hash_backet *pp;
 
   key = (*hash->hash_key) (data);
-  index = key % hash->size;
 
-  for (backet = pp = hash->index[index]; backet; backet = backet->next)
+  for (index = hash_slot (hash, key); (backet = &hash->index[index])->data;
+       index = (index + 1) & mask)
     {
-      if (backet->key == key && (*hash->hash_cmp) (backet->data, data)) 
+      if (backet->data != HASH_DELETED
+	  && backet->key == key && (*hash->hash_cmp) (backet->data, data)) 
 	{
-	  if (backet == pp) 
-	    hash->index[index] = backet->next;
-	  else 
-	    pp->next = backet->next;
-
 	  ret = backet->data;
-	  XFREE (MTYPE_HASH_BACKET, backet);
+
+	  /* If nothing probes past this slot, it and any released
+	     slots just before it can be freed outright. */
+	  if (hash->index[(index + 1) & mask].data == NULL)
+	    {
+	      backet->data = NULL;
+	      for (index = (index - 1) & mask;
+		   hash->index[index].data == HASH_DELETED;
+		   index = (index - 1) & mask)
+		{
+		  hash->index[index].data = NULL;
+		  hash->deleted--;
+		}
+	    }
+	  else
+	    {
+	      backet->data = HASH_DELETED;
+	      hash->deleted++;
+	    }
+
 	  hash->count--;
+	  hash_shrink (hash);
 	  return ret;
 	}
-      pp = backet;
     }
   return NULL;
 }
 
-/* Iterator function for hash.  */
+/* Iterator function for hash.  FUNC may release the backet it is given,
+   or others.  */
 void
 hash_iterate (struct hash *hash, 
 	      void (*func) (struct hash_backet *, void *), void *arg)
 {
   unsigned int i;
-  struct hash_backet *hb;
-  struct hash_backet *hbnext;
 
+  hash->iterating++;
   for (i = 0; i < hash->size; i++)
-    for (hb = hash->index[i]; hb; hb = hbnext)
-      {
-	/* get pointer to next hash backet here, in case (*func)
-	 * decides to delete hb by calling hash_release
-	 */
-	hbnext = hb->next;
-	(*func) (hb, arg);
-      }
+    if (HASH_BACKET_USED (&hash->index[i]))
+      (*func) (&hash->index[i], arg);
+  hash->iterating--;
+
+  hash_shrink (hash);
+}
+
+/* The backet in slot I of HASH, or NULL if the slot is free.  For
+   walking all of a table in place, with I from 0 to hash->size.  */
+struct hash_backet *
+hash_backet_at (struct hash *hash, unsigned int i)
+{
+  return HASH_BACKET_USED (&hash->index[i]) ? &hash->index[i] : NULL;
 }
 
 /* Clean up hash.  */
@@ -171,23 +285,24 @@ void
 hash_clean (struct hash *hash, void (*free_func) (void *))
 {
   unsigned int i;
-  struct hash_backet *hb;
-  struct hash_backet *next;
+  void *data;
 
   for (i = 0; i < hash->size; i++)
-    {
-      for (hb = hash->index[i]; hb; hb = next)
-	{
-	  next = hb->next;
-	      
-	  if (free_func)
-	    (*free_func) (hb->data);
+    if (HASH_BACKET_USED (&hash->index[i]))
+      {
+	data = hash->index[i].data;
+	hash->index[i].data = HASH_DELETED;
+	hash->count--;
 
-	  XFREE (MTYPE_HASH_BACKET, hb);
-	  hash->count--;
-	}
-      hash->index[i] = NULL;
-    }
+	if (free_func)
+	  (*free_func) (data);
+      }
+
+  XFREE (MTYPE_HASH_INDEX, hash->index);
+  hash->size = hash->min_size;
+  hash->index = XCALLOC (MTYPE_HASH_INDEX,
+			 sizeof (struct hash_backet) * hash->size);
+  hash->deleted = 0;
 }
 
 /* Free hash memory.  You may call hash_clean before call this
@@ -195,6 +310,48 @@ hash_clean (struct hash *hash, void (*free_func) (void *))
 void
 hash_free (struct hash *hash)
 {
+  listnode_delete (hashes, hash);
   XFREE (MTYPE_HASH_INDEX, hash->index);
   XFREE (MTYPE_HASH, hash);
 }
+
+DEFUN (show_hashtable,
+       show_hashtable_cmd,
+       "show hashtable",
+       SHOW_STR
+       "Hash table statistics\n")
+{
+  struct listnode *node;
+  struct hash *hash;
+  unsigned int i, probes, max;
+  unsigned long total;
+
+  vty_out (vty, "%-26s %8s %8s %5s %8s %5s %7s%s",
+	   "Name", "Size", "Entries", "Load", "Probes", "Max", "Resizes",
+	   VTY_NEWLINE);
+
+  if (hashes == NULL)
+    return CMD_SUCCESS;
+  for (ALL_LIST_ELEMENTS_RO (hashes, node, hash))
+    {
+      /* Probes a lookup of each entry takes, from its home slot. */
+      total = max = 0;
+      for (i = 0; i < hash->size; i++)
+	if (HASH_BACKET_USED (&hash->index[i]))
+	  {
+	    probes = ((i - hash_slot (hash, hash->index[i].key))
+		      & (hash->size - 1)) + 1;
+	    total += probes;
+	    if (probes > max)
+	      max = probes;
+	  }
+
+      vty_out (vty, "%-26s %8u %8lu %4lu%% %8.2f %5u %7lu%s",
+	       hash->name ? hash->name : "(unnamed)",
+	       hash->size, hash->count, hash->count * 100 / hash->size,
+	       hash->count ? (double) total / hash->count : 0.0, max,
+	       hash->resizes, VTY_NEWLINE);
+    }
+
+  return CMD_SUCCESS;
+}
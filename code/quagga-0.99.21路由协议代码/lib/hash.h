@@ -21,14 +21,15 @@ Boston, MA 02111-1307, USA.  */
 #ifndef _ZEBRA_HASH_H
 #define _ZEBRA_HASH_H
 
-/* Default hash table size.  */ 
-#define HASHTABSIZE     1024
+/* Default hash table size.  Tables grow from here as entries are added,
+   and shrink back to it as they are removed. */
+#define HASHTABSIZE     256
 
+/* One slot of the table.  Tables use open addressing with linear
+   probing, so backets are stored in place rather than allocated one by
+   one; a slot is in use when its data is set. */
 struct hash_backet
 {
-  /* Linked list.  */
-  struct hash_backet *next;
-
   /* Hash key. */
   unsigned int key;
 
@@ -39,11 +40,22 @@ struct hash_backet
 struct hash
 {
   /* Hash backet. */
-  struct hash_backet **index;
+  struct hash_backet *index;
 
-  /* Hash table size. */
+  /* Hash table size, a power of two. */
   unsigned int size;
 
+  /* Size the table was created with, below which it does not shrink. */
+  unsigned int min_size;
+
+  /* Slots left behind by hash_release(), cleared when the table is
+     rebuilt. */
+  unsigned int deleted;
+
+  /* Set while hash_iterate() runs; the table is not rebuilt meanwhile,
+     so that callbacks may release the backet they are given. */
+  unsigned int iterating;
+
   /* Key make function. */
   unsigned int (*hash_key) (void *);
 
@@ -52,12 +64,20 @@ struct hash
 
   /* Backet alloc. */
   unsigned long count;
+
+  /* Times the table has been rebuilt at a new size. */
+  unsigned long resizes;
+
+  /* Name for show hashtable. */
+  const char *name;
 };
 
 extern struct hash *hash_create (unsigned int (*) (void *), 
-				 int (*) (const void *, const void *));
+				 int (*) (const void *, const void *),
+				 const char *);
 extern struct hash *hash_create_size (unsigned int, unsigned int (*) (void *), 
-                                             int (*) (const void *, const void *));
+                                             int (*) (const void *, const void *),
+				      const char *);
 
 extern void *hash_get (struct hash *, void *, void * (*) (void *));
 extern void *hash_alloc_intern (void *);
@@ -66,10 +86,13 @@ extern void *hash_release (struct hash *, void *);
 
 extern void hash_iterate (struct hash *, 
 		   void (*) (struct hash_backet *, void *), void *);
+extern struct hash_backet *hash_backet_at (struct hash *, unsigned int);
 
 extern void hash_clean (struct hash *, void (*) (void *));
 extern void hash_free (struct hash *);
 
 extern unsigned int string_hash_make (const char *);
 
+extern struct cmd_element show_hashtable_cmd;
+
 #endif /* _ZEBRA_HASH_H */
@@ -283,7 +283,7 @@ config_write_if_rmap (struct vty *vty)
   int write = 0;
 
   for (i = 0; i < ifrmaphash->size; i++)
-    for (mp = ifrmaphash->index[i]; mp; mp = mp->next)
+    if ((mp = hash_backet_at (ifrmaphash, i)) != NULL)
       {
 	struct if_rmap *if_rmap;
 
@@ -319,7 +319,8 @@ if_rmap_reset ()
 void
 if_rmap_init (int node)
 {
-  ifrmaphash = hash_create (if_rmap_hash_make, if_rmap_hash_cmp);
+  ifrmaphash = hash_create (if_rmap_hash_make, if_rmap_hash_cmp,
+                            "Interface route-maps");
   if (node == RIPNG_NODE) {
     install_element (RIPNG_NODE, &if_ipv6_rmap_cmd);
     install_element (RIPNG_NODE, &no_if_ipv6_rmap_cmd);
@@ -34,9 +34,83 @@
 #ifdef HAVE_UCONTEXT_H
 #include <ucontext.h>
 #endif
+#include <pthread.h>
 
 static int logfile_fd = -1;	/* Used in signal handler. */
 
+/* Asynchronous logging: vzlog() formats each message once into a ring
+   of ZLOG_RING_SIZE bytes, allocated when it is turned on, and a writer
+   thread of its own writes the ring out to syslog, the file and stdout,
+   so that the daemon doesn't wait on them.  The writer allocates
+   nothing.  The daemon's thread is the only one that queues, and the
+   writer the only one that takes, so the ring needs no lock: each
+   publishes its end with a store-release the other loads with
+   load-acquire.  The lock and its conditions are only for waiting on
+   an empty or a full ring. */
+#define ZLOG_RING_SIZE 262144
+
+/* Longer messages are cut short. */
+#define ZLOG_MSG_MAX 8192
+
+/* Lines to the file or stdout written by one writev(). */
+#if defined(IOV_MAX) && IOV_MAX < 256
+#define ZLOG_IOV_MAX IOV_MAX
+#else
+#define ZLOG_IOV_MAX 256
+#endif
+
+/* A message in the ring, followed by its line for the file and stdout:
+   HLEN bytes of timestamp, priority and protocol name, the message,
+   which is what syslog gets, and a newline.  An entry for no
+   destinations fills the end of the ring that the next one didn't fit
+   in; where less than an entry is left, the ring wraps without one. */
+struct zlog_entry
+{
+  u_int32_t size;	/* in the ring, padding included */
+  u_int32_t len;	/* of the line */
+  u_int16_t hlen;
+  u_char dests;		/* bits for zlog_dest_t */
+  int priority;		/* for syslog, with the facility */
+};
+#define ZLOG_ENTRY_ALIGN 8
+#define ZLOG_ENTRY_SIZE(L) \
+  ((sizeof (struct zlog_entry) + (L) + ZLOG_ENTRY_ALIGN - 1) \
+   & ~(ZLOG_ENTRY_ALIGN - 1))
+
+struct zlog_ring
+{
+  struct zlog *zl;
+  struct zlog_ring *next;	/* in zlog_rings */
+
+  pthread_mutex_t mtx;
+  pthread_cond_t queued;	/* to the writer: there is something */
+  pthread_cond_t written;	/* from the writer: there is room */
+  pthread_t writer;
+  int running;
+  int idle;			/* writer waits on queued */
+  int waiting;			/* daemon waits on written */
+  int stop;
+
+  /* Bytes ever queued, moved on by the daemon alone, and bytes ever
+     written out, moved on by the writer alone.  Both run on past
+     ZLOG_RING_SIZE, modulo which they are offsets into buf. */
+  size_t head;
+  size_t tail;
+  char buf[ZLOG_RING_SIZE];
+};
+
+/* Those in use, for fork(). */
+static struct zlog_ring *zlog_rings;
+
+#define ZLOG_LOAD(P) __atomic_load_n ((P), __ATOMIC_ACQUIRE)
+#define ZLOG_STORE(P,V) __atomic_store_n ((P), (V), __ATOMIC_RELEASE)
+
+/* For an end or a flag that is set before looking whether the other
+   side waits on it, or has moved on: sequentially consistent, so that
+   one of the two sees the other. */
+#define ZLOG_SYNC_LOAD(P) __atomic_load_n ((P), __ATOMIC_SEQ_CST)
+#define ZLOG_SYNC_STORE(P,V) __atomic_store_n ((P), (V), __ATOMIC_SEQ_CST)
+
 struct zlog *zlog_default = NULL;
 
 const char *zlog_proto_names[] = 
@@ -144,6 +218,454 @@ time_print(FILE *fp, struct timestamp_control *ctl)
     }
   fprintf(fp, "%s ", ctl->buf);
 }
+
+/* Write out a buffer, however many writes it takes. */
+static void
+zlog_write (int fd, const char *buf, size_t len)
+{
+  ssize_t nbyte;
+
+  while (len > 0)
+    {
+      nbyte = write (fd, buf, len);
+      if (nbyte < 0)
+	{
+	  if (errno == EINTR)
+	    continue;
+	  return;
+	}
+      buf += nbyte;
+      len -= nbyte;
+    }
+}
+
+/* Write out lines, however many writes it takes. */
+static void
+zlog_writev (int fd, struct iovec *iov, int iovcnt)
+{
+  ssize_t nbyte;
+
+  while (iovcnt > 0)
+    {
+      nbyte = writev (fd, iov, iovcnt);
+      if (nbyte < 0)
+	{
+	  if (errno == EINTR)
+	    continue;
+	  return;
+	}
+      while (iovcnt > 0 && (size_t) nbyte >= iov->iov_len)
+	{
+	  nbyte -= iov->iov_len;
+	  iov++;
+	  iovcnt--;
+	}
+      if (iovcnt > 0)
+	{
+	  iov->iov_base = (char *) iov->iov_base + nbyte;
+	  iov->iov_len -= nbyte;
+	}
+    }
+}
+
+/* Add a line to those to write out to FD, writing them out if there
+   are ZLOG_IOV_MAX of them. */
+static void
+zlog_iov_put (int fd, struct iovec *iov, int *iovcnt, char *line, size_t len)
+{
+  iov[*iovcnt].iov_base = line;
+  iov[*iovcnt].iov_len = len;
+  if (++(*iovcnt) == ZLOG_IOV_MAX)
+    {
+      zlog_writev (fd, iov, *iovcnt);
+      *iovcnt = 0;
+    }
+}
+
+/* The next of the entries from *POS up to HEAD, or NULL when there
+   are none left. */
+static struct zlog_entry *
+zlog_ring_next (struct zlog_ring *r, size_t *pos, size_t head)
+{
+  struct zlog_entry *e;
+  size_t off = *pos % ZLOG_RING_SIZE;
+
+  if (*pos != head && ZLOG_RING_SIZE - off < sizeof (struct zlog_entry))
+    {
+      *pos += ZLOG_RING_SIZE - off;
+      off = 0;
+    }
+  if (head - *pos < sizeof (struct zlog_entry))
+    return NULL;
+
+  e = (struct zlog_entry *) (r->buf + off);
+  if (e->size < sizeof (struct zlog_entry) || e->size > head - *pos)
+    return NULL;
+  *pos += e->size;
+  return e;
+}
+
+/* Write out the entries from TAIL up to HEAD: one syslog() call per
+   message, and one writev() for every ZLOG_IOV_MAX lines to the file
+   and stdout. */
+static void
+zlog_ring_write (struct zlog_ring *r, size_t tail, size_t head, int fd)
+{
+  struct iovec file[ZLOG_IOV_MAX], out[ZLOG_IOV_MAX];
+  int nfile = 0, nout = 0;
+  struct zlog_entry *e;
+  char *line;
+
+  while ((e = zlog_ring_next (r, &tail, head)) != NULL)
+    {
+      line = (char *) (e + 1);
+      if (e->dests & (1 << ZLOG_DEST_SYSLOG))
+	syslog (e->priority, "%.*s", (int) (e->len - e->hlen - 1),
+		line + e->hlen);
+      if ((e->dests & (1 << ZLOG_DEST_FILE)) && fd >= 0)
+	zlog_iov_put (fd, file, &nfile, line, e->len);
+      if (e->dests & (1 << ZLOG_DEST_STDOUT))
+	zlog_iov_put (STDOUT_FILENO, out, &nout, line, e->len);
+    }
+  if (nfile)
+    zlog_writev (fd, file, nfile);
+  if (nout)
+    zlog_writev (STDOUT_FILENO, out, nout);
+}
+
+/* Write out what is queued for the file and stdout from a signal
+   handler, with write() alone.  The writer may be writing out some of
+   it at the same time. */
+static void
+zlog_ring_dump (struct zlog_ring *r)
+{
+  size_t tail = ZLOG_LOAD (&r->tail), head = ZLOG_LOAD (&r->head);
+  struct zlog_entry *e;
+
+  while ((e = zlog_ring_next (r, &tail, head)) != NULL)
+    {
+      if ((e->dests & (1 << ZLOG_DEST_FILE)) && logfile_fd >= 0)
+	zlog_write (logfile_fd, (char *) (e + 1), e->len);
+      if (e->dests & (1 << ZLOG_DEST_STDOUT))
+	zlog_write (STDOUT_FILENO, (char *) (e + 1), e->len);
+    }
+}
+
+/* The writer thread: takes all that is queued at once, and only takes
+   the lock to sleep when there is nothing, or to wake the daemon when
+   it waits for room. */
+static void *
+zlog_writer (void *arg)
+{
+  struct zlog_ring *r = arg;
+  size_t tail = r->tail, head;
+  int fd, stop = 0;
+
+  for (;;)
+    {
+      head = ZLOG_LOAD (&r->head);
+      if (head == tail)
+	{
+	  if (stop)
+	    break;
+	  pthread_mutex_lock (&r->mtx);
+	  ZLOG_SYNC_STORE (&r->idle, 1);
+	  while (ZLOG_SYNC_LOAD (&r->head) == tail && !r->stop)
+	    pthread_cond_wait (&r->queued, &r->mtx);
+	  ZLOG_STORE (&r->idle, 0);
+	  stop = r->stop;
+	  pthread_mutex_unlock (&r->mtx);
+	  continue;
+	}
+
+      fd = r->zl->fp ? fileno (r->zl->fp) : -1;
+      zlog_ring_write (r, tail, head, fd);
+      tail = head;
+      ZLOG_SYNC_STORE (&r->tail, tail);
+      if (ZLOG_SYNC_LOAD (&r->waiting))
+	{
+	  pthread_mutex_lock (&r->mtx);
+	  pthread_cond_broadcast (&r->written);
+	  pthread_mutex_unlock (&r->mtx);
+	}
+    }
+  return NULL;
+}
+
+static int
+zlog_ring_start (struct zlog_ring *r)
+{
+  sigset_t all, old;
+
+  /* Signals are for the daemon's own thread. */
+  sigfillset (&all);
+  pthread_sigmask (SIG_SETMASK, &all, &old);
+  r->running = (pthread_create (&r->writer, NULL, zlog_writer, r) == 0);
+  pthread_sigmask (SIG_SETMASK, &old, NULL);
+  return r->running;
+}
+
+/* Wait until the writer has taken all but ROOM bytes of what is
+   queued.  With the lock held. */
+static void
+zlog_ring_wait (struct zlog_ring *r, size_t room)
+{
+  ZLOG_SYNC_STORE (&r->waiting, 1);
+  while (r->head - ZLOG_SYNC_LOAD (&r->tail) > room && r->running)
+    pthread_cond_wait (&r->written, &r->mtx);
+  ZLOG_STORE (&r->waiting, 0);
+}
+
+static struct zlog_ring *
+zlog_ring_new (struct zlog *zl)
+{
+  struct zlog_ring *r;
+
+  r = XCALLOC (MTYPE_ZLOG, sizeof (struct zlog_ring));
+  r->zl = zl;
+  pthread_mutex_init (&r->mtx, NULL);
+  pthread_cond_init (&r->queued, NULL);
+  pthread_cond_init (&r->written, NULL);
+  if (! zlog_ring_start (r))
+    {
+      pthread_cond_destroy (&r->written);
+      pthread_cond_destroy (&r->queued);
+      pthread_mutex_destroy (&r->mtx);
+      XFREE (MTYPE_ZLOG, r);
+      return NULL;
+    }
+
+  r->next = zlog_rings;
+  zlog_rings = r;
+  return r;
+}
+
+/* Stop the writer once it has written out all that is queued. */
+static void
+zlog_ring_free (struct zlog_ring *r)
+{
+  struct zlog_ring **rp;
+
+  pthread_mutex_lock (&r->mtx);
+  r->stop = 1;
+  pthread_cond_signal (&r->queued);
+  pthread_mutex_unlock (&r->mtx);
+  if (r->running)
+    pthread_join (r->writer, NULL);
+
+  for (rp = &zlog_rings; *rp; rp = &(*rp)->next)
+    if (*rp == r)
+      {
+	*rp = r->next;
+	break;
+      }
+  pthread_cond_destroy (&r->written);
+  pthread_cond_destroy (&r->queued);
+  pthread_mutex_destroy (&r->mtx);
+  XFREE (MTYPE_ZLOG, r);
+}
+
+/* fork() copies the rings but not their writers: have them written
+   out, so that neither process writes the same lines, and let the
+   child start writers of its own when it logs. */
+static void
+zlog_fork_prepare (void)
+{
+  struct zlog_ring *r;
+
+  for (r = zlog_rings; r; r = r->next)
+    {
+      pthread_mutex_lock (&r->mtx);
+      zlog_ring_wait (r, 0);
+    }
+}
+
+static void
+zlog_fork_parent (void)
+{
+  struct zlog_ring *r;
+
+  for (r = zlog_rings; r; r = r->next)
+    pthread_mutex_unlock (&r->mtx);
+}
+
+static void
+zlog_fork_child (void)
+{
+  struct zlog_ring *r;
+
+  for (r = zlog_rings; r; r = r->next)
+    {
+      pthread_mutex_init (&r->mtx, NULL);
+      pthread_cond_init (&r->queued, NULL);
+      pthread_cond_init (&r->written, NULL);
+      r->running = 0;
+      r->idle = r->waiting = 0;
+    }
+}
+
+/* Queue a line, with HLEN bytes of timestamp, priority and protocol
+   name before the message.  Returns -1 if it is dropped. */
+static int
+zlog_ring_put (struct zlog_ring *r, int dests, int priority,
+	       const char *head, size_t hlen, const char *msg, size_t len)
+{
+  struct zlog_entry *e;
+  size_t size, skip, off;
+  char *line;
+
+  if (len > ZLOG_MSG_MAX)
+    len = ZLOG_MSG_MAX;
+  size = ZLOG_ENTRY_SIZE (hlen + len + 1);
+
+  if (! r->running && ! zlog_ring_start (r))
+    return -1;
+
+  /* Entries don't wrap: what is left at the end of the ring when the
+     next one doesn't fit there is skipped. */
+  off = r->head % ZLOG_RING_SIZE;
+  skip = 0;
+  if (ZLOG_RING_SIZE - off < size)
+    skip = ZLOG_RING_SIZE - off;
+  if (r->head - ZLOG_LOAD (&r->tail) + skip + size > ZLOG_RING_SIZE)
+    {
+      if (r->zl->async == ZLOG_ASYNC_DROP)
+	return -1;
+      pthread_mutex_lock (&r->mtx);
+      zlog_ring_wait (r, ZLOG_RING_SIZE - skip - size);
+      pthread_mutex_unlock (&r->mtx);
+    }
+
+  if (skip >= sizeof (struct zlog_entry))
+    {
+      e = (struct zlog_entry *) (r->buf + off);
+      memset (e, 0, sizeof (struct zlog_entry));
+      e->size = skip;
+    }
+  if (skip)
+    off = 0;
+
+  e = (struct zlog_entry *) (r->buf + off);
+  e->size = size;
+  e->len = hlen + len + 1;
+  e->hlen = hlen;
+  e->dests = dests;
+  e->priority = priority;
+  line = (char *) (e + 1);
+  memcpy (line, head, hlen);
+  memcpy (line + hlen, msg, len);
+  line[hlen + len] = '\n';
+
+  ZLOG_SYNC_STORE (&r->head, r->head + skip + size);
+  if (ZLOG_SYNC_LOAD (&r->idle))
+    {
+      pthread_mutex_lock (&r->mtx);
+      pthread_cond_signal (&r->queued);
+      pthread_mutex_unlock (&r->mtx);
+    }
+  return 0;
+}
+
+void
+zlog_flush (struct zlog *zl)
+{
+  if (zl == NULL)
+    zl = zlog_default;
+  if (zl == NULL || zl->ring == NULL)
+    return;
+
+  pthread_mutex_lock (&zl->ring->mtx);
+  zlog_ring_wait (zl->ring, 0);
+  pthread_mutex_unlock (&zl->ring->mtx);
+}
+
+static void
+zlog_flush_default (void)
+{
+  zlog_flush (zlog_default);
+}
+
+/* Queue a message for the destinations that want it, with the
+   timestamp, priority and protocol name before it, as vzlog() writes
+   them.  Returns -1 if it is dropped. */
+static int
+zlog_queue_put (struct zlog *zl, int priority, struct timestamp_control *ctl,
+		const char *msg, size_t len)
+{
+  char head[sizeof (ctl->buf) + 32];
+  size_t hlen;
+  int dests = 0;
+
+  if (priority <= zl->maxlvl[ZLOG_DEST_SYSLOG])
+    dests |= (1 << ZLOG_DEST_SYSLOG);
+  if ((priority <= zl->maxlvl[ZLOG_DEST_FILE]) && zl->fp)
+    dests |= (1 << ZLOG_DEST_FILE);
+  if (priority <= zl->maxlvl[ZLOG_DEST_STDOUT])
+    dests |= (1 << ZLOG_DEST_STDOUT);
+  if (! dests)
+    return 0;
+
+  if (!ctl->already_rendered)
+    {
+      ctl->len = quagga_timestamp (ctl->precision, ctl->buf,
+				   sizeof (ctl->buf));
+      ctl->already_rendered = 1;
+    }
+  hlen = snprintf (head, sizeof (head), "%s %s%s%s: ", ctl->buf,
+		   zl->record_priority ? zlog_priority[priority] : "",
+		   zl->record_priority ? ": " : "",
+		   zlog_proto_names[zl->protocol]);
+  if (hlen >= sizeof (head))
+    hlen = sizeof (head) - 1;
+
+  return zlog_ring_put (zl->ring, dests, priority | zl->facility,
+			head, hlen, msg, len);
+}
+
+/* Format a message once, and queue it. */
+static void
+vzlog_queue (struct zlog *zl, int priority, struct timestamp_control *ctl,
+	     const char *format, va_list args)
+{
+  char buf[1024];
+  char *msg = buf;
+  int len;
+  va_list ac;
+
+  if (priority > zl->maxlvl[ZLOG_DEST_SYSLOG]
+      && (priority > zl->maxlvl[ZLOG_DEST_FILE] || !zl->fp)
+      && priority > zl->maxlvl[ZLOG_DEST_STDOUT])
+    return;
+
+  /* Once there is room again, say how many were dropped. */
+  if (zl->dropped != zl->dropped_reported)
+    {
+      len = snprintf (buf, sizeof (buf),
+		      "Log queue full, %lu messages dropped so far",
+		      zl->dropped);
+      if (zlog_queue_put (zl, LOG_WARNING, ctl, buf, len) == 0)
+	zl->dropped_reported = zl->dropped;
+    }
+
+  va_copy (ac, args);
+  len = vsnprintf (buf, sizeof (buf), format, ac);
+  va_end (ac);
+  if (len < 0)
+    return;
+  if ((size_t) len >= sizeof (buf))
+    {
+      msg = XMALLOC (MTYPE_TMP, len + 1);
+      va_copy (ac, args);
+      vsnprintf (msg, len + 1, format, ac);
+      va_end (ac);
+    }
+
+  if (zlog_queue_put (zl, priority, ctl, msg, len) < 0)
+    zl->dropped++;
+
+  if (msg != buf)
+    XFREE (MTYPE_TMP, msg);
+}
   
 
 /* va_list version of zlog. */
@@ -172,6 +694,17 @@ vzlog (struct zlog *zl, int priority, const char *format, va_list args)
     }
   tsctl.precision = zl->timestamp_precision;
 
+  if (zl->async)
+    {
+      vzlog_queue (zl, priority, &tsctl, format, args);
+
+      /* Terminal monitor. */
+      if (priority <= zl->maxlvl[ZLOG_DEST_MONITOR])
+	vty_log ((zl->record_priority ? zlog_priority[priority] : NULL),
+		 zlog_proto_names[zl->protocol], format, &tsctl, args);
+      return;
+    }
+
   /* Syslog output */
   if (priority <= zl->maxlvl[ZLOG_DEST_SYSLOG])
     {
@@ -399,6 +932,10 @@ zlog_signal(int signo, const char *action
   /* N.B. implicit priority is most severe */
 #define PRI LOG_CRIT
 
+  /* What was logged before goes first. */
+  if (zlog_default && zlog_default->ring)
+    zlog_ring_dump (zlog_default->ring);
+
 #define DUMP(FD) write(FD, buf, s-buf);
   /* If no file logging configured, try to write to fallback log file. */
   if ((logfile_fd >= 0) || ((logfile_fd = open_crashlog()) >= 0))
@@ -608,6 +1145,11 @@ void
 _zlog_assert_failed (const char *assertion, const char *file,
 		     unsigned int line, const char *function)
 {
+  /* What was logged before goes first, and the rest is written out at
+     once. */
+  if (zlog_default)
+    zlog_set_async (zlog_default, ZLOG_ASYNC_OFF);
+
   /* Force fallback file logging? */
   if (zlog_default && !zlog_default->fp &&
       ((logfile_fd = open_crashlog()) >= 0) &&
@@ -649,6 +1191,10 @@ openzlog (const char *progname, zlog_proto_t protocol,
 void
 closezlog (struct zlog *zl)
 {
+  if (zl->ring)
+    zlog_ring_free (zl->ring);
+  zl->ring = NULL;
+
   closelog();
 
   if (zl->fp != NULL)
@@ -657,6 +1203,11 @@ closezlog (struct zlog *zl)
   if (zl->filename != NULL)
     free (zl->filename);
 
+  /* Daemons exit() right after, and zlog_flush_default() would find
+     it. */
+  if (zl == zlog_default)
+    zlog_default = NULL;
+
   XFREE (MTYPE_ZLOG, zl);
 }
 
@@ -707,7 +1258,10 @@ zlog_reset_file (struct zlog *zl)
     zl = zlog_default;
 
   if (zl->fp)
-    fclose (zl->fp);
+    {
+      zlog_flush (zl);
+      fclose (zl->fp);
+    }
   zl->fp = NULL;
   logfile_fd = -1;
   zl->maxlvl[ZLOG_DEST_FILE] = ZLOG_DISABLED;
@@ -729,7 +1283,10 @@ zlog_rotate (struct zlog *zl)
     zl = zlog_default;
 
   if (zl->fp)
-    fclose (zl->fp);
+    {
+      zlog_flush (zl);
+      fclose (zl->fp);
+    }
   zl->fp = NULL;
   logfile_fd = -1;
   level = zl->maxlvl[ZLOG_DEST_FILE];
@@ -756,6 +1313,43 @@ zlog_rotate (struct zlog *zl)
 
   return 1;
 }
+
+int
+zlog_set_async (struct zlog *zl, zlog_async_t policy)
+{
+  static int registered;
+
+  if (zl == NULL)
+    zl = zlog_default;
+
+  if (policy == ZLOG_ASYNC_OFF)
+    {
+      if (zl->ring)
+	zlog_ring_free (zl->ring);
+      zl->ring = NULL;
+      zl->async = ZLOG_ASYNC_OFF;
+      return 1;
+    }
+
+  if (zl->ring == NULL)
+    {
+      if (zl->fp)
+	fflush (zl->fp);
+      fflush (stdout);
+      if ((zl->ring = zlog_ring_new (zl)) == NULL)
+	return 0;
+    }
+  zl->async = policy;
+
+  /* Don't lose what is queued when the daemon exits, or forks. */
+  if (!registered)
+    {
+      atexit (zlog_flush_default);
+      pthread_atfork (zlog_fork_prepare, zlog_fork_parent, zlog_fork_child);
+      registered = 1;
+    }
+  return 1;
+}
 
 /* Message lookup function. */
 const char *
@@ -845,6 +1439,9 @@ static const struct zebra_desc_table command_types[] = {
   DESC_ENTRY	(ZEBRA_ROUTER_ID_DELETE),
   DESC_ENTRY	(ZEBRA_ROUTER_ID_UPDATE),
   DESC_ENTRY	(ZEBRA_HELLO),
+  DESC_ENTRY	(ZEBRA_NEXTHOP_REGISTER),
+  DESC_ENTRY	(ZEBRA_NEXTHOP_UNREGISTER),
+  DESC_ENTRY	(ZEBRA_NEXTHOP_UPDATE),
 };
 #undef DESC_ENTRY
 
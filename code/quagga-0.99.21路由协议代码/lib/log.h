@@ -69,6 +69,17 @@ typedef enum
 } zlog_dest_t;
 #define ZLOG_NUM_DESTS		(ZLOG_DEST_FILE+1)
 
+/* Asynchronous logging, and what it does with messages that find the
+   queue full. */
+typedef enum
+{
+  ZLOG_ASYNC_OFF = 0,	/* write every message as it is logged */
+  ZLOG_ASYNC_DROP,	/* drop them, and count them */
+  ZLOG_ASYNC_BLOCK	/* wait for the writer to make room */
+} zlog_async_t;
+
+struct zlog_ring;
+
 struct zlog 
 {
   const char *ident;	/* daemon name (first arg to openlog) */
@@ -83,6 +94,13 @@ struct zlog
   			   priority of the message? */
   int syslog_options;	/* 2nd arg to openlog */
   int timestamp_precision;	/* # of digits of subsecond precision */
+
+  /* When logging asynchronously, messages for syslog, stdout and the
+     file are queued in a ring, which a thread of its own writes out. */
+  zlog_async_t async;
+  struct zlog_ring *ring;
+  unsigned long dropped;
+  unsigned long dropped_reported;
 };
 
 /* Message structure. */
@@ -146,6 +164,15 @@ extern int zlog_reset_file (struct zlog *zl);
 /* Rotate log. */
 extern int zlog_rotate (struct zlog *);
 
+/* Queue messages for syslog, stdout and the file, and have a writer
+   thread write them out (ZLOG_ASYNC_DROP or ZLOG_ASYNC_BLOCK), or stop
+   doing so (ZLOG_ASYNC_OFF).  Returns 0 if the thread can't be
+   started. */
+extern int zlog_set_async (struct zlog *zl, zlog_async_t policy);
+
+/* Wait until the queued messages have been written out. */
+extern void zlog_flush (struct zlog *zl);
+
 /* For hackey massage lookup and check */
 #define LOOKUP(x, y) mes_lookup(x, x ## _max, y, "(no item found)", #x)
 
@@ -26,9 +26,15 @@
 #include <malloc.h>
 #endif /* !HAVE_STDLIB_H || HAVE_MALLINFO */
 
+#include <sys/mman.h>
+
 #include "log.h"
 #include "memory.h"
 
+#if !defined(MAP_ANONYMOUS) && defined(MAP_ANON)
+#define MAP_ANONYMOUS MAP_ANON
+#endif
+
 static void alloc_inc (int);
 static void alloc_dec (int);
 static void log_memstats(int log_priority);
@@ -58,6 +64,265 @@ zerror (const char *fname, int type, size_t size)
   abort();
 }
 
+/*
+ * Slab pools.
+ *
+ * Types flagged MEMORY_POOL in memtypes.c are allocated from pools of
+ * objects of one size, carved out of SLAB_SIZE slabs mapped from the
+ * system.  Slabs are aligned on their size, so the slab of an object is
+ * found by masking its address, and objects carry no header.  The size
+ * of the objects of a pool is that of its first allocation; a larger
+ * allocation of the type gets a slab of its own.  A slab left empty is
+ * unmapped, but for one kept per pool so that a type hovering around a
+ * slab boundary does not map and unmap it over and over.
+ */
+#define SLAB_SIZE	(64 * 1024)
+#define SLAB_ALIGN	(2 * sizeof (void *))
+#define SLAB_ROUNDUP(n)	(((n) + SLAB_ALIGN - 1) & ~(SLAB_ALIGN - 1))
+#define SLAB_HEADER	SLAB_ROUNDUP (sizeof (struct slab))
+#define SLAB_OF(ptr) \
+  ((struct slab *) ((uintptr_t) (ptr) & ~((uintptr_t) SLAB_SIZE - 1)))
+
+struct slab
+{
+  struct mpool *pool;
+
+  /* In the list of slabs of the pool with free objects. */
+  struct slab *next;
+  struct slab *prev;
+
+  /* Objects freed, linked through their first word. */
+  void *free;
+
+  /* Objects never handed out, from here to the end of the slab. */
+  char *fresh;
+
+  /* Size of the objects, and of the mapping. */
+  size_t size;
+  size_t length;
+
+  /* Objects in use. */
+  unsigned int used;
+
+  /* Holds a single larger object. */
+  int large;
+};
+
+struct mpool
+{
+  int type;
+  size_t size;
+  unsigned int per_slab;
+
+  /* Slabs with free objects, and an empty one kept back. */
+  struct slab *partial;
+  struct slab *spare;
+
+  unsigned long slabs;
+  unsigned long used;
+  unsigned long large;
+  unsigned long hits;
+  unsigned long misses;
+  unsigned long released;
+};
+
+static struct mpool *mpools[MTYPE_MAX];
+static int mpools_ready;
+
+/* Create the pools of the types flagged for one. */
+static void
+mpool_init (void)
+{
+  struct mlist *ml;
+  struct memory_list *m;
+
+  mpools_ready = 1;
+  for (ml = mlists; ml->list; ml++)
+    for (m = ml->list; m->index >= 0; m++)
+      if (m->index && (m->flags & MEMORY_POOL) && ! mpools[m->index])
+	{
+	  mpools[m->index] = calloc (1, sizeof (struct mpool));
+	  if (mpools[m->index])
+	    mpools[m->index]->type = m->index;
+	}
+}
+
+static inline struct mpool *
+mpool_lookup (int type)
+{
+  if (! mpools_ready)
+    mpool_init ();
+  return mpools[type];
+}
+
+/* Map LENGTH bytes, aligned on SLAB_SIZE. */
+static struct slab *
+slab_map (struct mpool *pool, size_t length)
+{
+  char *p, *base, *end;
+
+  p = mmap (NULL, length + SLAB_SIZE, PROT_READ | PROT_WRITE,
+	    MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (p == MAP_FAILED)
+    zerror ("mmap", pool->type, length);
+
+  /* Give back what is before and after the aligned part. */
+  base = (char *) (((uintptr_t) p + SLAB_SIZE - 1)
+		   & ~((uintptr_t) SLAB_SIZE - 1));
+  end = p + length + SLAB_SIZE;
+  if (base > p)
+    munmap (p, base - p);
+  if (end > base + length)
+    munmap (base + length, end - (base + length));
+
+  return (struct slab *) base;
+}
+
+static void
+slab_link (struct mpool *pool, struct slab *slab)
+{
+  slab->prev = NULL;
+  slab->next = pool->partial;
+  if (pool->partial)
+    pool->partial->prev = slab;
+  pool->partial = slab;
+}
+
+static void
+slab_unlink (struct mpool *pool, struct slab *slab)
+{
+  if (slab->prev)
+    slab->prev->next = slab->next;
+  else
+    pool->partial = slab->next;
+  if (slab->next)
+    slab->next->prev = slab->prev;
+}
+
+static struct slab *
+slab_new (struct mpool *pool)
+{
+  struct slab *slab;
+
+  slab = slab_map (pool, SLAB_SIZE);
+  slab->pool = pool;
+  slab->free = NULL;
+  slab->fresh = (char *) slab + SLAB_HEADER;
+  slab->size = pool->size;
+  slab->length = SLAB_SIZE;
+  slab->used = 0;
+  slab->large = 0;
+  pool->slabs++;
+  return slab;
+}
+
+static void *
+mpool_alloc_large (struct mpool *pool, size_t size)
+{
+  struct slab *slab;
+  size_t length;
+  long pagesize;
+
+  pagesize = sysconf (_SC_PAGESIZE);
+  length = SLAB_HEADER + size;
+  length = (length + pagesize - 1) / pagesize * pagesize;
+
+  slab = slab_map (pool, length);
+  slab->pool = pool;
+  slab->size = size;
+  slab->length = length;
+  slab->used = 1;
+  slab->large = 1;
+  pool->large++;
+  pool->misses++;
+  return (char *) slab + SLAB_HEADER;
+}
+
+static void *
+mpool_alloc (struct mpool *pool, size_t size)
+{
+  struct slab *slab;
+  void *obj;
+
+  /* The first allocation sets the size of the objects. */
+  if (pool->size == 0 && SLAB_HEADER + SLAB_ROUNDUP (size) <= SLAB_SIZE)
+    {
+      pool->size = SLAB_ROUNDUP (size > sizeof (void *)
+				 ? size : sizeof (void *));
+      pool->per_slab = (SLAB_SIZE - SLAB_HEADER) / pool->size;
+    }
+  if (size > pool->size || pool->size == 0)
+    return mpool_alloc_large (pool, size);
+
+  if ((slab = pool->partial) != NULL)
+    pool->hits++;
+  else
+    {
+      if ((slab = pool->spare) != NULL)
+	{
+	  pool->spare = NULL;
+	  pool->hits++;
+	}
+      else
+	{
+	  slab = slab_new (pool);
+	  pool->misses++;
+	}
+      slab_link (pool, slab);
+    }
+
+  if (slab->free)
+    {
+      obj = slab->free;
+      slab->free = *(void **) obj;
+    }
+  else
+    {
+      obj = slab->fresh;
+      slab->fresh += slab->size;
+    }
+  pool->used++;
+  if (++slab->used == pool->per_slab)
+    slab_unlink (pool, slab);
+
+  return obj;
+}
+
+static void
+mpool_free (struct mpool *pool, void *ptr)
+{
+  struct slab *slab = SLAB_OF (ptr);
+
+  assert (slab->pool == pool);
+
+  if (slab->large)
+    {
+      pool->large--;
+      munmap (slab, slab->length);
+      return;
+    }
+
+  *(void **) ptr = slab->free;
+  slab->free = ptr;
+  pool->used--;
+  /* A full slab is on no list. */
+  if (slab->used-- == pool->per_slab)
+    slab_link (pool, slab);
+
+  if (slab->used == 0)
+    {
+      slab_unlink (pool, slab);
+      if (pool->spare == NULL)
+	pool->spare = slab;
+      else
+	{
+	  munmap (slab, slab->length);
+	  pool->slabs--;
+	  pool->released++;
+	}
+    }
+}
+
 /*
  * Allocate memory of a given size, to be tracked by a given type.
  * Effects: Returns a pointer to usable memory.  If memory cannot
@@ -66,9 +331,13 @@ zerror (const char *fname, int type, size_t size)
 void *
 zmalloc (int type, size_t size)
 {
+  struct mpool *pool;
   void *memory;
 
-  memory = malloc (size);
+  if ((pool = mpool_lookup (type)) != NULL)
+    memory = mpool_alloc (pool, size);
+  else
+    memory = malloc (size);
 
   if (memory == NULL)
     zerror ("malloc", type, size);
@@ -84,9 +353,16 @@ zmalloc (int type, size_t size)
 void *
 zcalloc (int type, size_t size)
 {
+  struct mpool *pool;
   void *memory;
 
-  memory = calloc (1, size);
+  if ((pool = mpool_lookup (type)) != NULL)
+    {
+      memory = mpool_alloc (pool, size);
+      memset (memory, 0, size);
+    }
+  else
+    memory = calloc (1, size);
 
   if (memory == NULL)
     zerror ("calloc", type, size);
@@ -106,9 +382,26 @@ zcalloc (int type, size_t size)
 void *
 zrealloc (int type, void *ptr, size_t size)
 {
+  struct mpool *pool;
+  struct slab *slab;
   void *memory;
 
-  memory = realloc (ptr, size);
+  if ((pool = mpool_lookup (type)) != NULL)
+    {
+      /* Move the object if it outgrows its slot. */
+      if (ptr == NULL)
+	memory = mpool_alloc (pool, size);
+      else if (size <= (slab = SLAB_OF (ptr))->size)
+	memory = ptr;
+      else
+	{
+	  memory = mpool_alloc (pool, size);
+	  memcpy (memory, ptr, slab->size);
+	  mpool_free (pool, ptr);
+	}
+    }
+  else
+    memory = realloc (ptr, size);
   if (memory == NULL)
     zerror ("realloc", type, size);
   if (ptr == NULL)
@@ -129,7 +422,10 @@ zfree (int type, void *ptr)
   if (ptr != NULL)
     {
       alloc_dec (type);
-      free (ptr);
+      if (mpools[type])
+	mpool_free (mpools[type], ptr);
+      else
+	free (ptr);
     }
 }
 
@@ -142,9 +438,16 @@ zfree (int type, void *ptr)
 char *
 zstrdup (int type, const char *str)
 {
+  struct mpool *pool;
   void *dup;
 
-  dup = strdup (str);
+  if ((pool = mpool_lookup (type)) != NULL)
+    {
+      dup = mpool_alloc (pool, strlen (str) + 1);
+      strcpy (dup, str);
+    }
+  else
+    dup = strdup (str);
   if (dup == NULL)
     zerror ("strdup", type, strlen (str));
   alloc_inc (type);
@@ -392,6 +695,50 @@ show_memory_mallinfo (struct vty *vty)
 }
 #endif /* HAVE_MALLINFO */
 
+/* Fragmentation and hit rate of the pools in use. */
+static int
+show_memory_pools (struct vty *vty, int needsep)
+{
+  struct mlist *ml;
+  struct memory_list *m;
+  struct mpool *pool;
+  char buf[MTYPE_MEMSTR_LEN];
+  unsigned long slots;
+  int shown = 0;
+
+  for (ml = mlists; ml->list; ml++)
+    for (m = ml->list; m->index >= 0; m++)
+      {
+	if (! m->index || (pool = mpools[m->index]) == NULL
+	    || (pool->slabs == 0 && pool->large == 0))
+	  continue;
+
+	if (! shown)
+	  {
+	    if (needsep)
+	      show_separator (vty);
+	    vty_out (vty, "Slab pools:%s", VTY_NEWLINE);
+	    vty_out (vty, "%-22s %5s %9s %6s %10s %5s %6s %6s%s",
+		     "Type", "Size", "In use", "Slabs", "Held", "Frag",
+		     "Hits", "Freed", VTY_NEWLINE);
+	    shown = 1;
+	  }
+	slots = pool->slabs * pool->per_slab;
+	vty_out (vty, "%-22s %5lu %9lu %6lu %10s %4lu%% %5lu%% %6lu%s",
+		 m->format, (unsigned long) pool->size, pool->used,
+		 pool->slabs,
+		 mtype_memstr (buf, MTYPE_MEMSTR_LEN, pool->slabs * SLAB_SIZE),
+		 slots ? (slots - pool->used) * 100 / slots : 0,
+		 pool->hits + pool->misses
+		 ? pool->hits * 100 / (pool->hits + pool->misses) : 0,
+		 pool->released, VTY_NEWLINE);
+	if (pool->large)
+	  vty_out (vty, "%-22s %5s %9lu  (larger, in slabs of their own)%s",
+		   "", "", pool->large, VTY_NEWLINE);
+      }
+  return shown || needsep;
+}
+
 DEFUN (show_memory_all,
        show_memory_all_cmd,
        "show memory all",
@@ -405,6 +752,7 @@ DEFUN (show_memory_all,
 #ifdef HAVE_MALLINFO
   needsep = show_memory_mallinfo (vty);
 #endif /* HAVE_MALLINFO */
+  needsep = show_memory_pools (vty, needsep);
   
   for (ml = mlists; ml->list; ml++)
     {
@@ -627,3 +975,22 @@ mtype_stats_alloc (int type)
 {
   return mstat[type].alloc;
 }
+
+int
+mtype_pool_stats (int type, struct mtype_pool_stats *stats)
+{
+  struct mpool *pool;
+
+  if ((pool = mpool_lookup (type)) == NULL)
+    return 0;
+
+  stats->size = pool->size;
+  stats->slabs = pool->slabs;
+  stats->used = pool->used;
+  stats->free = pool->slabs * pool->per_slab - pool->used;
+  stats->large = pool->large;
+  stats->hits = pool->hits;
+  stats->misses = pool->misses;
+  stats->released = pool->released;
+  return 1;
+}
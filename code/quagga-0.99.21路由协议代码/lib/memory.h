@@ -26,8 +26,12 @@ struct memory_list
 {
   int index;
   const char *format;
+  int flags;
 };
 
+/* Flags of a memory_list entry. */
+#define MEMORY_POOL	(1 << 0)	/* Allocate from a slab pool. */
+
 struct mlist {
   struct memory_list *list;
   const char *name;
@@ -88,6 +92,22 @@ extern void log_memstats_stderr (const char *);
 /* return number of allocations outstanding for the type */
 extern unsigned long mtype_stats_alloc (int);
 
+/* Statistics of the slab pool of a type. */
+struct mtype_pool_stats
+{
+  size_t size;			/* Object size, 0 before the first. */
+  unsigned long slabs;		/* Slabs mapped. */
+  unsigned long used;		/* Objects in use in them. */
+  unsigned long free;		/* Objects free in them. */
+  unsigned long large;		/* Larger objects, in slabs of their own. */
+  unsigned long hits;		/* Allocations from a mapped slab. */
+  unsigned long misses;		/* Allocations which mapped one. */
+  unsigned long released;	/* Slabs unmapped. */
+};
+
+/* fill in the pool statistics of the type, return 0 if it has no pool */
+extern int mtype_pool_stats (int, struct mtype_pool_stats *);
+
 /* Human friendly string for given byte count */
 #define MTYPE_MEMSTR_LEN 20
 extern const char *mtype_memstr (char *, size_t, unsigned long);
@@ -5,6 +5,10 @@
  *
  * The script is sensitive to the format (though not whitespace), see
  * the top of memtypes.awk for more details.
+ *
+ * Types flagged MEMORY_POOL are allocated from slab pools of objects of
+ * a single size rather than by malloc, see memory.c.  Flag only types
+ * allocated in large numbers, always with the same size.
  */
 
 #include "zebra.h"
@@ -18,10 +22,12 @@ struct memory_list memory_list_lib[] =
   { MTYPE_VECTOR_INDEX,		"Vector index"			},
   { MTYPE_LINK_LIST,		"Link List"			},
   { MTYPE_LINK_NODE,		"Link Node"			},
-  { MTYPE_THREAD,		"Thread"			},
+  { MTYPE_THREAD,		"Thread",			MEMORY_POOL },
   { MTYPE_THREAD_MASTER,	"Thread master"			},
   { MTYPE_THREAD_STATS,		"Thread stats"			},
   { MTYPE_THREAD_FUNCNAME,	"Thread function name" 		},
+  { MTYPE_THREAD_FD,		"Thread fd index"		},
+  { MTYPE_THREAD_IO,		"Thread I/O backend"		},
   { MTYPE_VTY,			"VTY"				},
   { MTYPE_VTY_OUT_BUF,		"VTY output buffer"		},
   { MTYPE_VTY_HIST,		"VTY history"			},
@@ -30,17 +36,16 @@ struct memory_list memory_list_lib[] =
   { MTYPE_CONNECTED_LABEL,	"Connected interface label"	},
   { MTYPE_BUFFER,		"Buffer"			},
   { MTYPE_BUFFER_DATA,		"Buffer data"			},
-  { MTYPE_STREAM,		"Stream"			},
+  { MTYPE_STREAM,		"Stream",			MEMORY_POOL },
   { MTYPE_STREAM_DATA,		"Stream data"			},
   { MTYPE_STREAM_FIFO,		"Stream FIFO"			},
   { MTYPE_PREFIX,		"Prefix"			},
   { MTYPE_PREFIX_IPV4,		"Prefix IPv4"			},
   { MTYPE_PREFIX_IPV6,		"Prefix IPv6"			},
   { MTYPE_HASH,			"Hash"				},
-  { MTYPE_HASH_BACKET,		"Hash Bucket"			},
   { MTYPE_HASH_INDEX,		"Hash Index"			},
   { MTYPE_ROUTE_TABLE,		"Route table"			},
-  { MTYPE_ROUTE_NODE,		"Route node"			},
+  { MTYPE_ROUTE_NODE,		"Route node",			MEMORY_POOL },
   { MTYPE_DISTRIBUTE,		"Distribute list"		},
   { MTYPE_DISTRIBUTE_IFNAME,	"Dist-list ifname"		},
   { MTYPE_ACCESS_LIST,		"Access List"			},
@@ -49,13 +54,16 @@ struct memory_list memory_list_lib[] =
   { MTYPE_PREFIX_LIST,		"Prefix List"			},
   { MTYPE_PREFIX_LIST_ENTRY,	"Prefix List Entry"		},
   { MTYPE_PREFIX_LIST_STR,	"Prefix List Str"		},
+  { MTYPE_PREFIX_LIST_REF,	"Prefix List ref"		},
   { MTYPE_ROUTE_MAP,		"Route map"			},
   { MTYPE_ROUTE_MAP_NAME,	"Route map name"		},
   { MTYPE_ROUTE_MAP_INDEX,	"Route map index"		},
   { MTYPE_ROUTE_MAP_RULE,	"Route map rule"		},
   { MTYPE_ROUTE_MAP_RULE_STR,	"Route map rule str"		},
   { MTYPE_ROUTE_MAP_COMPILED,	"Route map compiled"		},
+  { MTYPE_ROUTE_MAP_REF,	"Route map ref"			},
   { MTYPE_DESC,			"Command desc"			},
+  { MTYPE_CMD_TREE,		"Command tree"			},
   { MTYPE_KEY,			"Key"				},
   { MTYPE_KEYCHAIN,		"Key chain"			},
   { MTYPE_IF_RMAP,		"Interface route map"		},
@@ -83,6 +91,7 @@ struct memory_list memory_list_zebra[] =
   { MTYPE_RIB_QUEUE,		"RIB process work queue"	},
   { MTYPE_STATIC_IPV4,		"Static IPv4 route"		},
   { MTYPE_STATIC_IPV6,		"Static IPv6 route"		},
+  { MTYPE_RNH,			"Registered nexthop"		},
   { -1, NULL },
 };
 
@@ -95,7 +104,7 @@ struct memory_list memory_list_bgp[] =
   { MTYPE_PEER_GROUP,		"Peer group"			},
   { MTYPE_PEER_DESC,		"Peer description"		},
   { MTYPE_PEER_PASSWORD,	"Peer password string"		},
-  { MTYPE_ATTR,			"BGP attribute"			},
+  { MTYPE_ATTR,			"BGP attribute",		MEMORY_POOL },
   { MTYPE_ATTR_EXTRA,		"BGP extra attributes"		},
   { MTYPE_AS_PATH,		"BGP aspath"			},
   { MTYPE_AS_SEG,		"BGP aspath seg"		},
@@ -103,21 +112,24 @@ struct memory_list memory_list_bgp[] =
   { MTYPE_AS_STR,		"BGP aspath str"		},
   { 0, NULL },
   { MTYPE_BGP_TABLE,		"BGP table"			},
-  { MTYPE_BGP_NODE,		"BGP node"			},
-  { MTYPE_BGP_ROUTE,		"BGP route"			},
+  { MTYPE_BGP_NODE,		"BGP node",			MEMORY_POOL },
+  { MTYPE_BGP_ROUTE,		"BGP route",			MEMORY_POOL },
   { MTYPE_BGP_ROUTE_EXTRA,	"BGP ancillary route info"	},
   { MTYPE_BGP_CONN,		"BGP connected"			},
   { MTYPE_BGP_STATIC,		"BGP static"			},
-  { MTYPE_BGP_ADVERTISE_ATTR,	"BGP adv attr"			},
-  { MTYPE_BGP_ADVERTISE,	"BGP adv"			},
+  { MTYPE_BGP_ADVERTISE_ATTR,	"BGP adv attr",			MEMORY_POOL },
+  { MTYPE_BGP_ADVERTISE,	"BGP adv",			MEMORY_POOL },
   { MTYPE_BGP_SYNCHRONISE,	"BGP synchronise"		},
-  { MTYPE_BGP_ADJ_IN,		"BGP adj in"			},
-  { MTYPE_BGP_ADJ_OUT,		"BGP adj out"			},
+  { MTYPE_BGP_ADJ_IN,		"BGP adj in",			MEMORY_POOL },
+  { MTYPE_BGP_ADJ_OUT,		"BGP adj out",			MEMORY_POOL },
   { MTYPE_BGP_MPATH_INFO,	"BGP multipath info"		},
+  { MTYPE_BGP_UPDGRP,		"BGP update group"		},
+  { MTYPE_BGP_UPDGRP_PACKET,	"BGP update group packet"	},
   { 0, NULL },
   { MTYPE_AS_LIST,		"BGP AS list"			},
   { MTYPE_AS_FILTER,		"BGP AS filter"			},
   { MTYPE_AS_FILTER_STR,	"BGP AS filter str"		},
+  { MTYPE_AS_LIST_REF,		"BGP AS list ref"		},
   { 0, NULL },
   { MTYPE_COMMUNITY,		"community"			},
   { MTYPE_COMMUNITY_VAL,	"community val"			},
@@ -149,6 +161,7 @@ struct memory_list memory_list_bgp[] =
   { MTYPE_BGP_DAMP_INFO,	"Dampening info"		},
   { MTYPE_BGP_DAMP_ARRAY,	"BGP Dampening array"		},
   { MTYPE_BGP_REGEXP,		"BGP regexp"			},
+  { MTYPE_BGP_REGEXP_MEMO,	"BGP regexp results"		},
   { MTYPE_BGP_AGGREGATE,	"BGP aggregate"			},
   { -1, NULL }
 };
@@ -161,6 +174,7 @@ struct memory_list memory_list_rip[] =
   { MTYPE_RIP_PEER,           "RIP peer"			},
   { MTYPE_RIP_OFFSET_LIST,    "RIP offset list"			},
   { MTYPE_RIP_DISTANCE,       "RIP distance"			},
+  { MTYPE_RIP_RESPONSE,       "RIP response"			},
   { -1, NULL }
 };
 
@@ -201,6 +215,8 @@ struct memory_list memory_list_ospf[] =
   { MTYPE_OSPF_VERTEX,        "OSPF vertex"			},
   { MTYPE_OSPF_VERTEX_PARENT, "OSPF vertex parent",		},
   { MTYPE_OSPF_NEXTHOP,       "OSPF nexthop"			},
+  { MTYPE_OSPF_SPF_NODE,      "OSPF graph node"			},
+  { MTYPE_OSPF_SPF_EDGE,      "OSPF graph edges"		},
   { MTYPE_OSPF_PATH,	      "OSPF path"			},
   { MTYPE_OSPF_VL_DATA,       "OSPF VL data"			},
   { MTYPE_OSPF_CRYPT_KEY,     "OSPF crypt key"			},
@@ -16,6 +16,8 @@ enum
   MTYPE_THREAD_MASTER,
   MTYPE_THREAD_STATS,
   MTYPE_THREAD_FUNCNAME,
+  MTYPE_THREAD_FD,
+  MTYPE_THREAD_IO,
   MTYPE_VTY,
   MTYPE_VTY_OUT_BUF,
   MTYPE_VTY_HIST,
@@ -31,7 +33,6 @@ enum
   MTYPE_PREFIX_IPV4,
   MTYPE_PREFIX_IPV6,
   MTYPE_HASH,
-  MTYPE_HASH_BACKET,
   MTYPE_HASH_INDEX,
   MTYPE_ROUTE_TABLE,
   MTYPE_ROUTE_NODE,
@@ -43,13 +44,16 @@ enum
   MTYPE_PREFIX_LIST,
   MTYPE_PREFIX_LIST_ENTRY,
   MTYPE_PREFIX_LIST_STR,
+  MTYPE_PREFIX_LIST_REF,
   MTYPE_ROUTE_MAP,
   MTYPE_ROUTE_MAP_NAME,
   MTYPE_ROUTE_MAP_INDEX,
   MTYPE_ROUTE_MAP_RULE,
   MTYPE_ROUTE_MAP_RULE_STR,
   MTYPE_ROUTE_MAP_COMPILED,
+  MTYPE_ROUTE_MAP_REF,
   MTYPE_DESC,
+  MTYPE_CMD_TREE,
   MTYPE_KEY,
   MTYPE_KEYCHAIN,
   MTYPE_IF_RMAP,
@@ -72,6 +76,7 @@ enum
   MTYPE_RIB_QUEUE,
   MTYPE_STATIC_IPV4,
   MTYPE_STATIC_IPV6,
+  MTYPE_RNH,
   MTYPE_BGP,
   MTYPE_BGP_LISTENER,
   MTYPE_BGP_PEER,
@@ -97,9 +102,12 @@ enum
   MTYPE_BGP_ADJ_IN,
   MTYPE_BGP_ADJ_OUT,
   MTYPE_BGP_MPATH_INFO,
+  MTYPE_BGP_UPDGRP,
+  MTYPE_BGP_UPDGRP_PACKET,
   MTYPE_AS_LIST,
   MTYPE_AS_FILTER,
   MTYPE_AS_FILTER_STR,
+  MTYPE_AS_LIST_REF,
   MTYPE_COMMUNITY,
   MTYPE_COMMUNITY_VAL,
   MTYPE_COMMUNITY_STR,
@@ -124,6 +132,7 @@ enum
   MTYPE_BGP_DAMP_INFO,
   MTYPE_BGP_DAMP_ARRAY,
   MTYPE_BGP_REGEXP,
+  MTYPE_BGP_REGEXP_MEMO,
   MTYPE_BGP_AGGREGATE,
   MTYPE_RIP,
   MTYPE_RIP_INFO,
@@ -131,6 +140,7 @@ enum
   MTYPE_RIP_PEER,
   MTYPE_RIP_OFFSET_LIST,
   MTYPE_RIP_DISTANCE,
+  MTYPE_RIP_RESPONSE,
   MTYPE_RIPNG,
   MTYPE_RIPNG_ROUTE,
   MTYPE_RIPNG_AGGREGATE,
@@ -156,6 +166,8 @@ enum
   MTYPE_OSPF_VERTEX,
   MTYPE_OSPF_VERTEX_PARENT,
   MTYPE_OSPF_NEXTHOP,
+  MTYPE_OSPF_SPF_NODE,
+  MTYPE_OSPF_SPF_EDGE,
   MTYPE_OSPF_PATH,
   MTYPE_OSPF_VL_DATA,
   MTYPE_OSPF_CRYPT_KEY,
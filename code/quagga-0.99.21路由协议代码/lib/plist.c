@@ -29,6 +29,8 @@
 #include "buffer.h"
 #include "stream.h"
 #include "log.h"
+#include "table.h"
+#include "hash.h"
 
 /* Each prefix-list's entry. */
 struct prefix_list_entry
@@ -48,6 +50,9 @@ struct prefix_list_entry
 
   struct prefix_list_entry *next;
   struct prefix_list_entry *prev;
+
+  /* Next entry with the same prefix, in sequence order. */
+  struct prefix_list_entry *trie_next;
 };
 
 /* List of struct prefix_list. */
@@ -66,6 +71,10 @@ struct prefix_master
   /* List of prefix_list which name is string. */
   struct prefix_list_list str;
 
+  /* struct prefix_list_ref by name, for every name either defined or
+     referred to. */
+  struct hash *names;
+
   /* Whether sequential number is used. */
   int seqnum;
 
@@ -84,6 +93,7 @@ static struct prefix_master prefix_master_ipv4 =
 { 
   {NULL, NULL},
   {NULL, NULL},
+  NULL,
   1,
   NULL,
   NULL,
@@ -95,6 +105,7 @@ static struct prefix_master prefix_master_ipv6 =
 { 
   {NULL, NULL},
   {NULL, NULL},
+  NULL,
   1,
   NULL,
   NULL,
@@ -106,6 +117,7 @@ static struct prefix_master prefix_master_orf =
 { 
   {NULL, NULL},
   {NULL, NULL},
+  NULL,
   1,
   NULL,
   NULL,
@@ -125,11 +137,102 @@ prefix_master_get (afi_t afi)
   return NULL;
 }
 
+static unsigned int
+prefix_list_ref_key (void *arg)
+{
+  struct prefix_list_ref *ref = arg;
+
+  return string_hash_make (ref->name);
+}
+
+static int
+prefix_list_ref_cmp (const void *a, const void *b)
+{
+  const struct prefix_list_ref *ref1 = a;
+  const struct prefix_list_ref *ref2 = b;
+
+  return strcmp (ref1->name, ref2->name) == 0;
+}
+
+static void *
+prefix_list_ref_alloc (void *arg)
+{
+  struct prefix_list_ref *key = arg;
+  struct prefix_list_ref *ref;
+  size_t len = strlen (key->name) + 1;
+  char *name;
+
+  /* The name is kept right after the entry, and freed with it. */
+  ref = XCALLOC (MTYPE_PREFIX_LIST_REF, sizeof (struct prefix_list_ref) + len);
+  name = (char *) (ref + 1);
+  memcpy (name, key->name, len);
+  ref->name = name;
+  ref->master = key->master;
+  return ref;
+}
+
+/* The name's entry in the master's index, created if CREATE. */
+static struct prefix_list_ref *
+prefix_list_ref_lookup (struct prefix_master *master, const char *name,
+			int create)
+{
+  struct prefix_list_ref key;
+
+  if (master->names == NULL)
+    {
+      if (! create)
+	return NULL;
+      master->names = hash_create (prefix_list_ref_key, prefix_list_ref_cmp,
+				   "Prefix-list names");
+    }
+
+  key.name = name;
+  key.master = master;
+  return hash_get (master->names, &key,
+		   create ? prefix_list_ref_alloc : NULL);
+}
+
+/* Drop the name from the index once nothing defines or refers to it. */
+static void
+prefix_list_ref_release (struct prefix_list_ref *ref)
+{
+  if (ref->plist || ref->refcnt)
+    return;
+
+  hash_release (ref->master->names, ref);
+  XFREE (MTYPE_PREFIX_LIST_REF, ref);
+}
+
+/* Hold a reference to the prefix-list of the given name, which need not
+   exist yet.  Release it with prefix_list_ref_put(). */
+struct prefix_list_ref *
+prefix_list_ref_get (afi_t afi, const char *name)
+{
+  struct prefix_master *master;
+  struct prefix_list_ref *ref;
+
+  master = prefix_master_get (afi);
+  if (master == NULL)
+    return NULL;
+
+  ref = prefix_list_ref_lookup (master, name, 1);
+  ref->refcnt++;
+  return ref;
+}
+
+void
+prefix_list_ref_put (struct prefix_list_ref *ref)
+{
+  assert (ref->refcnt > 0);
+  ref->refcnt--;
+  prefix_list_ref_release (ref);
+}
+
 /* Lookup prefix_list from list of prefix_list by name. */
 struct prefix_list *
 prefix_list_lookup (afi_t afi, const char *name)
 {
-  struct prefix_list *plist;
+  struct prefix_list_ref *ref;
   struct prefix_master *master;
 
   if (name == NULL)
@@ -139,15 +242,8 @@ prefix_list_lookup (afi_t afi, const char *name)
   if (master == NULL)
     return NULL;
 
-  for (plist = master->num.head; plist; plist = plist->next)
-    if (strcmp (plist->name, name) == 0)
-      return plist;
-
-  for (plist = master->str.head; plist; plist = plist->next)
-    if (strcmp (plist->name, name) == 0)
-      return plist;
-
-  return NULL;
+  ref = prefix_list_ref_lookup (master, name, 0);
+  return ref ? ref->plist : NULL;
 }
 
 static struct prefix_list *
@@ -162,6 +258,10 @@ prefix_list_new (void)
 static void
 prefix_list_free (struct prefix_list *plist)
 {
+  if (plist->trie)
+    route_table_finish (plist->trie);
+  if (plist->seqs)
+    route_table_finish (plist->seqs);
   XFREE (MTYPE_PREFIX_LIST, plist);
 }
 
@@ -200,6 +300,7 @@ prefix_list_insert (afi_t afi, const char *name)
   plist = prefix_list_new ();
   plist->name = XSTRDUP (MTYPE_PREFIX_LIST_STR, name);
   plist->master = master;
+  prefix_list_ref_lookup (master, name, 1)->plist = plist;
 
   /* If name is made by all digit character.  We treat it as
      number. */
@@ -284,12 +385,14 @@ prefix_list_get (afi_t afi, const char *name)
   return plist;
 }
 
-/* Delete prefix-list from prefix_list_master and free it. */
+/* Take prefix-list out of prefix_list_master and free it, without
+   telling the protocols. */
 static void
-prefix_list_delete (struct prefix_list *plist)
+prefix_list_unlink (struct prefix_list *plist)
 {
   struct prefix_list_list *list;
   struct prefix_master *master;
+  struct prefix_list_ref *ref;
   struct prefix_list_entry *pentry;
   struct prefix_list_entry *next;
 
@@ -325,11 +428,24 @@ prefix_list_delete (struct prefix_list *plist)
      cleared. */
   master->recent = NULL;
 
+  ref = prefix_list_ref_lookup (master, plist->name, 0);
+  ref->plist = NULL;
+  prefix_list_ref_release (ref);
+
   if (plist->name)
     XFREE (MTYPE_PREFIX_LIST_STR, plist->name);
   
   prefix_list_free (plist);
-  
+}
+
+/* Delete prefix-list from prefix_list_master and free it. */
+static void
+prefix_list_delete (struct prefix_list *plist)
+{
+  struct prefix_master *master = plist->master;
+
+  prefix_list_unlink (plist);
+
   if (master->delete_hook)
     (*master->delete_hook) (NULL);
 }
@@ -374,46 +490,126 @@ prefix_list_delete_hook (void (*func) (struct prefix_list *plist))
 #endif /* HAVE_IPVt6 */
 }
 
-/* Calculate new sequential number. */
+/* Calculate new sequential number.  The list is in sequence order, so
+   the highest number is the tail's. */
 static int
 prefix_new_seq_get (struct prefix_list *plist)
 {
   int maxseq;
   int newseq;
-  struct prefix_list_entry *pentry;
 
   maxseq = newseq = 0;
 
-  for (pentry = plist->head; pentry; pentry = pentry->next)
-    {
-      if (maxseq < pentry->seq)
-	maxseq = pentry->seq;
-    }
+  if (plist->tail && maxseq < plist->tail->seq)
+    maxseq = plist->tail->seq;
 
   newseq = ((maxseq / 5) * 5) + 5;
   
   return newseq;
 }
 
+/* Besides the list, entries are kept in a table by sequence number, so
+   that the entry with a number, and where a new one goes in the list,
+   are found without walking it.  The number stands in for an IPv4 host
+   address, offset so that the table's order is the list's. */
+static void
+prefix_seq_key (struct prefix *key, int seq)
+{
+  memset (key, 0, sizeof (struct prefix));
+  key->family = AF_INET;
+  key->prefixlen = IPV4_MAX_BITLEN;
+  key->u.prefix4.s_addr = htonl ((u_int32_t) seq ^ 0x80000000);
+}
+
 /* Return prefix list entry which has same seq number. */
 static struct prefix_list_entry *
 prefix_seq_check (struct prefix_list *plist, int seq)
 {
-  struct prefix_list_entry *pentry;
+  struct route_node *rn;
+  struct prefix key;
 
-  for (pentry = plist->head; pentry; pentry = pentry->next)
-    if (pentry->seq == seq)
-      return pentry;
+  if (plist->seqs == NULL)
+    return NULL;
+
+  prefix_seq_key (&key, seq);
+  rn = route_node_lookup (plist->seqs, &key);
+  if (rn == NULL)
+    return NULL;
+  route_unlock_node (rn);
+  return rn->info;
+}
+
+/* Add an entry to the table by sequence number, where there is none
+   with its number, and return the entry with the next number, if
+   any. */
+static struct prefix_list_entry *
+prefix_seq_add (struct prefix_list *plist, struct prefix_list_entry *pentry)
+{
+  struct route_node *rn;
+  struct prefix key;
+
+  if (plist->seqs == NULL)
+    plist->seqs = route_table_init ();
+
+  prefix_seq_key (&key, pentry->seq);
+  rn = route_node_get (plist->seqs, &key);
+  rn->info = pentry;
+
+  /* The node keeps the lock route_node_get() took; walk on another. */
+  route_lock_node (rn);
+  for (rn = route_next (rn); rn; rn = route_next (rn))
+    if (rn->info)
+      {
+	route_unlock_node (rn);
+	return rn->info;
+      }
   return NULL;
 }
 
+static void
+prefix_seq_delete (struct prefix_list *plist, struct prefix_list_entry *pentry)
+{
+  struct route_node *rn;
+  struct prefix key;
+
+  prefix_seq_key (&key, pentry->seq);
+  rn = route_node_lookup (plist->seqs, &key);
+  if (rn == NULL)
+    return;
+
+  rn->info = NULL;
+  route_unlock_node (rn);
+  route_unlock_node (rn);
+}
+
+/* The entries with the same masked prefix as the given one, in sequence
+   order; see prefix_list_trie_add(). */
+static struct prefix_list_entry *
+prefix_list_trie_lookup (struct prefix_list *plist, struct prefix *prefix)
+{
+  struct route_node *rn;
+  struct prefix key;
+
+  if (plist->trie == NULL)
+    return NULL;
+
+  prefix_copy (&key, prefix);
+  apply_mask (&key);
+  rn = route_node_lookup (plist->trie, &key);
+  if (rn == NULL)
+    return NULL;
+  route_unlock_node (rn);
+  return rn->info;
+}
+
 static struct prefix_list_entry *
 prefix_list_entry_lookup (struct prefix_list *plist, struct prefix *prefix,
 			  enum prefix_list_type type, int seq, int le, int ge)
 {
   struct prefix_list_entry *pentry;
 
-  for (pentry = plist->head; pentry; pentry = pentry->next)
+  for (pentry = prefix_list_trie_lookup (plist, prefix); pentry;
+       pentry = pentry->trie_next)
     if (prefix_same (&pentry->prefix, prefix) && pentry->type == type)
       {
 	if (seq >= 0 && pentry->seq != seq)
@@ -430,6 +626,74 @@ prefix_list_entry_lookup (struct prefix_list *plist, struct prefix *prefix,
   return NULL;
 }
 
+/* Besides the list in sequence order, entries are kept in a trie by
+   prefix.  Each trie node holds the entries for its prefix, in sequence
+   order, and keeps one lock for as long as it holds any.  Entry
+   prefixes may have host bits set, which matching ignores, so the trie
+   is keyed by the masked prefix. */
+static void
+prefix_list_trie_add (struct prefix_list *plist,
+		      struct prefix_list_entry *pentry)
+{
+  struct route_node *rn;
+  struct prefix_list_entry *head;
+  struct prefix_list_entry *prev;
+  struct prefix key;
+
+  if (plist->trie == NULL)
+    plist->trie = route_table_init ();
+
+  prefix_copy (&key, &pentry->prefix);
+  apply_mask (&key);
+  rn = route_node_get (plist->trie, &key);
+
+  head = rn->info;
+  if (head)
+    route_unlock_node (rn);
+
+  if (head == NULL || head->seq > pentry->seq)
+    {
+      pentry->trie_next = head;
+      rn->info = pentry;
+      return;
+    }
+
+  for (prev = head; prev->trie_next; prev = prev->trie_next)
+    if (prev->trie_next->seq > pentry->seq)
+      break;
+  pentry->trie_next = prev->trie_next;
+  prev->trie_next = pentry;
+}
+
+static void
+prefix_list_trie_delete (struct prefix_list *plist,
+			 struct prefix_list_entry *pentry)
+{
+  struct route_node *rn;
+  struct prefix_list_entry *prev;
+  struct prefix key;
+
+  prefix_copy (&key, &pentry->prefix);
+  apply_mask (&key);
+  rn = route_node_lookup (plist->trie, &key);
+  if (rn == NULL)
+    return;
+
+  if (rn->info == pentry)
+    rn->info = pentry->trie_next;
+  else
+    for (prev = rn->info; prev->trie_next; prev = prev->trie_next)
+      if (prev->trie_next == pentry)
+	{
+	  prev->trie_next = pentry->trie_next;
+	  break;
+	}
+
+  route_unlock_node (rn);
+  if (rn->info == NULL)
+    route_unlock_node (rn);
+}
+
 static void
 prefix_list_entry_delete (struct prefix_list *plist, 
 			  struct prefix_list_entry *pentry,
@@ -437,6 +701,8 @@ prefix_list_entry_delete (struct prefix_list *plist,
 {
   if (plist == NULL || pentry == NULL)
     return;
+  prefix_list_trie_delete (plist, pentry);
+  prefix_seq_delete (plist, pentry);
   if (pentry->prev)
     pentry->prev->next = pentry->next;
   else
@@ -479,9 +745,7 @@ prefix_list_entry_add (struct prefix_list *plist,
     prefix_list_entry_delete (plist, replace, 0);
 
   /* Check insert point. */
-  for (point = plist->head; point; point = point->next)
-    if (point->seq >= pentry->seq)
-      break;
+  point = prefix_seq_add (plist, pentry);
 
   /* In case of this is the first element of the list. */
   pentry->next = point;
@@ -507,6 +771,8 @@ prefix_list_entry_add (struct prefix_list *plist,
       plist->tail = pentry;
     }
 
+  prefix_list_trie_add (plist, pentry);
+
   /* Increment count. */
   plist->count++;
 
@@ -560,11 +826,21 @@ prefix_list_entry_match (struct prefix_list_entry *pentry, struct prefix *p)
   return 1;
 }
 
+/* The first entry in sequence order that matches is the one that
+   applies.  Only entries whose prefix covers P can match, and those are
+   on the trie nodes from P's longest match up to the root, so merge
+   just those nodes' entries by sequence number and stop at the first
+   match.  The refcount of an entry counts the times it has been looked
+   at this way. */
 enum prefix_list_type
 prefix_list_apply (struct prefix_list *plist, void *object)
 {
-  struct prefix_list_entry *pentry;
+  struct prefix_list_entry *heads[IPV6_MAX_BITLEN + 1];
+  struct prefix_list_entry *best;
+  struct route_node *match;
+  struct route_node *rn;
   struct prefix *p;
+  int n, i, min;
 
   p = (struct prefix *) object;
 
@@ -574,17 +850,42 @@ prefix_list_apply (struct prefix_list *plist, void *object)
   if (plist->count == 0)
     return PREFIX_PERMIT;
 
-  for (pentry = plist->head; pentry; pentry = pentry->next)
+  match = route_node_match (plist->trie, p);
+  if (match == NULL)
+    return PREFIX_DENY;
+
+  /* A node's prefix is longer than its parent's, so there are no more
+     of these than there are prefix lengths. */
+  n = 0;
+  for (rn = match; rn; rn = rn->parent)
+    if (rn->info)
+      heads[n++] = rn->info;
+  route_unlock_node (match);
+
+  best = NULL;
+  while (n > 0)
     {
-      pentry->refcnt++;
-      if (prefix_list_entry_match (pentry, p))
+      for (min = 0, i = 1; i < n; i++)
+	if (heads[i]->seq < heads[min]->seq)
+	  min = i;
+
+      heads[min]->refcnt++;
+      if (prefix_list_entry_match (heads[min], p))
 	{
-	  pentry->hitcnt++;
-	  return pentry->type;
+	  best = heads[min];
+	  break;
 	}
+
+      heads[min] = heads[min]->trie_next;
+      if (heads[min] == NULL)
+	heads[min] = heads[--n];
     }
 
-  return PREFIX_DENY;
+  if (best == NULL)
+    return PREFIX_DENY;
+
+  best->hitcnt++;
+  return best->type;
 }
 
 static void __attribute__ ((unused))
@@ -635,7 +936,8 @@ prefix_entry_dup_check (struct prefix_list *plist,
   else
     seq = new->seq;
 
-  for (pentry = plist->head; pentry; pentry = pentry->next)
+  for (pentry = prefix_list_trie_lookup (plist, &new->prefix); pentry;
+       pentry = pentry->trie_next)
     {
       if (prefix_same (&pentry->prefix, &new->prefix)
 	  && pentry->type == new->type
@@ -909,6 +1211,68 @@ vty_prefix_list_desc_unset (struct vty *vty, afi_t afi, const char *name)
   return CMD_SUCCESS;
 }
 
+/* Give prefix-list NAME the entries of FROM, built aside, and delete
+   FROM.  The entries change hands in one step, so nothing sees NAME
+   half replaced, and the hooks run once rather than for every entry. */
+static int
+vty_prefix_list_replace (struct vty *vty, afi_t afi, const char *name,
+			 const char *from)
+{
+  struct prefix_list *plist;
+  struct prefix_list *new;
+  struct prefix_list_entry *pentry;
+  struct route_table *table;
+  int count;
+
+  new = prefix_list_lookup (afi, from);
+  if (! new)
+    {
+      vty_out (vty, "%% Can't find specified prefix-list%s", VTY_NEWLINE);
+      return CMD_WARNING;
+    }
+
+  plist = prefix_list_get (afi, name);
+  if (plist == new)
+    return CMD_SUCCESS;
+
+  pentry = plist->head;
+  plist->head = new->head;
+  new->head = pentry;
+  pentry = plist->tail;
+  plist->tail = new->tail;
+  new->tail = pentry;
+
+  table = plist->trie;
+  plist->trie = new->trie;
+  new->trie = table;
+  table = plist->seqs;
+  plist->seqs = new->seqs;
+  new->seqs = table;
+
+  count = plist->count;
+  plist->count = new->count;
+  new->count = count;
+  count = plist->rangecount;
+  plist->rangecount = new->rangecount;
+  new->rangecount = count;
+
+  /* The old entries go with the list the new ones were built in, of
+     which the protocols need not hear: they are told of NAME below. */
+  prefix_list_unlink (new);
+
+  if (plist->head == NULL && plist->tail == NULL && plist->desc == NULL)
+    {
+      prefix_list_delete (plist);
+      return CMD_SUCCESS;
+    }
+
+  if (plist->master->add_hook)
+    (*plist->master->add_hook) (plist);
+  plist->master->recent = plist;
+
+  return CMD_SUCCESS;
+}
+
 enum display_type
 {
   normal_display,
@@ -1608,6 +1972,18 @@ ALIAS (no_ip_prefix_list_description,
        "Prefix-list specific description\n"
        "Up to 80 characters describing this prefix-list\n")
 
+DEFUN (ip_prefix_list_replace,
+       ip_prefix_list_replace_cmd,
+       "ip prefix-list WORD replace WORD",
+       IP_STR
+       PREFIX_LIST_STR
+       "Name of a prefix list\n"
+       "Replace all entries at once\n"
+       "Name of the prefix list holding the new entries, which is deleted\n")
+{
+  return vty_prefix_list_replace (vty, AFI_IP, argv[0], argv[1]);
+}
+
 DEFUN (show_ip_prefix_list,
        show_ip_prefix_list_cmd,
        "show ip prefix-list",
@@ -2204,6 +2580,18 @@ ALIAS (no_ipv6_prefix_list_description,
        "Prefix-list specific description\n"
        "Up to 80 characters describing this prefix-list\n")
 
+DEFUN (ipv6_prefix_list_replace,
+       ipv6_prefix_list_replace_cmd,
+       "ipv6 prefix-list WORD replace WORD",
+       IPV6_STR
+       PREFIX_LIST_STR
+       "Name of a prefix list\n"
+       "Replace all entries at once\n"
+       "Name of the prefix list holding the new entries, which is deleted\n")
+{
+  return vty_prefix_list_replace (vty, AFI_IP6, argv[0], argv[1]);
+}
+
 DEFUN (show_ipv6_prefix_list,
        show_ipv6_prefix_list_cmd,
        "show ipv6 prefix-list",
@@ -2699,6 +3087,7 @@ prefix_list_init_ipv4 (void)
   install_element (CONFIG_NODE, &ip_prefix_list_description_cmd);
   install_element (CONFIG_NODE, &no_ip_prefix_list_description_cmd);
   install_element (CONFIG_NODE, &no_ip_prefix_list_description_arg_cmd);
+  install_element (CONFIG_NODE, &ip_prefix_list_replace_cmd);
 
   install_element (CONFIG_NODE, &ip_prefix_list_sequence_number_cmd);
   install_element (CONFIG_NODE, &no_ip_prefix_list_sequence_number_cmd);
@@ -2808,6 +3197,7 @@ prefix_list_init_ipv6 (void)
   install_element (CONFIG_NODE, &ipv6_prefix_list_description_cmd);
   install_element (CONFIG_NODE, &no_ipv6_prefix_list_description_cmd);
   install_element (CONFIG_NODE, &no_ipv6_prefix_list_description_arg_cmd);
+  install_element (CONFIG_NODE, &ipv6_prefix_list_replace_cmd);
 
   install_element (CONFIG_NODE, &ipv6_prefix_list_sequence_number_cmd);
   install_element (CONFIG_NODE, &no_ipv6_prefix_list_sequence_number_cmd);
@@ -52,10 +52,30 @@ struct prefix_list
   struct prefix_list_entry *head;
   struct prefix_list_entry *tail;
 
+  /* The same entries by prefix, for prefix_list_apply(). */
+  struct route_table *trie;
+
+  /* And by sequence number. */
+  struct route_table *seqs;
+
   struct prefix_list *next;
   struct prefix_list *prev;
 };
 
+/* A prefix-list name as route-map rules and the like refer to it,
+   whether or not a list of that name exists.  PLIST follows the list as
+   it is added and deleted, so holders need no lookup by name. */
+struct prefix_list_ref
+{
+  const char *name;
+  struct prefix_master *master;
+
+  /* The list of that name, or NULL. */
+  struct prefix_list *plist;
+
+  unsigned long refcnt;
+};
+
 struct orf_prefix
 {
   u_int32_t seq;
@@ -71,6 +91,8 @@ extern void prefix_list_add_hook (void (*func) (struct prefix_list *));
 extern void prefix_list_delete_hook (void (*func) (struct prefix_list *));
 
 extern struct prefix_list *prefix_list_lookup (afi_t, const char *);
+extern struct prefix_list_ref *prefix_list_ref_get (afi_t, const char *);
+extern void prefix_list_ref_put (struct prefix_list_ref *);
 extern enum prefix_list_type prefix_list_apply (struct prefix_list *, void *);
 
 extern struct stream * prefix_bgp_orf_entry (struct stream *,
@@ -28,6 +28,7 @@ Software Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
 #include "command.h"
 #include "vty.h"
 #include "log.h"
+#include "hash.h"
 
 /* Vector for route match rules. */
 static vector route_match_vec;
@@ -58,13 +59,17 @@ struct route_map_list
   struct route_map *head;
   struct route_map *tail;
 
+  /* struct route_map_ref by name, for every name either defined or
+     referred to. */
+  struct hash *names;
+
   void (*add_hook) (const char *);
   void (*delete_hook) (const char *);
   void (*event_hook) (route_map_event_t, const char *); 
 };
 
 /* Master list of route map. */
-static struct route_map_list route_map_master = { NULL, NULL, NULL, NULL };
+static struct route_map_list route_map_master = { NULL, NULL, NULL, NULL, NULL, NULL };
 
 static void
 route_map_rule_delete (struct route_map_rule_list *,
@@ -73,6 +78,90 @@ route_map_rule_delete (struct route_map_rule_list *,
 static void
 route_map_index_delete (struct route_map_index *, int);
 
+static unsigned int
+route_map_ref_key (void *arg)
+{
+  struct route_map_ref *ref = arg;
+
+  return string_hash_make (ref->name);
+}
+
+static int
+route_map_ref_cmp (const void *a, const void *b)
+{
+  const struct route_map_ref *ref1 = a;
+  const struct route_map_ref *ref2 = b;
+
+  return strcmp (ref1->name, ref2->name) == 0;
+}
+
+static void *
+route_map_ref_alloc (void *arg)
+{
+  struct route_map_ref *key = arg;
+  struct route_map_ref *ref;
+  size_t len = strlen (key->name) + 1;
+  char *name;
+
+  /* The name is kept right after the entry, and freed with it. */
+  ref = XCALLOC (MTYPE_ROUTE_MAP_REF, sizeof (struct route_map_ref) + len);
+  name = (char *) (ref + 1);
+  memcpy (name, key->name, len);
+  ref->name = name;
+  return ref;
+}
+
+/* The name's entry in the index, created if CREATE. */
+static struct route_map_ref *
+route_map_ref_lookup (const char *name, int create)
+{
+  struct route_map_ref key;
+
+  if (route_map_master.names == NULL)
+    {
+      if (! create)
+	return NULL;
+      route_map_master.names = hash_create (route_map_ref_key,
+					    route_map_ref_cmp,
+					    "Route-map names");
+    }
+
+  key.name = name;
+  return hash_get (route_map_master.names, &key,
+		   create ? route_map_ref_alloc : NULL);
+}
+
+/* Drop the name from the index once nothing defines or refers to it. */
+static void
+route_map_ref_release (struct route_map_ref *ref)
+{
+  if (ref->map || ref->refcnt)
+    return;
+
+  hash_release (route_map_master.names, ref);
+  XFREE (MTYPE_ROUTE_MAP_REF, ref);
+}
+
+/* Hold a reference to the route map of the given name, which need not
+   exist yet.  Release it with route_map_ref_put(). */
+struct route_map_ref *
+route_map_ref_get (const char *name)
+{
+  struct route_map_ref *ref;
+
+  ref = route_map_ref_lookup (name, 1);
+  ref->refcnt++;
+  return ref;
+}
+
+void
+route_map_ref_put (struct route_map_ref *ref)
+{
+  assert (ref->refcnt > 0);
+  ref->refcnt--;
+  route_map_ref_release (ref);
+}
+
 /* New route map allocation. Please note route map's name must be
    specified. */
 static struct route_map *
@@ -94,6 +183,7 @@ route_map_add (const char *name)
 
   map = route_map_new (name);
   list = &route_map_master;
+  route_map_ref_lookup (name, 1)->map = map;
     
   map->next = NULL;
   map->prev = list->tail;
@@ -116,6 +206,7 @@ route_map_delete (struct route_map *map)
 {
   struct route_map_list *list;
   struct route_map_index *index;
+  struct route_map_ref *ref;
   char *name;
   
   while ((index = map->head) != NULL)
@@ -123,6 +214,10 @@ route_map_delete (struct route_map *map)
 
   name = map->name;
 
+  ref = route_map_ref_lookup (name, 0);
+  ref->map = NULL;
+  route_map_ref_release (ref);
+
   list = &route_map_master;
 
   if (map->next)
@@ -150,12 +245,10 @@ route_map_delete (struct route_map *map)
 struct route_map *
 route_map_lookup_by_name (const char *name)
 {
-  struct route_map *map;
+  struct route_map_ref *ref;
 
-  for (map = route_map_master.head; map; map = map->next)
-    if (strcmp (map->name, name) == 0)
-      return map;
-  return NULL;
+  ref = route_map_ref_lookup (name, 0);
+  return ref ? ref->map : NULL;
 }
 
 /* Lookup route map.  If there isn't route map create one and return
@@ -235,7 +328,7 @@ vty_show_route_map_entry (struct vty *vty, struct route_map *map)
       /* Call clause */
       vty_out (vty, "  Call clause:%s", VTY_NEWLINE);
       if (index->nextrm)
-        vty_out (vty, "    Call %s%s", index->nextrm, VTY_NEWLINE);
+        vty_out (vty, "    Call %s%s", index->nextrm->name, VTY_NEWLINE);
       
       /* Exit Policy */
       vty_out (vty, "  Action:%s", VTY_NEWLINE);
@@ -314,9 +407,9 @@ route_map_index_delete (struct route_map_index *index, int notify)
   else
     index->map->head = index->next;
 
-  /* Free 'char *nextrm' if not NULL */
+  /* Release the "call" target if any. */
   if (index->nextrm)
-    XFREE (MTYPE_ROUTE_MAP_NAME, index->nextrm);
+    route_map_ref_put (index->nextrm);
 
     /* Execute event hook. */
   if (route_map_master.event_hook && notify)
@@ -813,8 +906,7 @@ route_map_apply (struct route_map *map, struct prefix *prefix,
               /* Call another route-map if available */
               if (index->nextrm)
                 {
-                  struct route_map *nextrm =
-                                    route_map_lookup_by_name (index->nextrm);
+                  struct route_map *nextrm = index->nextrm->map;
 
                   if (nextrm) /* Target route-map found, jump to it */
                     {
@@ -1180,8 +1272,8 @@ DEFUN (rmap_call,
   if (index)
     {
       if (index->nextrm)
-          XFREE (MTYPE_ROUTE_MAP_NAME, index->nextrm);
-      index->nextrm = XSTRDUP (MTYPE_ROUTE_MAP_NAME, argv[0]);
+          route_map_ref_put (index->nextrm);
+      index->nextrm = route_map_ref_get (argv[0]);
     }
   return CMD_SUCCESS;
 }
@@ -1198,7 +1290,7 @@ DEFUN (no_rmap_call,
 
   if (index->nextrm)
     {
-      XFREE (MTYPE_ROUTE_MAP_NAME, index->nextrm);
+      route_map_ref_put (index->nextrm);
       index->nextrm = NULL;
     }
 
@@ -1277,7 +1369,7 @@ route_map_config_write (struct vty *vty)
 		   rule->rule_str ? rule->rule_str : "",
 		   VTY_NEWLINE);
    if (index->nextrm)
-     vty_out (vty, " call %s%s", index->nextrm, VTY_NEWLINE);
+     vty_out (vty, " call %s%s", index->nextrm->name, VTY_NEWLINE);
 	if (index->exitpolicy == RMAP_GOTO)
       vty_out (vty, " on-match goto %d%s", index->nextpref, VTY_NEWLINE);
 	if (index->exitpolicy == RMAP_NEXT)
@@ -125,7 +125,7 @@ struct route_map_index
   int nextpref;
 
   /* If we're using "CALL", to which route-map do ew go? */
-  char *nextrm;
+  struct route_map_ref *nextrm;
 
   /* Matching rule list. */
   struct route_map_rule_list match_list;
@@ -151,6 +151,19 @@ struct route_map
   struct route_map *prev;
 };
 
+/* A route-map name as "call" and the daemons refer to it, whether or
+   not a route-map of that name exists.  MAP follows the route-map as it
+   is added and deleted, so holders need no lookup by name. */
+struct route_map_ref
+{
+  const char *name;
+
+  /* The route-map of that name, or NULL. */
+  struct route_map *map;
+
+  unsigned long refcnt;
+};
+
 /* Prototypes. */
 extern void route_map_init (void);
 extern void route_map_init_vty (void);
@@ -185,6 +198,10 @@ extern void route_map_install_set (struct route_map_rule_cmd *cmd);
 /* Lookup route map by name. */
 extern struct route_map * route_map_lookup_by_name (const char *name);
 
+/* Hold and release a reference to a route map by name. */
+extern struct route_map_ref *route_map_ref_get (const char *name);
+extern void route_map_ref_put (struct route_map_ref *ref);
+
 /* Apply route map to the object. */
 extern route_map_result_t route_map_apply (struct route_map *map,
                                            struct prefix *,
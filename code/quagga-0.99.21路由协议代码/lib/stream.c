@@ -121,7 +121,16 @@ stream_free (struct stream *s)
   if (!s)
     return;
   
-  XFREE (MTYPE_STREAM_DATA, s->data);
+  if (s->refcnt)
+    {
+      s->refcnt--;
+      return;
+    }
+
+  if (s->ref)
+    stream_free (s->ref);
+  else
+    XFREE (MTYPE_STREAM_DATA, s->data);
   XFREE (MTYPE_STREAM, s);
 }
 
@@ -154,11 +163,33 @@ stream_dup (struct stream *s)
   return (stream_copy (new, s));
 }
 
+/* Make a stream reading the same data as S, without copying it.  The
+ * data stays around until both streams are freed, so neither may be
+ * written to any more.  The new stream has a get pointer of its own.
+ */
+struct stream *
+stream_ref (struct stream *s)
+{
+  struct stream *new;
+
+  STREAM_VERIFY_SANE (s);
+
+  new = XCALLOC (MTYPE_STREAM, sizeof (struct stream));
+  new->data = s->data;
+  new->size = s->size;
+  new->endp = s->endp;
+  new->ref = s;
+  s->refcnt++;
+
+  return new;
+}
+
 size_t
 stream_resize (struct stream *s, size_t newsize)
 {
   u_char *newdata;
   STREAM_VERIFY_SANE (s);
+  assert (s->ref == NULL && s->refcnt == 0);
   
   newdata = XREALLOC (MTYPE_STREAM_DATA, s->data, newsize);
   
@@ -896,6 +927,21 @@ stream_reset (struct stream *s)
   s->getp = s->endp = 0;
 }
 
+/* Move the data not yet read to the start of the stream, making room
+   after it for more. */
+void
+stream_pulldown (struct stream *s)
+{
+  size_t rlen;
+
+  STREAM_VERIFY_SANE (s);
+
+  rlen = STREAM_READABLE (s);
+  memmove (s->data, s->data + s->getp, rlen);
+  s->getp = 0;
+  s->endp = rlen;
+}
+
 /* Write stream contens to the file discriptor. */
 int
 stream_flush (struct stream *s, int fd)
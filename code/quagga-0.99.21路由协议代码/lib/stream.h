@@ -104,6 +104,9 @@ struct stream
   size_t endp;		/* last valid data position */
   size_t size;		/* size of data segment */
   unsigned char *data; /* data pointer */
+
+  struct stream *ref;	/* stream whose data this one shares */
+  unsigned int refcnt;	/* holders of this stream, less one */
 };
 
 /* First in first out queue structure. */
@@ -139,6 +142,7 @@ extern struct stream *stream_new (size_t);
 extern void stream_free (struct stream *);
 extern struct stream * stream_copy (struct stream *, struct stream *src);
 extern struct stream *stream_dup (struct stream *);
+extern struct stream *stream_ref (struct stream *);
 extern size_t stream_resize (struct stream *, size_t);
 extern size_t stream_get_getp (struct stream *);
 extern size_t stream_get_endp (struct stream *);
@@ -205,6 +209,7 @@ extern size_t stream_write (struct stream *, const void *, size_t);
 
 /* reset the stream. See Note above */
 extern void stream_reset (struct stream *);
+extern void stream_pulldown (struct stream *);
 extern int stream_flush (struct stream *, int);
 extern int stream_empty (struct stream *); /* is the stream empty? */
 
@@ -29,6 +29,7 @@
 #include "hash.h"
 #include "command.h"
 #include "sigevent.h"
+#include "pqueue.h"
 
 /* Recent absolute time of day */
 struct timeval recent_time;
@@ -40,6 +41,25 @@ static struct timeval relative_time_base;
 static unsigned short timers_inited;
 
 static struct hash *cpu_record = NULL;
+static unsigned int master_count = 0;
+
+/* I/O backend of a thread master.  The backend watches the descriptors
+ * of read and write threads and hands the ready ones to thread_fd_ready().
+ */
+struct thread_io_ops
+{
+  const char *name;
+  int (*init) (struct thread_master *);
+  void (*finish) (struct thread_master *);
+  /* Start and stop watching fd for read or write. */
+  int (*add) (struct thread_master *, int fd, thread_type);
+  void (*del) (struct thread_master *, int fd, thread_type);
+  /* Wait for I/O, at most until timer_wait. Returns the number of ready
+   * descriptors, or -1 with errno set. */
+  int (*wait) (struct thread_master *, struct timeval *timer_wait);
+  /* Move the threads found ready by the last wait to the ready list. */
+  void (*process) (struct thread_master *, int num);
+};
 
 /* Struct timeval's tv_usec one second value.  */
 #define TIMER_SECOND_MICRO 1000000L
@@ -474,6 +494,13 @@ thread_list_debug (struct thread_list *list)
 	  list->count, list->head, list->tail);
 }
 
+/* Timer queue count and allocation print out. */
+static void
+thread_queue_debug (struct pqueue *queue)
+{
+  printf ("count [%d] size [%d]\n", queue->size, queue->array_size);
+}
+
 /* Debug print for thread_master. */
 static void  __attribute__ ((unused))
 thread_master_debug (struct thread_master *m)
@@ -483,31 +510,18 @@ thread_master_debug (struct thread_master *m)
   thread_list_debug (&m->read);
   printf ("writelist : ");
   thread_list_debug (&m->write);
-  printf ("timerlist : ");
-  thread_list_debug (&m->timer);
+  printf ("timerqueue: ");
+  thread_queue_debug (m->timer);
   printf ("eventlist : ");
   thread_list_debug (&m->event);
   printf ("unuselist : ");
   thread_list_debug (&m->unuse);
-  printf ("bgndlist : ");
-  thread_list_debug (&m->background);
+  printf ("bgndqueue : ");
+  thread_queue_debug (m->background);
   printf ("total alloc: [%ld]\n", m->alloc);
   printf ("-----------\n");
 }
 
-/* Allocate new thread master.  */
-struct thread_master *
-thread_master_create ()
-{
-  if (cpu_record == NULL) 
-    cpu_record 
-      = hash_create_size (1011, (unsigned int (*) (void *))cpu_record_hash_key, 
-                          (int (*) (const void *, const void *))cpu_record_hash_cmp);
-    
-  return (struct thread_master *) XCALLOC (MTYPE_THREAD_MASTER,
-					   sizeof (struct thread_master));
-}
-
 /* Add a new thread to the list.  */
 static void
 thread_list_add (struct thread_list *list, struct thread *thread)
@@ -522,22 +536,6 @@ thread_list_add (struct thread_list *list, struct thread *thread)
   list->count++;
 }
 
-/* Add a new thread just before the point.  */
-static void
-thread_list_add_before (struct thread_list *list, 
-			struct thread *point, 
-			struct thread *thread)
-{
-  thread->next = point;
-  thread->prev = point->prev;
-  if (point->prev)
-    point->prev->next = thread;
-  else
-    list->head = thread;
-  point->prev = thread;
-  list->count++;
-}
-
 /* Delete a thread from the list. */
 static struct thread *
 thread_list_delete (struct thread_list *list, struct thread *thread)
@@ -585,21 +583,44 @@ thread_list_free (struct thread_master *m, struct thread_list *list)
     }
 }
 
+/* Free all threads still on a timer queue. */
+static void
+thread_queue_free (struct thread_master *m, struct pqueue *queue)
+{
+  int i;
+
+  for (i = 0; i < queue->size; i++)
+    {
+      struct thread *t = queue->array[i];
+
+      if (t->funcname)
+        XFREE (MTYPE_THREAD_FUNCNAME, t->funcname);
+      XFREE (MTYPE_THREAD, t);
+      m->alloc--;
+    }
+  pqueue_delete (queue);
+}
+
 /* Stop thread scheduler. */
 void
 thread_master_free (struct thread_master *m)
 {
   thread_list_free (m, &m->read);
   thread_list_free (m, &m->write);
-  thread_list_free (m, &m->timer);
+  thread_queue_free (m, m->timer);
   thread_list_free (m, &m->event);
   thread_list_free (m, &m->ready);
   thread_list_free (m, &m->unuse);
-  thread_list_free (m, &m->background);
+  thread_queue_free (m, m->background);
+
+  m->io->finish (m);
+  if (m->fds)
+    XFREE (MTYPE_THREAD_FD, m->fds);
   
   XFREE (MTYPE_THREAD_MASTER, m);
 
-  if (cpu_record)
+  /* The CPU history is shared by all masters. */
+  if (--master_count == 0 && cpu_record)
     {
       hash_clean (cpu_record, cpu_record_hash_free);
       hash_free (cpu_record);
@@ -623,6 +644,459 @@ thread_trim_head (struct thread_list *list)
   return NULL;
 }
 
+/* Descriptor index flags. */
+#define THREAD_FD_CHANGED	0x01	/* registration needs to be synced */
+#define THREAD_FD_REMOVED	0x02	/* a thread left, fd may be closed */
+
+/* Look up the index slot of fd, growing the index as needed. */
+static struct thread_fd *
+thread_fd_get (struct thread_master *m, int fd)
+{
+  if (fd >= m->fds_size)
+    {
+      int size = m->fds_size ? m->fds_size : 64;
+
+      while (size <= fd)
+	size *= 2;
+      m->fds = XREALLOC (MTYPE_THREAD_FD, m->fds,
+			 size * sizeof (struct thread_fd));
+      memset (m->fds + m->fds_size, 0,
+	      (size - m->fds_size) * sizeof (struct thread_fd));
+      m->fds_size = size;
+    }
+  return &m->fds[fd];
+}
+
+/* Stop watching the descriptor of an I/O thread. */
+static void
+thread_fd_del (struct thread *thread)
+{
+  struct thread_master *m = thread->master;
+  struct thread_fd *tfd = &m->fds[THREAD_FD (thread)];
+
+  if (thread->type == THREAD_READ)
+    {
+      assert (tfd->read == thread);
+      tfd->read = NULL;
+    }
+  else
+    {
+      assert (tfd->write == thread);
+      tfd->write = NULL;
+    }
+  m->io->del (m, THREAD_FD (thread), thread->type);
+}
+
+/* Called by the backend for each I/O thread found ready. */
+static void
+thread_fd_ready (struct thread *thread)
+{
+  struct thread_list *list;
+
+  list = (thread->type == THREAD_READ) ? &thread->master->read
+                                       : &thread->master->write;
+  thread_fd_del (thread);
+  thread_list_delete (list, thread);
+  thread_list_add (&thread->master->ready, thread);
+  thread->type = THREAD_READY;
+}
+
+/* select() backend.  Portable, but limited to FD_SETSIZE descriptors and
+ * linear in the number of I/O threads on every wakeup.
+ */
+struct thread_io_select
+{
+  fd_set readfd;
+  fd_set writefd;
+  fd_set exceptfd;
+};
+
+static int
+thread_io_select_init (struct thread_master *m)
+{
+  m->io_info = XCALLOC (MTYPE_THREAD_IO, sizeof (struct thread_io_select));
+  return 0;
+}
+
+static void
+thread_io_select_finish (struct thread_master *m)
+{
+  XFREE (MTYPE_THREAD_IO, m->io_info);
+}
+
+static int
+thread_io_select_add (struct thread_master *m, int fd, thread_type type)
+{
+  if (fd >= FD_SETSIZE)
+    {
+      zlog (NULL, LOG_WARNING, "fd [%d] exceeds FD_SETSIZE for select()", fd);
+      return -1;
+    }
+  FD_SET (fd, (type == THREAD_READ) ? &m->readfd : &m->writefd);
+  return 0;
+}
+
+static void
+thread_io_select_del (struct thread_master *m, int fd, thread_type type)
+{
+  FD_CLR (fd, (type == THREAD_READ) ? &m->readfd : &m->writefd);
+}
+
+static int
+thread_io_select_wait (struct thread_master *m, struct timeval *timer_wait)
+{
+  struct thread_io_select *sel = m->io_info;
+
+  /* Structure copy.  */
+  sel->readfd = m->readfd;
+  sel->writefd = m->writefd;
+  sel->exceptfd = m->exceptfd;
+
+  return select (FD_SETSIZE, &sel->readfd, &sel->writefd, &sel->exceptfd,
+		 timer_wait);
+}
+
+static void
+thread_process_fd (struct thread_list *list, fd_set *fdset)
+{
+  struct thread *thread;
+  struct thread *next;
+  
+  assert (list);
+  
+  for (thread = list->head; thread; thread = next)
+    {
+      next = thread->next;
+
+      if (FD_ISSET (THREAD_FD (thread), fdset))
+        thread_fd_ready (thread);
+    }
+}
+
+static void
+thread_io_select_process (struct thread_master *m, int num)
+{
+  struct thread_io_select *sel = m->io_info;
+
+  /* Normal priority read thead. */
+  thread_process_fd (&m->read, &sel->readfd);
+  /* Write thead. */
+  thread_process_fd (&m->write, &sel->writefd);
+}
+
+static const struct thread_io_ops thread_io_select =
+{
+  .name = "select",
+  .init = thread_io_select_init,
+  .finish = thread_io_select_finish,
+  .add = thread_io_select_add,
+  .del = thread_io_select_del,
+  .wait = thread_io_select_wait,
+  .process = thread_io_select_process,
+};
+
+#ifdef HAVE_SYS_EPOLL_H
+/* epoll() backend.  The interest set lives in the kernel, so a wakeup
+ * costs time in the number of ready descriptors only.
+ *
+ * Registration changes are not pushed to the kernel straight away but
+ * collected in a change list and synced just before epoll_wait().  An
+ * I/O thread that re-adds itself from its own handler, the common case,
+ * then costs a single epoll_ctl() rather than a delete and an add.
+ */
+struct thread_io_epoll
+{
+  int epfd;
+  struct epoll_event *events;
+  int events_size;
+  /* Events made up for descriptors epoll refused, at the head of events. */
+  int forced;
+  /* Descriptors whose registration may be out of date. */
+  int *changes;
+  int changes_count;
+  int changes_size;
+};
+
+#define THREAD_EPOLL_EVENTS_MIN 64
+
+static int
+thread_io_epoll_init (struct thread_master *m)
+{
+  struct thread_io_epoll *ep;
+  int epfd;
+
+  if ((epfd = epoll_create (THREAD_EPOLL_EVENTS_MIN)) < 0)
+    {
+      zlog_warn ("epoll_create() error: %s", safe_strerror (errno));
+      return -1;
+    }
+  fcntl (epfd, F_SETFD, FD_CLOEXEC);
+
+  ep = XCALLOC (MTYPE_THREAD_IO, sizeof (struct thread_io_epoll));
+  ep->epfd = epfd;
+  ep->events_size = THREAD_EPOLL_EVENTS_MIN;
+  ep->events = XCALLOC (MTYPE_THREAD_IO,
+			ep->events_size * sizeof (struct epoll_event));
+  m->io_info = ep;
+  return 0;
+}
+
+static void
+thread_io_epoll_finish (struct thread_master *m)
+{
+  struct thread_io_epoll *ep = m->io_info;
+
+  close (ep->epfd);
+  XFREE (MTYPE_THREAD_IO, ep->events);
+  if (ep->changes)
+    XFREE (MTYPE_THREAD_IO, ep->changes);
+  XFREE (MTYPE_THREAD_IO, ep);
+}
+
+static void
+thread_io_epoll_change (struct thread_master *m, int fd, int flags)
+{
+  struct thread_io_epoll *ep = m->io_info;
+  struct thread_fd *tfd = &m->fds[fd];
+
+  if (! (tfd->flags & THREAD_FD_CHANGED))
+    {
+      if (ep->changes_count == ep->changes_size)
+	{
+	  ep->changes_size = ep->changes_size ? ep->changes_size * 2 : 64;
+	  ep->changes = XREALLOC (MTYPE_THREAD_IO, ep->changes,
+				  ep->changes_size * sizeof (int));
+	}
+      ep->changes[ep->changes_count++] = fd;
+    }
+  tfd->flags |= THREAD_FD_CHANGED | flags;
+}
+
+static int
+thread_io_epoll_add (struct thread_master *m, int fd, thread_type type)
+{
+  thread_io_epoll_change (m, fd, 0);
+  return 0;
+}
+
+static void
+thread_io_epoll_del (struct thread_master *m, int fd, thread_type type)
+{
+  thread_io_epoll_change (m, fd, THREAD_FD_REMOVED);
+}
+
+/* Bring the kernel's view of fd in line with the threads on it. */
+static void
+thread_io_epoll_sync (struct thread_master *m, int fd)
+{
+  struct thread_io_epoll *ep = m->io_info;
+  struct thread_fd *tfd = &m->fds[fd];
+  struct epoll_event ev;
+  int events = 0;
+  int op;
+
+  if (tfd->read)
+    events |= EPOLLIN;
+  if (tfd->write)
+    events |= EPOLLOUT;
+
+  /* Once a thread has left the descriptor it may have been closed, and
+   * closing it drops the registration, so resync even if unchanged. */
+  if (events == tfd->events && ! (tfd->flags & THREAD_FD_REMOVED))
+    {
+      tfd->flags = 0;
+      return;
+    }
+  tfd->flags = 0;
+
+  memset (&ev, 0, sizeof (ev));
+  ev.events = events;
+  ev.data.fd = fd;
+
+  if (! events)
+    {
+      /* Fails harmlessly if fd was closed already. */
+      if (tfd->events)
+	epoll_ctl (ep->epfd, EPOLL_CTL_DEL, fd, &ev);
+      tfd->events = 0;
+      return;
+    }
+
+  op = tfd->events ? EPOLL_CTL_MOD : EPOLL_CTL_ADD;
+  if (epoll_ctl (ep->epfd, op, fd, &ev) < 0)
+    {
+      if (op == EPOLL_CTL_MOD && errno == ENOENT)
+	op = EPOLL_CTL_ADD;
+      else if (op == EPOLL_CTL_ADD && errno == EEXIST)
+	op = EPOLL_CTL_MOD;
+      else
+	op = -1;
+
+      if (op < 0 || epoll_ctl (ep->epfd, op, fd, &ev) < 0)
+	{
+	  /* Regular files and the like cannot be polled, and select()
+	   * always finds them ready, so report them ready.  So too a bad
+	   * descriptor, whose handler then gets the error. */
+	  if (errno != EPERM)
+	    zlog_warn ("epoll_ctl() error on fd [%d]: %s",
+		       fd, safe_strerror (errno));
+	  tfd->events = 0;
+	  ep->events[ep->forced++] = ev;
+	  return;
+	}
+    }
+  tfd->events = events;
+}
+
+static int
+thread_io_epoll_wait (struct thread_master *m, struct timeval *timer_wait)
+{
+  struct thread_io_epoll *ep = m->io_info;
+  int timeout = -1;
+  int i, num;
+
+  /* Make room to collect every registered descriptor in one go. */
+  if (ep->events_size < m->read.count + m->write.count)
+    {
+      while (ep->events_size < m->read.count + m->write.count)
+	ep->events_size *= 2;
+      ep->events = XREALLOC (MTYPE_THREAD_IO, ep->events,
+			     ep->events_size * sizeof (struct epoll_event));
+    }
+
+  ep->forced = 0;
+  for (i = 0; i < ep->changes_count; i++)
+    thread_io_epoll_sync (m, ep->changes[i]);
+  ep->changes_count = 0;
+
+  /* Round up, so a timer is never polled for before it is due. */
+  if (timer_wait)
+    timeout = timer_wait->tv_sec * 1000 + (timer_wait->tv_usec + 999) / 1000;
+
+  /* Do not sleep with threads already ready. */
+  if (ep->forced)
+    timeout = 0;
+
+  num = epoll_wait (ep->epfd, ep->events + ep->forced,
+		    ep->events_size - ep->forced, timeout);
+  if (num < 0)
+    return ep->forced ? ep->forced : num;
+  return ep->forced + num;
+}
+
+static void
+thread_io_epoll_process (struct thread_master *m, int num)
+{
+  struct thread_io_epoll *ep = m->io_info;
+  struct thread_fd *tfd;
+  int i;
+
+  /* Reads first, then writes, as select() processing does. */
+  for (i = 0; i < num; i++)
+    {
+      tfd = &m->fds[ep->events[i].data.fd];
+      if (tfd->read && (ep->events[i].events & (EPOLLIN|EPOLLHUP|EPOLLERR)))
+	thread_fd_ready (tfd->read);
+    }
+  for (i = 0; i < num; i++)
+    {
+      tfd = &m->fds[ep->events[i].data.fd];
+      if (tfd->write && (ep->events[i].events & (EPOLLOUT|EPOLLHUP|EPOLLERR)))
+	thread_fd_ready (tfd->write);
+    }
+}
+
+static const struct thread_io_ops thread_io_epoll =
+{
+  .name = "epoll",
+  .init = thread_io_epoll_init,
+  .finish = thread_io_epoll_finish,
+  .add = thread_io_epoll_add,
+  .del = thread_io_epoll_del,
+  .wait = thread_io_epoll_wait,
+  .process = thread_io_epoll_process,
+};
+#endif /* HAVE_SYS_EPOLL_H */
+
+/* Timer queues are binary heaps ordered by expiry time.  Each thread
+ * keeps its position in the heap so it can be cancelled in O(log n). */
+static int
+thread_timer_cmp (void *a, void *b)
+{
+  struct thread *ta = a;
+  struct thread *tb = b;
+  long cmp = timeval_cmp (ta->u.sands, tb->u.sands);
+
+  return (cmp < 0) ? -1 : (cmp > 0);
+}
+
+static void
+thread_timer_update (void *node, int actual_position)
+{
+  struct thread *thread = node;
+
+  thread->index = actual_position;
+}
+
+/* Allocate new thread master, with the given I/O backend.  Falls back to
+ * select() if the backend asked for is not available. */
+struct thread_master *
+thread_master_create_io (enum thread_io_type type)
+{
+  struct thread_master *m;
+
+  if (cpu_record == NULL) 
+    cpu_record 
+      = hash_create_size (1011, (unsigned int (*) (void *))cpu_record_hash_key, 
+                          (int (*) (const void *, const void *))cpu_record_hash_cmp,
+                          "Thread CPU records");
+
+  m = XCALLOC (MTYPE_THREAD_MASTER, sizeof (struct thread_master));
+  master_count++;
+
+  m->timer = pqueue_create ();
+  m->timer->cmp = thread_timer_cmp;
+  m->timer->update = thread_timer_update;
+  m->background = pqueue_create ();
+  m->background->cmp = thread_timer_cmp;
+  m->background->update = thread_timer_update;
+
+  switch (type)
+    {
+#ifdef HAVE_SYS_EPOLL_H
+    case THREAD_IO_DEFAULT:
+    case THREAD_IO_EPOLL:
+      m->io = &thread_io_epoll;
+      break;
+#endif /* HAVE_SYS_EPOLL_H */
+    default:
+      m->io = &thread_io_select;
+      break;
+    }
+
+  if (m->io->init (m) < 0)
+    {
+      m->io = &thread_io_select;
+      m->io->init (m);
+    }
+
+  return m;
+}
+
+/* Allocate new thread master.  */
+struct thread_master *
+thread_master_create ()
+{
+  return thread_master_create_io (THREAD_IO_DEFAULT);
+}
+
+/* Name of the I/O backend in use. */
+const char *
+thread_master_io_name (struct thread_master *m)
+{
+  return m->io->name;
+}
+
 /* Return remain time in second. */
 unsigned long
 thread_timer_remain_second (struct thread *thread)
@@ -685,6 +1159,7 @@ thread_get (struct thread_master *m, u_char type,
   thread->master = m;
   thread->func = func;
   thread->arg = arg;
+  thread->index = -1;
   
   thread->funcname = strip_funcname(funcname);
 
@@ -697,18 +1172,23 @@ funcname_thread_add_read (struct thread_master *m,
 		 int (*func) (struct thread *), void *arg, int fd, const char* funcname)
 {
   struct thread *thread;
+  struct thread_fd *tfd;
 
   assert (m != NULL);
 
-  if (FD_ISSET (fd, &m->readfd))
+  tfd = thread_fd_get (m, fd);
+  if (tfd->read)
     {
       zlog (NULL, LOG_WARNING, "There is already read fd [%d]", fd);
       return NULL;
     }
 
+  if (m->io->add (m, fd, THREAD_READ) < 0)
+    return NULL;
+
   thread = thread_get (m, THREAD_READ, func, arg, funcname);
-  FD_SET (fd, &m->readfd);
   thread->u.fd = fd;
+  tfd->read = thread;
   thread_list_add (&m->read, thread);
 
   return thread;
@@ -720,18 +1200,23 @@ funcname_thread_add_write (struct thread_master *m,
 		 int (*func) (struct thread *), void *arg, int fd, const char* funcname)
 {
   struct thread *thread;
+  struct thread_fd *tfd;
 
   assert (m != NULL);
 
-  if (FD_ISSET (fd, &m->writefd))
+  tfd = thread_fd_get (m, fd);
+  if (tfd->write)
     {
       zlog (NULL, LOG_WARNING, "There is already write fd [%d]", fd);
       return NULL;
     }
 
+  if (m->io->add (m, fd, THREAD_WRITE) < 0)
+    return NULL;
+
   thread = thread_get (m, THREAD_WRITE, func, arg, funcname);
-  FD_SET (fd, &m->writefd);
   thread->u.fd = fd;
+  tfd->write = thread;
   thread_list_add (&m->write, thread);
 
   return thread;
@@ -746,16 +1231,15 @@ funcname_thread_add_timer_timeval (struct thread_master *m,
                                   const char* funcname)
 {
   struct thread *thread;
-  struct thread_list *list;
+  struct pqueue *queue;
   struct timeval alarm_time;
-  struct thread *tt;
 
   assert (m != NULL);
 
   assert (type == THREAD_TIMER || type == THREAD_BACKGROUND);
   assert (time_relative);
   
-  list = ((type == THREAD_TIMER) ? &m->timer : &m->background);
+  queue = ((type == THREAD_TIMER) ? m->timer : m->background);
   thread = thread_get (m, type, func, arg, funcname);
 
   /* Do we need jitter here? */
@@ -764,15 +1248,7 @@ funcname_thread_add_timer_timeval (struct thread_master *m,
   alarm_time.tv_usec = relative_time.tv_usec + time_relative->tv_usec;
   thread->u.sands = timeval_adjust(alarm_time);
 
-  /* Sort by timeval. */
-  for (tt = list->head; tt; tt = tt->next)
-    if (timeval_cmp (thread->u.sands, tt->u.sands) <= 0)
-      break;
-
-  if (tt)
-    thread_list_add_before (list, tt, thread);
-  else
-    thread_list_add (list, thread);
+  pqueue_enqueue (thread, queue);
 
   return thread;
 }
@@ -858,22 +1334,21 @@ funcname_thread_add_event (struct thread_master *m,
 void
 thread_cancel (struct thread *thread)
 {
-  struct thread_list *list;
+  struct thread_list *list = NULL;
+  struct pqueue *queue = NULL;
   
   switch (thread->type)
     {
     case THREAD_READ:
-      assert (FD_ISSET (thread->u.fd, &thread->master->readfd));
-      FD_CLR (thread->u.fd, &thread->master->readfd);
+      thread_fd_del (thread);
       list = &thread->master->read;
       break;
     case THREAD_WRITE:
-      assert (FD_ISSET (thread->u.fd, &thread->master->writefd));
-      FD_CLR (thread->u.fd, &thread->master->writefd);
+      thread_fd_del (thread);
       list = &thread->master->write;
       break;
     case THREAD_TIMER:
-      list = &thread->master->timer;
+      queue = thread->master->timer;
       break;
     case THREAD_EVENT:
       list = &thread->master->event;
@@ -882,13 +1357,22 @@ thread_cancel (struct thread *thread)
       list = &thread->master->ready;
       break;
     case THREAD_BACKGROUND:
-      list = &thread->master->background;
+      queue = thread->master->background;
       break;
     default:
       return;
       break;
     }
-  thread_list_delete (list, thread);
+
+  if (queue)
+    {
+      assert (thread->index >= 0);
+      assert (thread == queue->array[thread->index]);
+      pqueue_remove_at (thread->index, queue);
+      thread->index = -1;
+    }
+  else
+    thread_list_delete (list, thread);
   thread->type = THREAD_UNUSED;
   thread_add_unuse (thread->master, thread);
 }
@@ -920,11 +1404,12 @@ thread_cancel_event (struct thread_master *m, void *arg)
 }
 
 static struct timeval *
-thread_timer_wait (struct thread_list *tlist, struct timeval *timer_val)
+thread_timer_wait (struct pqueue *queue, struct timeval *timer_val)
 {
-  if (!thread_empty (tlist))
+  if (queue->size)
     {
-      *timer_val = timeval_subtract (tlist->head->u.sands, relative_time);
+      struct thread *next_timer = queue->array[0];
+      *timer_val = timeval_subtract (next_timer->u.sands, relative_time);
       return timer_val;
     }
   return NULL;
@@ -941,46 +1426,20 @@ thread_run (struct thread_master *m, struct thread *thread,
   return fetch;
 }
 
-static int
-thread_process_fd (struct thread_list *list, fd_set *fdset, fd_set *mfdset)
-{
-  struct thread *thread;
-  struct thread *next;
-  int ready = 0;
-  
-  assert (list);
-  
-  for (thread = list->head; thread; thread = next)
-    {
-      next = thread->next;
-
-      if (FD_ISSET (THREAD_FD (thread), fdset))
-        {
-          assert (FD_ISSET (THREAD_FD (thread), mfdset));
-          FD_CLR(THREAD_FD (thread), mfdset);
-          thread_list_delete (list, thread);
-          thread_list_add (&thread->master->ready, thread);
-          thread->type = THREAD_READY;
-          ready++;
-        }
-    }
-  return ready;
-}
-
 /* Add all timers that have popped to the ready list. */
 static unsigned int
-thread_timer_process (struct thread_list *list, struct timeval *timenow)
+thread_timer_process (struct pqueue *queue, struct timeval *timenow)
 {
   struct thread *thread;
-  struct thread *next;
   unsigned int ready = 0;
   
-  for (thread = list->head; thread; thread = next)
+  while (queue->size)
     {
-      next = thread->next;
+      thread = queue->array[0];
       if (timeval_cmp (*timenow, thread->u.sands) < 0)
         return ready;
-      thread_list_delete (list, thread);
+      pqueue_dequeue (queue);
+      thread->index = -1;
       thread->type = THREAD_READY;
       thread_list_add (&thread->master->ready, thread);
       ready++;
@@ -1013,9 +1472,6 @@ struct thread *
 thread_fetch (struct thread_master *m, struct thread *fetch)
 {
   struct thread *thread;
-  fd_set readfd;
-  fd_set writefd;
-  fd_set exceptfd;
   struct timeval timer_val = { .tv_sec = 0, .tv_usec = 0 };
   struct timeval timer_val_bg;
   struct timeval *timer_wait = &timer_val;
@@ -1042,31 +1498,26 @@ thread_fetch (struct thread_master *m, struct thread *fetch)
       /* Normal event are the next highest priority.  */
       thread_process (&m->event);
       
-      /* Structure copy.  */
-      readfd = m->readfd;
-      writefd = m->writefd;
-      exceptfd = m->exceptfd;
-      
       /* Calculate select wait timer if nothing else to do */
       if (m->ready.count == 0)
         {
           quagga_get_relative (NULL);
-          timer_wait = thread_timer_wait (&m->timer, &timer_val);
-          timer_wait_bg = thread_timer_wait (&m->background, &timer_val_bg);
+          timer_wait = thread_timer_wait (m->timer, &timer_val);
+          timer_wait_bg = thread_timer_wait (m->background, &timer_val_bg);
           
           if (timer_wait_bg &&
               (!timer_wait || (timeval_cmp (*timer_wait, *timer_wait_bg) > 0)))
             timer_wait = timer_wait_bg;
         }
       
-      num = select (FD_SETSIZE, &readfd, &writefd, &exceptfd, timer_wait);
+      num = m->io->wait (m, timer_wait);
       
       /* Signals should get quick treatment */
       if (num < 0)
         {
           if (errno == EINTR)
             continue; /* signal received - process it */
-          zlog_warn ("select() error: %s", safe_strerror (errno));
+          zlog_warn ("%s() error: %s", m->io->name, safe_strerror (errno));
             return NULL;
         }
 
@@ -1074,16 +1525,11 @@ thread_fetch (struct thread_master *m, struct thread *fetch)
          priority than I/O threads, so let's push them onto the ready
 	 list in front of the I/O threads. */
       quagga_get_relative (NULL);
-      thread_timer_process (&m->timer, &relative_time);
+      thread_timer_process (m->timer, &relative_time);
       
       /* Got IO, process it */
       if (num > 0)
-        {
-          /* Normal priority read thead. */
-          thread_process_fd (&m->read, &readfd, &m->readfd);
-          /* Write thead. */
-          thread_process_fd (&m->write, &writefd, &m->writefd);
-        }
+        m->io->process (m, num);
 
 #if 0
       /* If any threads were made ready above (I/O or foreground timer),
@@ -1095,7 +1541,7 @@ thread_fetch (struct thread_master *m, struct thread *fetch)
 #endif
 
       /* Background timer/events, lowest priority */
-      thread_timer_process (&m->background, &relative_time);
+      thread_timer_process (m->background, &relative_time);
       
       if ((thread = thread_trim_head (&m->ready)) != NULL)
         return thread_run (m, thread, fetch);
@@ -44,20 +44,45 @@ struct thread_list
   int count;
 };
 
+/* I/O readiness backends a thread_master can be created with. */
+enum thread_io_type
+{
+  THREAD_IO_DEFAULT = 0,	/* best available on this system */
+  THREAD_IO_SELECT,
+  THREAD_IO_EPOLL,
+};
+
+struct thread_io_ops;
+
+/* Per file descriptor state, indexed by fd. */
+struct thread_fd
+{
+  struct thread *read;
+  struct thread *write;
+  int events;			/* events registered with the backend */
+  int flags;
+};
+
 /* Master of the theads. */
 struct thread_master
 {
   struct thread_list read;
   struct thread_list write;
-  struct thread_list timer;
+  struct pqueue *timer;
   struct thread_list event;
   struct thread_list ready;
   struct thread_list unuse;
-  struct thread_list background;
+  struct pqueue *background;
   fd_set readfd;
   fd_set writefd;
   fd_set exceptfd;
   unsigned long alloc;
+
+  /* I/O backend. */
+  const struct thread_io_ops *io;
+  void *io_info;
+  struct thread_fd *fds;
+  int fds_size;
 };
 
 typedef unsigned char thread_type;
@@ -69,6 +94,7 @@ struct thread
   thread_type add_type;		/* thread type */
   struct thread *next;		/* next pointer of the thread */   
   struct thread *prev;		/* previous pointer of the thread */
+  int index;			/* position in timer heap, -1 if none */
   struct thread_master *master;	/* pointer to the struct thread_master. */
   int (*func) (struct thread *); /* event function */
   void *arg;			/* event argument */
@@ -171,6 +197,8 @@ enum quagga_clkid {
 
 /* Prototypes. */
 extern struct thread_master *thread_master_create (void);
+extern struct thread_master *thread_master_create_io (enum thread_io_type);
+extern const char *thread_master_io_name (struct thread_master *);
 extern void thread_master_free (struct thread_master *);
 
 extern struct thread *funcname_thread_add_read (struct thread_master *, 
@@ -55,7 +55,7 @@ zclient_new ()
 
   zclient->ibuf = stream_new (ZEBRA_MAX_PACKET_SIZ);
   zclient->obuf = stream_new (ZEBRA_MAX_PACKET_SIZ);
-  zclient->wb = buffer_new(0);
+  zclient->wb = buffer_new(ZCLIENT_FLUSH_SIZE);
 
   return zclient;
 }
@@ -73,7 +73,12 @@ zclient_free (struct zclient *zclient)
   if (zclient->obuf)
     stream_free(zclient->obuf);
   if (zclient->wb)
-    buffer_free(zclient->wb);
+    {
+      /* Don't lose what was sent last, such as withdrawals on exit. */
+      if (zclient->sock >= 0)
+	buffer_flush_all(zclient->wb, zclient->sock);
+      buffer_free(zclient->wb);
+    }
 
   XFREE (MTYPE_ZCLIENT, zclient);
 }
@@ -128,6 +133,7 @@ zclient_stop (struct zclient *zclient)
 
   /* Empty the write buffer. */
   buffer_reset(zclient->wb);
+  zclient->corked = 0;
 
   /* Close socket. */
   if (zclient->sock >= 0)
@@ -249,8 +255,21 @@ zclient_flush_data(struct thread *thread)
   struct zclient *zclient = THREAD_ARG(thread);
 
   zclient->t_write = NULL;
+  return zclient_flush(zclient);
+}
+
+/* Write what is waiting in the write buffer, as far as the socket takes
+   it, and wait for it to take the rest. */
+int
+zclient_flush(struct zclient *zclient)
+{
   if (zclient->sock < 0)
     return -1;
+  if (zclient->corked)
+    {
+      zclient->flushes++;
+      zclient->corked = 0;
+    }
   switch (buffer_flush_available(zclient->wb, zclient->sock))
     {
     case BUFFER_ERROR:
@@ -259,36 +278,40 @@ zclient_flush_data(struct thread *thread)
       return zclient_failed(zclient);
       break;
     case BUFFER_PENDING:
-      zclient->t_write = thread_add_write(master, zclient_flush_data,
-					  zclient, zclient->sock);
+      if (! zclient->t_write)
+	zclient->t_write = thread_add_write(master, zclient_flush_data,
+					    zclient, zclient->sock);
       break;
     case BUFFER_EMPTY:
+      THREAD_OFF(zclient->t_write);
       break;
     }
   return 0;
 }
 
+/* Messages are corked in the write buffer, and written together by an
+   event once the threads ready to run have run, or as soon as
+   ZCLIENT_FLUSH_SIZE bytes of them are waiting: a daemon announcing a
+   table to zebra sends it in a few large writes rather than one per
+   route. */
 int
 zclient_send_message(struct zclient *zclient)
 {
+  size_t length;
+
   if (zclient->sock < 0)
     return -1;
-  switch (buffer_write(zclient->wb, zclient->sock, STREAM_DATA(zclient->obuf),
-		       stream_get_endp(zclient->obuf)))
-    {
-    case BUFFER_ERROR:
-      zlog_warn("%s: buffer_write failed to zclient fd %d, closing",
-      		 __func__, zclient->sock);
-      return zclient_failed(zclient);
-      break;
-    case BUFFER_EMPTY:
-      THREAD_OFF(zclient->t_write);
-      break;
-    case BUFFER_PENDING:
-      THREAD_WRITE_ON(master, zclient->t_write,
-		      zclient_flush_data, zclient, zclient->sock);
-      break;
-    }
+
+  length = stream_get_endp(zclient->obuf);
+  buffer_put(zclient->wb, STREAM_DATA(zclient->obuf), length);
+  zclient->corked += length;
+  zclient->messages++;
+
+  if (zclient->corked >= ZCLIENT_FLUSH_SIZE)
+    return zclient_flush(zclient);
+  if (! zclient->t_write)
+    zclient->t_write = thread_add_event(master, zclient_flush_data,
+					zclient, 0);
   return 0;
 }
 
@@ -395,6 +418,9 @@ zclient_start (struct zclient *zclient)
   if (zclient->default_information)
     zebra_message_send (zclient, ZEBRA_REDISTRIBUTE_DEFAULT_ADD);
 
+  if (zclient->zebra_connected)
+    (*zclient->zebra_connected) (zclient);
+
   return 0;
 }
 
@@ -596,6 +622,31 @@ zebra_redistribute_send (int command, struct zclient *zclient, int type)
   return zclient_send_message(zclient);
 }
 
+/* 
+ * Register (ZEBRA_NEXTHOP_REGISTER) or unregister
+ * (ZEBRA_NEXTHOP_UNREGISTER) interest in the host address P.  Once
+ * registered, zebra sends ZEBRA_NEXTHOP_UPDATE with how P resolves,
+ * straight away and again whenever that changes.
+ */
+int
+zebra_nexthop_register_send (int command, struct zclient *zclient,
+                             struct prefix *p)
+{
+  struct stream *s;
+
+  s = zclient->obuf;
+  stream_reset (s);
+
+  zclient_create_header (s, command);
+  stream_putw (s, p->family);
+  stream_putc (s, p->prefixlen);
+  stream_put (s, &p->u.prefix, PSIZE (p->prefixlen));
+
+  stream_putw_at (s, 0, stream_get_endp (s));
+
+  return zclient_send_message(zclient);
+}
+
 /* Router-id update from zebra daemon. */
 void
 zebra_router_id_update_read (struct stream *s, struct prefix *rid)
@@ -957,6 +1008,10 @@ zclient_read (struct thread *thread)
       if (zclient->ipv6_route_delete)
 	(*zclient->ipv6_route_delete) (command, zclient, length);
       break;
+    case ZEBRA_NEXTHOP_UPDATE:
+      if (zclient->nexthop_update)
+	(*zclient->nexthop_update) (command, zclient, length);
+      break;
     default:
       break;
     }
@@ -34,6 +34,9 @@
 /* Zebra header size. */
 #define ZEBRA_HEADER_SIZE             6
 
+/* Bytes of messages corked before they are written out. */
+#define ZCLIENT_FLUSH_SIZE            65536
+
 /* Structure for the zebra client. */
 struct zclient
 {
@@ -63,6 +66,13 @@ struct zclient
   /* Thread to write buffered data to zebra. */
   struct thread *t_write;
 
+  /* Bytes corked in the write buffer since the last flush. */
+  size_t corked;
+
+  /* Messages sent, and the flushes they went out in. */
+  unsigned long messages;
+  unsigned long flushes;
+
   /* Redistribute information. */
   u_char redist_default;
   u_char redist[ZEBRA_ROUTE_MAX];
@@ -82,6 +92,10 @@ struct zclient
   int (*ipv4_route_delete) (int, struct zclient *, uint16_t);
   int (*ipv6_route_add) (int, struct zclient *, uint16_t);
   int (*ipv6_route_delete) (int, struct zclient *, uint16_t);
+  int (*nexthop_update) (int, struct zclient *, uint16_t);
+
+  /* Called once the connection is up and the initial requests sent. */
+  void (*zebra_connected) (struct zclient *);
 };
 
 /* Zebra API message flag. */
@@ -144,10 +158,18 @@ extern void zclient_redistribute (int command, struct zclient *, int type);
 /* If state has changed, update state and send the command to zebra. */
 extern void zclient_redistribute_default (int command, struct zclient *);
 
-/* Send the message in zclient->obuf to the zebra daemon (or enqueue it).
+/* Ask zebra to start or stop tracking how a nexthop address resolves. */
+extern int zebra_nexthop_register_send (int command, struct zclient *,
+                                        struct prefix *);
+
+/* Queue the message in zclient->obuf for the zebra daemon; it is written
+   out with the others queued at the end of the event loop's pass.
    Returns 0 for success or -1 on an I/O error. */
 extern int zclient_send_message(struct zclient *);
 
+/* Write out the queued messages now. */
+extern int zclient_flush(struct zclient *);
+
 /* create header for command, length to be filled in by user later */
 extern void zclient_create_header (struct stream *, uint16_t);
 
@@ -325,6 +325,9 @@ ospf_if_free (struct ospf_interface *oi)
   
   ospf_delete_from_if (oi->ifp, oi);
 
+  /* Nexthops on the kept SPF trees may refer to the interface. */
+  oi->ospf->spf_pending = OSPF_SPF_FULL;
+
   listnode_delete (oi->ospf->oiflist, oi);
   listnode_delete (oi->area->oiflist, oi);
 
@@ -2364,7 +2364,7 @@ ospf_external_lsa_refresh (struct ospf *ospf, struct ospf_lsa *lsa,
 /* Install router-LSA to an area. */
 static struct ospf_lsa *
 ospf_router_lsa_install (struct ospf *ospf, struct ospf_lsa *new,
-                         int rt_recalc)
+                         struct ospf_lsa *old, int rt_recalc)
 {
   struct ospf_area *area = new->area;
 
@@ -2390,7 +2390,7 @@ ospf_router_lsa_install (struct ospf *ospf, struct ospf_lsa *new,
       ospf_refresher_register_lsa (ospf, new);
     }
   if (rt_recalc)
-    ospf_spf_calculate_schedule (ospf);
+    ospf_spf_schedule_lsa (ospf, old, new);
 
   return new;
 }
@@ -2403,7 +2403,7 @@ ospf_router_lsa_install (struct ospf *ospf, struct ospf_lsa *new,
 static struct ospf_lsa *
 ospf_network_lsa_install (struct ospf *ospf,
 			  struct ospf_interface *oi, 
-			  struct ospf_lsa *new,
+			  struct ospf_lsa *new, struct ospf_lsa *old,
 			  int rt_recalc)
 {
 
@@ -2425,7 +2425,7 @@ ospf_network_lsa_install (struct ospf *ospf,
       ospf_refresher_register_lsa (ospf, new);
     }
   if (rt_recalc)
-    ospf_spf_calculate_schedule (ospf);
+    ospf_spf_schedule_lsa (ospf, old, new);
 
   return new;
 }
@@ -2433,7 +2433,7 @@ ospf_network_lsa_install (struct ospf *ospf,
 /* Install summary-LSA to an area. */
 static struct ospf_lsa *
 ospf_summary_lsa_install (struct ospf *ospf, struct ospf_lsa *new,
-			  int rt_recalc)
+			  struct ospf_lsa *old, int rt_recalc)
 {
   if (rt_recalc && !IS_LSA_SELF (new))
     {
@@ -2444,12 +2444,7 @@ ospf_summary_lsa_install (struct ospf *ospf, struct ospf_lsa *new,
 	 necessary to re-examine all the AS-external-LSAs.
       */
 
-#if 0
-      /* This doesn't exist yet... */
-      ospf_summary_incremental_update(new); */
-#else /* #if 0 */
-      ospf_spf_calculate_schedule (ospf);
-#endif /* #if 0 */
+      ospf_spf_schedule_lsa (ospf, old, new);
  
       if (IS_DEBUG_OSPF (lsa, LSA_INSTALL))
 	zlog_debug ("ospf_summary_lsa_install(): SPF scheduled");
@@ -2464,7 +2459,7 @@ ospf_summary_lsa_install (struct ospf *ospf, struct ospf_lsa *new,
 /* Install ASBR-summary-LSA to an area. */
 static struct ospf_lsa *
 ospf_summary_asbr_lsa_install (struct ospf *ospf, struct ospf_lsa *new,
-			       int rt_recalc)
+			       struct ospf_lsa *old, int rt_recalc)
 {
   if (rt_recalc && !IS_LSA_SELF (new))
     {
@@ -2474,15 +2469,7 @@ ospf_summary_asbr_lsa_install (struct ospf *ospf, struct ospf_lsa *new,
 	 destination is an AS boundary router, it may also be
 	 necessary to re-examine all the AS-external-LSAs.
       */
-#if 0
-      /* These don't exist yet... */
-      ospf_summary_incremental_update(new);
-      /* Isn't this done by the above call? 
-	 - RFC 2328 Section 16.5 implies it should be */
-      /* ospf_ase_calculate_schedule(); */
-#else  /* #if 0 */
-      ospf_spf_calculate_schedule (ospf);
-#endif /* #if 0 */
+      ospf_spf_schedule_lsa (ospf, old, new);
     }
 
   /* register LSA to refresh-list. */
@@ -2687,9 +2674,12 @@ ospf_lsa_install (struct ospf *ospf, struct ospf_interface *oi,
         }
     }
 
-  /* discard old LSA from LSDB */
+  /* discard old LSA from LSDB, keeping hold of it to compare with */
   if (old != NULL)
-    ospf_discard_from_db (ospf, lsdb, lsa);
+    {
+      ospf_lsa_lock (old);
+      ospf_discard_from_db (ospf, lsdb, lsa);
+    }
 
   /* Calculate Checksum if self-originated?. */
   if (IS_LSA_SELF (lsa))
@@ -2703,17 +2693,17 @@ ospf_lsa_install (struct ospf *ospf, struct ospf_interface *oi,
   switch (lsa->data->type)
     {
     case OSPF_ROUTER_LSA:
-      new = ospf_router_lsa_install (ospf, lsa, rt_recalc);
+      new = ospf_router_lsa_install (ospf, lsa, old, rt_recalc);
       break;
     case OSPF_NETWORK_LSA:
       assert (oi);
-      new = ospf_network_lsa_install (ospf, oi, lsa, rt_recalc);
+      new = ospf_network_lsa_install (ospf, oi, lsa, old, rt_recalc);
       break;
     case OSPF_SUMMARY_LSA:
-      new = ospf_summary_lsa_install (ospf, lsa, rt_recalc);
+      new = ospf_summary_lsa_install (ospf, lsa, old, rt_recalc);
       break;
     case OSPF_ASBR_SUMMARY_LSA:
-      new = ospf_summary_asbr_lsa_install (ospf, lsa, rt_recalc);
+      new = ospf_summary_asbr_lsa_install (ospf, lsa, old, rt_recalc);
       break;
     case OSPF_AS_EXTERNAL_LSA:
       new = ospf_external_lsa_install (ospf, lsa, rt_recalc);
@@ -2736,6 +2726,9 @@ ospf_lsa_install (struct ospf *ospf, struct ospf_interface *oi,
       break;
     }
 
+  if (old != NULL)
+    ospf_lsa_unlock (&old);
+
   if (new == NULL)
     return new;  /* Installation failed, cannot proceed further -- endo. */
 
@@ -2953,7 +2946,7 @@ ospf_lsa_maxage_walker_remover (struct ospf *ospf, struct ospf_lsa *lsa)
 	    ospf_ase_incremental_update (ospf, lsa);
             break;
           default:
-	    ospf_spf_calculate_schedule (ospf);
+	    ospf_spf_schedule_lsa (ospf, NULL, lsa);
             break;
           }
 	ospf_lsa_maxage (ospf, lsa);
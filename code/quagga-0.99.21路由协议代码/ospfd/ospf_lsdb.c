@@ -31,6 +31,7 @@
 #include "ospfd/ospf_asbr.h"
 #include "ospfd/ospf_lsa.h"
 #include "ospfd/ospf_lsdb.h"
+#include "ospfd/ospf_spf.h"
 
 struct ospf_lsdb *
 ospf_lsdb_new ()
@@ -98,6 +99,7 @@ ospf_lsdb_delete_entry (struct ospf_lsdb *lsdb, struct route_node *rn)
   lsdb->total--;
   rn->info = NULL;
   route_unlock_node (rn);
+  ospf_spf_graph_delete (lsdb, lsa);
 #ifdef MONITOR_LSDB_CHANGE
   if (lsdb->del_lsa_hook != NULL)
     (* lsdb->del_lsa_hook)(lsa);
@@ -140,6 +142,7 @@ ospf_lsdb_add (struct ospf_lsdb *lsdb, struct ospf_lsa *lsa)
 #endif /* MONITOR_LSDB_CHANGE */
   lsdb->type[lsa->data->type].checksum += ntohs(lsa->data->checksum);
   rn->info = ospf_lsa_lock (lsa); /* lsdb */
+  ospf_spf_graph_add (lsdb, lsa);
 }
 
 void
@@ -30,6 +30,7 @@ Software Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
 #include "log.h"
 #include "sockunion.h"          /* for inet_ntop () */
 #include "pqueue.h"
+#include "jhash.h"
 
 #include "ospfd/ospfd.h"
 #include "ospfd/ospf_interface.h"
@@ -47,11 +48,21 @@ Software Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
 #include "ospfd/ospf_dump.h"
 
 static void ospf_vertex_free (void *);
-/* List of allocated vertices, to simplify cleanup of SPF.
+/* List of vertices allocated by a calculation.  Those that make it onto
+ * the shortest-path tree are kept on the area's spf_vertices list, the
+ * others are freed when the calculation is done.
  * Not thread-safe obviously. If it ever needs to be, it'd have to be
  * dynamically allocated at begin of ospf_spf_calculate
  */
-static struct list vertex_list = { .del = ospf_vertex_free };
+static struct list vertex_list;
+
+const char *ospf_spf_kind_str[] =
+{
+  "None",
+  "Partial route calculation",
+  "Incremental SPF",
+  "Full SPF",
+};
 
 /* Heap related functions, for the managment of the candidates, to
  * be used with pqueue. */
@@ -160,9 +171,273 @@ vertex_parent_free (void *p)
   XFREE (MTYPE_OSPF_VERTEX_PARENT, p);
 }
 
+static unsigned int
+ospf_spf_node_key (void *data)
+{
+  struct ospf_spf_node *n = data;
+
+  return jhash_2words (n->id.s_addr, n->type, 0);
+}
+
+static int
+ospf_spf_node_cmp (const void *d1, const void *d2)
+{
+  const struct ospf_spf_node *n1 = d1;
+  const struct ospf_spf_node *n2 = d2;
+
+  return n1->type == n2->type && IPV4_ADDR_SAME (&n1->id, &n2->id);
+}
+
+static void *
+ospf_spf_node_alloc (void *data)
+{
+  struct ospf_spf_node *key = data;
+  struct ospf_spf_node *n;
+
+  n = XCALLOC (MTYPE_OSPF_SPF_NODE, sizeof (struct ospf_spf_node));
+  n->type = key->type;
+  n->id = key->id;
+  n->area = key->area;
+  return n;
+}
+
+static struct ospf_spf_node *
+ospf_spf_node_get (struct ospf_area *area, u_char type, struct in_addr id)
+{
+  struct ospf_spf_node key;
+
+  key.type = type;
+  key.id = id;
+  key.area = area;
+  return hash_get (area->spf_graph, &key, ospf_spf_node_alloc);
+}
+
+/* Free N once nothing refers to it any more. */
+static void
+ospf_spf_node_release (struct ospf_spf_node *n)
+{
+  if (n->lsa || n->refcnt)
+    return;
+
+  hash_release (n->area->spf_graph, n);
+  XFREE (MTYPE_OSPF_SPF_NODE, n);
+}
+
+/* The first edge from FROM to TO, or NULL. */
+static struct ospf_spf_edge *
+ospf_spf_edge_find (struct ospf_spf_node *from, struct ospf_spf_node *to)
+{
+  unsigned int i;
+
+  for (i = 0; i < from->edge_count; i++)
+    if (from->edges[i].node == to)
+      return &from->edges[i];
+  return NULL;
+}
+
+static void
+ospf_spf_edge_add (struct ospf_spf_node *n, u_char type, struct in_addr id,
+                   struct router_lsa_link *l, u_int16_t cost, u_int16_t index)
+{
+  struct ospf_spf_edge *e = &n->edges[n->edge_count++];
+
+  e->node = ospf_spf_node_get (n->area, type, id);
+  e->node->refcnt++;
+  e->link = l;
+  e->cost = cost;
+  e->index = index;
+  e->backlink = -1;
+}
+
+/* Build the edges of N from its LSA, and resolve the links back between
+ * them and the edges of the nodes they lead to, in both directions: an
+ * edge counts only if it is matched by one back (RFC2328 16.1 (2) (b)).
+ */
+static void
+ospf_spf_node_link (struct ospf_spf_node *n)
+{
+  struct lsa_header *lsah = n->lsa->data;
+  struct network_lsa *nl;
+  struct router_lsa_link *l;
+  struct ospf_spf_edge *e, *back;
+  u_char *p, *lim;
+  unsigned int i, count;
+
+  p = ((u_char *) lsah) + OSPF_LSA_HEADER_SIZE + 4;
+  lim = ((u_char *) lsah) + ntohs (lsah->length);
+
+  if (lsah->type == OSPF_NETWORK_LSA)
+    {
+      nl = (struct network_lsa *) lsah;
+      count = (lim - p) / sizeof (struct in_addr);
+      n->edges = XMALLOC (MTYPE_OSPF_SPF_EDGE,
+                          count * sizeof (struct ospf_spf_edge));
+      for (i = 0; i < count; i++)
+        ospf_spf_edge_add (n, OSPF_VERTEX_ROUTER, nl->routers[i], NULL, 0, i);
+    }
+  else
+    {
+      /* Links to stub networks are left to the second stage. */
+      for (count = 0; p < lim; count++)
+        {
+          l = (struct router_lsa_link *) p;
+          p += (OSPF_ROUTER_LSA_LINK_SIZE +
+                (l->m[0].tos_count * OSPF_ROUTER_LSA_TOS_SIZE));
+        }
+      n->edges = XMALLOC (MTYPE_OSPF_SPF_EDGE,
+                          count * sizeof (struct ospf_spf_edge));
+
+      p = ((u_char *) lsah) + OSPF_LSA_HEADER_SIZE + 4;
+      for (i = 0; p < lim; i++)
+        {
+          l = (struct router_lsa_link *) p;
+          p += (OSPF_ROUTER_LSA_LINK_SIZE +
+                (l->m[0].tos_count * OSPF_ROUTER_LSA_TOS_SIZE));
+
+          switch (l->m[0].type)
+            {
+            case LSA_LINK_TYPE_POINTOPOINT:
+            case LSA_LINK_TYPE_VIRTUALLINK:
+              ospf_spf_edge_add (n, OSPF_VERTEX_ROUTER, l->link_id, l,
+                                 ntohs (l->m[0].metric), i);
+              break;
+            case LSA_LINK_TYPE_TRANSIT:
+              ospf_spf_edge_add (n, OSPF_VERTEX_NETWORK, l->link_id, l,
+                                 ntohs (l->m[0].metric), i);
+              break;
+            default:
+              break;
+            }
+        }
+    }
+
+  for (i = 0; i < n->edge_count; i++)
+    {
+      e = &n->edges[i];
+      if ((back = ospf_spf_edge_find (e->node, n)) == NULL)
+        continue;
+      e->backlink = back->index;
+      for (; back < e->node->edges + e->node->edge_count; back++)
+        if (back->node == n && back->backlink < 0)
+          back->backlink = e->index;
+    }
+}
+
+/* Take the edges of N away, and the links back to it with them. */
+static void
+ospf_spf_node_unlink (struct ospf_spf_node *n)
+{
+  struct ospf_spf_node *to;
+  unsigned int i, j;
+
+  for (i = 0; i < n->edge_count; i++)
+    {
+      to = n->edges[i].node;
+      for (j = 0; j < to->edge_count; j++)
+        if (to->edges[j].node == n)
+          to->edges[j].backlink = -1;
+    }
+
+  for (i = 0; i < n->edge_count; i++)
+    {
+      to = n->edges[i].node;
+      to->refcnt--;
+      if (to != n)
+        ospf_spf_node_release (to);
+    }
+
+  if (n->edges)
+    XFREE (MTYPE_OSPF_SPF_EDGE, n->edges);
+  n->edges = NULL;
+  n->edge_count = 0;
+}
+
+static int
+ospf_spf_graph_lsa (struct ospf_lsdb *lsdb, struct ospf_lsa *lsa, u_char *type)
+{
+  if (lsa->area == NULL || lsa->area->lsdb != lsdb
+      || lsa->area->spf_graph == NULL)
+    return 0;
+
+  switch (lsa->data->type)
+    {
+    case OSPF_ROUTER_LSA:
+      /* Only the router's own is looked up. */
+      if (! IPV4_ADDR_SAME (&lsa->data->id, &lsa->data->adv_router))
+        return 0;
+      *type = OSPF_VERTEX_ROUTER;
+      return 1;
+    case OSPF_NETWORK_LSA:
+      *type = OSPF_VERTEX_NETWORK;
+      return 1;
+    default:
+      return 0;
+    }
+}
+
+/* LSA added to LSDB, replacing any other instance. */
+void
+ospf_spf_graph_add (struct ospf_lsdb *lsdb, struct ospf_lsa *lsa)
+{
+  struct ospf_spf_node *n;
+  u_char type;
+
+  if (! ospf_spf_graph_lsa (lsdb, lsa, &type))
+    return;
+
+  n = ospf_spf_node_get (lsa->area, type, lsa->data->id);
+  ospf_spf_node_unlink (n);
+  n->lsa = lsa;
+  ospf_spf_node_link (n);
+}
+
+/* LSA deleted from LSDB. */
+void
+ospf_spf_graph_delete (struct ospf_lsdb *lsdb, struct ospf_lsa *lsa)
+{
+  struct ospf_spf_node key;
+  struct ospf_spf_node *n;
+
+  if (! ospf_spf_graph_lsa (lsdb, lsa, &key.type))
+    return;
+
+  key.id = lsa->data->id;
+  n = hash_lookup (lsa->area->spf_graph, &key);
+  if (n == NULL || n->lsa != lsa)
+    return;
+
+  ospf_spf_node_unlink (n);
+
+  /* Another router may still claim the network's ID. */
+  n->lsa = NULL;
+  if (n->type == OSPF_VERTEX_NETWORK)
+    n->lsa = ospf_lsa_lookup_by_id (n->area, OSPF_NETWORK_LSA, n->id);
+  if (n->lsa)
+    ospf_spf_node_link (n);
+  else
+    ospf_spf_node_release (n);
+}
+
+void
+ospf_spf_graph_init (struct ospf_area *area)
+{
+  area->spf_graph = hash_create (ospf_spf_node_key, ospf_spf_node_cmp,
+			          "OSPF SPF graph");
+}
+
+/* After the LSDB and the kept tree have gone, nothing is left. */
+void
+ospf_spf_graph_free (struct ospf_area *area)
+{
+  assert (area->spf_graph->count == 0);
+  hash_free (area->spf_graph);
+  area->spf_graph = NULL;
+}
+
 static struct vertex *
-ospf_vertex_new (struct ospf_lsa *lsa)
+ospf_vertex_new (struct ospf_spf_node *node)
 {
+  struct ospf_lsa *lsa = node->lsa;
   struct vertex *new;
 
   new = XCALLOC (MTYPE_OSPF_VERTEX, sizeof (struct vertex));
@@ -171,6 +446,8 @@ ospf_vertex_new (struct ospf_lsa *lsa)
   new->stat = &(lsa->stat);
   new->type = lsa->data->type;
   new->id = lsa->data->id;
+  new->node = node;
+  node->refcnt++;
   new->lsa = lsa->data;
   new->children = list_new ();
   new->parents = list_new ();
@@ -193,7 +470,7 @@ ospf_vertex_free (void *data)
   if (IS_DEBUG_OSPF_EVENT)
     zlog_debug ("%s: Free %s vertex %s", __func__,
                 v->type == OSPF_VERTEX_ROUTER ? "Router" : "Network",
-                inet_ntoa (v->lsa->id));
+                inet_ntoa (v->id));
   
   /* There should be no parents potentially holding references to this vertex
    * Children however may still be there, but presumably referenced by other
@@ -210,6 +487,8 @@ ospf_vertex_free (void *data)
   v->parents = NULL;
   
   v->lsa = NULL;
+  v->node->refcnt--;
+  ospf_spf_node_release (v->node);
   
   XFREE (MTYPE_OSPF_VERTEX, v);
 }
@@ -278,12 +557,12 @@ ospf_vertex_add_parent (struct vertex *v)
 }
 
 static void
-ospf_spf_init (struct ospf_area *area)
+ospf_spf_init (struct ospf_area *area, struct ospf_spf_node *root)
 {
   struct vertex *v;
   
   /* Create root node. */
-  v = ospf_vertex_new (area->router_lsa_self);
+  v = ospf_vertex_new (root);
   
   area->spf = v;
 
@@ -292,68 +571,103 @@ ospf_spf_init (struct ospf_area *area)
   area->asbr_count = 0;
 }
 
-/* return index of link back to V from W, or -1 if no link found */
-static int
-ospf_lsa_has_link (struct lsa_header *w, struct lsa_header *v)
+/* Put V on the area's kept tree, after the vertices already there. */
+static void
+ospf_spf_tree_add (struct ospf_area *area, struct vertex *v)
 {
-  unsigned int i, length;
-  struct router_lsa *rl;
-  struct network_lsa *nl;
+  SET_FLAG (v->flags, OSPF_VERTEX_SPFTREE);
+  listnode_add (area->spf_vertices, v);
+}
 
-  /* In case of W is Network LSA. */
-  if (w->type == OSPF_NETWORK_LSA)
+/* Free the vertices of the calculation just done that did not make it
+ * onto the tree.  Nothing refers to them: only vertices on the tree
+ * become parents.
+ */
+static void
+ospf_spf_vertex_list_reap (void)
+{
+  struct listnode *node, *nnode;
+  struct vertex *v;
+
+  for (node = vertex_list.head; node; node = nnode)
     {
-      if (v->type == OSPF_NETWORK_LSA)
-        return -1;
+      nnode = listnextnode (node);
+      v = listgetdata (node);
+      if (! CHECK_FLAG (v->flags, OSPF_VERTEX_SPFTREE))
+        ospf_vertex_free (v);
+    }
+  list_delete_all_node (&vertex_list);
+}
 
-      nl = (struct network_lsa *) w;
-      length = (ntohs (w->length) - OSPF_LSA_HEADER_SIZE - 4) / 4;
+/* Free the tree kept from the last calculation for an area. */
+static void
+ospf_spf_tree_clear (struct ospf_area *area)
+{
+  struct listnode *node;
+  struct vertex *v;
 
-      for (i = 0; i < length; i++)
-        if (IPV4_ADDR_SAME (&nl->routers[i], &v->id))
-          return i;
-      return -1;
-    }
+  if (area->spf)
+    ospf_canonical_nexthops_free (area->spf);
+  area->spf = NULL;
 
-  /* In case of W is Router LSA. */
-  if (w->type == OSPF_ROUTER_LSA)
+  if (area->spf_vertices)
     {
-      rl = (struct router_lsa *) w;
+      for (ALL_LIST_ELEMENTS_RO (area->spf_vertices, node, v))
+        ospf_vertex_free (v);
+      list_delete_all_node (area->spf_vertices);
+    }
+  else
+    area->spf_vertices = list_new ();
+}
+
+void
+ospf_spf_tree_free (struct ospf_area *area)
+{
+  ospf_spf_tree_clear (area);
+  list_delete (area->spf_vertices);
+  area->spf_vertices = NULL;
+}
 
-      length = ntohs (w->length);
+/* The current instance of the LSA of V, or NULL if it has gone. */
+static struct ospf_lsa *
+ospf_spf_vertex_lsa (struct vertex *v)
+{
+  struct ospf_lsa *lsa = v->node->lsa;
 
-      for (i = 0;
-           i < ntohs (rl->links) && length >= sizeof (struct router_lsa);
-           i++, length -= 12)
+  if (lsa == NULL || IS_LSA_MAXAGE (lsa))
+    return NULL;
+  return lsa;
+}
+
+/* Point the vertices of the kept tree at the current instances of their
+ * LSAs, which later calculations read.  Vertices whose LSAs have
+ * changed in a way that matters have been taken off the tree already, so
+ * an LSA that has gone means something was missed: -1 asks for a full
+ * calculation.
+ */
+static int
+ospf_spf_tree_refresh (struct ospf_area *area)
+{
+  struct listnode *node, *pnode;
+  struct vertex *v;
+  struct vertex_parent *vp;
+  struct ospf_spf_edge *e;
+  struct ospf_lsa *lsa;
+
+  for (ALL_LIST_ELEMENTS_RO (area->spf_vertices, node, v))
+    {
+      if ((lsa = ospf_spf_vertex_lsa (v)) == NULL)
+        return -1;
+
+      v->lsa = lsa->data;
+      v->stat = &lsa->stat;
+      for (ALL_LIST_ELEMENTS_RO (v->parents, pnode, vp))
         {
-          switch (rl->link[i].type)
-            {
-            case LSA_LINK_TYPE_POINTOPOINT:
-            case LSA_LINK_TYPE_VIRTUALLINK:
-              /* Router LSA ID. */
-              if (v->type == OSPF_ROUTER_LSA &&
-                  IPV4_ADDR_SAME (&rl->link[i].link_id, &v->id))
-                {
-                  return i;
-                }
-              break;
-            case LSA_LINK_TYPE_TRANSIT:
-              /* Network LSA ID. */
-              if (v->type == OSPF_NETWORK_LSA &&
-                  IPV4_ADDR_SAME (&rl->link[i].link_id, &v->id))
-                {
-                  return i;
-                }
-              break;
-            case LSA_LINK_TYPE_STUB:
-              /* Stub can't lead anywhere, carry on */
-              continue;
-            default:
-              break;
-            }
+          e = ospf_spf_edge_find (v->node, vp->parent->node);
+          vp->backlink = e ? e->index : -1;
         }
     }
-  return -1;
+  return 0;
 }
 
 /* Find the next link after prev_link from v to w.  If prev_link is
@@ -364,37 +678,20 @@ static struct router_lsa_link *
 ospf_get_next_link (struct vertex *v, struct vertex *w,
                     struct router_lsa_link *prev_link)
 {
-  u_char *p;
-  u_char *lim;
-  u_char lsa_type =  LSA_LINK_TYPE_TRANSIT;
-  struct router_lsa_link *l;
+  struct ospf_spf_node *n = v->node;
+  struct ospf_spf_edge *e = n->edges;
 
-  if (w->type == OSPF_VERTEX_ROUTER)
-    lsa_type = LSA_LINK_TYPE_POINTOPOINT;
-
-  if (prev_link == NULL)
-    p = ((u_char *) v->lsa) + OSPF_LSA_HEADER_SIZE + 4;
-  else
+  if (prev_link != NULL)
     {
-      p = (u_char *) prev_link;
-      p += (OSPF_ROUTER_LSA_LINK_SIZE +
-            (prev_link->m[0].tos_count * OSPF_ROUTER_LSA_TOS_SIZE));
+      while (e < n->edges + n->edge_count && e->link != prev_link)
+        e++;
+      e++;
     }
 
-  lim = ((u_char *) v->lsa) + ntohs (v->lsa->length);
-
-  while (p < lim)
-    {
-      l = (struct router_lsa_link *) p;
-
-      p += (OSPF_ROUTER_LSA_LINK_SIZE + (l->m[0].tos_count * OSPF_ROUTER_LSA_TOS_SIZE));
-
-      if (l->m[0].type != lsa_type)
-        continue;
-
-      if (IPV4_ADDR_SAME (&l->link_id, &w->id))
-        return l;
-    }
+  for (; e < n->edges + n->edge_count; e++)
+    if (e->node == w->node && e->link
+        && e->link->m[0].type != LSA_LINK_TYPE_VIRTUALLINK)
+      return e->link;
 
   return NULL;
 }
@@ -420,7 +717,7 @@ ospf_spf_flush_parents (struct vertex *w)
 static void
 ospf_spf_add_parent (struct vertex *v, struct vertex *w,
                      struct vertex_nexthop *newhop,
-                     unsigned int distance)
+                     unsigned int distance, int backlink)
 {
   struct vertex_parent *vp;
     
@@ -457,17 +754,14 @@ ospf_spf_add_parent (struct vertex *v, struct vertex *w,
     }
   
   /* new parent is <= existing parents, add it to parent list */  
-  vp = vertex_parent_new (v, ospf_lsa_has_link (w->lsa, v->lsa), newhop);
+  vp = vertex_parent_new (v, backlink, newhop);
   listnode_add (w->parents, vp);
 
   return;
 }
 
 /* 16.1.1.  Calculate nexthop from root through V (parent) to
- * vertex W (destination), with given distance from root->W.
- *
- * The link must be supplied if V is the root vertex. In all other cases
- * it may be NULL.
+ * vertex W (destination) over edge E, with given distance from root->W.
  *
  * Note that this function may fail, hence the state of the destination
  * vertex, W, should /not/ be modified in a dependent manner until
@@ -476,9 +770,10 @@ ospf_spf_add_parent (struct vertex *v, struct vertex *w,
  */
 static unsigned int
 ospf_nexthop_calculation (struct ospf_area *area, struct vertex *v,
-                          struct vertex *w, struct router_lsa_link *l,
+                          struct vertex *w, struct ospf_spf_edge *e,
                           unsigned int distance)
 {
+  struct router_lsa_link *l = e->link;
   struct listnode *node, *nnode;
   struct vertex_nexthop *nh;
   struct vertex_parent *vp;
@@ -592,7 +887,7 @@ ospf_nexthop_calculation (struct ospf_area *area, struct vertex *v,
                   nh = vertex_nexthop_new ();
                   nh->oi = oi;
                   nh->router = l2->link_data;
-                  ospf_spf_add_parent (v, w, nh, distance);
+                  ospf_spf_add_parent (v, w, nh, distance, e->backlink);
                   return 1;
                 }
               else
@@ -618,7 +913,7 @@ ospf_nexthop_calculation (struct ospf_area *area, struct vertex *v,
                   nh = vertex_nexthop_new ();
                   nh->oi = vl_data->nexthop.oi;
                   nh->router = vl_data->nexthop.router;
-                  ospf_spf_add_parent (v, w, nh, distance);
+                  ospf_spf_add_parent (v, w, nh, distance, e->backlink);
                   return 1;
                 }
               else
@@ -636,7 +931,7 @@ ospf_nexthop_calculation (struct ospf_area *area, struct vertex *v,
               nh = vertex_nexthop_new ();
               nh->oi = oi;
               nh->router.s_addr = 0;
-              ospf_spf_add_parent (v, w, nh, distance);
+              ospf_spf_add_parent (v, w, nh, distance, e->backlink);
               return 1;
             }
         }
@@ -671,7 +966,7 @@ ospf_nexthop_calculation (struct ospf_area *area, struct vertex *v,
 		  nh->oi = vp->nexthop->oi;
 		  nh->router = l->link_data;
 		  added = 1;
-                  ospf_spf_add_parent (v, w, nh, distance);
+                  ospf_spf_add_parent (v, w, nh, distance, e->backlink);
                 }
             }
         }
@@ -703,7 +998,7 @@ ospf_nexthop_calculation (struct ospf_area *area, struct vertex *v,
   for (ALL_LIST_ELEMENTS (v->parents, node, nnode, vp))
     {
       added = 1;
-      ospf_spf_add_parent (v, w, vp->nexthop, distance);
+      ospf_spf_add_parent (v, w, vp->nexthop, distance, e->backlink);
     }
   
   return added;
@@ -719,11 +1014,8 @@ ospf_spf_next (struct vertex *v, struct ospf_area *area,
 	       struct pqueue * candidate)
 {
   struct ospf_lsa *w_lsa = NULL;
-  u_char *p;
-  u_char *lim;
-  struct router_lsa_link *l = NULL;
-  struct in_addr *r;
-  int type = 0;
+  struct ospf_spf_node *n = v->node;
+  struct ospf_spf_edge *e;
 
   /* If this is a router-LSA, and bit V of the router-LSA (see Section
      A.4.2:RFC2328) is set, set Area A's TransitCapability to TRUE.  */
@@ -739,87 +1031,24 @@ ospf_spf_next (struct vertex *v, struct ospf_area *area,
                 v->type == OSPF_VERTEX_ROUTER ? "Router" : "Network",
                 inet_ntoa(v->lsa->id));
   
-  p = ((u_char *) v->lsa) + OSPF_LSA_HEADER_SIZE + 4;
-  lim = ((u_char *) v->lsa) + ntohs (v->lsa->length);
-
-  while (p < lim)
+  /* (a) Links to stub networks are not on the graph: they are
+     considered in the second stage of the shortest path calculation. */
+  for (e = n->edges; e < n->edges + n->edge_count; e++)
     {
       struct vertex *w;
       unsigned int distance;
       
-      /* In case of V is Router-LSA. */
-      if (v->lsa->type == OSPF_ROUTER_LSA)
-        {
-          l = (struct router_lsa_link *) p;
-
-          p += (OSPF_ROUTER_LSA_LINK_SIZE +
-                (l->m[0].tos_count * OSPF_ROUTER_LSA_TOS_SIZE));
-
-          /* (a) If this is a link to a stub network, examine the next
-             link in V's LSA.  Links to stub networks will be
-             considered in the second stage of the shortest path
-             calculation. */
-          if ((type = l->m[0].type) == LSA_LINK_TYPE_STUB)
-            continue;
-          
-          /* Infinite distance links shouldn't be followed, except
-           * for local links (a stub-routed router still wants to
-           * calculate tree, so must follow its own links).
-           */
-          if ((v != area->spf) && l->m[0].metric >= OSPF_OUTPUT_COST_INFINITE)
-            continue;
-
-          /* (b) Otherwise, W is a transit vertex (router or transit
-             network).  Look up the vertex W's LSA (router-LSA or
-             network-LSA) in Area A's link state database. */
-          switch (type)
-            {
-            case LSA_LINK_TYPE_POINTOPOINT:
-            case LSA_LINK_TYPE_VIRTUALLINK:
-              if (type == LSA_LINK_TYPE_VIRTUALLINK)
-                {
-                  if (IS_DEBUG_OSPF_EVENT)
-                    zlog_debug ("looking up LSA through VL: %s",
-                               inet_ntoa (l->link_id));
-                }
-
-              w_lsa = ospf_lsa_lookup (area, OSPF_ROUTER_LSA, l->link_id,
-                                       l->link_id);
-              if (w_lsa)
-                {
-                  if (IS_DEBUG_OSPF_EVENT)
-                    zlog_debug ("found Router LSA %s", inet_ntoa (l->link_id));
-                }
-              break;
-            case LSA_LINK_TYPE_TRANSIT:
-              if (IS_DEBUG_OSPF_EVENT)
-                zlog_debug ("Looking up Network LSA, ID: %s",
-                           inet_ntoa (l->link_id));
-              w_lsa = ospf_lsa_lookup_by_id (area, OSPF_NETWORK_LSA,
-                                             l->link_id);
-              if (w_lsa)
-                if (IS_DEBUG_OSPF_EVENT)
-                  zlog_debug ("found the LSA");
-              break;
-            default:
-              zlog_warn ("Invalid LSA link type %d", type);
-              continue;
-            }
-        }
-      else
-        {
-          /* In case of V is Network-LSA. */
-          r = (struct in_addr *) p;
-          p += sizeof (struct in_addr);
+      /* Infinite distance links shouldn't be followed, except
+       * for local links (a stub-routed router still wants to
+       * calculate tree, so must follow its own links).
+       */
+      if ((v != area->spf) && e->cost >= OSPF_OUTPUT_COST_INFINITE)
+        continue;
 
-          /* Lookup the vertex W's LSA. */
-          w_lsa = ospf_lsa_lookup_by_id (area, OSPF_ROUTER_LSA, *r);
-          if (w_lsa)
-            {
-              if (IS_DEBUG_OSPF_EVENT)
-                zlog_debug ("found Router LSA %s", inet_ntoa (w_lsa->data->id));
-            }
-        }
+      /* (b) Otherwise, W is a transit vertex (router or transit
+         network), whose LSA (router-LSA or network-LSA) in Area A's
+         link state database is on the graph with it. */
+      w_lsa = e->node->lsa;
 
       /* (b cont.) If the LSA does not exist, or its LS age is equal
          to MaxAge, or it does not have a link back to vertex V,
@@ -838,7 +1067,7 @@ ospf_spf_next (struct vertex *v, struct ospf_area *area,
           continue;
         }
 
-      if (ospf_lsa_has_link (w_lsa->data, v->lsa) < 0 )
+      if (e->backlink < 0)
         {
           if (IS_DEBUG_OSPF_EVENT)
             zlog_debug ("The LSA doesn't have a link back");
@@ -861,19 +1090,16 @@ ospf_spf_next (struct vertex *v, struct ospf_area *area,
          V and W.  If D is: */
 
       /* calculate link cost D. */
-      if (v->lsa->type == OSPF_ROUTER_LSA)
-	distance = v->distance + ntohs (l->m[0].metric);
-      else /* v is not a Router-LSA */
-	distance = v->distance;
+      distance = v->distance + e->cost;
 
       /* Is there already vertex W in candidate list? */
       if (w_lsa->stat == LSA_SPF_NOT_EXPLORED)
 	{
           /* prepare vertex W. */
-          w = ospf_vertex_new (w_lsa);
+          w = ospf_vertex_new (e->node);
 
           /* Calculate nexthop to W. */
-          if (ospf_nexthop_calculation (area, v, w, l, distance))
+          if (ospf_nexthop_calculation (area, v, w, e, distance))
             pqueue_enqueue (w, candidate);
           else if (IS_DEBUG_OSPF_EVENT)
             zlog_debug ("Nexthop Calc failed");
@@ -893,7 +1119,7 @@ ospf_spf_next (struct vertex *v, struct ospf_area *area,
             {
 	      /* Found an equal-cost path to W.  
                * Calculate nexthop of to W from V. */
-              ospf_nexthop_calculation (area, v, w, l, distance);
+              ospf_nexthop_calculation (area, v, w, e, distance);
             }
            /* less than. */
 	  else
@@ -903,7 +1129,7 @@ ospf_spf_next (struct vertex *v, struct ospf_area *area,
                * valid nexthop it will call spf_add_parents, which
                * will flush the old parents
                */
-              if (ospf_nexthop_calculation (area, v, w, l, distance))
+              if (ospf_nexthop_calculation (area, v, w, e, distance))
                 /* Decrease the key of the node in the heap.
                  * trickle-sort it up towards root, just in case this
                  * node should now be the new root due the cost change. 
@@ -1110,6 +1336,7 @@ ospf_spf_calculate (struct ospf_area *area, struct route_table *new_table,
                     struct route_table *new_rtrs)
 {
   struct pqueue *candidate;
+  struct ospf_spf_node *root = NULL;
   struct vertex *v;
   
   if (IS_DEBUG_OSPF_EVENT)
@@ -1119,9 +1346,15 @@ ospf_spf_calculate (struct ospf_area *area, struct route_table *new_table,
                  inet_ntoa (area->area_id));
     }
 
+  /* Free the tree kept from the last calculation. */
+  ospf_spf_tree_clear (area);
+
   /* Check router-lsa-self.  If self-router-lsa is not yet allocated,
      return this area's calculation. */
-  if (!area->router_lsa_self)
+  if (area->router_lsa_self)
+    root = ospf_spf_node_get (area, OSPF_VERTEX_ROUTER,
+                              area->router_lsa_self->data->id);
+  if (!root || root->lsa != area->router_lsa_self)
     {
       if (IS_DEBUG_OSPF_EVENT)
         zlog_debug ("ospf_spf_calculate: "
@@ -1143,11 +1376,12 @@ ospf_spf_calculate (struct ospf_area *area, struct route_table *new_table,
 
   /* Initialize the shortest-path tree to only the root (which is the
      router doing the calculation). */
-  ospf_spf_init (area);
+  ospf_spf_init (area, root);
   v = area->spf;
   /* Set LSA position to LSA_SPF_IN_SPFTREE. This vertex is the root of the
    * spanning tree. */
   *(v->stat) = LSA_SPF_IN_SPFTREE;
+  ospf_spf_tree_add (area, v);
 
   /* Set Area A's TransitCapability to FALSE. */
   area->transit = OSPF_TRANSIT_FALSE;
@@ -1175,6 +1409,7 @@ ospf_spf_calculate (struct ospf_area *area, struct route_table *new_table,
       *(v->stat) = LSA_SPF_IN_SPFTREE;
 
       ospf_vertex_add_parent (v);
+      ospf_spf_tree_add (area, v);
 
       /* RFC2328 16.1. (4). */
       if (v->type == OSPF_VERTEX_ROUTER)
@@ -1200,27 +1435,335 @@ ospf_spf_calculate (struct ospf_area *area, struct route_table *new_table,
   pqueue_delete (candidate);
   
   ospf_vertex_dump (__func__, area->spf, 0, 1);
-  /* Free nexthop information, canonical versions of which are attached
-   * the first level of router vertices attached to the root vertex, see
-   * ospf_nexthop_calculation.
-   */
-  ospf_canonical_nexthops_free (area->spf);
-  
-  /* Free SPF vertices, but not the list. List has ospf_vertex_free
-   * as deconstructor.
+
+  /* Keep the tree, and the nexthop information attached to it, for
+   * partial and incremental calculations; see ospf_spf_tree_clear.
    */
-  list_delete_all_node (&vertex_list);
+  ospf_spf_vertex_list_reap ();
   
   /* Increment SPF Calculation Counter. */
   area->spf_calculation++;
 
-  quagga_gettime (QUAGGA_CLK_MONOTONIC, &area->ospf->ts_spf);
-
   if (IS_DEBUG_OSPF_EVENT)
     zlog_debug ("ospf_spf_calculate: Stop. %ld vertices",
                 mtype_stats_alloc(MTYPE_OSPF_VERTEX));
 }
 
+/* Partial route calculation: the routing table entries of an area, from
+ * its kept tree.  The vertices are visited in the order Dijkstra added
+ * them, so this gives the same result as the calculation that built the
+ * tree, with the current contents of the LSAs.
+ */
+static void
+ospf_spf_replay (struct ospf_area *area, struct route_table *new_table,
+                 struct route_table *new_rtrs)
+{
+  struct listnode *node;
+  struct vertex *v;
+
+  area->abr_count = 0;
+  area->asbr_count = 0;
+  area->transit = OSPF_TRANSIT_FALSE;
+  area->shortcut_capability = 1;
+
+  for (ALL_LIST_ELEMENTS_RO (area->spf_vertices, node, v))
+    {
+      UNSET_FLAG (v->flags, OSPF_VERTEX_PROCESSED);
+
+      if (v->type == OSPF_VERTEX_ROUTER
+          && IS_ROUTER_LSA_VIRTUAL ((struct router_lsa *) v->lsa))
+        area->transit = OSPF_TRANSIT_TRUE;
+
+      if (v == area->spf)
+        continue;
+
+      if (v->type == OSPF_VERTEX_ROUTER)
+        ospf_intra_add_router (new_rtrs, v, area);
+      else
+        ospf_intra_add_transit (new_table, v, area);
+    }
+
+  ospf_spf_process_stubs (area, area->spf, new_table, 0);
+}
+
+static int
+ospf_spf_changed (struct ospf_area *area, u_char type, struct in_addr id)
+{
+  int i;
+
+  for (i = 0; i < area->spf_changed_count; i++)
+    if (area->spf_changed[i].type == type
+        && IPV4_ADDR_SAME (&area->spf_changed[i].id, &id))
+      return 1;
+  return 0;
+}
+
+/* Whether the current LSAs still give the tree edge from PARENT to V:
+ * PARENT's LSA offers V at V's distance, and V's LSA links back.
+ */
+static int
+ospf_spf_edge_holds (struct vertex *parent, struct vertex *v)
+{
+  struct ospf_spf_node *n = parent->node;
+  struct ospf_spf_edge *e;
+
+  if (ospf_spf_vertex_lsa (parent) == NULL || ospf_spf_vertex_lsa (v) == NULL)
+    return 0;
+
+  for (e = n->edges; e < n->edges + n->edge_count; e++)
+    if (e->node == v->node && e->backlink >= 0
+        && e->cost < OSPF_OUTPUT_COST_INFINITE
+        && parent->distance + e->cost == v->distance)
+      return 1;
+  return 0;
+}
+
+/* Whether the nexthop of VP was made for it, rather than inherited, and
+ * so belongs to it: see ospf_canonical_nexthops_free.
+ */
+static int
+ospf_vertex_parent_canonical (struct ospf_area *area, struct vertex_parent *vp)
+{
+  struct listnode *node;
+  struct vertex_parent *pp;
+
+  if (vp->parent == area->spf)
+    return 1;
+
+  if (vp->parent->type == OSPF_VERTEX_NETWORK)
+    for (ALL_LIST_ELEMENTS_RO (vp->parent->parents, node, pp))
+      if (pp->parent == area->spf)
+        return 1;
+
+  return 0;
+}
+
+static unsigned int
+ospf_vertex_hash_key (void *data)
+{
+  struct vertex *v = data;
+
+  return jhash_2words (v->id.s_addr, v->type, 0);
+}
+
+static int
+ospf_vertex_hash_cmp (const void *d1, const void *d2)
+{
+  const struct vertex *v1 = d1;
+  const struct vertex *v2 = d2;
+
+  return v1->type == v2->type && IPV4_ADDR_SAME (&v1->id, &v2->id);
+}
+
+/* D was taken off the tree.  Examine again the links of the vertices
+ * left on it which lead to D, which, since links are only followed when
+ * they are matched by one back, are those D's LSA has links to.
+ */
+static void
+ospf_spf_reattach (struct ospf_area *area, struct vertex *d,
+                   struct hash *kept, struct pqueue *candidate)
+{
+  struct ospf_spf_node *n = d->node;
+  struct ospf_spf_edge *e;
+  struct vertex key;
+  struct vertex *u;
+
+  if (ospf_spf_vertex_lsa (d) == NULL)
+    return;
+
+  for (e = n->edges; e < n->edges + n->edge_count; e++)
+    {
+      if (e->backlink < 0)
+        continue;
+
+      key.type = e->node->type;
+      key.id = e->node->id;
+      u = hash_lookup (kept, &key);
+      if (u && ! CHECK_FLAG (u->flags, OSPF_VERTEX_PROCESSED))
+        {
+          SET_FLAG (u->flags, OSPF_VERTEX_PROCESSED);
+          ospf_spf_next (u, area, candidate);
+        }
+    }
+}
+
+/* Incremental SPF.  The changes recorded for the area only took links
+ * away or made them dearer (see ospf_spf_schedule_lsa), so only
+ * vertices below the changed ones on the tree can have moved, and none
+ * can have come closer.  Take those subtrees off the kept tree and run
+ * Dijkstra for just them, from the vertices left on it.  Returns -1 if
+ * a full calculation is needed instead.
+ */
+static int
+ospf_spf_calculate_incremental (struct ospf_area *area)
+{
+  struct listnode *node, *nnode, *pnode;
+  struct listnode *n1, *n2;
+  struct vertex *v;
+  struct vertex_parent *vp;
+  struct list *kept_list, *detached, *added;
+  struct hash *kept;
+  struct pqueue *candidate;
+  int ret = 0;
+
+  if (area->spf == NULL || area->router_lsa_self == NULL)
+    return -1;
+
+  /* The changes only take links away or make them dearer, so a vertex
+     keeps its place unless an edge into it on the tree is gone, or it
+     hangs off one that has.  Parents come before their children on the
+     list. */
+  kept_list = list_new ();
+  detached = list_new ();
+  for (ALL_LIST_ELEMENTS_RO (area->spf_vertices, node, v))
+    {
+      pnode = NULL;
+      if (v != area->spf)
+        for (ALL_LIST_ELEMENTS_RO (v->parents, pnode, vp))
+          if (CHECK_FLAG (vp->parent->flags, OSPF_VERTEX_DETACHED)
+              || ((ospf_spf_changed (area, vp->parent->type, vp->parent->id)
+                   || ospf_spf_changed (area, v->type, v->id))
+                  && ! ospf_spf_edge_holds (vp->parent, v)))
+            break;
+
+      if (pnode == NULL)
+        listnode_add (kept_list, v);
+      else
+        {
+          SET_FLAG (v->flags, OSPF_VERTEX_DETACHED);
+          listnode_add (detached, v);
+        }
+    }
+
+  /* Nothing to gain if most of the tree has to go.  Nexthops all derive
+     from the root's links, so a change there needs a full calculation. */
+  if (ospf_spf_changed (area, area->spf->type, area->spf->id)
+      || listcount (detached) * 2 > listcount (area->spf_vertices))
+    {
+      for (ALL_LIST_ELEMENTS_RO (detached, node, v))
+        UNSET_FLAG (v->flags, OSPF_VERTEX_DETACHED);
+      list_delete (kept_list);
+      list_delete (detached);
+      return -1;
+    }
+
+  if (IS_DEBUG_OSPF_EVENT)
+    zlog_debug ("%s: area %s, %d of %d vertices detached", __func__,
+                inet_ntoa (area->area_id), listcount (detached),
+                listcount (area->spf_vertices));
+
+  /* Take the subtrees off the tree. */
+  for (ALL_LIST_ELEMENTS_RO (detached, node, v))
+    for (ALL_LIST_ELEMENTS_RO (v->parents, pnode, vp))
+      {
+        if (ospf_vertex_parent_canonical (area, vp))
+          vertex_nexthop_free (vp->nexthop);
+        if (! CHECK_FLAG (vp->parent->flags, OSPF_VERTEX_DETACHED))
+          listnode_delete (vp->parent->children, v);
+      }
+  list_delete (area->spf_vertices);
+  area->spf_vertices = kept_list;
+
+  if (ospf_spf_tree_refresh (area) < 0)
+    {
+      ret = -1;
+      goto out;
+    }
+
+  ospf_lsdb_clean_stat (area->lsdb);
+  kept = hash_create (ospf_vertex_hash_key, ospf_vertex_hash_cmp,
+		      "OSPF SPF kept vertices");
+  for (ALL_LIST_ELEMENTS_RO (kept_list, node, v))
+    {
+      *(v->stat) = LSA_SPF_IN_SPFTREE;
+      UNSET_FLAG (v->flags, OSPF_VERTEX_PROCESSED);
+      hash_get (kept, v, hash_alloc_intern);
+    }
+
+  candidate = pqueue_create ();
+  candidate->cmp = cmp;
+  candidate->update = update_stat;
+
+  for (ALL_LIST_ELEMENTS_RO (detached, node, v))
+    ospf_spf_reattach (area, v, kept, candidate);
+
+  /* RFC2328 16.1. (3), for the vertices left to place. */
+  added = list_new ();
+  while (candidate->size)
+    {
+      v = (struct vertex *) pqueue_dequeue (candidate);
+      *(v->stat) = LSA_SPF_IN_SPFTREE;
+      ospf_vertex_add_parent (v);
+      SET_FLAG (v->flags, OSPF_VERTEX_SPFTREE);
+      listnode_add (added, v);
+      ospf_spf_next (v, area, candidate);
+    }
+  pqueue_delete (candidate);
+  ospf_spf_vertex_list_reap ();
+  hash_clean (kept, NULL);
+  hash_free (kept);
+
+  /* Merge the vertices placed again in, keeping the list in the order
+     a full calculation would have added them. */
+  area->spf_vertices = list_new ();
+  n1 = listhead (kept_list);
+  n2 = listhead (added);
+  while (n1 || n2)
+    {
+      if (n1 && (n2 == NULL || cmp (listgetdata (n1), listgetdata (n2)) <= 0))
+        {
+          listnode_add (area->spf_vertices, listgetdata (n1));
+          n1 = listnextnode (n1);
+        }
+      else
+        {
+          listnode_add (area->spf_vertices, listgetdata (n2));
+          n2 = listnextnode (n2);
+        }
+    }
+  list_delete (kept_list);
+  list_delete (added);
+
+  area->spf_calculation++;
+
+ out:
+  for (ALL_LIST_ELEMENTS (detached, node, nnode, v))
+    ospf_vertex_free (v);
+  list_delete (detached);
+  return ret;
+}
+
+/* Work out the routing table entries of an area, with the cheapest
+ * calculation that will do.  Returns the kind of calculation done.
+ */
+static int
+ospf_spf_calculate_area (struct ospf_area *area, int kind,
+                         struct route_table *new_table,
+                         struct route_table *new_rtrs)
+{
+  if (kind == OSPF_SPF_INCREMENTAL
+      && ospf_spf_calculate_incremental (area) < 0)
+    kind = OSPF_SPF_FULL;
+
+  if (kind == OSPF_SPF_PARTIAL
+      && (area->spf == NULL || ospf_spf_tree_refresh (area) < 0))
+    kind = OSPF_SPF_FULL;
+
+  if (IS_DEBUG_OSPF_EVENT)
+    zlog_debug ("SPF: %s for area %s", ospf_spf_kind_str[kind],
+                inet_ntoa (area->area_id));
+
+  if (kind == OSPF_SPF_FULL)
+    ospf_spf_calculate (area, new_table, new_rtrs);
+  else if (area->spf)
+    ospf_spf_replay (area, new_table, new_rtrs);
+
+  area->spf_pending = OSPF_SPF_NONE;
+  area->spf_changed_count = 0;
+
+  return kind;
+}
+
 /* Timer for SPF calculation. */
 static int
 ospf_spf_calculate_timer (struct thread *thread)
@@ -1229,17 +1772,34 @@ ospf_spf_calculate_timer (struct thread *thread)
   struct route_table *new_table, *new_rtrs;
   struct ospf_area *area;
   struct listnode *node, *nnode;
+  struct timeval start, stop;
+  unsigned long usecs;
+  int kind, ran, done;
 
   if (IS_DEBUG_OSPF_EVENT)
     zlog_debug ("SPF: Timer (SPF calculation expire)");
 
   ospf->t_spf_calc = NULL;
 
+  quagga_gettime (QUAGGA_CLK_MONOTONIC, &start);
+
+  /* The backbone's tree depends on the transit areas of virtual links,
+     so with any configured, all areas are calculated afresh whenever
+     one's tree changes. */
+  kind = MAX (ospf->spf_pending, OSPF_SPF_PARTIAL);
+  if (listcount (ospf->vlinks))
+    for (ALL_LIST_ELEMENTS_RO (ospf->areas, node, area))
+      if (area->spf_pending > OSPF_SPF_PARTIAL)
+        kind = OSPF_SPF_FULL;
+  ospf->spf_pending = OSPF_SPF_NONE;
+  done = OSPF_SPF_PARTIAL;
+
   /* Allocate new table tree. */
   new_table = route_table_init ();
   new_rtrs = route_table_init ();
 
-  ospf_vl_unapprove (ospf);
+  if (kind == OSPF_SPF_FULL)
+    ospf_vl_unapprove (ospf);
 
   /* Calculate SPF for each area. */
   for (ALL_LIST_ELEMENTS (ospf->areas, node, nnode, area))
@@ -1249,15 +1809,23 @@ ospf_spf_calculate_timer (struct thread *thread)
        */
       if (ospf->backbone && ospf->backbone == area)
         continue;
-      
-      ospf_spf_calculate (area, new_table, new_rtrs);
+
+      ran = ospf_spf_calculate_area (area, MAX (kind, area->spf_pending),
+                                     new_table, new_rtrs);
+      done = MAX (done, ran);
     }
-  
+
   /* SPF for backbone, if required */
   if (ospf->backbone)
-    ospf_spf_calculate (ospf->backbone, new_table, new_rtrs);
-  
-  ospf_vl_shut_unapproved (ospf);
+    {
+      ran = ospf_spf_calculate_area (ospf->backbone,
+                                     MAX (kind, ospf->backbone->spf_pending),
+                                     new_table, new_rtrs);
+      done = MAX (done, ran);
+    }
+
+  if (kind == OSPF_SPF_FULL)
+    ospf_vl_shut_unapproved (ospf);
 
   ospf_ia_routing (ospf, new_table, new_rtrs);
 
@@ -1290,16 +1858,26 @@ ospf_spf_calculate_timer (struct thread *thread)
   if (IS_OSPF_ABR (ospf))
     ospf_abr_task (ospf);
 
+  quagga_gettime (QUAGGA_CLK_MONOTONIC, &stop);
+  ospf->ts_spf = stop;
+
+  stop = tv_sub (stop, start);
+  usecs = stop.tv_sec * 1000000UL + stop.tv_usec;
+  ospf->spf_stats[done].runs++;
+  ospf->spf_stats[done].last = usecs;
+  ospf->spf_stats[done].total += usecs;
+
   if (IS_DEBUG_OSPF_EVENT)
-    zlog_debug ("SPF: calculation complete");
+    zlog_debug ("SPF: calculation complete (%s, %lu usecs)",
+                ospf_spf_kind_str[done], usecs);
 
   return 0;
 }
 
 /* Add schedule for SPF calculation.  To avoid frequenst SPF calc, we
    set timer for SPF calc. */
-void
-ospf_spf_calculate_schedule (struct ospf *ospf)
+static void
+ospf_spf_schedule (struct ospf *ospf)
 {
   unsigned long delay, elapsed, ht;
   struct timeval result;
@@ -1307,10 +1885,6 @@ ospf_spf_calculate_schedule (struct ospf *ospf)
   if (IS_DEBUG_OSPF_EVENT)
     zlog_debug ("SPF: calculation timer scheduled");
 
-  /* OSPF instance does not exist. */
-  if (ospf == NULL)
-    return;
-  
   /* SPF calculation timer is already scheduled. */
   if (ospf->t_spf_calc)
     {
@@ -1319,16 +1893,16 @@ ospf_spf_calculate_schedule (struct ospf *ospf)
                    ospf->t_spf_calc);
       return;
     }
-  
+
   /* XXX Monotic timers: we only care about relative time here. */
   result = tv_sub (recent_relative_time (), ospf->ts_spf);
-  
+
   elapsed = (result.tv_sec * 1000) + (result.tv_usec / 1000);
   ht = ospf->spf_holdtime * ospf->spf_hold_multiplier;
-  
+
   if (ht > ospf->spf_max_holdtime)
     ht = ospf->spf_max_holdtime;
-  
+
   /* Get SPF calculation delay time. */
   if (elapsed < ht)
     {
@@ -1338,7 +1912,7 @@ ospf_spf_calculate_schedule (struct ospf *ospf)
        */
       if (ht < ospf->spf_max_holdtime)
         ospf->spf_hold_multiplier++;
-      
+
       /* always honour the SPF initial delay */
       if ( (ht - elapsed) < ospf->spf_delay)
         delay = ospf->spf_delay;
@@ -1351,10 +1925,195 @@ ospf_spf_calculate_schedule (struct ospf *ospf)
       delay = ospf->spf_delay;
       ospf->spf_hold_multiplier = 1;
     }
-  
+
   if (IS_DEBUG_OSPF_EVENT)
     zlog_debug ("SPF: calculation timer delay = %ld", delay);
 
   ospf->t_spf_calc =
     thread_add_timer_msec (master, ospf_spf_calculate_timer, ospf, delay);
 }
+
+/* Schedule a full calculation: for changes not described by an LSA. */
+void
+ospf_spf_calculate_schedule (struct ospf *ospf)
+{
+  /* OSPF instance does not exist. */
+  if (ospf == NULL)
+    return;
+
+  ospf->spf_pending = OSPF_SPF_FULL;
+  ospf_spf_schedule (ospf);
+}
+
+/* Return the first link after PREV in a router-LSA that is not to a stub
+   network, or NULL.  PREV is NULL to start with. */
+static struct router_lsa_link *
+ospf_router_lsa_next_transit (struct lsa_header *lsa,
+                              struct router_lsa_link *prev)
+{
+  struct router_lsa_link *l;
+  u_char *p;
+  u_char *lim;
+
+  if (prev == NULL)
+    p = ((u_char *) lsa) + OSPF_LSA_HEADER_SIZE + 4;
+  else
+    p = ((u_char *) prev) + OSPF_ROUTER_LSA_LINK_SIZE
+        + prev->m[0].tos_count * OSPF_ROUTER_LSA_TOS_SIZE;
+  lim = ((u_char *) lsa) + ntohs (lsa->length);
+
+  while (p < lim)
+    {
+      l = (struct router_lsa_link *) p;
+      if (l->m[0].type != LSA_LINK_TYPE_STUB)
+        return l;
+      p += (OSPF_ROUTER_LSA_LINK_SIZE +
+            (l->m[0].tos_count * OSPF_ROUTER_LSA_TOS_SIZE));
+    }
+  return NULL;
+}
+
+static int
+ospf_router_lsa_link_same (struct router_lsa_link *l1,
+                           struct router_lsa_link *l2)
+{
+  return l1->m[0].type == l2->m[0].type
+         && IPV4_ADDR_SAME (&l1->link_id, &l2->link_id)
+         && IPV4_ADDR_SAME (&l1->link_data, &l2->link_data);
+}
+
+/* The calculation a router-LSA going from OLD to NEW needs.  If only its
+ * stub networks or bits have changed, the tree stays the same.  If it
+ * only lost links or made them dearer, it can be calculated again from
+ * the changed vertex down.
+ */
+static int
+ospf_spf_router_lsa_change (struct ospf_lsa *old, struct ospf_lsa *new)
+{
+  struct router_lsa_link *l, *ol;
+
+  if (IS_LSA_MAXAGE (new))
+    return OSPF_SPF_INCREMENTAL;
+  if (old == NULL || IS_LSA_MAXAGE (old))
+    return OSPF_SPF_FULL;
+
+  l = ospf_router_lsa_next_transit (new->data, NULL);
+  ol = ospf_router_lsa_next_transit (old->data, NULL);
+  while (l && ol && ospf_router_lsa_link_same (l, ol)
+         && l->m[0].metric == ol->m[0].metric)
+    {
+      l = ospf_router_lsa_next_transit (new->data, l);
+      ol = ospf_router_lsa_next_transit (old->data, ol);
+    }
+  if (l == NULL && ol == NULL)
+    return OSPF_SPF_PARTIAL;
+
+  for (l = ospf_router_lsa_next_transit (new->data, NULL); l;
+       l = ospf_router_lsa_next_transit (new->data, l))
+    {
+      for (ol = ospf_router_lsa_next_transit (old->data, NULL); ol;
+           ol = ospf_router_lsa_next_transit (old->data, ol))
+        if (ospf_router_lsa_link_same (l, ol)
+            && ntohs (ol->m[0].metric) <= ntohs (l->m[0].metric))
+          break;
+      if (ol == NULL)
+        return OSPF_SPF_FULL;
+    }
+  return OSPF_SPF_INCREMENTAL;
+}
+
+/* The same for a network-LSA: its attached routers are its links. */
+static int
+ospf_spf_network_lsa_change (struct ospf_lsa *old, struct ospf_lsa *new)
+{
+  struct network_lsa *nl, *onl;
+  unsigned int i, j, n, on;
+
+  if (IS_LSA_MAXAGE (new))
+    return OSPF_SPF_INCREMENTAL;
+  if (old == NULL || IS_LSA_MAXAGE (old))
+    return OSPF_SPF_FULL;
+
+  nl = (struct network_lsa *) new->data;
+  onl = (struct network_lsa *) old->data;
+  n = (ntohs (new->data->length) - OSPF_LSA_HEADER_SIZE - 4) / 4;
+  on = (ntohs (old->data->length) - OSPF_LSA_HEADER_SIZE - 4) / 4;
+
+  if (n == on && memcmp (nl->routers, onl->routers, n * 4) == 0)
+    return OSPF_SPF_PARTIAL;
+
+  for (i = 0; i < n; i++)
+    {
+      for (j = 0; j < on; j++)
+        if (IPV4_ADDR_SAME (&nl->routers[i], &onl->routers[j]))
+          break;
+      if (j == on)
+        return OSPF_SPF_FULL;
+    }
+  return OSPF_SPF_INCREMENTAL;
+}
+
+/* Schedule the calculation an LSA going from OLD (NULL if there was
+ * none) to NEW needs.  A MaxAge NEW is the LSA being withdrawn.
+ */
+void
+ospf_spf_schedule_lsa (struct ospf *ospf, struct ospf_lsa *old,
+                       struct ospf_lsa *new)
+{
+  struct ospf_area *area = new->area;
+  int kind;
+
+  if (ospf == NULL)
+    return;
+
+  switch (new->data->type)
+    {
+    case OSPF_SUMMARY_LSA:
+    case OSPF_ASBR_SUMMARY_LSA:
+      /* Only inter-area routes change. */
+      ospf->spf_pending = MAX (ospf->spf_pending, OSPF_SPF_PARTIAL);
+      ospf_spf_schedule (ospf);
+      return;
+    case OSPF_ROUTER_LSA:
+      kind = ospf_spf_router_lsa_change (old, new);
+      break;
+    case OSPF_NETWORK_LSA:
+      kind = ospf_spf_network_lsa_change (old, new);
+      break;
+    default:
+      kind = OSPF_SPF_FULL;
+      break;
+    }
+
+  if (area == NULL)
+    {
+      ospf_spf_calculate_schedule (ospf);
+      return;
+    }
+
+  if (kind == OSPF_SPF_INCREMENTAL
+      && ! ospf_spf_changed (area, new->data->type, new->data->id))
+    {
+      if (area->spf_changed_count < OSPF_SPF_CHANGED_MAX)
+        {
+          area->spf_changed[area->spf_changed_count].type = new->data->type;
+          area->spf_changed[area->spf_changed_count].id = new->data->id;
+          area->spf_changed_count++;
+        }
+      else
+        kind = OSPF_SPF_FULL;
+    }
+
+  if (IS_DEBUG_OSPF_EVENT)
+    {
+      char buf[INET_ADDRSTRLEN];
+
+      zlog_debug ("SPF: %s needed for LSA[Type%d:%s] in area %s",
+                  ospf_spf_kind_str[kind], new->data->type,
+                  inet_ntop (AF_INET, &new->data->id, buf, sizeof (buf)),
+                  inet_ntoa (area->area_id));
+    }
+
+  area->spf_pending = MAX (area->spf_pending, kind);
+  ospf_spf_schedule (ospf);
+}
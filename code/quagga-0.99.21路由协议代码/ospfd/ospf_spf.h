@@ -29,6 +29,31 @@
 
 /* values for vertex->flags */
 #define OSPF_VERTEX_PROCESSED      0x01
+#define OSPF_VERTEX_SPFTREE        0x02 /* on the kept tree */
+#define OSPF_VERTEX_DETACHED       0x04 /* taken off it, incremental SPF */
+
+/* The router- and network-LSAs of an area as a graph, which the SPF
+   calculation walks instead of the LSAs.  It is kept up to date as the
+   LSAs are added to and deleted from the area's LSDB. */
+struct ospf_spf_edge
+{
+  struct ospf_spf_node *node;	/* the router or network linked to */
+  struct router_lsa_link *link;	/* link in a router-LSA, or NULL */
+  u_int16_t cost;		/* 0 from a network */
+  u_int16_t index;		/* of the link in the LSA */
+  int backlink;			/* index of the link back, or -1 */
+};
+
+struct ospf_spf_node
+{
+  u_char type;			/* OSPF_VERTEX_ROUTER or _NETWORK */
+  struct in_addr id;
+  struct ospf_area *area;
+  struct ospf_lsa *lsa;		/* current instance, or NULL */
+  unsigned int refcnt;		/* edges and vertices referring to it */
+  unsigned int edge_count;
+  struct ospf_spf_edge *edges;
+};
 
 /* The "root" is the node running the SPF calculation */
 
@@ -38,6 +63,7 @@ struct vertex
   u_char flags;
   u_char type;		/* copied from LSA header */
   struct in_addr id;	/* copied from LSA header */
+  struct ospf_spf_node *node;
   struct lsa_header *lsa; /* Router or Network LSA */
   int *stat;		/* Link to LSA status. */
   u_int32_t distance;	/* from root to this vertex */  
@@ -60,6 +86,14 @@ struct vertex_parent
 };
 
 extern void ospf_spf_calculate_schedule (struct ospf *);
+extern void ospf_spf_schedule_lsa (struct ospf *, struct ospf_lsa *,
+                                   struct ospf_lsa *);
+extern void ospf_spf_tree_free (struct ospf_area *);
+extern void ospf_spf_graph_init (struct ospf_area *);
+extern void ospf_spf_graph_free (struct ospf_area *);
+extern void ospf_spf_graph_add (struct ospf_lsdb *, struct ospf_lsa *);
+extern void ospf_spf_graph_delete (struct ospf_lsdb *, struct ospf_lsa *);
+extern const char *ospf_spf_kind_str[];
 extern void ospf_rtrs_free (struct route_table *);
 
 /* void ospf_spf_calculate_timer_add (); */
@@ -2687,6 +2687,7 @@ DEFUN (show_ip_ospf,
   struct ospf *ospf;
   struct timeval result;
   char timebuf[OSPF_TIME_DUMP_SIZE];
+  int i;
 
   /* Check OSPF is enable. */
   ospf = ospf_lookup ();
@@ -2758,6 +2759,13 @@ DEFUN (show_ip_ospf,
            (ospf->t_spf_calc ? "due in " : "is "),
            ospf_timer_dump (ospf->t_spf_calc, timebuf, sizeof (timebuf)),
            VTY_NEWLINE);
+  for (i = OSPF_SPF_FULL; i > OSPF_SPF_NONE; i--)
+    vty_out (vty, " %s executed %lu times, last took %lu usecs, "
+             "average %lu usecs%s", ospf_spf_kind_str[i],
+             ospf->spf_stats[i].runs, ospf->spf_stats[i].last,
+             ospf->spf_stats[i].runs
+             ? ospf->spf_stats[i].total / ospf->spf_stats[i].runs : 0,
+             VTY_NEWLINE);
   
   /* Show refresh parameters. */
   vty_out (vty, " Refresh timer %d secs%s",
@@ -574,6 +574,7 @@ ospf_area_new (struct ospf *ospf, struct in_addr area_id)
   
   /* New LSDB init. */
   new->lsdb = ospf_lsdb_new ();
+  ospf_spf_graph_init (new);
 
   /* Self-originated LSAs initialize. */
   new->router_lsa_self = NULL;
@@ -620,6 +621,8 @@ ospf_area_free (struct ospf_area *area)
   ospf_lsdb_free (area->lsdb);
 
   ospf_lsa_unlock (&area->router_lsa_self);
+  ospf_spf_tree_free (area);
+  ospf_spf_graph_free (area);
   
   route_table_finish (area->ranges);
   list_delete (area->oiflist);
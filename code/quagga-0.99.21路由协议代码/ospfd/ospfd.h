@@ -90,6 +90,16 @@
 #define OSPF_SPF_HOLDTIME_DEFAULT           1000
 #define OSPF_SPF_MAX_HOLDTIME_DEFAULT	    10000
 
+/* Kinds of routing table calculation, cheapest first. */
+#define OSPF_SPF_NONE                       0
+#define OSPF_SPF_PARTIAL                    1 /* Routes from kept trees. */
+#define OSPF_SPF_INCREMENTAL                2 /* Dijkstra for subtrees. */
+#define OSPF_SPF_FULL                       3 /* Dijkstra for the area. */
+#define OSPF_SPF_KIND_MAX                   4
+
+/* Changed vertices an incremental calculation takes per area. */
+#define OSPF_SPF_CHANGED_MAX               16
+
 /* OSPF interface default values. */
 #define OSPF_OUTPUT_COST_DEFAULT           10
 #define OSPF_OUTPUT_COST_INFINITE	   UINT16_MAX
@@ -201,6 +211,13 @@ struct ospf
   unsigned int spf_holdtime;		/* SPF hold time. */
   unsigned int spf_max_holdtime;	/* SPF maximum-holdtime */
   unsigned int spf_hold_multiplier;	/* Adaptive multiplier for hold time */
+  u_char spf_pending;			/* Calculation needed everywhere. */
+  struct
+  {
+    unsigned long runs;
+    unsigned long last;			/* usecs */
+    unsigned long total;		/* usecs */
+  } spf_stats[OSPF_SPF_KIND_MAX];
   
   int default_originate;		/* Default information originate. */
 #define DEFAULT_ORIGINATE_NONE		0
@@ -429,8 +446,23 @@ struct ospf_area
 #define PREFIX_LIST_OUT(A)  (A)->plist_out.list
 #define PREFIX_NAME_OUT(A)  (A)->plist_out.name
 
-  /* Shortest Path Tree. */
+  /* Shortest Path Tree, kept between calculations, and its vertices in
+     the order they were added. */
   struct vertex *spf;
+  struct list *spf_vertices;
+
+  /* Graph of the router- and network-LSAs in the LSDB. */
+  struct hash *spf_graph;
+
+  /* Calculation needed for this area and, for an incremental one, the
+     vertices whose LSAs have lost links or made them dearer. */
+  u_char spf_pending;
+  u_char spf_changed_count;
+  struct
+  {
+    u_char type;
+    struct in_addr id;
+  } spf_changed[OSPF_SPF_CHANGED_MAX];
 
   /* Threads. */
   struct thread *t_stub_router;    /* Stub-router timer */
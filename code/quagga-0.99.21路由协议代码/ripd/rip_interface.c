@@ -461,6 +461,9 @@ rip_interface_add (int command, struct zclient *zclient, zebra_size_t length)
   /* Check interface routemap. */
   rip_if_rmap_update_interface (ifp);
 
+  /* Split horizon goes by its index. */
+  rip_response_invalidate ();
+
   return 0;
 }
 
@@ -490,6 +493,7 @@ rip_interface_delete (int command, struct zclient *zclient,
   /* To support pseudo interface do not free interface structure.  */
   /* if_delete(ifp); */
   ifp->ifindex = IFINDEX_INTERNAL;
+  rip_response_invalidate ();
 
   return 0;
 }
@@ -688,6 +692,7 @@ rip_interface_address_add (int command, struct zclient *zclient,
       rip_enable_apply(ifc->ifp);
       /* Check if this prefix needs to be redistributed */
       rip_apply_address_add(ifc);
+      rip_response_invalidate ();
 
 #ifdef HAVE_SNMP
       rip_ifaddr_add (ifc->ifp, ifc);
@@ -748,6 +753,9 @@ rip_interface_address_delete (int command, struct zclient *zclient,
 
 	}
 
+      /* Responses encoded for it must not outlive it. */
+      rip_response_invalidate ();
+
       connected_free (ifc);
 
     }
@@ -2067,6 +2075,7 @@ rip_interface_new_hook (struct interface *ifp)
 static int
 rip_interface_delete_hook (struct interface *ifp)
 {
+  rip_response_clean (ifp->info);
   XFREE (MTYPE_RIP_INTERFACE, ifp->info);
   ifp->info = NULL;
   return 0;
@@ -137,6 +137,7 @@ rip_offset_list_set (struct vty *vty, const char *alist, const char *direct_str,
     free (offset->direct[direct].alist_name);
   offset->direct[direct].alist_name = strdup (alist);
   offset->direct[direct].metric = metric;
+  rip_response_invalidate ();
 
   return CMD_SUCCESS;
 }
@@ -186,6 +187,7 @@ rip_offset_list_unset (struct vty *vty, const char *alist,
 	    free (offset->ifname);
 	  rip_offset_list_free (offset);
 	}
+      rip_response_invalidate ();
     }
   else
     {
@@ -161,6 +161,7 @@ rip_routemap_set (int type, const char *name)
 
   rip->route_map[type].name = strdup (name);
   rip->route_map[type].map = route_map_lookup_by_name (name);
+  rip_response_invalidate ();
 }
 
 static void
@@ -168,6 +169,7 @@ rip_redistribute_metric_set (int type, unsigned int metric)
 {
   rip->route_map[type].metric_config = 1;
   rip->route_map[type].metric = metric;
+  rip_response_invalidate ();
 }
 
 static int
@@ -179,6 +181,7 @@ rip_metric_unset (int type, unsigned int metric)
     return 1;
   rip->route_map[type].metric_config = 0;
   rip->route_map[type].metric = 0;
+  rip_response_invalidate ();
   return 0;
 }
 
@@ -193,6 +196,7 @@ rip_routemap_unset (int type, const char *name)
   free (rip->route_map[type].name);
   rip->route_map[type].name = NULL;
   rip->route_map[type].map = NULL;
+  rip_response_invalidate ();
 
   return 0;
 }
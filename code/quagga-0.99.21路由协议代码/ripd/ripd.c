@@ -121,6 +121,30 @@ rip_info_free (struct rip_info *rinfo)
   XFREE (MTYPE_RIP_INFO, rinfo);
 }
 
+/* Responses encoded before this last moved are stale. */
+static unsigned long rip_response_generation;
+
+/* Something that goes into responses changed: a route, a filter, a
+   route-map, an offset-list or an interface. */
+void
+rip_response_invalidate (void)
+{
+  rip_response_generation++;
+}
+
+/* Set the route change flag, and queue the route for the next
+   triggered update. */
+static void
+rip_route_changed (struct rip_info *rinfo)
+{
+  if (! (rinfo->flags & RIP_RTF_CHANGED))
+    {
+      rinfo->flags |= RIP_RTF_CHANGED;
+      listnode_add (rip->changed, route_lock_node (rinfo->rp));
+    }
+  rip_response_invalidate ();
+}
+
 /* RIP route garbage collect timer. */
 static int
 rip_garbage_collect (struct thread *t)
@@ -143,6 +167,7 @@ rip_garbage_collect (struct thread *t)
 
   /* Free RIP routing information. */
   rip_info_free (rinfo);
+  rip_response_invalidate ();
 
   return 0;
 }
@@ -172,7 +197,7 @@ rip_timeout (struct thread *t)
 
   /* - The route change flag is to indicate that this entry has been
      changed. */
-  rinfo->flags |= RIP_RTF_CHANGED;
+  rip_route_changed (rinfo);
 
   /* - The output process is signalled to trigger a response. */
   rip_event (RIP_TRIGGERED_UPDATE, 0);
@@ -542,7 +567,7 @@ rip_rte_process (struct rte *rte, struct sockaddr_in *from,
           rip_timeout_update (rinfo);
 
           /* - Set the route change flag. */
-          rinfo->flags |= RIP_RTF_CHANGED;
+          rip_route_changed (rinfo);
 
           /* - Signal the output process to trigger an update (see section
              2.5). */
@@ -648,7 +673,7 @@ rip_rte_process (struct rte *rte, struct sockaddr_in *from,
 
           /* - Set the route change flag and signal the output process
              to trigger an update. */
-          rinfo->flags |= RIP_RTF_CHANGED;
+          rip_route_changed (rinfo);
           rip_event (RIP_TRIGGERED_UPDATE, 0);
 
           /* - If the new metric is infinity, start the deletion
@@ -1401,13 +1426,46 @@ rip_create_socket (struct sockaddr_in *from)
   return sock;
 }
 
+/* Make a socket to send to the RIP multicast group from the connected
+   address. */
+static int
+rip_multicast_socket (struct connected *ifc)
+{
+  int sock;
+  struct sockaddr_in from;
+
+  /* multicast send should bind to local interface address */
+  memset (&from, 0, sizeof (struct sockaddr_in));
+  from.sin_family = AF_INET;
+  from.sin_port = htons (RIP_PORT_DEFAULT);
+  from.sin_addr = ifc->address->u.prefix4;
+#ifdef HAVE_STRUCT_SOCKADDR_IN_SIN_LEN
+  from.sin_len = sizeof (struct sockaddr_in);
+#endif /* HAVE_STRUCT_SOCKADDR_IN_SIN_LEN */
+
+  /*
+   * we have to open a new socket for each source address because
+   * this is the most portable way to bind to a different source
+   * ipv4 address for each packet. 
+   */
+  if ( (sock = rip_create_socket (&from)) < 0)
+    {
+      zlog_warn("rip_send_packet could not create socket.");
+      return -1;
+    }
+  rip_interface_multicast_set (sock, ifc);
+  return sock;
+}
+
 /* RIP packet send to destination address, on interface denoted by
  * by connected argument. NULL to argument denotes destination should be
- * should be RIP multicast group
+ * should be RIP multicast group, sent through msock if it is a socket
+ * rip_multicast_socket() made for the connected address, or else
+ * through one made for the packet.
  */
 static int
-rip_send_packet (u_char * buf, int size, struct sockaddr_in *to,
-                 struct connected *ifc)
+rip_send_packet_sock (u_char * buf, int size, struct sockaddr_in *to,
+		      struct connected *ifc, int msock)
 {
   int ret, send_sock;
   struct sockaddr_in sin;
@@ -1469,30 +1527,12 @@ rip_send_packet (u_char * buf, int size, struct sockaddr_in *to,
     }
   else
     {
-      struct sockaddr_in from;
-      
       sin.sin_port = htons (RIP_PORT_DEFAULT);
       sin.sin_addr.s_addr = htonl (INADDR_RIP_GROUP);
       
-      /* multicast send should bind to local interface address */
-      from.sin_family = AF_INET;
-      from.sin_port = htons (RIP_PORT_DEFAULT);
-      from.sin_addr = ifc->address->u.prefix4;
-#ifdef HAVE_STRUCT_SOCKADDR_IN_SIN_LEN
-      from.sin_len = sizeof (struct sockaddr_in);
-#endif /* HAVE_STRUCT_SOCKADDR_IN_SIN_LEN */
-      
-      /*
-       * we have to open a new socket for each packet because this
-       * is the most portable way to bind to a different source
-       * ipv4 address for each packet. 
-       */
-      if ( (send_sock = rip_create_socket (&from)) < 0)
-        {
-          zlog_warn("rip_send_packet could not create socket.");
-          return -1;
-        }
-      rip_interface_multicast_set (send_sock, ifc);
+      send_sock = msock;
+      if (send_sock < 0 && (send_sock = rip_multicast_socket (ifc)) < 0)
+        return -1;
     }
 
   ret = sendto (send_sock, buf, size, 0, (struct sockaddr *)&sin,
@@ -1505,12 +1545,19 @@ rip_send_packet (u_char * buf, int size, struct sockaddr_in *to,
   if (ret < 0)
     zlog_warn ("can't send packet : %s", safe_strerror (errno));
 
-  if (!to)
+  if (!to && msock < 0)
     close(send_sock);
 
   return ret;
 }
 
+static int
+rip_send_packet (u_char * buf, int size, struct sockaddr_in *to,
+                 struct connected *ifc)
+{
+  return rip_send_packet_sock (buf, size, to, ifc, -1);
+}
+
 /* Add redistributed route to RIP table. */
 void
 rip_redistribute_add (int type, int sub_type, struct prefix_ipv4 *p, 
@@ -1581,7 +1628,7 @@ rip_redistribute_add (int type, int sub_type, struct prefix_ipv4 *p,
   rinfo->flags |= RIP_RTF_FIB;
   rp->info = rinfo;
 
-  rinfo->flags |= RIP_RTF_CHANGED;
+  rip_route_changed (rinfo);
 
   if (IS_RIP_DEBUG_EVENT) {
     if (!nexthop)
@@ -1626,7 +1673,7 @@ rip_redistribute_delete (int type, int sub_type, struct prefix_ipv4 *p,
 	  RIP_TIMER_ON (rinfo->t_garbage_collect, 
 			rip_garbage_collect, rip->garbage_time);
 	  RIP_TIMER_OFF (rinfo->t_timeout);
-	  rinfo->flags |= RIP_RTF_CHANGED;
+	  rip_route_changed (rinfo);
 
           if (IS_RIP_DEBUG_EVENT)
             zlog_debug ("Poisone %s/%d on the interface %s with an infinity metric [delete]",
@@ -2130,43 +2177,284 @@ rip_write_rte (int num, struct stream *s, struct prefix_ipv4 *p,
   return ++num;
 }
 
-/* Send update to the ifp or spcified neighbor. */
-void
-rip_output_process (struct connected *ifc, struct sockaddr_in *to, 
-                    int route_type, u_char version)
+/* Decide whether the route goes into the response, filling in what it
+   goes out with, and encode it. */
+static void
+rip_response_add (struct rip_response *resp, struct route_node *rp)
 {
   int ret;
-  struct stream *s;
-  struct route_node *rp;
+  struct connected *ifc = resp->ifc;
+  u_char version = resp->version;
   struct rip_info *rinfo;
   struct rip_interface *ri;
   struct prefix_ipv4 *p;
   struct prefix_ipv4 classfull;
   struct prefix_ipv4 ifaddrclass;
+  struct stream *s;
+
+  if ((rinfo = rp->info) == NULL)
+    return;
+
+  ri = ifc->ifp->info;
+  p = (struct prefix_ipv4 *) &rp->p;
+
+  /* For RIPv1, if we are subnetted, output subnets in our network    */
+  /* that have the same mask as the output "interface". For other     */
+  /* networks, only the classfull version is output.                  */
+
+  if (version == RIPv1)
+    {
+      if (IS_RIP_DEBUG_PACKET)
+	zlog_debug("RIPv1 mask check, %s/%d considered for output",
+		  inet_ntoa (rp->p.u.prefix4), rp->p.prefixlen);
+
+      memcpy (&ifaddrclass, ifc->address, sizeof (struct prefix_ipv4));
+      apply_classful_mask_ipv4 (&ifaddrclass);
+
+      if (ifc->address->prefixlen > ifaddrclass.prefixlen &&
+	  prefix_match ((struct prefix *) &ifaddrclass, &rp->p))
+	{
+	  if ((ifc->address->prefixlen != rp->p.prefixlen) &&
+	      (rp->p.prefixlen != 32))
+	    return;
+	}
+      else
+	{
+	  memcpy (&classfull, &rp->p, sizeof(struct prefix_ipv4));
+	  apply_classful_mask_ipv4(&classfull);
+	  if (rp->p.u.prefix4.s_addr != 0 &&
+	      classfull.prefixlen != rp->p.prefixlen)
+	    return;
+	}
+      if (IS_RIP_DEBUG_PACKET)
+	zlog_debug("RIPv1 mask check, %s/%d made it through",
+		  inet_ntoa (rp->p.u.prefix4), rp->p.prefixlen);
+    }
+
+  /* Apply output filters. */
+  ret = rip_outgoing_filter (p, ri);
+  if (ret < 0)
+    return;
+
+  /* Split horizon. */
+  /* if (split_horizon == rip_split_horizon) */
+  if (resp->split_horizon == RIP_SPLIT_HORIZON)
+    {
+      /* 
+       * We perform split horizon for RIP and connected route. 
+       * For rip routes, we want to suppress the route if we would
+       * end up sending the route back on the interface that we
+       * learned it from, with a higher metric. For connected routes,
+       * we suppress the route if the prefix is a subset of the
+       * source address that we are going to use for the packet 
+       * (in order to handle the case when multiple subnets are
+       * configured on the same interface).
+       */
+      if (rinfo->type == ZEBRA_ROUTE_RIP  &&
+	  rinfo->ifindex == ifc->ifp->ifindex) 
+	return;
+      if (rinfo->type == ZEBRA_ROUTE_CONNECT &&
+	  prefix_match((struct prefix *)p, ifc->address))
+	return;
+    }
+
+  /* Preparation for route-map. */
+  rinfo->metric_set = 0;
+  rinfo->nexthop_out.s_addr = 0;
+  rinfo->metric_out = rinfo->metric;
+  rinfo->tag_out = rinfo->tag;
+  rinfo->ifindex_out = ifc->ifp->ifindex;
+
+  /* In order to avoid some local loops,
+   * if the RIP route has a nexthop via this interface, keep the nexthop,
+   * otherwise set it to 0. The nexthop should not be propagated
+   * beyond the local broadcast/multicast area in order
+   * to avoid an IGP multi-level recursive look-up.
+   * see (4.4)
+   */
+  if (rinfo->ifindex == ifc->ifp->ifindex)
+    rinfo->nexthop_out = rinfo->nexthop;
+
+  /* Interface route-map */
+  if (ri->routemap[RIP_FILTER_OUT])
+    {
+      ret = route_map_apply (ri->routemap[RIP_FILTER_OUT], 
+			     (struct prefix *) p, RMAP_RIP, 
+			     rinfo);
+
+      if (ret == RMAP_DENYMATCH)
+	{
+	  if (IS_RIP_DEBUG_PACKET)
+	    zlog_debug ("RIP %s/%d is filtered by route-map out",
+		       inet_ntoa (p->prefix), p->prefixlen);
+	  return;
+	}
+    }
+
+  /* Apply redistribute route map - continue, if deny */
+  if (rip->route_map[rinfo->type].name
+      && rinfo->sub_type != RIP_ROUTE_INTERFACE)
+    {
+      ret = route_map_apply (rip->route_map[rinfo->type].map,
+			     (struct prefix *)p, RMAP_RIP, rinfo);
+
+      if (ret == RMAP_DENYMATCH) 
+	{
+	  if (IS_RIP_DEBUG_PACKET)
+	    zlog_debug ("%s/%d is filtered by route-map",
+		       inet_ntoa (p->prefix), p->prefixlen);
+	  return;
+	}
+    }
+
+  /* When route-map does not set metric. */
+  if (! rinfo->metric_set)
+    {
+      /* If redistribute metric is set. */
+      if (rip->route_map[rinfo->type].metric_config
+	  && rinfo->metric != RIP_METRIC_INFINITY)
+	{
+	  rinfo->metric_out = rip->route_map[rinfo->type].metric;
+	}
+      else
+	{
+	  /* If the route is not connected or localy generated
+	     one, use default-metric value*/
+	  if (rinfo->type != ZEBRA_ROUTE_RIP 
+	      && rinfo->type != ZEBRA_ROUTE_CONNECT
+	      && rinfo->metric != RIP_METRIC_INFINITY)
+	    rinfo->metric_out = rip->default_metric;
+	}
+    }
+
+  /* Apply offset-list */
+  if (rinfo->metric != RIP_METRIC_INFINITY)
+    rip_offset_list_apply_out (p, ifc->ifp, &rinfo->metric_out);
+
+  if (rinfo->metric_out > RIP_METRIC_INFINITY)
+    rinfo->metric_out = RIP_METRIC_INFINITY;
+
+  /* Perform split-horizon with poisoned reverse 
+   * for RIP and connected routes.
+   **/
+  if (resp->split_horizon == RIP_SPLIT_HORIZON_POISONED_REVERSE) {
+      /* 
+       * We perform split horizon for RIP and connected route. 
+       * For rip routes, we want to suppress the route if we would
+       * end up sending the route back on the interface that we
+       * learned it from, with a higher metric. For connected routes,
+       * we suppress the route if the prefix is a subset of the
+       * source address that we are going to use for the packet 
+       * (in order to handle the case when multiple subnets are
+       * configured on the same interface).
+       */
+    if (rinfo->type == ZEBRA_ROUTE_RIP  &&
+	 rinfo->ifindex == ifc->ifp->ifindex)
+	 rinfo->metric_out = RIP_METRIC_INFINITY;
+    if (rinfo->type == ZEBRA_ROUTE_CONNECT &&
+	prefix_match((struct prefix *)p, ifc->address))
+	 rinfo->metric_out = RIP_METRIC_INFINITY;
+  }
+
+  /* Write RTE to the response. */
+  if (resp->count == resp->max)
+    {
+      resp->max = resp->max ? resp->max * 2 : RIP_MAX_RTE;
+      resp->rte = XREALLOC (MTYPE_RIP_RESPONSE, resp->rte,
+			    resp->max * RIP_RTE_SIZE);
+    }
+  s = rip->obuf;
+  stream_reset (s);
+  rip_write_rte (0, s, p, version, rinfo);
+  memcpy (resp->rte + resp->count * RIP_RTE_SIZE, STREAM_DATA (s),
+	  RIP_RTE_SIZE);
+  resp->count++;
+}
+
+static void
+rip_response_free (struct rip_response *resp)
+{
+  if (resp->rte)
+    XFREE (MTYPE_RIP_RESPONSE, resp->rte);
+  XFREE (MTYPE_RIP_RESPONSE, resp);
+}
+
+/* Free the responses encoded for the interface. */
+void
+rip_response_clean (struct rip_interface *ri)
+{
+  if (ri->responses)
+    {
+      list_delete (ri->responses);
+      ri->responses = NULL;
+    }
+}
+
+/* Get the response of a regular update on the connected address,
+   encoding it from the whole table unless nothing that goes into it
+   changed since it last was. */
+static struct rip_response *
+rip_response_get (struct connected *ifc, u_char version)
+{
+  struct rip_interface *ri;
+  struct rip_response *resp;
+  struct listnode *node, *nnode;
+  struct route_node *rp;
+
+  ri = ifc->ifp->info;
+  if (! ri->responses)
+    {
+      ri->responses = list_new ();
+      ri->responses->del = (void (*) (void *)) rip_response_free;
+    }
+
+  /* Stale responses go, and with them those of addresses gone since. */
+  for (ALL_LIST_ELEMENTS (ri->responses, node, nnode, resp))
+    {
+      if (resp->generation != rip_response_generation
+	  || resp->split_horizon != ri->split_horizon)
+	{
+	  list_delete_node (ri->responses, node);
+	  rip_response_free (resp);
+	}
+      else if (resp->ifc == ifc && resp->version == version)
+	return resp;
+    }
+
+  resp = XCALLOC (MTYPE_RIP_RESPONSE, sizeof (struct rip_response));
+  resp->ifc = ifc;
+  resp->version = version;
+  resp->generation = rip_response_generation;
+  resp->split_horizon = ri->split_horizon;
+
+  for (rp = route_top (rip->table); rp; rp = route_next (rp))
+    rip_response_add (resp, rp);
+
+  listnode_add (ri->responses, resp);
+  return resp;
+}
+
+/* Send the RTEs of the response in as many packets as they take, with
+   the authentication the interface has now. */
+static void
+rip_response_send (struct rip_response *resp, struct sockaddr_in *to)
+{
+  int ret;
+  struct stream *s;
+  struct connected *ifc = resp->ifc;
+  u_char version = resp->version;
+  struct rip_interface *ri;
   struct key *key = NULL;
   /* this might need to made dynamic if RIP ever supported auth methods
      with larger key string sizes */
   char auth_str[RIP_AUTH_SIMPLE_SIZE];
   size_t doff = 0; /* offset of digest offset field */
-  int num = 0;
+  int i, num;
   int rtemax;
-  int subnetted = 0;
-
-  /* Logging output event. */
-  if (IS_RIP_DEBUG_EVENT)
-    {
-      if (to)
-	zlog_debug ("update routes to neighbor %s", inet_ntoa (to->sin_addr));
-      else
-	zlog_debug ("update routes on interface %s ifindex %d",
-		   ifc->ifp->name, ifc->ifp->ifindex);
-    }
+  int msock = -1;
 
   /* Set output stream. */
   s = rip->obuf;
-
-  /* Reset stream and RTE counter. */
-  stream_reset (s);
   rtemax = (RIP_PACKET_MAXSIZ - 4) / 20;
 
   /* Get RIP interface. */
@@ -2198,227 +2486,84 @@ rip_output_process (struct connected *ifc, struct sockaddr_in *to,
       rip_auth_prepare_str_send (ri, key, auth_str, RIP_AUTH_SIMPLE_SIZE);
     }
 
-  if (version == RIPv1)
-    {
-      memcpy (&ifaddrclass, ifc->address, sizeof (struct prefix_ipv4));
-      apply_classful_mask_ipv4 (&ifaddrclass);
-      subnetted = 0;
-      if (ifc->address->prefixlen > ifaddrclass.prefixlen)
-        subnetted = 1;
-    }
-
-  for (rp = route_top (rip->table); rp; rp = route_next (rp))
-    if ((rinfo = rp->info) != NULL)
-      {
-	/* For RIPv1, if we are subnetted, output subnets in our network    */
-	/* that have the same mask as the output "interface". For other     */
-	/* networks, only the classfull version is output.                  */
-	
-	if (version == RIPv1)
-	  {
-	    p = (struct prefix_ipv4 *) &rp->p;
-
-	    if (IS_RIP_DEBUG_PACKET)
-	      zlog_debug("RIPv1 mask check, %s/%d considered for output",
-			inet_ntoa (rp->p.u.prefix4), rp->p.prefixlen);
+  /* All of the packets go out of the one multicast socket. */
+  if (! to && resp->count)
+    msock = rip_multicast_socket (ifc);
 
-	    if (subnetted &&
-		prefix_match ((struct prefix *) &ifaddrclass, &rp->p))
-	      {
-		if ((ifc->address->prefixlen != rp->p.prefixlen) &&
-		    (rp->p.prefixlen != 32))
-		  continue;
-	      }
-	    else
-	      {
-		memcpy (&classfull, &rp->p, sizeof(struct prefix_ipv4));
-		apply_classful_mask_ipv4(&classfull);
-		if (rp->p.u.prefix4.s_addr != 0 &&
-		    classfull.prefixlen != rp->p.prefixlen)
-		  continue;
-	      }
-	    if (IS_RIP_DEBUG_PACKET)
-	      zlog_debug("RIPv1 mask check, %s/%d made it through",
-			inet_ntoa (rp->p.u.prefix4), rp->p.prefixlen);
-	  }
-	else 
-	  p = (struct prefix_ipv4 *) &rp->p;
+  for (i = 0; i < resp->count; i += num)
+    {
+      num = MIN (rtemax, resp->count - i);
 
-	/* Apply output filters. */
-	ret = rip_outgoing_filter (p, ri);
-	if (ret < 0)
-	  continue;
+      /* Prepare preamble, auth headers, if needs be */
+      stream_reset (s);
+      stream_putc (s, RIP_RESPONSE);
+      stream_putc (s, version);
+      stream_putw (s, 0);
 
-	/* Changed route only output. */
-	if (route_type == rip_changed_route &&
-	    (! (rinfo->flags & RIP_RTF_CHANGED)))
-	  continue;
+      /* auth header for !v1 && !no_auth */
+      if ( (ri->auth_type != RIP_NO_AUTH) && (version != RIPv1) )
+	doff = rip_auth_header_write (s, ri, key, auth_str, 
+				      RIP_AUTH_SIMPLE_SIZE);
 
-	/* Split horizon. */
-	/* if (split_horizon == rip_split_horizon) */
-	if (ri->split_horizon == RIP_SPLIT_HORIZON)
-	  {
-	    /* 
-	     * We perform split horizon for RIP and connected route. 
-	     * For rip routes, we want to suppress the route if we would
-             * end up sending the route back on the interface that we
-             * learned it from, with a higher metric. For connected routes,
-             * we suppress the route if the prefix is a subset of the
-             * source address that we are going to use for the packet 
-             * (in order to handle the case when multiple subnets are
-             * configured on the same interface).
-             */
-	    if (rinfo->type == ZEBRA_ROUTE_RIP  &&
-                 rinfo->ifindex == ifc->ifp->ifindex) 
-	      continue;
-	    if (rinfo->type == ZEBRA_ROUTE_CONNECT &&
-                 prefix_match((struct prefix *)p, ifc->address))
-	      continue;
-	  }
+      stream_put (s, resp->rte + i * RIP_RTE_SIZE, num * RIP_RTE_SIZE);
 
-	/* Preparation for route-map. */
-	rinfo->metric_set = 0;
-	rinfo->nexthop_out.s_addr = 0;
-	rinfo->metric_out = rinfo->metric;
-	rinfo->tag_out = rinfo->tag;
-	rinfo->ifindex_out = ifc->ifp->ifindex;
-
-	/* In order to avoid some local loops,
-	 * if the RIP route has a nexthop via this interface, keep the nexthop,
-	 * otherwise set it to 0. The nexthop should not be propagated
-	 * beyond the local broadcast/multicast area in order
-	 * to avoid an IGP multi-level recursive look-up.
-	 * see (4.4)
-	 */
-	if (rinfo->ifindex == ifc->ifp->ifindex)
-	  rinfo->nexthop_out = rinfo->nexthop;
-
-	/* Interface route-map */
-	if (ri->routemap[RIP_FILTER_OUT])
-	  {
-	    ret = route_map_apply (ri->routemap[RIP_FILTER_OUT], 
-				     (struct prefix *) p, RMAP_RIP, 
-				     rinfo);
+      if (version == RIPv2 && ri->auth_type == RIP_AUTH_MD5)
+	rip_auth_md5_set (s, ri, doff, auth_str, RIP_AUTH_SIMPLE_SIZE);
 
-	    if (ret == RMAP_DENYMATCH)
-	      {
-	        if (IS_RIP_DEBUG_PACKET)
-	          zlog_debug ("RIP %s/%d is filtered by route-map out",
-			     inet_ntoa (p->prefix), p->prefixlen);
-		  continue;
-	      }
-	  }
-           
-	/* Apply redistribute route map - continue, if deny */
-	if (rip->route_map[rinfo->type].name
-	    && rinfo->sub_type != RIP_ROUTE_INTERFACE)
-	  {
-	    ret = route_map_apply (rip->route_map[rinfo->type].map,
-				   (struct prefix *)p, RMAP_RIP, rinfo);
+      ret = rip_send_packet_sock (STREAM_DATA (s), stream_get_endp (s),
+				  to, ifc, msock);
 
-	    if (ret == RMAP_DENYMATCH) 
-	      {
-		if (IS_RIP_DEBUG_PACKET)
-		  zlog_debug ("%s/%d is filtered by route-map",
-			     inet_ntoa (p->prefix), p->prefixlen);
-		continue;
-	      }
-	  }
+      if (ret >= 0 && IS_RIP_DEBUG_SEND)
+	rip_packet_dump ((struct rip_packet *)STREAM_DATA (s),
+			 stream_get_endp (s), "SEND");
+    }
+  stream_reset (s);
 
-	/* When route-map does not set metric. */
-	if (! rinfo->metric_set)
-	  {
-	    /* If redistribute metric is set. */
-	    if (rip->route_map[rinfo->type].metric_config
-		&& rinfo->metric != RIP_METRIC_INFINITY)
-	      {
-		rinfo->metric_out = rip->route_map[rinfo->type].metric;
-	      }
-	    else
-	      {
-		/* If the route is not connected or localy generated
-		   one, use default-metric value*/
-		if (rinfo->type != ZEBRA_ROUTE_RIP 
-		    && rinfo->type != ZEBRA_ROUTE_CONNECT
-		    && rinfo->metric != RIP_METRIC_INFINITY)
-		  rinfo->metric_out = rip->default_metric;
-	      }
-	  }
+  if (msock >= 0)
+    close (msock);
+}
 
-	/* Apply offset-list */
-	if (rinfo->metric != RIP_METRIC_INFINITY)
-	  rip_offset_list_apply_out (p, ifc->ifp, &rinfo->metric_out);
-
-	if (rinfo->metric_out > RIP_METRIC_INFINITY)
-	  rinfo->metric_out = RIP_METRIC_INFINITY;
-
-	/* Perform split-horizon with poisoned reverse 
-	 * for RIP and connected routes.
-	 **/
-	if (ri->split_horizon == RIP_SPLIT_HORIZON_POISONED_REVERSE) {
-	    /* 
-	     * We perform split horizon for RIP and connected route. 
-	     * For rip routes, we want to suppress the route if we would
-             * end up sending the route back on the interface that we
-             * learned it from, with a higher metric. For connected routes,
-             * we suppress the route if the prefix is a subset of the
-             * source address that we are going to use for the packet 
-             * (in order to handle the case when multiple subnets are
-             * configured on the same interface).
-             */
-	  if (rinfo->type == ZEBRA_ROUTE_RIP  &&
-	       rinfo->ifindex == ifc->ifp->ifindex)
-	       rinfo->metric_out = RIP_METRIC_INFINITY;
-	  if (rinfo->type == ZEBRA_ROUTE_CONNECT &&
-              prefix_match((struct prefix *)p, ifc->address))
-	       rinfo->metric_out = RIP_METRIC_INFINITY;
-	}
-	
-	/* Prepare preamble, auth headers, if needs be */
-	if (num == 0)
-	  {
-	    stream_putc (s, RIP_RESPONSE);
-	    stream_putc (s, version);
-	    stream_putw (s, 0);
-	    
-	    /* auth header for !v1 && !no_auth */
-            if ( (ri->auth_type != RIP_NO_AUTH) && (version != RIPv1) )
-              doff = rip_auth_header_write (s, ri, key, auth_str, 
-                                              RIP_AUTH_SIMPLE_SIZE);
-          }
-        
-	/* Write RTE to the stream. */
-	num = rip_write_rte (num, s, p, version, rinfo);
-	if (num == rtemax)
-	  {
-	    if (version == RIPv2 && ri->auth_type == RIP_AUTH_MD5)
-              rip_auth_md5_set (s, ri, doff, auth_str, RIP_AUTH_SIMPLE_SIZE);
+/* Send update to the ifp or spcified neighbor. */
+void
+rip_output_process (struct connected *ifc, struct sockaddr_in *to, 
+                    int route_type, u_char version)
+{
+  struct route_node *rp;
+  struct rip_interface *ri;
+  struct rip_response changed;
+  struct listnode *node;
 
-	    ret = rip_send_packet (STREAM_DATA (s), stream_get_endp (s),
-				   to, ifc);
+  /* Logging output event. */
+  if (IS_RIP_DEBUG_EVENT)
+    {
+      if (to)
+	zlog_debug ("update routes to neighbor %s", inet_ntoa (to->sin_addr));
+      else
+	zlog_debug ("update routes on interface %s ifindex %d",
+		   ifc->ifp->name, ifc->ifp->ifindex);
+    }
 
-	    if (ret >= 0 && IS_RIP_DEBUG_SEND)
-	      rip_packet_dump ((struct rip_packet *)STREAM_DATA (s),
-			       stream_get_endp(s), "SEND");
-	    num = 0;
-	    stream_reset (s);
-	  }
-      }
+  /* Get RIP interface. */
+  ri = ifc->ifp->info;
 
-  /* Flush unwritten RTE. */
-  if (num != 0)
+  /* Changed route only output: encode just the routes queued for the
+     triggered update. */
+  if (route_type == rip_changed_route)
     {
-      if (version == RIPv2 && ri->auth_type == RIP_AUTH_MD5)
-        rip_auth_md5_set (s, ri, doff, auth_str, RIP_AUTH_SIMPLE_SIZE);
+      memset (&changed, 0, sizeof (struct rip_response));
+      changed.ifc = ifc;
+      changed.version = version;
+      changed.split_horizon = ri->split_horizon;
 
-      ret = rip_send_packet (STREAM_DATA (s), stream_get_endp (s), to, ifc);
+      for (ALL_LIST_ELEMENTS_RO (rip->changed, node, rp))
+	rip_response_add (&changed, rp);
 
-      if (ret >= 0 && IS_RIP_DEBUG_SEND)
-	rip_packet_dump ((struct rip_packet *)STREAM_DATA (s),
-			 stream_get_endp (s), "SEND");
-      num = 0;
-      stream_reset (s);
+      rip_response_send (&changed, to);
+      if (changed.rte)
+	XFREE (MTYPE_RIP_RESPONSE, changed.rte);
     }
+  else
+    rip_response_send (rip_response_get (ifc, version), to);
 
   /* Statistics updates. */
   ri->sent_updates++;
@@ -2586,17 +2731,16 @@ rip_update (struct thread *t)
   return 0;
 }
 
-/* Walk down the RIP routing table then clear changed flag. */
+/* Release the routes queued for the triggered update. */
 static void
-rip_clear_changed_flag (void)
+rip_changed_clean (void)
 {
+  struct listnode *node;
   struct route_node *rp;
-  struct rip_info *rinfo;
 
-  for (rp = route_top (rip->table); rp; rp = route_next (rp))
-    if ((rinfo = rp->info) != NULL)
-      if (rinfo->flags & RIP_RTF_CHANGED)
-	rinfo->flags &= ~RIP_RTF_CHANGED;
+  for (ALL_LIST_ELEMENTS_RO (rip->changed, node, rp))
+    route_unlock_node (rp);
+  list_delete_all_node (rip->changed);
 }
 
 /* Triggered update interval timer. */
@@ -2620,6 +2764,9 @@ static int
 rip_triggered_update (struct thread *t)
 {
   int interval;
+  struct listnode *node, *nnode;
+  struct route_node *rp;
+  struct rip_info *rinfo;
 
   /* Clear thred pointer. */
   rip->t_triggered_update = NULL;
@@ -2636,13 +2783,29 @@ rip_triggered_update (struct thread *t)
   if (IS_RIP_DEBUG_EVENT)
     zlog_debug ("triggered update!");
 
+  /* Keep the routes still there and changed, once each: a route
+     replaced while queued is queued again. */
+  for (ALL_LIST_ELEMENTS (rip->changed, node, nnode, rp))
+    {
+      rinfo = rp->info;
+      if (rinfo && (rinfo->flags & RIP_RTF_CHANGED))
+	{
+	  /* The route change flags are cleared as the routes go into
+	     the triggered update. */
+	  rinfo->flags &= ~RIP_RTF_CHANGED;
+	}
+      else
+	{
+	  route_unlock_node (rp);
+	  list_delete_node (rip->changed, node);
+	}
+    }
+
   /* Split Horizon processing is done when generating triggered
      updates as well as normal updates (see section 2.6). */
   rip_update_process (rip_changed_route);
 
-  /* Once all of the triggered updates have been generated, the route
-     change flags should be cleared. */
-  rip_clear_changed_flag ();
+  rip_changed_clean ();
 
   /* After a triggered update is sent, a timer should be set for a
    random interval between 1 and 5 seconds.  If other changes that
@@ -2677,7 +2840,7 @@ rip_redistribute_withdraw (int type)
 	    RIP_TIMER_ON (rinfo->t_garbage_collect, 
 			  rip_garbage_collect, rip->garbage_time);
 	    RIP_TIMER_OFF (rinfo->t_timeout);
-	    rinfo->flags |= RIP_RTF_CHANGED;
+	    rip_route_changed (rinfo);
 
 	    if (IS_RIP_DEBUG_EVENT) {
               struct prefix_ipv4 *p = (struct prefix_ipv4 *) &rp->p;
@@ -2710,6 +2873,7 @@ rip_create (void)
   rip->table = route_table_init ();
   rip->route = route_table_init ();
   rip->neighbor = route_table_init ();
+  rip->changed = list_new ();
 
   /* Make output stream. */
   rip->obuf = stream_new (1500);
@@ -2999,7 +3163,7 @@ DEFUN (rip_default_metric,
   if (rip)
     {
       rip->default_metric = atoi (argv[0]);
-      /* rip_update_default_metric (); */
+      rip_response_invalidate ();
     }
   return CMD_SUCCESS;
 }
@@ -3014,7 +3178,7 @@ DEFUN (no_rip_default_metric,
   if (rip)
     {
       rip->default_metric = RIP_DEFAULT_METRIC_DEFAULT;
-      /* rip_update_default_metric (); */
+      rip_response_invalidate ();
     }
   return CMD_SUCCESS;
 }
@@ -3704,6 +3868,8 @@ rip_distribute_update (struct distribute *dist)
   struct access_list *alist;
   struct prefix_list *plist;
 
+  rip_response_invalidate ();
+
   if (! dist->ifname)
     return;
 
@@ -3776,6 +3942,9 @@ rip_distribute_update_all (struct prefix_list *notused)
   struct interface *ifp;
   struct listnode *node, *nnode;
 
+  /* Route-maps and offset-lists may use the list too. */
+  rip_response_invalidate ();
+
   for (ALL_LIST_ELEMENTS (iflist, node, nnode, ifp))
     rip_distribute_update_interface (ifp);
 }
@@ -3796,6 +3965,10 @@ rip_clean (void)
 
   if (rip)
     {
+      rip_changed_clean ();
+      list_delete (rip->changed);
+      rip_response_invalidate ();
+
       /* Clear RIP routes */
       for (rp = route_top (rip->table); rp; rp = route_next (rp))
 	if ((rinfo = rp->info) != NULL)
@@ -3905,6 +4078,8 @@ rip_if_rmap_update (struct if_rmap *if_rmap)
   struct rip_interface *ri;
   struct route_map *rmap;
 
+  rip_response_invalidate ();
+
   ifp = if_lookup_by_name (if_rmap->ifname);
   if (ifp == NULL)
     return;
@@ -3967,6 +4142,8 @@ rip_routemap_update (const char *notused)
   struct interface *ifp;
   struct listnode *node, *nnode;
 
+  rip_response_invalidate ();
+
   for (ALL_LIST_ELEMENTS (iflist, node, nnode, ifp))
     rip_if_rmap_update_interface (ifp);
 
@@ -127,6 +127,9 @@ struct rip
   struct thread *t_triggered_update;
   struct thread *t_triggered_interval;
 
+  /* Locked nodes of the routes changed since the last triggered update. */
+  struct list *changed;
+
   /* RIP timer values. */
   unsigned long update_time;
   unsigned long timeout_time;
@@ -293,6 +296,26 @@ struct rip_interface
 
   /* Passive interface. */
   int passive;
+
+  /* Responses encoded for regular updates. */
+  struct list *responses;
+};
+
+/* The RTEs of a response, as encoded for one connected address. */
+struct rip_response
+{
+  /* Connected address and version they were encoded for. */
+  struct connected *ifc;
+  u_char version;
+
+  /* What they were encoded under. */
+  unsigned long generation;
+  split_horizon_policy_t split_horizon;
+
+  /* The RTEs, RIP_RTE_SIZE bytes each. */
+  u_char *rte;
+  int count;
+  int max;
 };
 
 /* RIP peer information. */
@@ -424,6 +447,8 @@ extern int rip_offset_list_apply_out (struct prefix_ipv4 *, struct interface *,
 extern void rip_offset_clean (void);
 
 extern void rip_info_free (struct rip_info *);
+extern void rip_response_invalidate (void);
+extern void rip_response_clean (struct rip_interface *);
 extern u_char rip_distance_apply (struct rip_info *);
 extern void rip_redistribute_clean (void);
 extern void rip_ifaddr_add (struct interface *, struct connected *);
@@ -3,6 +3,8 @@
 #include "vty.h"
 #include "stream.h"
 #include "privs.h"
+#include "memory.h"
+#include "thread.h"
 
 #include "bgpd/bgpd.h"
 #include "bgpd/bgp_aspath.h"
@@ -983,8 +985,8 @@ validate (struct aspath *as, const struct test_spec *sp)
       printf ("private check: %d %d\n", sp->private_as,
               aspath_private_as_check (as));
     }
-  aspath_unintern (asinout);
-  aspath_unintern (as4);
+  aspath_unintern (&asinout);
+  aspath_unintern (&as4);
   
   aspath_free (asconfeddel);
   aspath_free (asstr);
@@ -1030,7 +1032,7 @@ parse_test (struct test_segment *t)
   printf ("\n");
   
   if (asp)
-    aspath_unintern (asp);
+    aspath_unintern (&asp);
 }
 
 /* prepend testing */
@@ -1046,7 +1048,7 @@ prepend_test (struct tests *t)
   asp2 = make_aspath (t->test2->asdata, t->test2->len, 0);
   
   ascratch = aspath_dup (asp2);
-  aspath_unintern (asp2);
+  aspath_unintern (&asp2);
   
   asp2 = aspath_prepend (asp1, ascratch);
   
@@ -1058,7 +1060,7 @@ prepend_test (struct tests *t)
     printf ("%s!\n", FAILED);
   
   printf ("\n");
-  aspath_unintern (asp1);
+  aspath_unintern (&asp1);
   aspath_free (asp2);
 }
 
@@ -1074,7 +1076,7 @@ empty_prepend_test (struct test_segment *t)
   asp2 = aspath_empty ();
   
   ascratch = aspath_dup (asp2);
-  aspath_unintern (asp2);
+  aspath_unintern (&asp2);
   
   asp2 = aspath_prepend (asp1, ascratch);
   
@@ -1087,7 +1089,7 @@ empty_prepend_test (struct test_segment *t)
   
   printf ("\n");
   if (asp1)
-    aspath_unintern (asp1);
+    aspath_unintern (&asp1);
   aspath_free (asp2);
 }
 
@@ -1111,8 +1113,8 @@ as4_reconcile_test (struct tests *t)
     printf (FAILED "!\n");
   
   printf ("\n");
-  aspath_unintern (asp1);
-  aspath_unintern (asp2);
+  aspath_unintern (&asp1);
+  aspath_unintern (&asp2);
   aspath_free (ascratch);
 }
 
@@ -1137,8 +1139,8 @@ aggregate_test (struct tests *t)
     printf (FAILED "!\n");
   
   printf ("\n");
-  aspath_unintern (asp1);
-  aspath_unintern (asp2);
+  aspath_unintern (&asp1);
+  aspath_unintern (&asp2);
   aspath_free (ascratch);
 /*  aspath_unintern (ascratch);*/
 }
@@ -1185,8 +1187,8 @@ cmp_test ()
         printf (OK "\n");
       
       printf ("\n");
-      aspath_unintern (asp1);
-      aspath_unintern (asp2);
+      aspath_unintern (&asp1);
+      aspath_unintern (&asp2);
     }
 }
 
@@ -1229,20 +1231,20 @@ handle_attr_test (struct aspath_tests *t)
       printf ("aspath is NULL!\n");
       failed++;
     }
-  if (attr.aspath && strcmp (attr.aspath->str, t->shouldbe))
+  if (attr.aspath && strcmp (aspath_print (attr.aspath), t->shouldbe))
     {
       printf ("attr str and 'shouldbe' mismatched!\n"
               "attr str:  %s\n"
               "shouldbe:  %s\n",
-              attr.aspath->str, t->shouldbe);
+              aspath_print (attr.aspath), t->shouldbe);
       failed++;
     }
 
 out:
   if (attr.aspath)
-    aspath_unintern (attr.aspath);
+    aspath_unintern (&attr.aspath);
   if (asp)
-    aspath_unintern (asp);
+    aspath_unintern (&asp);
   return failed - initfail;
 }
 
@@ -1253,14 +1255,109 @@ attr_test (struct aspath_tests *t)
     printf ("%s\n\n", handle_attr_test (t) ? FAILED : OK);  
 }
 
+/* Interning throughput: BENCH_PEERS peers each send a table of
+ * BENCH_ROUTES routes whose AS_PATHs are drawn from BENCH_PATHS distinct
+ * paths, and every one is parsed off the wire and interned, as for an
+ * UPDATE.  The references are held until all peers are done, then
+ * dropped again.
+ */
+#define BENCH_PEERS 20
+#define BENCH_ROUTES 100000
+#define BENCH_PATHS 30000
+
+static unsigned long
+bench_usec (struct timeval *start)
+{
+  struct timeval now;
+
+  quagga_gettime (QUAGGA_CLK_MONOTONIC, &now);
+  return (now.tv_sec - start->tv_sec) * 1000000UL
+	 + now.tv_usec - start->tv_usec;
+}
+
+static void
+intern_benchmark (void)
+{
+  struct stream *paths;
+  size_t *offset, *length;
+  struct aspath **held;
+  struct timeval start;
+  unsigned long usec;
+  int i, j, n, p;
+
+  /* The distinct paths, on the wire with 4-byte ASNs: one AS_SEQUENCE
+   * of 2 to 9 ASNs, sometimes followed by an AS_SET. */
+  srandom (1);
+  paths = stream_new (BENCH_PATHS * 64);
+  offset = XCALLOC (MTYPE_TMP, BENCH_PATHS * sizeof (size_t));
+  length = XCALLOC (MTYPE_TMP, BENCH_PATHS * sizeof (size_t));
+  for (i = 0; i < BENCH_PATHS; i++)
+    {
+      offset[i] = stream_get_endp (paths);
+      n = 2 + random () % 8;
+      stream_putc (paths, AS_SEQUENCE);
+      stream_putc (paths, n);
+      for (j = 0; j < n; j++)
+	stream_putl (paths, 1 + random () % 65000);
+      if (random () % 8 == 0)
+	{
+	  stream_putc (paths, AS_SET);
+	  stream_putc (paths, 2);
+	  stream_putl (paths, 1 + random () % 65000);
+	  stream_putl (paths, 1 + random () % 65000);
+	}
+      length[i] = stream_get_endp (paths) - offset[i];
+    }
+
+  held = XCALLOC (MTYPE_TMP,
+		  BENCH_PEERS * BENCH_ROUTES * sizeof (struct aspath *));
+
+  quagga_gettime (QUAGGA_CLK_MONOTONIC, &start);
+  for (p = 0; p < BENCH_PEERS; p++)
+    for (i = 0; i < BENCH_ROUTES; i++)
+      {
+	j = (i * 7919 + p) % BENCH_PATHS;
+	stream_set_getp (paths, offset[j]);
+	held[p * BENCH_ROUTES + i] = aspath_parse (paths, length[j], 1);
+      }
+  usec = bench_usec (&start);
+  printf ("intern:   %d paths in %lu usec, %.0f paths/sec, %lu distinct\n",
+	  BENCH_PEERS * BENCH_ROUTES, usec,
+	  BENCH_PEERS * BENCH_ROUTES * 1e6 / usec, aspath_count ());
+
+  quagga_gettime (QUAGGA_CLK_MONOTONIC, &start);
+  for (i = 0; i < BENCH_ROUTES; i++)
+    aspath_print (held[i]);
+  usec = bench_usec (&start);
+  printf ("print:    %d paths in %lu usec\n", BENCH_ROUTES, usec);
+
+  quagga_gettime (QUAGGA_CLK_MONOTONIC, &start);
+  for (i = 0; i < BENCH_PEERS * BENCH_ROUTES; i++)
+    aspath_unintern (&held[i]);
+  usec = bench_usec (&start);
+  printf ("unintern: %d paths in %lu usec\n",
+	  BENCH_PEERS * BENCH_ROUTES, usec);
+
+  XFREE (MTYPE_TMP, held);
+  XFREE (MTYPE_TMP, offset);
+  XFREE (MTYPE_TMP, length);
+  stream_free (paths);
+}
+
 int
-main (void)
+main (int argc, char **argv)
 {
   int i = 0;
   bgp_master_init ();
   master = bm->master;
   bgp_attr_init ();
   
+  if (argc > 1 && strcmp (argv[1], "-b") == 0)
+    {
+      intern_benchmark ();
+      return aspath_count ();
+    }
+
   while (test_segments[i].name)
     {
       printf ("test %u\n", i);
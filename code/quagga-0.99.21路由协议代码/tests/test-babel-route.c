@@ -0,0 +1,379 @@
+/*
+ * Babel route and source table tests.
+ *
+ * This file is part of Quagga.
+ *
+ * Quagga is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2, or (at your option) any
+ * later version.
+ *
+ * Quagga is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Quagga; see the file COPYING.  If not, write to the Free
+ * Software Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ */
+
+/* Replays a burst of updates, as a babeld joining a mesh hears it from
+ * its neighbours, through update_route(): every router's prefixes, from
+ * each neighbour that has a route to them, in arrival order, for a few
+ * rounds of sequence numbers, with retractions mixed in.  Checks that
+ * every route the updates left behind is found, and that the walks see
+ * them all, then flushes the neighbours one by one and checks that the
+ * sources are released and expire.  With -b, times the replay of a
+ * burst of BENCH_PREFIXES prefixes instead.
+ *
+ * The interfaces are never up, so nothing is sent and every route is
+ * unreachable; routes are still installed, through a zclient that
+ * writes to /dev/null.
+ */
+#include <zebra.h>
+
+#include "command.h"
+#include "if.h"
+#include "thread.h"
+#include "zclient.h"
+
+#include "babeld/babel_main.h"
+#include "babeld/babeld.h"
+#include "babeld/babel_zebra.h"
+#include "babeld/util.h"
+#include "babeld/kernel.h"
+#include "babeld/source.h"
+#include "babeld/neighbour.h"
+#include "babeld/route.h"
+
+#define PREFIXES 1000
+#define ROUTERS 100
+#define BENCH_PREFIXES 3000
+#define BENCH_ROUTERS 300
+#define NEIGHS 4
+#define ROUNDS 4
+
+/* What babel_main.c provides for the daemon. */
+struct thread_master *master;
+struct timeval babel_now;
+unsigned char myid[8];
+int debug = 0;
+int resend_delay = -1;
+const unsigned char zeroes[16] = {0};
+const unsigned char ones[16] =
+    {0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+     0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff};
+unsigned char protocol_group[16];
+int protocol_port;
+int protocol_socket = -1;
+
+void
+babel_load_state_file(void)
+{
+}
+
+void
+show_babel_main_configuration(struct vty *vty)
+{
+}
+
+struct update
+{
+    int prefix;
+    int neigh;
+    unsigned short seqno;
+    unsigned short refmetric;
+};
+
+/* What the last update from every neighbour for every prefix left. */
+static struct
+{
+    int present;
+    unsigned short seqno;
+    unsigned short refmetric;
+} model[BENCH_PREFIXES][NEIGHS];
+
+static int nprefixes, nrouters;
+static struct neighbour *neighs_[NEIGHS];
+static struct update *burst;
+static int nupdates;
+static int failed;
+
+/* Every fourth prefix is IPv6, the others are v4-mapped /24s. */
+static void
+prefix_of(int i, unsigned char *prefix, unsigned char *plen)
+{
+    memset(prefix, 0, 16);
+    if(i % 4 == 0) {
+        prefix[0] = 0x20;
+        prefix[1] = 0x01;
+        prefix[2] = 0x0d;
+        prefix[3] = 0xb8;
+        prefix[4] = i >> 8;
+        prefix[5] = i & 0xff;
+        *plen = 64;
+    } else {
+        prefix[10] = prefix[11] = 0xff;
+        prefix[12] = 10;
+        prefix[13] = i >> 8;
+        prefix[14] = i & 0xff;
+        *plen = 120;
+    }
+}
+
+/* IPv4 routes need an IPv4 next hop. */
+static void
+nexthop_of(int i, int n, unsigned char *nexthop)
+{
+    if(i % 4 == 0) {
+        memcpy(nexthop, neighs_[n]->address, 16);
+    } else {
+        memset(nexthop, 0, 16);
+        nexthop[10] = nexthop[11] = 0xff;
+        nexthop[12] = 192;
+        nexthop[13] = 168;
+        nexthop[15] = n + 1;
+    }
+}
+
+static void
+router_of(int i, unsigned char *id)
+{
+    int router = i % nrouters;
+
+    memset(id, 0, 8);
+    id[0] = 0x02;
+    id[6] = router >> 8;
+    id[7] = router & 0xff;
+}
+
+static void
+setup(void)
+{
+    struct interface *ifp[2];
+    unsigned char address[16];
+    int n;
+
+    master = thread_master_create();
+    cmd_init(1);
+    babeld_quagga_init();
+    gettime(&babel_now);
+    myid[0] = 0xff;
+
+    zclient = zclient_new();
+    zclient->sock = open("/dev/null", O_WRONLY);
+
+    ifp[0] = if_get_by_name("eth0");
+    ifp[0]->ifindex = 1;
+    ifp[1] = if_get_by_name("eth1");
+    ifp[1]->ifindex = 2;
+
+    for(n = 0; n < NEIGHS; n++) {
+        memset(address, 0, 16);
+        address[0] = 0xfe;
+        address[1] = 0x80;
+        address[15] = n + 1;
+        neighs_[n] = find_neighbour(address, ifp[n % 2]);
+    }
+}
+
+/* Every neighbour hears three prefixes out of four, and the updates of a
+   round arrive interleaved. */
+static void
+make_burst(void)
+{
+    struct update u;
+    int round, i, n, j, first;
+
+    burst = malloc(ROUNDS * nprefixes * NEIGHS * sizeof(struct update));
+    nupdates = 0;
+    for(round = 0; round < ROUNDS; round++) {
+        first = nupdates;
+        for(i = 0; i < nprefixes; i++)
+            for(n = 0; n < NEIGHS; n++) {
+                if((i + n) % 4 == 0)
+                    continue;
+                u.prefix = i;
+                u.neigh = n;
+                u.seqno = 100 + round;
+                u.refmetric = random() % 16 == 0 ?
+                    INFINITY : 96 + random() % 1000;
+                burst[nupdates++] = u;
+            }
+        for(i = nupdates - 1; i > first; i--) {
+            j = first + random() % (i - first + 1);
+            u = burst[i];
+            burst[i] = burst[j];
+            burst[j] = u;
+        }
+    }
+}
+
+static void
+replay(int track)
+{
+    unsigned char prefix[16], plen, id[8], nexthop[16];
+    struct babel_route *route;
+    struct update *u;
+    int k;
+
+    for(k = 0; k < nupdates; k++) {
+        u = &burst[k];
+        prefix_of(u->prefix, prefix, &plen);
+        router_of(u->prefix, id);
+        nexthop_of(u->prefix, u->neigh, nexthop);
+        route = update_route(id, prefix, plen, u->seqno, u->refmetric, 400,
+                             neighs_[u->neigh], nexthop, NULL, 0);
+        if(track && route) {
+            model[u->prefix][u->neigh].present = 1;
+            model[u->prefix][u->neigh].seqno = u->seqno;
+            model[u->prefix][u->neigh].refmetric = u->refmetric;
+        }
+    }
+}
+
+static int walked;
+
+static void
+count_route(struct babel_route *route, void *closure)
+{
+    int n;
+
+    walked++;
+    for(n = 0; n < NEIGHS; n++)
+        if(route->neigh == neighs_[n])
+            return;
+    printf("route to %s through an unknown neighbour\n",
+           format_prefix(route->src->prefix, route->src->plen));
+    failed++;
+}
+
+/* Every route the model has is found with what its last update set, and
+   walking the table sees exactly those. */
+static void
+check(void)
+{
+    unsigned char prefix[16], plen, nexthop[16];
+    struct babel_route *route;
+    int i, n, present = 0;
+
+    for(i = 0; i < nprefixes; i++) {
+        prefix_of(i, prefix, &plen);
+        for(n = 0; n < NEIGHS; n++) {
+            nexthop_of(i, n, nexthop);
+            route = find_route(prefix, plen, neighs_[n], nexthop);
+            if(!model[i][n].present) {
+                if(route) {
+                    printf("%s through %d: not expected\n",
+                           format_prefix(prefix, plen), n);
+                    failed++;
+                }
+                continue;
+            }
+            present++;
+            if(route == NULL) {
+                printf("%s through %d: missing\n",
+                       format_prefix(prefix, plen), n);
+                failed++;
+            } else if(route->seqno != model[i][n].seqno ||
+                      route->refmetric != model[i][n].refmetric) {
+                printf("%s through %d: seqno %d metric %d, "
+                       "expected %d %d\n", format_prefix(prefix, plen), n,
+                       route->seqno, route->refmetric,
+                       model[i][n].seqno, model[i][n].refmetric);
+                failed++;
+            }
+        }
+    }
+
+    walked = 0;
+    for_all_routes(count_route, NULL);
+    if(walked != present) {
+        printf("walked %d routes, expected %d\n", walked, present);
+        failed++;
+    }
+}
+
+static void
+check_sources(int expect)
+{
+    unsigned char prefix[16], plen, id[8];
+    int i, found = 0;
+
+    for(i = 0; i < nprefixes; i++) {
+        prefix_of(i, prefix, &plen);
+        router_of(i, id);
+        found += find_source(id, prefix, plen, 0, 0) != NULL;
+    }
+    if(found != expect) {
+        printf("%d sources, expected %d\n", found, expect);
+        failed++;
+    }
+}
+
+static unsigned long
+usec_since(struct timeval *start)
+{
+    struct timeval now;
+
+    gettime(&now);
+    return (now.tv_sec - start->tv_sec) * 1000000UL
+        + now.tv_usec - start->tv_usec;
+}
+
+static void
+benchmark(void)
+{
+    struct timeval start;
+
+    nprefixes = BENCH_PREFIXES;
+    nrouters = BENCH_ROUTERS;
+    make_burst();
+
+    gettime(&start);
+    replay(0);
+    printf("replayed %d updates for %d prefixes in %lu usec\n",
+           nupdates, nprefixes, usec_since(&start));
+
+    gettime(&start);
+    flush_all_routes();
+    printf("flushed in %lu usec\n", usec_since(&start));
+}
+
+int
+main(int argc, char **argv)
+{
+    int i, n;
+
+    srandom(1);
+    setup();
+
+    if(argc > 1 && strcmp(argv[1], "-b") == 0) {
+        benchmark();
+        return 0;
+    }
+
+    nprefixes = PREFIXES;
+    nrouters = ROUTERS;
+    make_burst();
+    replay(1);
+    check();
+    check_sources(nprefixes);
+
+    for(n = 0; n < NEIGHS; n++) {
+        flush_neighbour_routes(neighs_[n]);
+        for(i = 0; i < nprefixes; i++)
+            model[i][n].present = 0;
+        check();
+    }
+
+    babel_now.tv_sec += SOURCE_GC_TIME + 1;
+    expire_sources();
+    check_sources(0);
+
+    printf("%d updates replayed\n", nupdates);
+    printf("failures: %d\n", failed);
+    return failed;
+}
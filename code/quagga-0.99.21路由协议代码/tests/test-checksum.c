@@ -3,6 +3,7 @@
 #include <time.h>
 
 #include "checksum.h"
+#include "thread.h"
 
 struct thread_master *master;
 
@@ -486,31 +487,94 @@ in_cksum_rfc(void *parg, int count)
 }
 
 
+/* Throughput of the library checksums against the byte- and word-wise
+ * originals above, over a range of LSA and packet sizes. */
+static void
+benchmark (void)
+{
+  static const int sizes[] = { 64, 256, 1500, 8192 };
+  static u_char data[8192 + sizeof (u_int16_t)];
+  struct timeval start, end;
+  volatile u_int16_t sink = 0;
+  unsigned long iter, i;
+  unsigned int s;
+  int n;
+  double usec[4];
+
+  for (n = 0; n < (int) sizeof (data); n++)
+    data[n] = random ();
+
+#define BENCH(slot, expr) \
+  do { \
+    quagga_gettime (QUAGGA_CLK_MONOTONIC, &start); \
+    for (i = 0; i < iter; i++) \
+      sink += (expr); \
+    quagga_gettime (QUAGGA_CLK_MONOTONIC, &end); \
+    usec[slot] = (end.tv_sec - start.tv_sec) * 1000000.0 \
+		 + (end.tv_usec - start.tv_usec); \
+  } while (0)
+
+  for (s = 0; s < sizeof (sizes) / sizeof (sizes[0]); s++)
+    {
+      n = sizes[s];
+      iter = (256UL << 20) / n;
+
+      BENCH (0, in_cksum_rfc (data, n));
+      BENCH (1, in_cksum (data, n));
+      BENCH (2, ospfd_checksum (data, n + sizeof (u_int16_t), n));
+      BENCH (3, fletcher_checksum (data, n + sizeof (u_int16_t), n));
+
+      printf ("%5d bytes: in_cksum %6.0f -> %6.0f MB/s, "
+	      "fletcher %6.0f -> %6.0f MB/s\n", n,
+	      (double) n * iter / usec[0], (double) n * iter / usec[1],
+	      (double) n * iter / usec[2], (double) n * iter / usec[3]);
+    }
+#undef BENCH
+}
+
 int
 main(int argc, char **argv)
 {
 /* 60017 65629 702179 */
 #define MAXDATALEN 60017
 #define BUFSIZE MAXDATALEN + sizeof(u_int16_t)
-  u_char buffer[BUFSIZE];
+  /* Room to start the data at any offset within a long, so the
+   * library's wide loads are also tried on misaligned buffers, and
+   * for the fill below running up to a long past the end. */
+  u_char storage[BUFSIZE + 2 * sizeof (long int)];
+  u_char *buffer;
   int exercise = 0;
+  unsigned long round, rounds = 0;
 #define EXERCISESTEP 257
   
   srandom (time (NULL));
+
+  if (argc > 1 && strcmp (argv[1], "-b") == 0)
+    {
+      benchmark ();
+      return 0;
+    }
+  if (argc > 1)
+    rounds = strtoul (argv[1], NULL, 10);
   
-  while (1) {
+  for (round = 0; rounds == 0 || round < rounds; round++) {
     u_int16_t ospfd, isisd, lib, in_csum, in_csum_res, in_csum_rfc;
     int i,j;
 
     exercise += EXERCISESTEP;
     exercise %= MAXDATALEN;
+    buffer = storage + round % sizeof (long int);
     
-    for (i = 0; i < exercise; i += sizeof (long int)) {
-      long int rand = random ();
+    /* Every so often, all ones, to push the carry folding to its limit. */
+    if (round % 16 == 0)
+      memset (buffer, 0xff, exercise);
+    else
+      for (i = 0; i < exercise; i += sizeof (long int)) {
+        long int rand = random ();
       
-      for (j = sizeof (long int); j > 0; j--)
-        buffer[i + (sizeof (long int) - j)] = (rand >> (j * 8)) & 0xff;
-    }
+        for (j = sizeof (long int); j > 0; j--)
+          buffer[i + (sizeof (long int) - j)] = (rand >> (j * 8)) & 0xff;
+      }
     
     in_csum = in_cksum(buffer, exercise);
     in_csum_res = in_cksum_optimized(buffer, exercise);
@@ -519,6 +583,8 @@ main(int argc, char **argv)
       printf ("verify: in_chksum failed in_csum:%x, in_csum_res:%x,"
 	      "in_csum_rfc %x, len:%d\n", 
 	      in_csum, in_csum_res, in_csum_rfc, exercise);
+    if (in_csum != in_csum_rfc)
+      exit (1);
 
     ospfd = ospfd_checksum (buffer, exercise + sizeof(u_int16_t), exercise);
     if (verify (buffer, exercise + sizeof(u_int16_t)))
@@ -564,4 +630,5 @@ main(int argc, char **argv)
       exit (1);
     }
   }
+  return 0;
 }
@@ -0,0 +1,278 @@
+/*
+ * Configuration load tests.
+ *
+ * This file is part of Quagga.
+ *
+ * Quagga is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2, or (at your option) any
+ * later version.
+ *
+ * Quagga is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Quagga; see the file COPYING.  If not, write to the Free
+ * Software Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ */
+
+/* Installs bgpd's commands, checks that lines match them with the
+ * abbreviation, ambiguity and incomplete-input rules of the vty and of
+ * configuration files, then generates a bgpd configuration with
+ * NEIGHBORS neighbors, their route-maps and prefix-lists, reads it with
+ * config_from_file() and checks that every line took.  With -b, times
+ * the read of one BENCH_NEIGHBORS neighbors large instead.
+ */
+#include <zebra.h>
+
+#include "command.h"
+#include "vty.h"
+#include "memory.h"
+#include "thread.h"
+#include "privs.h"
+#include "linklist.h"
+#include "prefix.h"
+#include "plist.h"
+#include "routemap.h"
+
+#include "bgpd/bgpd.h"
+
+#define NEIGHBORS 200
+#define BENCH_NEIGHBORS 5000
+#define ENTRIES 10
+
+struct thread_master *master;
+static char listen_address[] = "127.0.0.1";
+struct zebra_privs_t bgpd_privs =
+{
+  .user = NULL,
+  .group = NULL,
+  .vty_group = NULL,
+};
+
+static struct vty *vty;
+static int failed;
+
+static const struct
+{
+  enum node_type node;
+  int strict;
+  const char *line;
+  int ret;
+} lines[] =
+{
+  /* Keywords abbreviate at the vty, not in configuration files. */
+  { CONFIG_NODE, 0, "ip prefix-list A permit 10.0.0.0/8", CMD_SUCCESS },
+  { CONFIG_NODE, 0, "ip pre A p 10.0.0.0/8 le 24", CMD_SUCCESS },
+  { CONFIG_NODE, 1, "ip pre A permit 10.0.0.0/8", CMD_ERR_NO_MATCH },
+  { CONFIG_NODE, 1, "ip prefix-list A seq 5 deny 10.0.0.0/16", CMD_SUCCESS },
+  /* "de" is deny or description. */
+  { CONFIG_NODE, 0, "ip prefix-list A de 10.0.0.0/8", CMD_ERR_AMBIGUOUS },
+  { CONFIG_NODE, 0, "ip prefix-list A desc one two", CMD_SUCCESS },
+  { CONFIG_NODE, 0, "ip prefix-list A", CMD_ERR_INCOMPLETE },
+  { CONFIG_NODE, 1, "ip prefix-list A permit", CMD_ERR_INCOMPLETE },
+  /* Incomplete prefixes and numbers out of range match nothing. */
+  { CONFIG_NODE, 0, "ip prefix-list A permit 10.0.0.0/", CMD_ERR_NO_MATCH },
+  { CONFIG_NODE, 1, "ip prefix-list A seq 0 permit any", CMD_ERR_NO_MATCH },
+  { CONFIG_NODE, 1, "ip prefix-list A seq 10 permit any", CMD_SUCCESS },
+  { CONFIG_NODE, 0, "router bgp 65000", CMD_SUCCESS },
+  { BGP_NODE, 0, "nei 10.0.0.1 remote-as 65001", CMD_SUCCESS },
+  { BGP_NODE, 0, "n 10.0.0.1 remote-as 65001", CMD_ERR_AMBIGUOUS },
+  { BGP_NODE, 1, "neighbor 10.0.0.1 description a b c", CMD_SUCCESS },
+  { BGP_NODE, 1, "neighbor 10.0.0.1 route-map B in", CMD_SUCCESS },
+  { BGP_NODE, 1, "neighbor 10.0.0.1 route-map B", CMD_ERR_INCOMPLETE },
+  { BGP_NODE, 0, "neighbor 10.0.0.1 ro B out", CMD_ERR_AMBIGUOUS },
+  { BGP_NODE, 1, "neighbor 10.0.0.1 bogus", CMD_ERR_NO_MATCH },
+  { BGP_NODE, 0, "timers bgp 10 30", CMD_SUCCESS },
+  { BGP_NODE, 1, "timers bgp 10 70000", CMD_ERR_NO_MATCH },
+  { CONFIG_NODE, 0, "no router bgp 65000", CMD_SUCCESS },
+};
+
+static int
+execute (enum node_type node, int strict, const char *line)
+{
+  vector vline;
+  int ret;
+
+  vty->node = node;
+  vline = cmd_make_strvec (line);
+  if (strict)
+    ret = cmd_execute_command_strict (vline, vty, NULL);
+  else
+    ret = cmd_execute_command (vline, vty, NULL, 1);
+  cmd_free_strvec (vline);
+  return ret;
+}
+
+static void
+check_lines (void)
+{
+  unsigned int i;
+  int ret;
+
+  for (i = 0; i < sizeof (lines) / sizeof (lines[0]); i++)
+    {
+      ret = execute (lines[i].node, lines[i].strict, lines[i].line);
+      if (ret != lines[i].ret)
+	{
+	  printf ("\"%s\"%s: %d, expected %d\n", lines[i].line,
+		  lines[i].strict ? " (strict)" : "", ret, lines[i].ret);
+	  failed++;
+	}
+    }
+}
+
+/* A configuration as a route server or a transit router might have:
+   every neighbor with its description, a route-map each way and a
+   prefix-list of ENTRIES entries. */
+static int
+generate (FILE *fp, int neighbors)
+{
+  int i, j, n = 0;
+
+  fprintf (fp, "hostname bgpd\n!\n");
+  for (i = 0; i < neighbors; i++)
+    {
+      for (j = 1; j <= ENTRIES; j++)
+	fprintf (fp, "ip prefix-list PL%d seq %d permit 10.%d.%d.0/24 le 32\n",
+		 i, j * 5, i >> 8, ((i & 0xff) + j) & 0xff);
+      fprintf (fp, "!\nroute-map RM%d-in permit 10\n"
+	       " match ip address prefix-list PL%d\n"
+	       " set local-preference %d\n"
+	       " set community %d:%d additive\n"
+	       "route-map RM%d-out permit 10\n"
+	       " set as-path prepend 65000 65000\n!\n",
+	       i, i, 100 + i % 100, 65000, i & 0xffff, i);
+      n += ENTRIES + 8;
+    }
+
+  fprintf (fp, "router bgp 65000\n"
+	   " bgp router-id 192.0.2.1\n"
+	   " bgp log-neighbor-changes\n");
+  n += 4;
+  for (i = 0; i < neighbors; i++)
+    {
+      fprintf (fp, " neighbor 172.%d.%d.%d remote-as %d\n"
+	       " neighbor 172.%d.%d.%d description peer %d, AS%d\n"
+	       " neighbor 172.%d.%d.%d timers 10 30\n"
+	       " neighbor 172.%d.%d.%d route-map RM%d-in in\n"
+	       " neighbor 172.%d.%d.%d route-map RM%d-out out\n"
+	       " neighbor 172.%d.%d.%d soft-reconfiguration inbound\n",
+	       16 + (i >> 16), (i >> 8) & 0xff, i & 0xff, 64512 + i % 1000,
+	       16 + (i >> 16), (i >> 8) & 0xff, i & 0xff, i, 64512 + i % 1000,
+	       16 + (i >> 16), (i >> 8) & 0xff, i & 0xff,
+	       16 + (i >> 16), (i >> 8) & 0xff, i & 0xff, i,
+	       16 + (i >> 16), (i >> 8) & 0xff, i & 0xff, i,
+	       16 + (i >> 16), (i >> 8) & 0xff, i & 0xff);
+      n += 6;
+    }
+  for (i = 0; i < neighbors; i++)
+    {
+      fprintf (fp, " network 10.%d.%d.0/24\n", i >> 8, i & 0xff);
+      n++;
+    }
+  fprintf (fp, "!\nline vty\n!\n");
+  return n + 1;
+}
+
+static int
+load (int neighbors, unsigned long *usec)
+{
+  struct timeval start, now;
+  FILE *fp;
+  int n, ret;
+
+  fp = tmpfile ();
+  n = generate (fp, neighbors);
+  rewind (fp);
+
+  vty->node = CONFIG_NODE;
+  quagga_gettime (QUAGGA_CLK_MONOTONIC, &start);
+  ret = config_from_file (vty, fp);
+  quagga_gettime (QUAGGA_CLK_MONOTONIC, &now);
+  fclose (fp);
+
+  *usec = (now.tv_sec - start.tv_sec) * 1000000UL
+	  + now.tv_usec - start.tv_usec;
+  if (ret != CMD_SUCCESS)
+    {
+      printf ("loading failed at \"%s\": %d\n", vty->buf, ret);
+      failed++;
+    }
+  return n;
+}
+
+static void
+check_load (int neighbors)
+{
+  struct prefix_list *plist;
+  char name[32];
+  int i;
+
+  for (i = 0; i < neighbors; i++)
+    {
+      snprintf (name, sizeof (name), "PL%d", i);
+      plist = prefix_list_lookup (AFI_IP, name);
+      if (plist == NULL || plist->count != ENTRIES)
+	{
+	  printf ("%s: %d entries, expected %d\n", name,
+		  plist ? plist->count : 0, ENTRIES);
+	  failed++;
+	}
+      snprintf (name, sizeof (name), "RM%d-out", i);
+      if (route_map_lookup_by_name (name) == NULL)
+	{
+	  printf ("%s: missing\n", name);
+	  failed++;
+	}
+    }
+  if (listcount (bm->bgp) != 1
+      || listcount (((struct bgp *) listnode_head (bm->bgp))->peer)
+	 != (unsigned int) neighbors)
+    {
+      printf ("expected one bgp instance with %d neighbors\n", neighbors);
+      failed++;
+    }
+}
+
+int
+main (int argc, char **argv)
+{
+  unsigned long usec;
+  int n;
+
+  master = thread_master_create ();
+  zprivs_init (&bgpd_privs);
+  cmd_init (1);
+  vty_init (master);
+  memory_init ();
+  bgp_master_init ();
+  bgp_option_set (BGP_OPT_NO_FIB);
+  /* Listen where nothing will connect. */
+  bm->port = 0;
+  bm->address = listen_address;
+  bgp_init ();
+  sort_node ();
+
+  vty = vty_new ();
+  vty->type = VTY_TERM;
+
+  if (argc > 1 && strcmp (argv[1], "-b") == 0)
+    {
+      n = load (BENCH_NEIGHBORS, &usec);
+      printf ("loaded %d lines for %d neighbors in %lu usec\n",
+	      n, BENCH_NEIGHBORS, usec);
+      return 0;
+    }
+
+  check_lines ();
+  n = load (NEIGHBORS, &usec);
+  check_load (NEIGHBORS);
+
+  printf ("%d lines loaded\n", n);
+  printf ("failures: %d\n", failed);
+  return failed;
+}
@@ -0,0 +1,164 @@
+/*
+ * Hash table tests.
+ *
+ * This file is part of Quagga.
+ *
+ * Quagga is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2, or (at your option) any
+ * later version.
+ *
+ * Quagga is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Quagga; see the file COPYING.  If not, write to the Free
+ * Software Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ */
+
+/* Random inserts, lookups and releases against a plain array of which
+ * values should be present, with the table growing and shrinking as it
+ * goes, then releases from inside hash_iterate().  Keys only vary in
+ * their high bits, which linear probing would do badly with unmixed.
+ */
+#include <zebra.h>
+
+#include "hash.h"
+#include "memory.h"
+
+#define VALUES 50000
+#define ROUNDS 1000000
+
+struct thread_master *master;
+
+static unsigned int values[VALUES];
+static char present[VALUES];
+static int failed;
+
+static unsigned int
+test_hash_key (void *data)
+{
+  return *(unsigned int *) data << 16;
+}
+
+static int
+test_hash_cmp (const void *a, const void *b)
+{
+  return *(const unsigned int *) a == *(const unsigned int *) b;
+}
+
+static void
+check (struct hash *hash)
+{
+  unsigned long count = 0;
+  int i;
+
+  for (i = 0; i < VALUES; i++)
+    {
+      if ((hash_lookup (hash, &values[i]) != NULL) != present[i])
+	{
+	  printf ("value %d: %s\n", i, present[i] ? "missing" : "not released");
+	  failed++;
+	}
+      count += present[i];
+    }
+  if (count != hash->count)
+    {
+      printf ("count %lu, expected %lu\n", hash->count, count);
+      failed++;
+    }
+}
+
+/* Release every other value it is shown, checking none is shown twice. */
+static void
+release_odd (struct hash_backet *backet, void *arg)
+{
+  struct hash *hash = arg;
+  unsigned int *value = backet->data;
+
+  if (present[*value] != 1)
+    {
+      printf ("value %u iterated over twice\n", *value);
+      failed++;
+    }
+  present[*value] = 2;
+
+  if (*value & 1)
+    {
+      if (hash_release (hash, value) != value)
+	failed++;
+      present[*value] = 0;
+    }
+}
+
+int
+main (void)
+{
+  struct hash *hash;
+  unsigned int size = 0;
+  long r;
+  int i;
+
+  hash = hash_create (test_hash_key, test_hash_cmp, "test");
+  for (i = 0; i < VALUES; i++)
+    values[i] = i;
+
+  srandom (1);
+  for (r = 0; r < ROUNDS; r++)
+    {
+      /* Drift between filling and draining, so the table is resized
+         both ways. */
+      i = random () % VALUES;
+      if ((r / (ROUNDS / 8)) % 2 ? random () % 16 == 0 : random () % 4 != 0)
+	{
+	  if (hash_get (hash, &values[i], hash_alloc_intern) != &values[i])
+	    failed++;
+	  present[i] = 1;
+	}
+      else
+	{
+	  if (hash_release (hash, &values[i]) != (present[i] ? &values[i] : NULL))
+	    failed++;
+	  present[i] = 0;
+	}
+
+      if (hash->size != size)
+	{
+	  size = hash->size;
+	  check (hash);
+	}
+    }
+  check (hash);
+  printf ("%lu resizes, %lu entries in %u slots\n",
+	  hash->resizes, hash->count, hash->size);
+
+  for (i = 0; i < VALUES; i++)
+    if (! present[i])
+      {
+	hash_get (hash, &values[i], hash_alloc_intern);
+	present[i] = 1;
+      }
+  hash_iterate (hash, release_odd, hash);
+  for (i = 0; i < VALUES; i++)
+    {
+      if (present[i] == 2)
+	present[i] = 1;
+      else if (i % 2 == 0)
+	{
+	  printf ("value %d not iterated over\n", i);
+	  failed++;
+	}
+    }
+  check (hash);
+
+  hash_clean (hash, NULL);
+  if (hash->count != 0 || hash->size != HASHTABSIZE)
+    failed++;
+  hash_free (hash);
+
+  printf ("failures: %d\n", failed);
+  return failed;
+}
@@ -0,0 +1,324 @@
+/*
+ * Asynchronous logging tests.
+ *
+ * This file is part of Quagga.
+ *
+ * Quagga is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2, or (at your option) any
+ * later version.
+ *
+ * Quagga is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Quagga; see the file COPYING.  If not, write to the Free
+ * Software Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ */
+
+/* Logs bursts of messages to a file with "log asynchronous block", and
+ * checks that they all reach it, in order and whole.  Then with "log
+ * asynchronous drop" to a pipe which isn't read until the burst is
+ * over, and checks that the burst doesn't wait for it, and that what
+ * found the queue full was dropped, counted and reported.  Checks that
+ * a child logs after fork(), and that closezlog() leaves nothing for
+ * exit() to trip on.  With -b, times logging BENCH_LINES debug lines to
+ * a file synchronously and asynchronously instead.
+ */
+#include <zebra.h>
+#include <pthread.h>
+#include <sys/wait.h>
+
+#include "thread.h"
+#include "command.h"
+#include "vty.h"
+#include "log.h"
+
+#define LINES 10000
+#define LONG_LINE 5000
+#define BENCH_LINES 200000
+
+struct thread_master *master;
+
+static char path[] = "/tmp/testlog.XXXXXX";
+static char last_other[LONG_LINE + 128];
+static int failed;
+
+static void
+reopen (void)
+{
+  zlog_reset_file (NULL);
+  if (truncate (path, 0) < 0)
+    perror ("truncate");
+  zlog_set_file (NULL, path, LOG_DEBUG);
+}
+
+/* Log line I, at a length that varies with it. */
+static void
+log_line (int i)
+{
+  zlog_debug ("line %d %.*s", i, i % 97, "................................"
+	      "................................................................"
+	      "................................");
+}
+
+/* Checks that the file has lines 0 to LAST in order, or only some of
+   them if GAPS, and returns the number of other lines, which are
+   compared to OTHER if given, and the last of which is kept in
+   last_other.  Sets *FOUND to the number of lines. */
+static int
+check_file (int last, int gaps, const char *other, int *found)
+{
+  FILE *fp;
+  char line[LONG_LINE + 128];
+  char *msg;
+  int i = 0, others = 0, n, len;
+
+  *found = 0;
+  fp = fopen (path, "r");
+  while (fgets (line, sizeof (line), fp))
+    {
+      len = strlen (line);
+      if (len == 0 || line[len - 1] != '\n')
+	{
+	  printf ("line %d cut short\n", i);
+	  failed++;
+	  continue;
+	}
+      line[--len] = '\0';
+      msg = strstr (line, "NONE: ");
+      if (msg == NULL)
+	{
+	  printf ("no protocol name: %s\n", line);
+	  failed++;
+	  continue;
+	}
+      msg += strlen ("NONE: ");
+      if (sscanf (msg, "line %d", &n) != 1)
+	{
+	  if (other && strncmp (msg, other, strlen (other)) != 0)
+	    {
+	      printf ("unexpected line: %s\n", msg);
+	      failed++;
+	    }
+	  strcpy (last_other, msg);
+	  others++;
+	  continue;
+	}
+      if (n < i || (n > i && !gaps)
+	  || (int) strlen (msg) != snprintf (NULL, 0, "line %d ", n) + n % 97)
+	{
+	  printf ("line %d where line %d was expected: %s\n", n, i, msg);
+	  failed++;
+	}
+      i = n + 1;
+      (*found)++;
+    }
+  fclose (fp);
+
+  if (!gaps && i != last + 1)
+    {
+      printf ("lines %d to %d missing\n", i, last);
+      failed++;
+    }
+  return others;
+}
+
+static void
+check_block (void)
+{
+  static char long_line[LONG_LINE + 1];
+  int i, found;
+
+  reopen ();
+  zlog_set_async (NULL, ZLOG_ASYNC_BLOCK);
+  for (i = 0; i < LINES; i++)
+    log_line (i);
+  memset (long_line, 'x', LONG_LINE);
+  zlog_debug ("%s", long_line);
+
+  /* The burst overflowed the queue several times, but nothing is
+     lost. */
+  zlog_flush (NULL);
+  if (check_file (LINES - 1, 0, long_line, &found) != 1)
+    {
+      printf ("long line missing\n");
+      failed++;
+    }
+}
+
+/* Copies what comes down the pipe to the file. */
+static void *
+drain (void *arg)
+{
+  int in = *(int *) arg;
+  int out;
+  char buf[4096];
+  ssize_t n;
+
+  out = open (path, O_WRONLY | O_TRUNC);
+  while ((n = read (in, buf, sizeof (buf))) > 0)
+    if (write (out, buf, n) != n)
+      break;
+  close (out);
+  return NULL;
+}
+
+static void
+check_drop (void)
+{
+  char fifo[sizeof (path) + 8];
+  pthread_t reader;
+  unsigned long reported;
+  int fd, i, found;
+
+  snprintf (fifo, sizeof (fifo), "%s.fifo", path);
+  if (mkfifo (fifo, 0600) < 0
+      || (fd = open (fifo, O_RDONLY | O_NONBLOCK)) < 0)
+    {
+      perror ("fifo");
+      failed++;
+      return;
+    }
+  zlog_set_file (NULL, fifo, LOG_DEBUG);
+  fcntl (fd, F_SETFL, 0);
+  zlog_set_async (NULL, ZLOG_ASYNC_DROP);
+
+  /* Nothing reads the pipe, and the writer is stuck on it once it is
+     full: the burst goes on without it, dropping what doesn't fit. */
+  for (i = 0; i < LINES; i++)
+    log_line (i);
+  if (zlog_default->dropped == 0)
+    {
+      printf ("nothing dropped\n");
+      failed++;
+    }
+
+  /* Once the pipe is read, the next line finds room, after the count
+     of those dropped. */
+  pthread_create (&reader, NULL, drain, &fd);
+  zlog_flush (NULL);
+  log_line (LINES);
+  zlog_reset_file (NULL);
+  pthread_join (reader, NULL);
+  close (fd);
+  unlink (fifo);
+
+  /* The writer may have made room during the burst too. */
+  if (check_file (LINES, 1, "Log queue full", &found) < 1
+      || sscanf (last_other, "Log queue full, %lu", &reported) != 1
+      || reported != zlog_default->dropped)
+    {
+      printf ("drops not reported\n");
+      failed++;
+    }
+  if (found + zlog_default->dropped != LINES + 1)
+    {
+      printf ("%d lines written, %lu dropped, of %d\n",
+	      found, zlog_default->dropped, LINES + 1);
+      failed++;
+    }
+
+  zlog_set_async (NULL, ZLOG_ASYNC_OFF);
+  printf ("%lu of %d lines dropped\n", zlog_default->dropped, LINES + 1);
+}
+
+/* The child has no writer until it logs, and the lines queued before
+   fork() are written once. */
+static void
+check_fork (void)
+{
+  pid_t pid;
+  int status, found;
+
+  reopen ();
+  zlog_set_async (NULL, ZLOG_ASYNC_BLOCK);
+  for (pid = 0; pid < 100; pid++)
+    log_line (pid);
+  if ((pid = fork ()) == 0)
+    {
+      log_line (100);
+      zlog_flush (NULL);
+      _exit (0);
+    }
+  waitpid (pid, &status, 0);
+  log_line (101);
+  zlog_set_async (NULL, ZLOG_ASYNC_OFF);
+  check_file (101, 0, NULL, &found);
+}
+
+static unsigned long
+usec_since (struct timeval *start)
+{
+  struct timeval now;
+
+  quagga_gettime (QUAGGA_CLK_MONOTONIC, &now);
+  return (now.tv_sec - start->tv_sec) * 1000000UL
+	 + now.tv_usec - start->tv_usec;
+}
+
+static void
+bench (zlog_async_t policy)
+{
+  struct timeval start;
+  unsigned long logged;
+  int i;
+
+  reopen ();
+  zlog_set_async (NULL, policy);
+  quagga_gettime (QUAGGA_CLK_MONOTONIC, &start);
+  for (i = 0; i < BENCH_LINES; i++)
+    log_line (i);
+  logged = usec_since (&start);
+  zlog_flush (NULL);
+  printf ("%s: %d lines logged in %lu usec, written in %lu usec\n",
+	  policy == ZLOG_ASYNC_OFF ? "sync" : "async", BENCH_LINES,
+	  logged, usec_since (&start));
+  zlog_set_async (NULL, ZLOG_ASYNC_OFF);
+}
+
+int
+main (int argc, char **argv)
+{
+  int fd;
+
+  master = thread_master_create ();
+  zlog_default = openzlog ("testlog", ZLOG_NONE, 0, LOG_DAEMON);
+  cmd_init (1);
+  vty_init (master);
+
+  if ((fd = mkstemp (path)) < 0)
+    {
+      perror ("mkstemp");
+      return 1;
+    }
+  close (fd);
+
+  if (argc > 1 && strcmp (argv[1], "-b") == 0)
+    {
+      bench (ZLOG_ASYNC_OFF);
+      bench (ZLOG_ASYNC_BLOCK);
+      unlink (path);
+      return 0;
+    }
+
+  check_block ();
+  check_drop ();
+  check_fork ();
+  unlink (path);
+
+  /* As the daemons do on their way out. */
+  zlog_set_async (NULL, ZLOG_ASYNC_BLOCK);
+  closezlog (zlog_default);
+  if (zlog_default != NULL)
+    {
+      printf ("zlog_default left behind\n");
+      failed++;
+    }
+
+  printf ("failures: %d\n", failed);
+  return failed;
+}
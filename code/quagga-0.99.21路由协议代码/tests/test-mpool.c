@@ -0,0 +1,361 @@
+/*
+ * Slab pool tests.
+ *
+ * This file is part of Quagga.
+ *
+ * Quagga is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2, or (at your option) any
+ * later version.
+ *
+ * Quagga is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Quagga; see the file COPYING.  If not, write to the Free
+ * Software Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ */
+
+/* Loads a route table and checks that its nodes fill the slabs of their
+ * pool, then tears it down and checks that the slabs went back to the
+ * system.  Frees every other stream of a batch and checks that the holes
+ * are reused, allocates pooled types at other sizes, and checks that
+ * "show memory" reports the pools.  With -b, times the load and
+ * teardown of a BGP table of BENCH_ROUTES routes, each with its node,
+ * attribute and adj-in, instead.
+ */
+#include <zebra.h>
+
+#include "command.h"
+#include "vty.h"
+#include "buffer.h"
+#include "memory.h"
+#include "thread.h"
+#include "privs.h"
+#include "stream.h"
+#include "prefix.h"
+#include "table.h"
+
+#include "bgpd/bgpd.h"
+#include "bgpd/bgp_table.h"
+#include "bgpd/bgp_attr.h"
+#include "bgpd/bgp_route.h"
+#include "bgpd/bgp_advertise.h"
+
+#define ROUTES 100000
+#define STREAMS 10000
+#define BENCH_ROUTES 1000000
+
+struct thread_master *master;
+struct zebra_privs_t bgpd_privs =
+{
+  .user = NULL,
+  .group = NULL,
+  .vty_group = NULL,
+};
+
+static int failed;
+
+static void
+stats (int type, struct mtype_pool_stats *st)
+{
+  if (! mtype_pool_stats (type, st))
+    {
+      printf ("type %d has no pool\n", type);
+      failed++;
+      memset (st, 0, sizeof (*st));
+    }
+}
+
+static void
+prefix_of (unsigned int i, struct prefix_ipv4 *p)
+{
+  memset (p, 0, sizeof (struct prefix_ipv4));
+  p->family = AF_INET;
+  p->prefixlen = 32;
+  p->prefix.s_addr = htonl (0x0a000000 | i);
+}
+
+static void
+check_table (void)
+{
+  struct route_table *table;
+  struct route_node *rn;
+  struct prefix_ipv4 p;
+  struct mtype_pool_stats st, before;
+  unsigned long slabs;
+  unsigned int i;
+
+  stats (MTYPE_ROUTE_NODE, &before);
+  table = route_table_init ();
+  for (i = 0; i < ROUTES; i++)
+    {
+      prefix_of (i, &p);
+      rn = route_node_get (table, (struct prefix *) &p);
+      rn->info = table;
+    }
+
+  /* The nodes, with those joining them, fill all but the last slab. */
+  stats (MTYPE_ROUTE_NODE, &st);
+  if (st.used != mtype_stats_alloc (MTYPE_ROUTE_NODE)
+      || st.used < ROUTES || st.large != 0
+      || st.free >= (st.used + st.free) / st.slabs + before.free)
+    {
+      printf ("loaded: %lu nodes in %lu slabs, %lu free\n",
+	      st.used, st.slabs, st.free);
+      failed++;
+    }
+  slabs = st.slabs;
+  for (i = 0; i < ROUTES; i++)
+    {
+      prefix_of (i, &p);
+      rn = route_node_lookup (table, (struct prefix *) &p);
+      if (rn == NULL || rn->info != table)
+	{
+	  printf ("route %u lost\n", i);
+	  failed++;
+	  break;
+	}
+      route_unlock_node (rn);
+    }
+
+  /* Torn down, the slabs but one go back to the system. */
+  route_table_finish (table);
+  stats (MTYPE_ROUTE_NODE, &st);
+  if (st.used != 0 || st.slabs > 1
+      || st.released - before.released + 1 < slabs)
+    {
+      printf ("torn down: %lu nodes in %lu slabs, %lu released\n",
+	      st.used, st.slabs, st.released);
+      failed++;
+    }
+  printf ("route nodes: %lu hits, %lu misses, %lu slabs released\n",
+	  st.hits, st.misses, st.released);
+}
+
+static void
+check_reuse (void)
+{
+  static struct stream *s[STREAMS];
+  struct mtype_pool_stats st, loaded;
+  unsigned int i;
+
+  for (i = 0; i < STREAMS; i++)
+    {
+      s[i] = stream_new (16);
+      stream_putl (s[i], i);
+    }
+  stats (MTYPE_STREAM, &loaded);
+
+  /* Half free, the slabs stay, and take the next batch. */
+  for (i = 0; i < STREAMS; i += 2)
+    stream_free (s[i]);
+  stats (MTYPE_STREAM, &st);
+  if (st.slabs != loaded.slabs || st.free != loaded.free + STREAMS / 2)
+    {
+      printf ("half freed: %lu slabs, %lu free, expected %lu, %lu\n",
+	      st.slabs, st.free, loaded.slabs, loaded.free + STREAMS / 2);
+      failed++;
+    }
+  for (i = 0; i < STREAMS; i += 2)
+    {
+      s[i] = stream_new (16);
+      stream_putl (s[i], i);
+    }
+  stats (MTYPE_STREAM, &st);
+  if (st.slabs != loaded.slabs || st.misses != loaded.misses)
+    {
+      printf ("refilled: %lu slabs, %lu misses, expected %lu, %lu\n",
+	      st.slabs, st.misses, loaded.slabs, loaded.misses);
+      failed++;
+    }
+
+  for (i = 0; i < STREAMS; i++)
+    {
+      if (stream_getl_from (s[i], 0) != i)
+	{
+	  printf ("stream %u overwritten\n", i);
+	  failed++;
+	}
+      stream_free (s[i]);
+    }
+  stats (MTYPE_STREAM, &st);
+  if (st.used != 0 || st.slabs > 1)
+    {
+      printf ("freed: %lu streams in %lu slabs\n", st.used, st.slabs);
+      failed++;
+    }
+}
+
+/* A pool serves smaller allocations in its slots, larger ones in slabs
+   of their own, and moves what is reallocated larger. */
+static void
+check_sizes (void)
+{
+  struct mtype_pool_stats st;
+  char *a, *b, *c;
+
+  a = XMALLOC (MTYPE_BGP_ADVERTISE, 40);
+  memset (a, 'a', 40);
+  b = XSTRDUP (MTYPE_BGP_ADVERTISE, "short");
+  c = XCALLOC (MTYPE_BGP_ADVERTISE, 100000);
+  stats (MTYPE_BGP_ADVERTISE, &st);
+  if (st.size != 48 || st.used != 2 || st.large != 1
+      || strcmp (b, "short") != 0 || c[99999] != 0)
+    {
+      printf ("sizes: %lu bytes, %lu used, %lu large\n",
+	      (unsigned long) st.size, st.used, st.large);
+      failed++;
+    }
+
+  b = XREALLOC (MTYPE_BGP_ADVERTISE, b, 8);
+  a = XREALLOC (MTYPE_BGP_ADVERTISE, a, 1000);
+  a[999] = 0;
+  stats (MTYPE_BGP_ADVERTISE, &st);
+  if (strspn (a, "a") != 40 || strcmp (b, "short") != 0
+      || st.used != 1 || st.large != 2)
+    {
+      printf ("realloc: %lu used, %lu large\n", st.used, st.large);
+      failed++;
+    }
+
+  XFREE (MTYPE_BGP_ADVERTISE, a);
+  XFREE (MTYPE_BGP_ADVERTISE, b);
+  XFREE (MTYPE_BGP_ADVERTISE, c);
+  stats (MTYPE_BGP_ADVERTISE, &st);
+  if (st.used != 0 || st.large != 0
+      || mtype_stats_alloc (MTYPE_BGP_ADVERTISE) != 0)
+    {
+      printf ("freed: %lu used, %lu large\n", st.used, st.large);
+      failed++;
+    }
+}
+
+static void
+check_show (void)
+{
+  struct vty *vty;
+  struct stream *s;
+  vector vline;
+  char *out, *pools, *end;
+
+  s = stream_new (16);
+  vty = vty_new ();
+  vty->type = VTY_TERM;
+  vty->node = ENABLE_NODE;
+  vline = cmd_make_strvec ("show memory");
+  if (cmd_execute_command (vline, vty, NULL, 1) != CMD_SUCCESS)
+    {
+      printf ("show memory failed\n");
+      failed++;
+    }
+  cmd_free_strvec (vline);
+
+  /* The pools come before the separator which ends their section. */
+  out = buffer_getstr (vty->obuf);
+  if ((pools = strstr (out, "Slab pools:")) == NULL
+      || (end = strstr (pools, "-----")) == NULL
+      || (*end = '\0', strstr (pools, "\nStream ")) == NULL)
+    {
+      printf ("pools not shown:\n%s", out);
+      failed++;
+    }
+  XFREE (MTYPE_TMP, out);
+  stream_free (s);
+}
+
+static unsigned long
+usec_since (struct timeval *start)
+{
+  struct timeval now;
+
+  quagga_gettime (QUAGGA_CLK_MONOTONIC, &now);
+  return (now.tv_sec - start->tv_sec) * 1000000UL
+	 + now.tv_usec - start->tv_usec;
+}
+
+/* What bgpd keeps of a route learned from a peer. */
+static void
+benchmark (void)
+{
+  struct bgp_table *table;
+  struct bgp_node *rn;
+  struct bgp_info *ri;
+  struct bgp_adj_in *ain;
+  struct attr attr, *interned;
+  struct prefix_ipv4 p;
+  struct timeval start;
+  unsigned int i;
+
+  bgp_attr_init ();
+  table = bgp_table_init (AFI_IP, SAFI_UNICAST);
+
+  quagga_gettime (QUAGGA_CLK_MONOTONIC, &start);
+  for (i = 0; i < BENCH_ROUTES; i++)
+    {
+      prefix_of (i, &p);
+      rn = bgp_node_get (table, (struct prefix *) &p);
+
+      memset (&attr, 0, sizeof (attr));
+      attr.origin = BGP_ORIGIN_IGP;
+      attr.med = i;
+      attr.flag = ATTR_FLAG_BIT (BGP_ATTR_ORIGIN)
+		  | ATTR_FLAG_BIT (BGP_ATTR_MULTI_EXIT_DISC);
+      interned = bgp_attr_intern (&attr);
+
+      ain = XCALLOC (MTYPE_BGP_ADJ_IN, sizeof (struct bgp_adj_in));
+      ain->attr = bgp_attr_intern (interned);
+      rn->adj_in = ain;
+
+      ri = XCALLOC (MTYPE_BGP_ROUTE, sizeof (struct bgp_info));
+      ri->attr = interned;
+      rn->info = ri;
+    }
+  printf ("loaded %d routes in %lu usec\n", BENCH_ROUTES, usec_since (&start));
+
+  quagga_gettime (QUAGGA_CLK_MONOTONIC, &start);
+  for (rn = bgp_table_top (table); rn; rn = bgp_route_next (rn))
+    {
+      if ((ri = rn->info) != NULL)
+	{
+	  bgp_attr_unintern (&ri->attr);
+	  XFREE (MTYPE_BGP_ROUTE, ri);
+	  rn->info = NULL;
+	}
+      if ((ain = rn->adj_in) != NULL)
+	{
+	  bgp_attr_unintern (&ain->attr);
+	  XFREE (MTYPE_BGP_ADJ_IN, ain);
+	  rn->adj_in = NULL;
+	}
+    }
+  bgp_table_finish (&table);
+  printf ("tore down %d routes in %lu usec\n", BENCH_ROUTES,
+	  usec_since (&start));
+}
+
+int
+main (int argc, char **argv)
+{
+  master = thread_master_create ();
+  cmd_init (1);
+  vty_init (master);
+  memory_init ();
+
+  if (argc > 1 && strcmp (argv[1], "-b") == 0)
+    {
+      benchmark ();
+      return 0;
+    }
+
+  check_table ();
+  check_reuse ();
+  check_sizes ();
+  check_show ();
+
+  printf ("failures: %d\n", failed);
+  return failed;
+}
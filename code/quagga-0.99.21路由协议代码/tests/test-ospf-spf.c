@@ -0,0 +1,648 @@
+/*
+ * OSPF SPF calculation tests.
+ *
+ * This file is part of Quagga.
+ *
+ * Quagga is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2, or (at your option) any
+ * later version.
+ *
+ * Quagga is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Quagga; see the file COPYING.  If not, write to the Free
+ * Software Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ */
+
+/* Builds a random backbone around the calculating router: point-to-point
+ * links, one broadcast network, stub networks and summaries.  Changes
+ * its LSAs the way the other routers would, installing them as ospfd
+ * does, and after each batch of changes runs the calculation ospfd
+ * scheduled (partial, incremental or full), then a full one, and checks
+ * that both gave the same routing tables.  The seed is the argument.
+ */
+#include <zebra.h>
+
+#include "thread.h"
+#include "memory.h"
+#include "linklist.h"
+#include "prefix.h"
+#include "if.h"
+#include "table.h"
+#include "privs.h"
+#include "zclient.h"
+
+#include "ospfd/ospfd.h"
+#include "ospfd/ospf_interface.h"
+#include "ospfd/ospf_asbr.h"
+#include "ospfd/ospf_lsa.h"
+#include "ospfd/ospf_lsdb.h"
+#include "ospfd/ospf_spf.h"
+#include "ospfd/ospf_route.h"
+#include "ospfd/ospf_opaque.h"
+
+#define ROUTERS 48
+#define SUMMARIES 16
+#define ROUNDS 1000
+
+/* Router 0 does the calculation, router 1 is the network's DR. */
+#define ROOT_ROUTER 0
+#define DR_ROUTER 1
+
+struct thread_master *master;
+struct zebra_privs_t ospfd_privs =
+{
+  .user = NULL,
+  .group = NULL,
+  .vty_group = NULL,
+};
+
+static struct ospf *ospf;
+static struct ospf_area *area;
+static struct ospf_interface *oi_net;
+static u_int32_t seqnum = OSPF_INITIAL_SEQUENCE_NUMBER;
+
+/* The LSAs' contents: metric[i][j] is that of the link from router i
+   to router j, or 0. */
+static u_int16_t metric[ROUTERS][ROUTERS];
+static u_int16_t stub[ROUTERS];
+static u_int16_t net_metric[ROUTERS];
+static int on_net[ROUTERS];
+static int border[ROUTERS];
+static int alive[ROUTERS];
+static int advertised[ROUTERS];
+static u_int32_t summary[SUMMARIES];
+static int summary_advertised[SUMMARIES];
+
+static int failed;
+
+static struct in_addr
+addr (u_int32_t a)
+{
+  struct in_addr in;
+
+  in.s_addr = htonl (a);
+  return in;
+}
+
+static struct in_addr
+router_id (int i)
+{
+  return addr (0x0aff0000 | (i + 1));
+}
+
+/* The subnet of the link between routers i and j, and i's address on
+   it. */
+static u_int32_t
+link_net (int i, int j)
+{
+  return 0x0a000000 | ((MIN (i, j) + 1) << 16) | ((MAX (i, j) + 1) << 8);
+}
+
+static struct in_addr
+link_addr (int i, int j)
+{
+  return addr (link_net (i, j) | (i < j ? 1 : 2));
+}
+
+static struct in_addr
+net_addr (int i)
+{
+  return addr (0xac100000 | (i + 1));
+}
+
+static int
+summary_abr (int k)
+{
+  return (k * 8 + 3) % ROUTERS;
+}
+
+static struct ospf_lsa *
+lsa_new (u_char type, struct in_addr id, int adv, size_t length)
+{
+  struct ospf_lsa *lsa;
+
+  lsa = ospf_lsa_new ();
+  lsa->data = ospf_lsa_data_new (length);
+  lsa->data->options = OSPF_OPTION_E;
+  lsa->data->type = type;
+  lsa->data->id = id;
+  lsa->data->adv_router = router_id (adv);
+  lsa->data->ls_seqnum = htonl (seqnum++);
+  lsa->data->length = htons (length);
+  lsa->area = area;
+  if (adv == ROOT_ROUTER)
+    SET_FLAG (lsa->flags, OSPF_LSA_SELF);
+  return lsa;
+}
+
+static void
+lsa_install (struct ospf_lsa *lsa, int withdraw)
+{
+  if (withdraw)
+    lsa->data->ls_age = htons (OSPF_LSA_MAXAGE);
+  ospf_lsa_checksum (lsa->data);
+  ospf_lsa_install (ospf, oi_net, lsa);
+}
+
+static void
+router_link (struct router_lsa *rl, struct in_addr id, struct in_addr data,
+             u_char type, u_int16_t cost)
+{
+  int n = ntohs (rl->links);
+
+  rl->link[n].link_id = id;
+  rl->link[n].link_data = data;
+  rl->link[n].type = type;
+  rl->link[n].metric = htons (cost);
+  rl->links = htons (n + 1);
+}
+
+static void
+originate_router (int i)
+{
+  struct ospf_lsa *lsa;
+  struct router_lsa *rl;
+  int j, links = 0;
+
+  if (! alive[i] && ! advertised[i])
+    return;
+
+  for (j = 0; j < ROUTERS; j++)
+    if (metric[i][j])
+      links += 2;
+  links += on_net[i] + (stub[i] != 0);
+
+  lsa = lsa_new (OSPF_ROUTER_LSA, router_id (i), i,
+                 OSPF_LSA_HEADER_SIZE + 4 + links * OSPF_ROUTER_LSA_LINK_SIZE);
+  rl = (struct router_lsa *) lsa->data;
+  rl->flags = border[i] ? ROUTER_LSA_BORDER : 0;
+
+  for (j = 0; j < ROUTERS; j++)
+    if (metric[i][j])
+      {
+        router_link (rl, router_id (j), link_addr (i, j),
+                     LSA_LINK_TYPE_POINTOPOINT, metric[i][j]);
+        router_link (rl, addr (link_net (i, j)), addr (0xffffff00),
+                     LSA_LINK_TYPE_STUB, metric[i][j]);
+      }
+  if (on_net[i])
+    router_link (rl, net_addr (DR_ROUTER), net_addr (i), LSA_LINK_TYPE_TRANSIT,
+                 net_metric[i]);
+  if (stub[i])
+    router_link (rl, addr (0xc0a80000 | ((i + 1) << 8)), addr (0xffffff00),
+                 LSA_LINK_TYPE_STUB, stub[i]);
+
+  advertised[i] = alive[i];
+  lsa_install (lsa, ! alive[i]);
+}
+
+static void
+originate_network (void)
+{
+  struct ospf_lsa *lsa;
+  struct network_lsa *nl;
+  int i, n = 0;
+
+  for (i = 0; i < ROUTERS; i++)
+    n += on_net[i];
+
+  lsa = lsa_new (OSPF_NETWORK_LSA, net_addr (DR_ROUTER), DR_ROUTER,
+                 OSPF_LSA_HEADER_SIZE + 4 + n * 4);
+  nl = (struct network_lsa *) lsa->data;
+  nl->mask = addr (0xffffff00);
+  for (i = 0, n = 0; i < ROUTERS; i++)
+    if (on_net[i])
+      nl->routers[n++] = router_id (i);
+
+  lsa_install (lsa, 0);
+}
+
+static void
+originate_summary (int k)
+{
+  struct ospf_lsa *lsa;
+  struct summary_lsa *sl;
+
+  if (! summary[k] && ! summary_advertised[k])
+    return;
+
+  lsa = lsa_new (OSPF_SUMMARY_LSA, addr (0x0ac80000 | (k << 8)),
+                 summary_abr (k), OSPF_LSA_HEADER_SIZE + 8);
+  sl = (struct summary_lsa *) lsa->data;
+  sl->mask = addr (0xffffff00);
+  sl->metric[0] = (summary[k] >> 16) & 0xff;
+  sl->metric[1] = (summary[k] >> 8) & 0xff;
+  sl->metric[2] = summary[k] & 0xff;
+
+  summary_advertised[k] = (summary[k] != 0);
+  lsa_install (lsa, summary[k] == 0);
+}
+
+static u_int16_t
+random_metric (void)
+{
+  return 1 + random () % 10;
+}
+
+/* A router other than the root and the DR, which stay. */
+static int
+random_router (void)
+{
+  return 2 + random () % (ROUTERS - 2);
+}
+
+static void
+change (void)
+{
+  int i, j, k;
+
+  switch (random () % 8)
+    {
+    case 0:
+    case 1:
+      /* A link gets dearer or cheaper. */
+      for (k = 0; k < 100; k++)
+        {
+          i = random () % ROUTERS;
+          j = random () % ROUTERS;
+          if (metric[i][j])
+            {
+              metric[i][j] = random_metric ();
+              originate_router (i);
+              break;
+            }
+        }
+      break;
+    case 2:
+      /* A link goes down, or comes up. */
+      i = random () % ROUTERS;
+      j = random () % ROUTERS;
+      if (i == j)
+        break;
+      if (metric[i][j] || metric[j][i])
+        metric[i][j] = metric[j][i] = 0;
+      else
+        {
+          metric[i][j] = random_metric ();
+          metric[j][i] = random_metric ();
+        }
+      originate_router (i);
+      originate_router (j);
+      break;
+    case 3:
+      /* A stub network changes. */
+      i = random () % ROUTERS;
+      stub[i] = (random () % 4) ? random_metric () : 0;
+      originate_router (i);
+      break;
+    case 4:
+      /* A router goes away, or comes back. */
+      i = random_router ();
+      alive[i] = ! alive[i];
+      originate_router (i);
+      break;
+    case 5:
+      /* A router joins or leaves the network. */
+      i = random_router ();
+      on_net[i] = ! on_net[i];
+      net_metric[i] = random_metric ();
+      if (random () % 2)
+        {
+          originate_router (i);
+          originate_network ();
+        }
+      else
+        {
+          originate_network ();
+          originate_router (i);
+        }
+      break;
+    case 6:
+      /* A summary changes, goes away or comes back. */
+      k = random () % SUMMARIES;
+      summary[k] = (random () % 4) ? random_metric () : 0;
+      originate_summary (k);
+      break;
+    case 7:
+      /* A router becomes an ABR, or stops being one. */
+      i = random_router ();
+      border[i] = ! border[i];
+      originate_router (i);
+      break;
+    }
+}
+
+/* Run the calculation scheduled, as the timer would, and return its
+   kind. */
+static int
+run_spf (void)
+{
+  struct thread *t = ospf->t_spf_calc;
+  int (*func) (struct thread *);
+  unsigned long runs[OSPF_SPF_KIND_MAX];
+  int kind;
+
+  if (t == NULL)
+    return OSPF_SPF_NONE;
+
+  for (kind = 0; kind < OSPF_SPF_KIND_MAX; kind++)
+    runs[kind] = ospf->spf_stats[kind].runs;
+
+  func = t->func;
+  thread_cancel (t);
+  ospf->t_spf_calc = NULL;
+  thread_execute (master, func, ospf, 0);
+
+  for (kind = 0; kind < OSPF_SPF_KIND_MAX; kind++)
+    if (ospf->spf_stats[kind].runs != runs[kind])
+      return kind;
+  return OSPF_SPF_NONE;
+}
+
+static int
+same_paths (struct list *a, struct list *b)
+{
+  struct listnode *node, *bnode;
+  struct ospf_path *path, *bpath;
+
+  if (listcount (a) != listcount (b))
+    return 0;
+
+  for (ALL_LIST_ELEMENTS_RO (a, node, path))
+    {
+      for (ALL_LIST_ELEMENTS_RO (b, bnode, bpath))
+        if (IPV4_ADDR_SAME (&path->nexthop, &bpath->nexthop)
+            && IPV4_ADDR_SAME (&path->adv_router, &bpath->adv_router)
+            && path->ifindex == bpath->ifindex)
+          break;
+      if (bnode == NULL)
+        return 0;
+    }
+  return 1;
+}
+
+/* A network's ID is only that of the first of the routers reaching it
+   at its cost to be looked at, which the order of the vertices at the
+   same distance decides. */
+static int
+same_route (struct ospf_route *a, struct ospf_route *b)
+{
+  return a->type == b->type
+         && a->path_type == b->path_type
+         && a->cost == b->cost
+         && (a->type == OSPF_DESTINATION_NETWORK
+             || IPV4_ADDR_SAME (&a->id, &b->id))
+         && IPV4_ADDR_SAME (&a->u.std.area_id, &b->u.std.area_id)
+         && a->u.std.flags == b->u.std.flags
+         && a->u.std.origin == b->u.std.origin
+         && same_paths (a->paths, b->paths);
+}
+
+static void
+mismatch (int round, const char *what, struct prefix *p)
+{
+  char buf[BUFSIZ];
+
+  prefix2str (p, buf, sizeof (buf));
+  printf ("round %d: %s route to %s differs from a full calculation\n",
+          round, what, buf);
+  failed++;
+}
+
+static unsigned long
+compare_networks (int round, struct route_table *got,
+                  struct route_table *want)
+{
+  struct route_node *rn, *gn;
+  unsigned long count = 0;
+
+  for (rn = route_top (want); rn; rn = route_next (rn))
+    if (rn->info)
+      {
+        gn = route_node_lookup (got, &rn->p);
+        if (gn == NULL || gn->info == NULL
+            || ! same_route (gn->info, rn->info))
+          mismatch (round, "network", &rn->p);
+        if (gn)
+          route_unlock_node (gn);
+        count++;
+      }
+  for (rn = route_top (got); rn; rn = route_next (rn))
+    if (rn->info)
+      {
+        gn = route_node_lookup (want, &rn->p);
+        if (gn == NULL || gn->info == NULL)
+          mismatch (round, "extra network", &rn->p);
+        if (gn)
+          route_unlock_node (gn);
+      }
+  return count;
+}
+
+static int
+same_routers (struct list *a, struct list *b)
+{
+  struct listnode *node, *bnode;
+  struct ospf_route *or, *bor;
+
+  if (listcount (a) != listcount (b))
+    return 0;
+
+  for (ALL_LIST_ELEMENTS_RO (a, node, or))
+    {
+      for (ALL_LIST_ELEMENTS_RO (b, bnode, bor))
+        if (same_route (or, bor))
+          break;
+      if (bnode == NULL)
+        return 0;
+    }
+  return 1;
+}
+
+static void
+compare_routers (int round, struct route_table *got, struct route_table *want)
+{
+  struct route_node *rn, *gn;
+
+  for (rn = route_top (want); rn; rn = route_next (rn))
+    if (rn->info)
+      {
+        gn = route_node_lookup (got, &rn->p);
+        if (gn == NULL || gn->info == NULL
+            || ! same_routers (gn->info, rn->info))
+          mismatch (round, "router", &rn->p);
+        if (gn)
+          route_unlock_node (gn);
+      }
+  for (rn = route_top (got); rn; rn = route_next (rn))
+    if (rn->info)
+      {
+        gn = route_node_lookup (want, &rn->p);
+        if (gn == NULL || gn->info == NULL)
+          mismatch (round, "extra router", &rn->p);
+        if (gn)
+          route_unlock_node (gn);
+      }
+}
+
+static void
+root_interface (const char *name, unsigned int ifindex, struct in_addr address,
+                int type)
+{
+  struct interface *ifp;
+  struct connected *c;
+  struct prefix_ipv4 *p;
+  struct ospf_interface *oi;
+
+  ifp = if_get_by_name (name);
+  ifp->ifindex = ifindex;
+
+  p = prefix_ipv4_new ();
+  p->family = AF_INET;
+  p->prefix = address;
+  p->prefixlen = 24;
+
+  c = connected_new ();
+  c->ifp = ifp;
+  c->address = (struct prefix *) p;
+  listnode_add (ifp->connected, c);
+
+  oi = ospf_if_new (ospf, ifp, (struct prefix *) p);
+  oi->connected = c;
+  oi->type = type;
+  oi->area = area;
+  if (type == OSPF_IFTYPE_BROADCAST)
+    oi_net = oi;
+}
+
+/* What ospf_new() sets up, without the socket and the timers. */
+static void
+setup (void)
+{
+  char name[INTERFACE_NAMSIZ];
+  int i, j;
+
+  ospf = XCALLOC (MTYPE_OSPF_TOP, sizeof (struct ospf));
+  ospf->router_id = router_id (ROOT_ROUTER);
+  ospf->abr_type = OSPF_ABR_DEFAULT;
+  ospf->oiflist = list_new ();
+  ospf->vlinks = list_new ();
+  ospf->areas = list_new ();
+  ospf->networks = route_table_init ();
+  ospf->nbr_nbma = route_table_init ();
+  ospf->lsdb = ospf_lsdb_new ();
+  ospf->new_external_route = route_table_init ();
+  ospf->old_external_route = route_table_init ();
+  ospf->external_lsas = route_table_init ();
+  ospf->distance_table = route_table_init ();
+  ospf->maxage_lsa = list_new ();
+  ospf->maxage_delay = OSFP_LSA_MAXAGE_REMOVE_DELAY_DEFAULT;
+  ospf->lsa_refresh_interval = OSPF_LSA_REFRESH_INTERVAL_DEFAULT;
+  ospf->lsa_refresher_started = quagga_time (NULL);
+  ospf->spf_delay = OSPF_SPF_DELAY_DEFAULT;
+  ospf->spf_holdtime = OSPF_SPF_HOLDTIME_DEFAULT;
+  ospf->spf_max_holdtime = OSPF_SPF_MAX_HOLDTIME_DEFAULT;
+  ospf->spf_hold_multiplier = 1;
+  ospf->oi_write_q = list_new ();
+  listnode_add (om->ospf, ospf);
+
+  area = ospf_area_get (ospf, addr (0), OSPF_AREA_ID_FORMAT_ADDRESS);
+
+  /* An interface for every link the root may have. */
+  for (j = 1; j < ROUTERS; j++)
+    {
+      snprintf (name, sizeof (name), "ptmp%d", j);
+      root_interface (name, j, link_addr (ROOT_ROUTER, j),
+                      OSPF_IFTYPE_POINTOMULTIPOINT);
+    }
+  root_interface ("lan", ROUTERS, net_addr (ROOT_ROUTER), OSPF_IFTYPE_BROADCAST);
+
+  /* A ring, with chords. */
+  for (i = 0; i < ROUTERS; i++)
+    {
+      j = (i + 1) % ROUTERS;
+      metric[i][j] = random_metric ();
+      metric[j][i] = random_metric ();
+      j = random () % ROUTERS;
+      if (i != j)
+        {
+          metric[i][j] = random_metric ();
+          metric[j][i] = random_metric ();
+        }
+      alive[i] = 1;
+      border[i] = (i % 8 == 3);
+      stub[i] = (i % 3) ? random_metric () : 0;
+      on_net[i] = (i == ROOT_ROUTER || i == DR_ROUTER || random () % 4 == 0);
+      net_metric[i] = random_metric ();
+    }
+  for (i = 0; i < SUMMARIES; i++)
+    summary[i] = random_metric ();
+
+  for (i = 0; i < ROUTERS; i++)
+    originate_router (i);
+  originate_network ();
+  for (i = 0; i < SUMMARIES; i++)
+    originate_summary (i);
+}
+
+int
+main (int argc, char **argv)
+{
+  unsigned long done[OSPF_SPF_KIND_MAX] = { 0 };
+  unsigned long routes = 0;
+  int round, n, kind;
+
+  srandom (argc > 1 ? atoi (argv[1]) : 1);
+
+  ospf_master_init ();
+  master = om->master;
+  ospf_if_init ();
+  ospf_opaque_init ();
+  zclient = zclient_new ();
+
+  setup ();
+  ospf_spf_calculate_schedule (ospf);
+  run_spf ();
+
+  for (round = 0; round < ROUNDS; round++)
+    {
+      for (n = 1 + random () % 3; n > 0; n--)
+        change ();
+
+      kind = run_spf ();
+      done[kind]++;
+      if (kind == OSPF_SPF_NONE)
+        continue;
+
+      /* The tables just calculated become the old ones. */
+      ospf_spf_calculate_schedule (ospf);
+      if (run_spf () != OSPF_SPF_FULL)
+        {
+          printf ("round %d: full calculation not done\n", round);
+          failed++;
+          continue;
+        }
+      routes += compare_networks (round, ospf->old_table, ospf->new_table);
+      compare_routers (round, ospf->old_rtrs, ospf->new_rtrs);
+    }
+
+  printf ("%d rounds, %lu routes: %lu none, %lu partial, "
+          "%lu incremental, %lu full\n", ROUNDS, routes,
+          done[OSPF_SPF_NONE], done[OSPF_SPF_PARTIAL],
+          done[OSPF_SPF_INCREMENTAL], done[OSPF_SPF_FULL]);
+
+  if (! done[OSPF_SPF_PARTIAL] || ! done[OSPF_SPF_INCREMENTAL])
+    {
+      printf ("partial and incremental calculations not both done\n");
+      failed++;
+    }
+
+  printf ("failures: %d\n", failed);
+  return failed;
+}
@@ -0,0 +1,452 @@
+/*
+ * Prefix-list tests.
+ *
+ * This file is part of Quagga.
+ *
+ * Quagga is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2, or (at your option) any
+ * later version.
+ *
+ * Quagga is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Quagga; see the file COPYING.  If not, write to the Free
+ * Software Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ */
+
+/* Builds a prefix-list with random, nested entries through the ORF
+ * interface, adding, replacing and deleting entries as it goes, and
+ * checks prefix_list_apply() against a first-match scan of the entries
+ * in sequence order, as prefix-lists have always been evaluated, and
+ * that the list shows them in that order.  Then builds another list
+ * through the vty and has it replace an IPv4 one with "ip prefix-list
+ * NAME replace", checking that the entries changed hands, that
+ * holders of the list see the new ones and that the protocols were told
+ * once.  With -b, times building and
+ * applying instead, on a list of BENCH_ENTRIES entries shaped like a
+ * large customer filter: /16 to /24, exact or "le 24".
+ */
+#include <zebra.h>
+
+#include "prefix.h"
+#include "vty.h"
+#include "command.h"
+#include "plist.h"
+#include "memory.h"
+#include "thread.h"
+#include "buffer.h"
+
+#define ROUNDS 200000
+#define ROUNDS_SEQ_MAX 2000
+#define REPLACE_ENTRIES 1000
+#define REPLACE_LOOKUPS 100000
+#define BENCH_ENTRIES 50000
+#define BENCH_LOOKUPS 20000
+
+struct thread_master *master;
+
+static char name[] = "test";
+
+/* The entries, by sequence number, up to seq_max. */
+static struct
+{
+  int present;
+  int permit;
+  struct orf_prefix orf;
+} entries[BENCH_ENTRIES + 1];
+static int seq_max;
+
+static int failed;
+static struct vty *vty;
+
+/* First match in sequence order, the way prefix_list_apply() used to
+   walk the list. */
+static enum prefix_list_type
+linear_apply (int count, struct prefix *p)
+{
+  struct orf_prefix *orf;
+  int seq;
+
+  if (count == 0)
+    return PREFIX_DENY;
+
+  for (seq = 0; seq <= seq_max; seq++)
+    {
+      if (! entries[seq].present)
+	continue;
+      orf = &entries[seq].orf;
+      if (! prefix_match (&orf->p, p))
+	continue;
+      if (! orf->le && ! orf->ge)
+	{
+	  if (orf->p.prefixlen != p->prefixlen)
+	    continue;
+	}
+      else if ((orf->le && p->prefixlen > orf->le)
+	       || (orf->ge && p->prefixlen < orf->ge))
+	continue;
+      return entries[seq].permit ? PREFIX_PERMIT : PREFIX_DENY;
+    }
+  return PREFIX_DENY;
+}
+
+/* A prefix under 10.0.0.0/8, or under the given one if any, so that
+   entries nest and lookups find them. */
+static void
+random_prefix (struct prefix *p, struct prefix *under)
+{
+  u_int32_t addr = (10U << 24) | (random () & 0xffffff);
+  int minlen = 8;
+
+  if (under)
+    {
+      minlen = under->prefixlen;
+      addr = ntohl (under->u.prefix4.s_addr) & (~0U << (32 - minlen));
+      addr |= random () & (minlen == 32 ? 0 : ~0U >> minlen);
+    }
+
+  memset (p, 0, sizeof (struct prefix));
+  p->family = AF_INET;
+  p->prefixlen = minlen + random () % (33 - minlen);
+  p->u.prefix4.s_addr = htonl (addr);
+
+  /* Leave the host bits set now and then; matching ignores them. */
+  if (random () % 4)
+    apply_mask (p);
+}
+
+static void
+random_entry (struct orf_prefix *orf, int seq)
+{
+  memset (orf, 0, sizeof (struct orf_prefix));
+  orf->seq = seq;
+  random_prefix (&orf->p, NULL);
+  orf->p.prefixlen = 8 + random () % 17;
+  switch (random () % 4)
+    {
+    case 0:
+      break;
+    case 1:
+      orf->le = orf->p.prefixlen + 1 + random () % (32 - orf->p.prefixlen);
+      break;
+    case 2:
+      orf->ge = orf->p.prefixlen + 1 + random () % (32 - orf->p.prefixlen);
+      break;
+    default:
+      orf->ge = orf->p.prefixlen + 1 + random () % (32 - orf->p.prefixlen);
+      orf->le = orf->ge + random () % (33 - orf->ge);
+      break;
+    }
+}
+
+static void
+bench_entry (struct orf_prefix *orf, int seq)
+{
+  memset (orf, 0, sizeof (struct orf_prefix));
+  orf->seq = seq;
+  random_prefix (&orf->p, NULL);
+  orf->p.prefixlen = 16 + random () % 9;
+  apply_mask (&orf->p);
+  if (random () % 4 == 0 && orf->p.prefixlen < 24)
+    orf->le = 24;
+}
+
+/* A prefix to look up: mostly one under a present entry. */
+static void
+random_lookup (struct prefix *p)
+{
+  int seq = random () % (seq_max + 1);
+
+  random_prefix (p, (entries[seq].present && random () % 8)
+		    ? &entries[seq].orf.p : NULL);
+}
+
+static int
+set_entry (struct orf_prefix *orf, int permit, int set)
+{
+  return prefix_bgp_orf_set (name, AFI_IP, orf, permit, set);
+}
+
+/* The list shows the present entries, in sequence order. */
+static void
+check_order (void)
+{
+  char *out, *line, *save;
+  int seq, last = 0, count = 0;
+
+  buffer_reset (vty->obuf);
+  prefix_bgp_show_prefix_list (vty, AFI_IP, name);
+  out = buffer_getstr (vty->obuf);
+
+  for (line = strtok_r (out, "\r\n", &save); line;
+       line = strtok_r (NULL, "\r\n", &save))
+    {
+      if (sscanf (line, " seq %d", &seq) != 1)
+	continue;
+      if (seq <= last || seq > seq_max || ! entries[seq].present)
+	{
+	  printf ("seq %d shown after seq %d\n", seq, last);
+	  failed++;
+	}
+      last = seq;
+      count++;
+    }
+  for (seq = 0; seq <= seq_max; seq++)
+    count -= entries[seq].present;
+  if (count != 0)
+    {
+      printf ("%d entries shown more than present\n", count);
+      failed++;
+    }
+  XFREE (MTYPE_TMP, out);
+}
+
+static void
+equivalence (void)
+{
+  struct orf_prefix orf;
+  struct prefix p;
+  enum prefix_list_type want, got;
+  int count = 0;
+  int seq, permit;
+  long r;
+
+  seq_max = ROUNDS_SEQ_MAX;
+  for (r = 0; r < ROUNDS; r++)
+    {
+      seq = 1 + random () % seq_max;
+
+      /* Mostly add, and replace whatever had the same sequence number;
+	 now and then delete. */
+      if (entries[seq].present && random () % 4 == 0)
+	{
+	  orf = entries[seq].orf;
+	  if (set_entry (&orf, entries[seq].permit, 0) != CMD_SUCCESS)
+	    {
+	      printf ("seq %d: delete failed\n", seq);
+	      failed++;
+	    }
+	  entries[seq].present = 0;
+	  count--;
+	}
+      else
+	{
+	  random_entry (&orf, seq);
+	  permit = random () % 2;
+	  if (set_entry (&orf, permit, 1) == CMD_SUCCESS)
+	    {
+	      count += ! entries[seq].present;
+	      entries[seq].present = 1;
+	      entries[seq].permit = permit;
+	      entries[seq].orf = orf;
+	    }
+	}
+
+      random_lookup (&p);
+      want = linear_apply (count, &p);
+      got = prefix_list_apply (prefix_list_lookup (AFI_ORF_PREFIX, name), &p);
+      if (want != got)
+	{
+	  char buf[INET_ADDRSTRLEN];
+
+	  printf ("round %ld: %s/%d: %s, should be %s\n", r,
+		  inet_ntop (AF_INET, &p.u.prefix4, buf, sizeof (buf)),
+		  p.prefixlen, got == PREFIX_PERMIT ? "permit" : "deny",
+		  want == PREFIX_PERMIT ? "permit" : "deny");
+	  failed++;
+	}
+
+      if (r % (ROUNDS / 10) == 0)
+	check_order ();
+    }
+  check_order ();
+
+  prefix_bgp_orf_remove_all (name);
+  printf ("%d rounds, %d entries at the end\n", ROUNDS, count);
+}
+
+static int
+execute (const char *line)
+{
+  vector vline;
+  int ret;
+
+  vty->node = CONFIG_NODE;
+  vline = cmd_make_strvec (line);
+  ret = cmd_execute_command_strict (vline, vty, NULL);
+  cmd_free_strvec (vline);
+  return ret;
+}
+
+static int adds, deletes;
+
+static void
+count_add (struct prefix_list *plist)
+{
+  adds++;
+}
+
+static void
+count_delete (struct prefix_list *plist)
+{
+  deletes++;
+}
+
+static void
+replace (void)
+{
+  struct prefix_list_ref *ref;
+  struct orf_prefix orf;
+  struct prefix p;
+  char line[128], buf[INET_ADDRSTRLEN];
+  enum prefix_list_type want, got;
+  int count = 0;
+  int i, seq, permit;
+
+  execute ("ip prefix-list test permit 192.0.2.0/24");
+  ref = prefix_list_ref_get (AFI_IP, name);
+
+  memset (entries, 0, sizeof (entries));
+  seq_max = REPLACE_ENTRIES;
+  for (i = 0; i < REPLACE_ENTRIES; i++)
+    {
+      seq = 1 + random () % seq_max;
+      random_entry (&orf, seq);
+      permit = random () % 2;
+      snprintf (line, sizeof (line), "ip prefix-list staging seq %d %s %s/%d",
+		seq, permit ? "permit" : "deny",
+		inet_ntop (AF_INET, &orf.p.u.prefix4, buf, sizeof (buf)),
+		orf.p.prefixlen);
+      if (orf.ge)
+	snprintf (line + strlen (line), sizeof (line) - strlen (line),
+		  " ge %d", orf.ge);
+      if (orf.le)
+	snprintf (line + strlen (line), sizeof (line) - strlen (line),
+		  " le %d", orf.le);
+      if (execute (line) == CMD_SUCCESS)
+	{
+	  count += ! entries[seq].present;
+	  entries[seq].present = 1;
+	  entries[seq].permit = permit;
+	  entries[seq].orf = orf;
+	}
+    }
+
+  prefix_list_add_hook (count_add);
+  prefix_list_delete_hook (count_delete);
+  adds = deletes = 0;
+  if (execute ("ip prefix-list test replace staging") != CMD_SUCCESS
+      || prefix_list_lookup (AFI_IP, "staging") != NULL
+      || ref->plist != prefix_list_lookup (AFI_IP, name)
+      || ref->plist == NULL || ref->plist->count != count)
+    {
+      printf ("replace: list not replaced\n");
+      failed++;
+      return;
+    }
+  if (adds != 1 || deletes != 0)
+    {
+      printf ("replace: %d add and %d delete hooks run\n", adds, deletes);
+      failed++;
+    }
+
+  for (i = 0; i < REPLACE_LOOKUPS; i++)
+    {
+      random_lookup (&p);
+      want = linear_apply (count, &p);
+      got = prefix_list_apply (ref->plist, &p);
+      if (want != got)
+	{
+	  printf ("replace: %s/%d: %s, should be %s\n",
+		  inet_ntop (AF_INET, &p.u.prefix4, buf, sizeof (buf)),
+		  p.prefixlen, got == PREFIX_PERMIT ? "permit" : "deny",
+		  want == PREFIX_PERMIT ? "permit" : "deny");
+	  failed++;
+	}
+    }
+
+  prefix_list_ref_put (ref);
+  printf ("%d entries replaced\n", count);
+}
+
+static unsigned long
+usec_since (struct timeval *start)
+{
+  struct timeval now;
+
+  quagga_gettime (QUAGGA_CLK_MONOTONIC, &now);
+  return (now.tv_sec - start->tv_sec) * 1000000UL
+	 + now.tv_usec - start->tv_usec;
+}
+
+static void
+benchmark (void)
+{
+  static struct prefix lookups[BENCH_LOOKUPS];
+  struct prefix_list *plist;
+  struct orf_prefix orf;
+  struct timeval start;
+  unsigned long usec, permits;
+  int count = 0;
+  int i, seq;
+
+  seq_max = BENCH_ENTRIES;
+  quagga_gettime (QUAGGA_CLK_MONOTONIC, &start);
+  for (seq = 1; seq <= seq_max; seq++)
+    {
+      bench_entry (&orf, seq);
+      if (set_entry (&orf, seq % 2, 1) == CMD_SUCCESS)
+	{
+	  entries[seq].present = 1;
+	  entries[seq].permit = seq % 2;
+	  entries[seq].orf = orf;
+	  count++;
+	}
+    }
+  printf ("built %d entries in %lu usec\n", count, usec_since (&start));
+
+  for (i = 0; i < BENCH_LOOKUPS; i++)
+    random_lookup (&lookups[i]);
+  plist = prefix_list_lookup (AFI_ORF_PREFIX, name);
+
+  quagga_gettime (QUAGGA_CLK_MONOTONIC, &start);
+  for (permits = i = 0; i < BENCH_LOOKUPS; i++)
+    permits += prefix_list_apply (plist, &lookups[i]) == PREFIX_PERMIT;
+  usec = usec_since (&start);
+  printf ("trie:   %d lookups in %8lu usec, %lu permitted\n",
+	  BENCH_LOOKUPS, usec, permits);
+
+  quagga_gettime (QUAGGA_CLK_MONOTONIC, &start);
+  for (permits = i = 0; i < BENCH_LOOKUPS; i++)
+    permits += linear_apply (count, &lookups[i]) == PREFIX_PERMIT;
+  usec = usec_since (&start);
+  printf ("linear: %d lookups in %8lu usec, %lu permitted\n",
+	  BENCH_LOOKUPS, usec, permits);
+
+  prefix_bgp_orf_remove_all (name);
+}
+
+int
+main (int argc, char **argv)
+{
+  srandom (1);
+  cmd_init (1);
+  prefix_list_init ();
+  vty = vty_new ();
+
+  if (argc > 1 && strcmp (argv[1], "-b") == 0)
+    {
+      benchmark ();
+      return 0;
+    }
+
+  equivalence ();
+  replace ();
+  printf ("failures: %d\n", failed);
+  return failed;
+}
@@ -0,0 +1,237 @@
+/*
+ * Timer queue benchmark.
+ *
+ * This file is part of Quagga.
+ *
+ * Quagga is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2, or (at your option) any
+ * later version.
+ *
+ * Quagga is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Quagga; see the file COPYING.  If not, write to the Free
+ * Software Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ */
+
+/* Arms timers with random expiry and cancels them again in random order,
+ * once through the thread library's timer heap and once through a model
+ * of the sorted timer list thread_master used to keep.  Inserting into
+ * that list is linear, so it is only run up to a smaller count.
+ */
+#include <zebra.h>
+
+#include "thread.h"
+#include "memory.h"
+#include "pqueue.h"
+
+#define TIMER_COUNT_DEFAULT 1000000
+#define LIST_COUNT_MAX 20000
+#define TIMER_SPAN_MSEC (3600 * 1000)
+
+struct thread_master *master;
+
+/* The sorted timer list, as it was. */
+struct list_timer
+{
+  struct list_timer *next;
+  struct list_timer *prev;
+  struct timeval sands;
+};
+
+struct list_timer_list
+{
+  struct list_timer *head;
+  struct list_timer *tail;
+};
+
+static long
+timeval_cmp (struct timeval a, struct timeval b)
+{
+  return (a.tv_sec == b.tv_sec
+	  ? a.tv_usec - b.tv_usec : a.tv_sec - b.tv_sec);
+}
+
+static void
+list_timer_add (struct list_timer_list *list, struct list_timer *timer)
+{
+  struct list_timer *tt;
+
+  for (tt = list->head; tt; tt = tt->next)
+    if (timeval_cmp (timer->sands, tt->sands) <= 0)
+      break;
+
+  timer->next = tt;
+  timer->prev = tt ? tt->prev : list->tail;
+  if (timer->prev)
+    timer->prev->next = timer;
+  else
+    list->head = timer;
+  if (tt)
+    tt->prev = timer;
+  else
+    list->tail = timer;
+}
+
+static void
+list_timer_cancel (struct list_timer_list *list, struct list_timer *timer)
+{
+  if (timer->next)
+    timer->next->prev = timer->prev;
+  else
+    list->tail = timer->prev;
+  if (timer->prev)
+    timer->prev->next = timer->next;
+  else
+    list->head = timer->next;
+}
+
+static int
+dummy_func (struct thread *thread)
+{
+  return 0;
+}
+
+static unsigned long
+elapsed_usec (struct timeval *start)
+{
+  struct timeval now;
+
+  quagga_gettime (QUAGGA_CLK_MONOTONIC, &now);
+  return (now.tv_sec - start->tv_sec) * 1000000L
+         + (now.tv_usec - start->tv_usec);
+}
+
+static void
+shuffle (long *order, int count)
+{
+  int i;
+
+  for (i = 0; i < count; i++)
+    order[i] = i;
+  for (i = count - 1; i > 0; i--)
+    {
+      int j = random () % (i + 1);
+      long tmp = order[i];
+
+      order[i] = order[j];
+      order[j] = tmp;
+    }
+}
+
+static void
+report (const char *name, int count, unsigned long arm, unsigned long cancel)
+{
+  printf ("%-5s %8d timers: arm %8lu usec (%6.1f nsec/timer), "
+          "cancel %8lu usec (%6.1f nsec/timer)\n",
+          name, count, arm, arm * 1000.0 / count,
+          cancel, cancel * 1000.0 / count);
+}
+
+static void
+bench_heap (int count, long *msec, long *order)
+{
+  struct thread **timers;
+  struct timeval start;
+  unsigned long arm, cancel;
+  int i;
+
+  timers = XCALLOC (MTYPE_TMP, count * sizeof (struct thread *));
+
+  quagga_gettime (QUAGGA_CLK_MONOTONIC, &start);
+  for (i = 0; i < count; i++)
+    timers[i] = thread_add_timer_msec (master, dummy_func, NULL, msec[i]);
+  arm = elapsed_usec (&start);
+
+  quagga_gettime (QUAGGA_CLK_MONOTONIC, &start);
+  for (i = 0; i < count; i++)
+    thread_cancel (timers[order[i]]);
+  cancel = elapsed_usec (&start);
+
+  assert (master->timer->size == 0);
+  report ("heap", count, arm, cancel);
+  XFREE (MTYPE_TMP, timers);
+}
+
+static void
+bench_list (int count, long *msec, long *order)
+{
+  struct list_timer_list list = { NULL, NULL };
+  struct list_timer *timers;
+  struct timeval start, now;
+  unsigned long arm, cancel;
+  int i;
+
+  timers = XCALLOC (MTYPE_TMP, count * sizeof (struct list_timer));
+
+  quagga_gettime (QUAGGA_CLK_MONOTONIC, &start);
+  for (i = 0; i < count; i++)
+    {
+      /* Same work as the old funcname_thread_add_timer_timeval(). */
+      quagga_gettime (QUAGGA_CLK_MONOTONIC, &now);
+      timers[i].sands.tv_sec = now.tv_sec + msec[i] / 1000;
+      timers[i].sands.tv_usec = now.tv_usec + 1000 * (msec[i] % 1000);
+      if (timers[i].sands.tv_usec >= 1000000)
+        {
+          timers[i].sands.tv_usec -= 1000000;
+          timers[i].sands.tv_sec++;
+        }
+      list_timer_add (&list, &timers[i]);
+    }
+  arm = elapsed_usec (&start);
+
+  quagga_gettime (QUAGGA_CLK_MONOTONIC, &start);
+  for (i = 0; i < count; i++)
+    list_timer_cancel (&list, &timers[order[i]]);
+  cancel = elapsed_usec (&start);
+
+  assert (list.head == NULL);
+  report ("list", count, arm, cancel);
+  XFREE (MTYPE_TMP, timers);
+}
+
+int
+main (int argc, char **argv)
+{
+  int count = TIMER_COUNT_DEFAULT;
+  int list_count;
+  long *msec, *order;
+  int i;
+
+  if (argc > 1 && (count = atoi (argv[1])) <= 0)
+    {
+      fprintf (stderr, "Usage: %s [number of timers]\n", argv[0]);
+      return 1;
+    }
+
+  memory_init ();
+  master = thread_master_create ();
+  srandom (time (NULL));
+
+  msec = XCALLOC (MTYPE_TMP, count * sizeof (long));
+  order = XCALLOC (MTYPE_TMP, count * sizeof (long));
+  for (i = 0; i < count; i++)
+    msec[i] = random () % TIMER_SPAN_MSEC;
+  shuffle (order, count);
+
+  bench_heap (count, msec, order);
+
+  /* Compare both at the count the list can manage. */
+  list_count = (count > LIST_COUNT_MAX) ? LIST_COUNT_MAX : count;
+  if (list_count < count)
+    {
+      shuffle (order, list_count);
+      bench_heap (list_count, msec, order);
+    }
+  bench_list (list_count, msec, order);
+
+  XFREE (MTYPE_TMP, msec);
+  XFREE (MTYPE_TMP, order);
+  thread_master_free (master);
+  return 0;
+}
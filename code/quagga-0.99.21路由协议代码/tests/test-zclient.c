@@ -0,0 +1,292 @@
+/*
+ * zclient write coalescing tests.
+ *
+ * This file is part of Quagga.
+ *
+ * Quagga is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2, or (at your option) any
+ * later version.
+ *
+ * Quagga is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Quagga; see the file COPYING.  If not, write to the Free
+ * Software Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ */
+
+/* Announces routes through a zclient connected to a socketpair, in
+ * batches of various sizes as a daemon's threads would, running the
+ * event loop between batches and reading the other end as zebra would.
+ * Checks that every route arrives, in order and intact, and that the
+ * messages went out in about as many writes as batches, or as flushes
+ * of ZCLIENT_FLUSH_SIZE bytes.  Then drops the connection with routes
+ * corked, and checks that none are counted against the next one.  With
+ * -b, times the announcement of BENCH_ROUTES routes, BENCH_BATCH at a
+ * time, instead.
+ */
+#include <zebra.h>
+
+#include "thread.h"
+#include "stream.h"
+#include "buffer.h"
+#include "network.h"
+#include "prefix.h"
+#include "zclient.h"
+
+#define BENCH_ROUTES 500000
+#define BENCH_BATCH 1000
+
+struct thread_master *master;
+
+static struct zclient *zclient;
+static struct stream *rb;
+static int peer;
+static unsigned int sent, received;
+static unsigned long bytes;
+static int failed;
+
+static const unsigned int batches[] = { 1, 1, 10, 100, 1, 5000, 20000, 7 };
+
+static void
+route_of (unsigned int i, struct prefix_ipv4 *p)
+{
+  memset (p, 0, sizeof (struct prefix_ipv4));
+  p->family = AF_INET;
+  p->prefixlen = 24;
+  p->prefix.s_addr = htonl (0x0a000000 | (i << 8));
+}
+
+static void
+announce (unsigned int n)
+{
+  struct zapi_ipv4 api;
+  struct prefix_ipv4 p;
+  struct in_addr nexthop, *nexthops[1];
+  unsigned int i;
+
+  nexthop.s_addr = htonl (0xc0000201);
+  nexthops[0] = &nexthop;
+  for (i = 0; i < n; i++)
+    {
+      memset (&api, 0, sizeof (api));
+      api.type = ZEBRA_ROUTE_BGP;
+      api.safi = SAFI_UNICAST;
+      SET_FLAG (api.message, ZAPI_MESSAGE_NEXTHOP);
+      api.nexthop_num = 1;
+      api.nexthop = nexthops;
+      SET_FLAG (api.message, ZAPI_MESSAGE_METRIC);
+      api.metric = sent;
+      route_of (sent, &p);
+      zapi_ipv4_route (ZEBRA_IPV4_ROUTE_ADD, zclient, &p, &api);
+      sent++;
+    }
+}
+
+/* Read what has arrived, and check every whole message in it. */
+static void
+drain (void)
+{
+  struct prefix_ipv4 p;
+  size_t getp;
+  uint16_t length;
+  u_char plen;
+  u_int32_t prefix;
+
+  while (stream_read_try (rb, peer, STREAM_WRITEABLE (rb)) > 0)
+    {
+      while (STREAM_READABLE (rb) >= ZEBRA_HEADER_SIZE)
+	{
+	  getp = stream_get_getp (rb);
+	  length = stream_getw_from (rb, getp);
+	  if (STREAM_READABLE (rb) < length)
+	    break;
+	  bytes += length;
+
+	  route_of (received, &p);
+	  stream_forward_getp (rb, 2);
+	  if (stream_getc (rb) != ZEBRA_HEADER_MARKER
+	      || stream_getc (rb) != ZSERV_VERSION
+	      || stream_getw (rb) != ZEBRA_IPV4_ROUTE_ADD
+	      || stream_getc (rb) != ZEBRA_ROUTE_BGP)
+	    {
+	      printf ("route %u: bad header\n", received);
+	      failed++;
+	      stream_set_getp (rb, getp + length);
+	      received++;
+	      continue;
+	    }
+	  stream_forward_getp (rb, 4);
+	  plen = stream_getc (rb);
+	  prefix = 0;
+	  stream_get (&prefix, rb, PSIZE (plen));
+	  stream_forward_getp (rb, 2 + IPV4_MAX_BYTELEN);
+	  if (plen != p.prefixlen || prefix != p.prefix.s_addr
+	      || stream_getl (rb) != received)
+	    {
+	      printf ("route %u: got another\n", received);
+	      failed++;
+	    }
+	  if (stream_get_getp (rb) != getp + length)
+	    {
+	      printf ("route %u: %lu bytes, expected %u\n", received,
+		      (u_long) (stream_get_getp (rb) - getp), length);
+	      failed++;
+	      stream_set_getp (rb, getp + length);
+	    }
+	  received++;
+	}
+      stream_pulldown (rb);
+    }
+}
+
+/* Run the event loop until the zclient has written everything. */
+static void
+run (void)
+{
+  struct thread thread;
+
+  for (;;)
+    {
+      drain ();
+      if (! zclient->t_write)
+	break;
+      if (thread_fetch (master, &thread))
+	thread_call (&thread);
+    }
+  drain ();
+}
+
+/* Connect the zclient to a new peer. */
+static int
+connect_peer (void)
+{
+  int sv[2];
+
+  if (socketpair (AF_UNIX, SOCK_STREAM, 0, sv) < 0)
+    {
+      perror ("socketpair");
+      return -1;
+    }
+  set_nonblocking (sv[0]);
+  set_nonblocking (sv[1]);
+  zclient->sock = sv[0];
+  peer = sv[1];
+  return 0;
+}
+
+/* The routes corked when the connection goes are lost with it, and the
+   first route sent on the next goes out in a flush of its own. */
+static void
+check_reconnect (void)
+{
+  unsigned long flushes;
+  size_t length = bytes / received;
+
+  announce (100);
+  zclient_stop (zclient);
+  close (peer);
+  if (zclient->corked != 0)
+    {
+      printf ("stopped with %lu bytes corked\n", (u_long) zclient->corked);
+      failed++;
+    }
+  received = sent;
+
+  if (connect_peer () < 0)
+    {
+      failed++;
+      return;
+    }
+  flushes = zclient->flushes;
+  announce (1);
+  if (zclient->corked > length)
+    {
+      printf ("reconnected with %lu bytes corked\n", (u_long) zclient->corked);
+      failed++;
+    }
+  zclient_flush (zclient);
+  run ();
+  if (received != sent || zclient->flushes != flushes + 1)
+    {
+      printf ("reconnected: %u routes received, %u sent, in %lu flushes\n",
+	      received, sent, zclient->flushes - flushes);
+      failed++;
+    }
+}
+
+static unsigned long
+usec_since (struct timeval *start)
+{
+  struct timeval now;
+
+  quagga_gettime (QUAGGA_CLK_MONOTONIC, &now);
+  return (now.tv_sec - start->tv_sec) * 1000000UL
+	 + now.tv_usec - start->tv_usec;
+}
+
+static void
+benchmark (void)
+{
+  struct timeval start;
+
+  quagga_gettime (QUAGGA_CLK_MONOTONIC, &start);
+  while (sent < BENCH_ROUTES)
+    {
+      announce (BENCH_BATCH);
+      run ();
+    }
+  printf ("announced %u routes in %lu usec, %lu messages in %lu flushes\n",
+	  received, usec_since (&start), zclient->messages, zclient->flushes);
+}
+
+int
+main (int argc, char **argv)
+{
+  unsigned long expect = 0;
+  unsigned int i;
+
+  master = thread_master_create ();
+  rb = stream_new (ZCLIENT_FLUSH_SIZE);
+
+  zclient = zclient_new ();
+  if (connect_peer () < 0)
+    return 1;
+
+  if (argc > 1 && strcmp (argv[1], "-b") == 0)
+    {
+      benchmark ();
+      return 0;
+    }
+
+  for (i = 0; i < sizeof (batches) / sizeof (batches[0]); i++)
+    {
+      announce (batches[i]);
+      run ();
+      if (received != sent)
+	{
+	  printf ("batch %u: %u routes received, %u sent\n",
+		  i, received, sent);
+	  failed++;
+	}
+      expect += 1 + (batches[i] * (bytes / received)) / ZCLIENT_FLUSH_SIZE;
+    }
+
+  if (zclient->messages != sent || zclient->flushes > expect)
+    {
+      printf ("%lu messages in %lu flushes, expected %u in %lu\n",
+	      zclient->messages, zclient->flushes, sent, expect);
+      failed++;
+    }
+
+  printf ("%u routes in %lu flushes\n", sent, zclient->flushes);
+
+  check_reconnect ();
+
+  printf ("failures: %d\n", failed);
+  return failed;
+}
@@ -1627,6 +1627,39 @@ DEFUNSH (VTYSH_ALL,
   return CMD_SUCCESS;
 }
 
+DEFUNSH (VTYSH_ALL,
+	 vtysh_log_async,
+	 vtysh_log_async_cmd,
+	 "log asynchronous (drop|block)",
+	 "Logging control\n"
+	 "Queue messages for a thread of their own to write out\n"
+	 "Drop messages that find the queue full\n"
+	 "Wait for room when the queue is full\n")
+{
+  return CMD_SUCCESS;
+}
+
+DEFUNSH (VTYSH_ALL,
+	 no_vtysh_log_async,
+	 no_vtysh_log_async_cmd,
+	 "no log asynchronous",
+	 NO_STR
+	 "Logging control\n"
+	 "Write every message as it is logged\n")
+{
+  return CMD_SUCCESS;
+}
+
+ALIAS_SH (VTYSH_ALL,
+	  no_vtysh_log_async,
+	  no_vtysh_log_async_policy_cmd,
+	  "no log asynchronous (drop|block)",
+	  NO_STR
+	  "Logging control\n"
+	  "Write every message as it is logged\n"
+	  "Drop messages that find the queue full\n"
+	  "Wait for room when the queue is full\n")
+
 DEFUNSH (VTYSH_ALL,
 	 vtysh_service_password_encrypt,
 	 vtysh_service_password_encrypt_cmd,
@@ -2473,6 +2506,9 @@ vtysh_init_vty (void)
   install_element (CONFIG_NODE, &no_vtysh_log_record_priority_cmd);
   install_element (CONFIG_NODE, &vtysh_log_timestamp_precision_cmd);
   install_element (CONFIG_NODE, &no_vtysh_log_timestamp_precision_cmd);
+  install_element (CONFIG_NODE, &vtysh_log_async_cmd);
+  install_element (CONFIG_NODE, &no_vtysh_log_async_cmd);
+  install_element (CONFIG_NODE, &no_vtysh_log_async_policy_cmd);
 
   install_element (CONFIG_NODE, &vtysh_service_password_encrypt_cmd);
   install_element (CONFIG_NODE, &no_vtysh_service_password_encrypt_cmd);
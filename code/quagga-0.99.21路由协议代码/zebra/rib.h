@@ -91,10 +91,44 @@ struct rib
  * sub-queue 4: any other origin (if any)
  */
 #define MQ_SIZE 5
+
+/* Queueing latency histogram buckets: under 1ms, 10ms, 100ms, 1s, 10s
+ * and anything longer. */
+#define MQ_LATENCY_BUCKETS 6
+
+/* A sub-queue is a ring of route_nodes, growing when full. */
+struct meta_subq
+{
+  struct meta_subq_entry
+  {
+    struct route_node *rn;
+    struct timeval queued;
+  } *ring;
+  u_int32_t head;
+  u_int32_t count;
+  u_int32_t size;
+
+  /* Statistics. */
+  u_int32_t count_max;
+  unsigned long processed;
+  unsigned long latency[MQ_LATENCY_BUCKETS];
+};
+
+#define MQ_TIME_SLICE_DEFAULT 10 /* msec */
+
 struct meta_queue
 {
-  struct list *subq[MQ_SIZE];
+  struct meta_subq subq[MQ_SIZE];
   u_int32_t size; /* sum of lengths of all subqueues */
+
+  /* How long one run of the work queue may go on for, in msec. */
+  u_int32_t time_slice;
+
+  /* Route nodes processed per run. */
+  unsigned long runs;
+  unsigned long batch_total;
+  unsigned long batch_max;
+  unsigned long batch_last;
 };
 
 /* Static route information. */
@@ -268,6 +302,7 @@ extern struct rib *rib_lookup_ipv4 (struct prefix_ipv4 *);
 extern void rib_update (void);
 extern void rib_weed_tables (void);
 extern void rib_sweep_route (void);
+extern void rib_install_kernel_failed (struct prefix *, struct rib *, int);
 extern void rib_close (void);
 extern void rib_init (void);
 extern unsigned long rib_score_proto (u_char proto);
@@ -347,6 +347,12 @@ kernel_delete_ipv4 (struct prefix *p, struct rib *rib)
 {
   return kernel_ioctl_ipv4 (SIOCDELRT, p, rib, AF_INET);
 }
+
+/* Route changes are not queued here. */
+void
+kernel_route_sync (void)
+{
+}
 
 #ifdef HAVE_IPV6
 
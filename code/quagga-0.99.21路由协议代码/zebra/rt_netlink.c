@@ -36,6 +36,7 @@
 #include "rib.h"
 #include "thread.h"
 #include "privs.h"
+#include "command.h"
 
 #include "zebra/zserv.h"
 #include "zebra/rt.h"
@@ -1298,6 +1299,326 @@ addattr32 (struct nlmsghdr *n, int maxlen, int type, int data)
   return 0;
 }
 
+/* Route changes are not sent one at a time.  netlink_route_multipath()
+   appends each RTM_NEWROUTE/RTM_DELROUTE to a batch buffer, which is
+   sent to the kernel with a single sendmsg() once it fills up or once
+   the current thread run is over.  Only the last message of a batch
+   asks for an ACK: the kernel handles the messages of a batch in order
+   and reports every failure, so an ACK or error for sequence number
+   S tells that all earlier messages have been dealt with.  Messages
+   that have not been acknowledged yet are kept in a ring in sequence
+   order, so that a failed RTM_NEWROUTE can be handed back to the
+   RIB. */
+#define NL_BATCH_BUF_SIZE  32768
+#define NL_BATCH_RING_SIZE 4096
+
+struct nl_batch_entry
+{
+  u_int32_t seq;
+  int cmd;
+  struct prefix p;
+  struct rib *rib;
+};
+
+static struct
+{
+  /* Messages waiting to be sent. */
+  u_int32_t buf[NL_BATCH_BUF_SIZE / sizeof (u_int32_t)];
+  size_t len;
+  size_t last;
+
+  /* Ring of messages not acknowledged yet: [head, sent) have been
+     sent, [sent, tail) are still in buf. */
+  struct nl_batch_entry ring[NL_BATCH_RING_SIZE];
+  unsigned long head;
+  unsigned long sent;
+  unsigned long tail;
+
+  struct thread *t_flush;
+  struct thread *t_read;
+
+  /* Statistics. */
+  unsigned long batches;
+  unsigned long messages;
+  unsigned long bytes;
+  unsigned long batch_max;
+  unsigned long inflight_max;
+  unsigned long errors;
+  unsigned long send_errors;
+  unsigned long overruns;
+  unsigned long syncs;
+} nl_batch;
+
+#define NL_BATCH_ENTRY(I) (&nl_batch.ring[(I) % NL_BATCH_RING_SIZE])
+
+/* Sequence numbers wrap, compare them as such. */
+#define NL_SEQ_BEFORE(A,B) ((int32_t) ((u_int32_t) (A) - (u_int32_t) (B)) < 0)
+
+/* A batched route change has been dealt with by the kernel. */
+static void
+netlink_batch_done (struct nl_batch_entry *entry, int errnum)
+{
+  char buf[INET6_ADDRSTRLEN + 4];
+
+  if (errnum == 0)
+    return;
+  prefix2str (&entry->p, buf, sizeof buf);
+
+  /* Same races in link handling netlink_parse_info() puts up with. */
+  if ((entry->cmd == RTM_DELROUTE && (errnum == ENODEV || errnum == ESRCH))
+      || (entry->cmd == RTM_NEWROUTE && errnum == EEXIST))
+    {
+      if (IS_ZEBRA_DEBUG_KERNEL)
+        zlog_debug ("%s: error: %s type=%s(%u), seq=%u, prefix %s",
+                    netlink_cmd.name, safe_strerror (errnum),
+                    lookup (nlmsg_str, entry->cmd), entry->cmd, entry->seq,
+                    buf);
+      return;
+    }
+
+  nl_batch.errors++;
+  zlog_err ("%s error: %s, type=%s(%u), seq=%u, prefix %s",
+            netlink_cmd.name, safe_strerror (errnum),
+            lookup (nlmsg_str, entry->cmd), entry->cmd, entry->seq, buf);
+
+  if (entry->cmd == RTM_NEWROUTE)
+    rib_install_kernel_failed (&entry->p, entry->rib, errnum == ENOBUFS);
+}
+
+/* Hand the ACK or error for SEQ to the messages it covers. */
+static void
+netlink_batch_ack (u_int32_t seq, int errnum)
+{
+  struct nl_batch_entry *entry;
+
+  while (nl_batch.head != nl_batch.sent)
+    {
+      entry = NL_BATCH_ENTRY (nl_batch.head);
+      if (NL_SEQ_BEFORE (seq, entry->seq))
+        break;
+      nl_batch.head++;
+      netlink_batch_done (entry, entry->seq == seq ? errnum : 0);
+    }
+}
+
+/* The kernel dropped replies, so nothing more is going to be heard
+   about what has been sent.  Route installs may or may not have been
+   done: the RIB queues their nodes to install them again. */
+static void
+netlink_batch_abandon (void)
+{
+  nl_batch.overruns++;
+  zlog_err ("%s: lost replies for %lu route changes", netlink_cmd.name,
+            nl_batch.sent - nl_batch.head);
+
+  while (nl_batch.head != nl_batch.sent)
+    netlink_batch_done (NL_BATCH_ENTRY (nl_batch.head++), ENOBUFS);
+}
+
+/* Read ACKs and errors for batched messages off the command socket.
+   Without BLOCK only what is queued already is read. */
+static void
+netlink_batch_read (int block)
+{
+  int status;
+
+  while (nl_batch.head != nl_batch.sent)
+    {
+      char buf[NL_PKT_BUF_SIZE];
+      struct iovec iov = { buf, sizeof buf };
+      struct sockaddr_nl snl;
+      struct msghdr msg = { (void *) &snl, sizeof snl, &iov, 1, NULL, 0, 0 };
+      struct nlmsghdr *h;
+
+      status = recvmsg (netlink_cmd.sock, &msg, block ? 0 : MSG_DONTWAIT);
+      if (status < 0)
+        {
+          if (errno == EINTR)
+            continue;
+          if (errno == EWOULDBLOCK || errno == EAGAIN)
+            break;
+          if (errno == ENOBUFS)
+            {
+              netlink_batch_abandon ();
+              break;
+            }
+          zlog (NULL, LOG_ERR, "%s recvmsg error: %s",
+                netlink_cmd.name, safe_strerror (errno));
+          break;
+        }
+      if (status == 0)
+        {
+          zlog (NULL, LOG_ERR, "%s EOF", netlink_cmd.name);
+          break;
+        }
+
+      for (h = (struct nlmsghdr *) buf; NLMSG_OK (h, (unsigned int) status);
+           h = NLMSG_NEXT (h, status))
+        {
+          struct nlmsgerr *err;
+
+          if (h->nlmsg_type != NLMSG_ERROR
+              || h->nlmsg_len < NLMSG_LENGTH (sizeof (struct nlmsgerr)))
+            {
+              zlog_warn ("%s: ignoring message type 0x%04x",
+                         netlink_cmd.name, h->nlmsg_type);
+              continue;
+            }
+
+          err = (struct nlmsgerr *) NLMSG_DATA (h);
+          if (IS_ZEBRA_DEBUG_KERNEL && err->error == 0)
+            zlog_debug ("%s: %s ACK: type=%s(%u), seq=%u, pid=%u",
+                        __func__, netlink_cmd.name,
+                        lookup (nlmsg_str, err->msg.nlmsg_type),
+                        err->msg.nlmsg_type, err->msg.nlmsg_seq,
+                        err->msg.nlmsg_pid);
+          netlink_batch_ack (err->msg.nlmsg_seq, -err->error);
+        }
+    }
+}
+
+static int
+netlink_batch_read_thread (struct thread *thread)
+{
+  nl_batch.t_read = NULL;
+
+  netlink_batch_read (0);
+  if (nl_batch.head != nl_batch.sent)
+    nl_batch.t_read = thread_add_read (zebrad.master,
+                                       netlink_batch_read_thread, NULL,
+                                       netlink_cmd.sock);
+  return 0;
+}
+
+/* Send the batch buffer to the kernel. */
+static void
+netlink_batch_flush (void)
+{
+  struct nlmsghdr *last;
+  struct sockaddr_nl snl;
+  struct iovec iov = { (void *) nl_batch.buf, nl_batch.len };
+  struct msghdr msg = { (void *) &snl, sizeof snl, &iov, 1, NULL, 0, 0 };
+  unsigned long count;
+  int status;
+  int save_errno;
+
+  THREAD_OFF (nl_batch.t_flush);
+  count = nl_batch.tail - nl_batch.sent;
+  if (count == 0)
+    return;
+
+  memset (&snl, 0, sizeof snl);
+  snl.nl_family = AF_NETLINK;
+
+  /* The ACK for the last message covers the whole batch. */
+  last = (struct nlmsghdr *) ((char *) nl_batch.buf + nl_batch.last);
+  last->nlmsg_flags |= NLM_F_ACK;
+
+  if (IS_ZEBRA_DEBUG_KERNEL)
+    zlog_debug ("%s: %s %lu messages, %lu bytes, seq=%u-%u", __func__,
+                netlink_cmd.name, count, (unsigned long) nl_batch.len,
+                NL_BATCH_ENTRY (nl_batch.sent)->seq, last->nlmsg_seq);
+
+  if (zserv_privs.change (ZPRIVS_RAISE))
+    zlog (NULL, LOG_ERR, "Can't raise privileges");
+  status = sendmsg (netlink_cmd.sock, &msg, 0);
+  save_errno = errno;
+  if (zserv_privs.change (ZPRIVS_LOWER))
+    zlog (NULL, LOG_ERR, "Can't lower privileges");
+
+  nl_batch.len = 0;
+
+  if (status < 0)
+    {
+      zlog (NULL, LOG_ERR, "%s sendmsg() error: %s",
+            netlink_cmd.name, safe_strerror (save_errno));
+      nl_batch.send_errors++;
+      while (nl_batch.sent != nl_batch.tail)
+        netlink_batch_done (NL_BATCH_ENTRY (--nl_batch.tail), save_errno);
+      return;
+    }
+
+  nl_batch.batches++;
+  nl_batch.messages += count;
+  nl_batch.bytes += status;
+  if (count > nl_batch.batch_max)
+    nl_batch.batch_max = count;
+
+  nl_batch.sent = nl_batch.tail;
+  if (nl_batch.sent - nl_batch.head > nl_batch.inflight_max)
+    nl_batch.inflight_max = nl_batch.sent - nl_batch.head;
+
+  if (! nl_batch.t_read)
+    nl_batch.t_read = thread_add_read (zebrad.master,
+                                       netlink_batch_read_thread, NULL,
+                                       netlink_cmd.sock);
+}
+
+static int
+netlink_batch_flush_thread (struct thread *thread)
+{
+  nl_batch.t_flush = NULL;
+  netlink_batch_flush ();
+  return 0;
+}
+
+/* Send whatever is batched and wait until the kernel has dealt with
+   all of it, so that the command socket can be used synchronously. */
+static void
+netlink_batch_sync (void)
+{
+  if (nl_batch.head == nl_batch.tail)
+    return;
+
+  nl_batch.syncs++;
+  netlink_batch_flush ();
+  while (nl_batch.head != nl_batch.sent)
+    netlink_batch_read (1);
+  THREAD_OFF (nl_batch.t_read);
+}
+
+/* Queue route change N for P and RIB on the batch buffer. */
+static int
+netlink_batch_add (struct nlmsghdr *n, struct prefix *p, struct rib *rib)
+{
+  struct nl_batch_entry *entry;
+  size_t len = NLMSG_ALIGN (n->nlmsg_len);
+
+  if (nl_batch.len + len > sizeof nl_batch.buf)
+    netlink_batch_flush ();
+  if (nl_batch.tail - nl_batch.head == NL_BATCH_RING_SIZE)
+    {
+      /* Replies to what was sent are most likely queued already. */
+      netlink_batch_read (0);
+      if (nl_batch.tail - nl_batch.head == NL_BATCH_RING_SIZE)
+        netlink_batch_sync ();
+    }
+
+  n->nlmsg_seq = ++netlink_cmd.seq;
+
+  if (IS_ZEBRA_DEBUG_KERNEL)
+    zlog_debug ("%s: %s type %s(%u), seq=%u", __func__, netlink_cmd.name,
+                lookup (nlmsg_str, n->nlmsg_type), n->nlmsg_type,
+                n->nlmsg_seq);
+
+  nl_batch.last = nl_batch.len;
+  memcpy ((char *) nl_batch.buf + nl_batch.len, n, n->nlmsg_len);
+  memset ((char *) nl_batch.buf + nl_batch.len + n->nlmsg_len, 0,
+          len - n->nlmsg_len);
+  nl_batch.len += len;
+
+  entry = NL_BATCH_ENTRY (nl_batch.tail++);
+  entry->seq = n->nlmsg_seq;
+  entry->cmd = n->nlmsg_type;
+  prefix_copy (&entry->p, p);
+  entry->rib = rib;
+
+  if (! nl_batch.t_flush)
+    nl_batch.t_flush = thread_add_event (zebrad.master,
+                                         netlink_batch_flush_thread, NULL, 0);
+  return 0;
+}
+
 static int
 netlink_talk_filter (struct sockaddr_nl *snl, struct nlmsghdr *h)
 {
@@ -1318,6 +1639,10 @@ netlink_talk (struct nlmsghdr *n, struct nlsock *nl)
   memset (&snl, 0, sizeof snl);
   snl.nl_family = AF_NETLINK;
 
+  /* Replies to batched route changes must not get in the way. */
+  if (nl == &netlink_cmd)
+    netlink_batch_sync ();
+
   n->nlmsg_seq = ++nl->seq;
 
   /* Request an acknowledgement by setting NLM_F_ACK */
@@ -1848,8 +2173,15 @@ skip:
   memset (&snl, 0, sizeof snl);
   snl.nl_family = AF_NETLINK;
 
-  /* Talk to netlink socket. */
-  return netlink_talk (&req.n, &netlink_cmd);
+  /* Queue on the batch for the netlink socket. */
+  return netlink_batch_add (&req.n, p, rib);
+}
+
+/* Wait for the kernel to act on all queued route changes. */
+void
+kernel_route_sync (void)
+{
+  netlink_batch_sync ();
 }
 
 int
@@ -1993,6 +2325,38 @@ static void netlink_install_filter (int sock, __u32 pid)
     zlog_warn ("Can't install socket filter: %s\n", safe_strerror(errno));
 }
 
+DEFUN (show_zebra_netlink_batch,
+       show_zebra_netlink_batch_cmd,
+       "show zebra netlink-batch",
+       SHOW_STR
+       "Zebra information\n"
+       "Batched netlink route changes\n")
+{
+  vty_out (vty, "Batches sent:           %lu%s", nl_batch.batches,
+           VTY_NEWLINE);
+  vty_out (vty, "Messages sent:          %lu (%lu bytes)%s",
+           nl_batch.messages, nl_batch.bytes, VTY_NEWLINE);
+  vty_out (vty, "Average batch size:     %lu%s",
+           nl_batch.batches ? nl_batch.messages / nl_batch.batches : 0,
+           VTY_NEWLINE);
+  vty_out (vty, "Largest batch:          %lu%s", nl_batch.batch_max,
+           VTY_NEWLINE);
+  vty_out (vty, "Queued, not sent:       %lu%s",
+           nl_batch.tail - nl_batch.sent, VTY_NEWLINE);
+  vty_out (vty, "In flight:              %lu (peak %lu)%s",
+           nl_batch.sent - nl_batch.head, nl_batch.inflight_max,
+           VTY_NEWLINE);
+  vty_out (vty, "Route errors:           %lu%s", nl_batch.errors,
+           VTY_NEWLINE);
+  vty_out (vty, "Send errors:            %lu%s", nl_batch.send_errors,
+           VTY_NEWLINE);
+  vty_out (vty, "Reply overruns:         %lu%s", nl_batch.overruns,
+           VTY_NEWLINE);
+  vty_out (vty, "Synchronous waits:      %lu%s", nl_batch.syncs,
+           VTY_NEWLINE);
+  return CMD_SUCCESS;
+}
+
 /* Exported interface function.  This function simply calls
    netlink_socket (). */
 void
@@ -2022,4 +2386,7 @@ kernel_init (void)
       netlink_install_filter (netlink.sock, netlink_cmd.snl.nl_pid);
       thread_add_read (zebrad.master, kernel_read, NULL, netlink.sock);
     }
+
+  install_element (VIEW_NODE, &show_zebra_netlink_batch_cmd);
+  install_element (ENABLE_NODE, &show_zebra_netlink_batch_cmd);
 }
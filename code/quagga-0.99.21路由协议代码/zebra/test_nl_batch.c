@@ -0,0 +1,252 @@
+/*
+ * Netlink route batch tests.
+ *
+ * This file is part of Quagga.
+ *
+ * Quagga is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2, or (at your option) any
+ * later version.
+ *
+ * Quagga is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Quagga; see the file COPYING.  If not, write to the Free
+ * Software Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ */
+
+/* Runs rt_netlink.o against a fake kernel, which stands in for the
+ * netlink command socket by way of sendmsg() and recvmsg() below.  Adds
+ * ROUTES routes and has the replies to their batches lost to ENOBUFS,
+ * then checks that the RIB installs every one of them again, and that
+ * they all end up in the FIB.
+ */
+#include <zebra.h>
+#include <sys/syscall.h>
+
+#include "thread.h"
+#include "command.h"
+#include "vty.h"
+#include "log.h"
+#include "if.h"
+#include "prefix.h"
+#include "table.h"
+#include "privs.h"
+#include "workqueue.h"
+
+#include "zebra/rib.h"
+#include "zebra/zserv.h"
+#include "zebra/rt.h"
+#include "zebra/interface.h"
+
+#define ROUTES 100
+
+struct zebra_t zebrad =
+{
+  .rtm_table_default = 0,
+};
+
+/* Pacify zclient.o in libzebra, which expects this variable. */
+struct thread_master *master;
+
+u_int32_t nl_rcvbufsize = 0;
+
+static int
+privs_change (zebra_privs_ops_t op)
+{
+  return 0;
+}
+
+struct zebra_privs_t zserv_privs =
+{
+  .change = privs_change,
+};
+
+/* The fake kernel. */
+static u_int32_t last_seq;
+static int replies;
+static int overrun;
+static int sends[ROUTES];
+
+/* The command socket is the netlink socket which joined no groups. */
+static int
+is_cmd_sock (int fd)
+{
+  struct sockaddr_nl snl;
+  socklen_t len = sizeof snl;
+
+  if (getsockname (fd, (struct sockaddr *) &snl, &len) < 0)
+    return 0;
+  return snl.nl_family == AF_NETLINK && snl.nl_groups == 0;
+}
+
+ssize_t
+sendmsg (int fd, const struct msghdr *msg, int flags)
+{
+  struct nlmsghdr *h;
+  struct rtmsg *rtm;
+  struct rtattr *rta;
+  struct in_addr dst;
+  int len, attrlen;
+
+  if (! is_cmd_sock (fd))
+    return syscall (SYS_sendmsg, fd, msg, flags);
+
+  len = msg->msg_iov[0].iov_len;
+  for (h = msg->msg_iov[0].iov_base; NLMSG_OK (h, (unsigned int) len);
+       h = NLMSG_NEXT (h, len))
+    {
+      last_seq = h->nlmsg_seq;
+      if (h->nlmsg_type != RTM_NEWROUTE)
+	continue;
+
+      rtm = NLMSG_DATA (h);
+      attrlen = h->nlmsg_len - NLMSG_LENGTH (sizeof *rtm);
+      for (rta = RTM_RTA (rtm); RTA_OK (rta, attrlen);
+	   rta = RTA_NEXT (rta, attrlen))
+	if (rta->rta_type == RTA_DST)
+	  {
+	    memcpy (&dst, RTA_DATA (rta), sizeof dst);
+	    sends[(ntohl (dst.s_addr) >> 8) & 0xff]++;
+	  }
+    }
+  replies++;
+  return msg->msg_iov[0].iov_len;
+}
+
+ssize_t
+recvmsg (int fd, struct msghdr *msg, int flags)
+{
+  struct nlmsghdr *h = msg->msg_iov[0].iov_base;
+  struct nlmsgerr *err;
+
+  if (! is_cmd_sock (fd))
+    return syscall (SYS_recvmsg, fd, msg, flags);
+
+  if (replies == 0)
+    {
+      errno = EAGAIN;
+      return -1;
+    }
+  replies = 0;
+
+  /* The socket buffer overflowed: every reply is gone. */
+  if (overrun)
+    {
+      overrun = 0;
+      errno = ENOBUFS;
+      return -1;
+    }
+
+  /* One ACK for the last message covers all of them. */
+  memset (h, 0, NLMSG_LENGTH (sizeof *err));
+  h->nlmsg_len = NLMSG_LENGTH (sizeof *err);
+  h->nlmsg_type = NLMSG_ERROR;
+  h->nlmsg_seq = last_seq;
+  err = NLMSG_DATA (h);
+  err->error = 0;
+  err->msg.nlmsg_type = RTM_NEWROUTE;
+  err->msg.nlmsg_seq = last_seq;
+  return h->nlmsg_len;
+}
+
+static struct prefix_ipv4 *
+route (int i)
+{
+  static struct prefix_ipv4 p;
+
+  p.family = AF_INET;
+  p.prefixlen = 24;
+  p.prefix.s_addr = htonl (0x0a000000 | (i << 8));
+  return &p;
+}
+
+/* Run the RIB until it is done with the queued nodes. */
+static void
+run (void)
+{
+  struct thread thread;
+
+  while (zebrad.mq->size && thread_fetch (zebrad.master, &thread))
+    thread_call (&thread);
+}
+
+/* Count the routes which are in the FIB. */
+static int
+installed (void)
+{
+  struct route_table *table;
+  struct route_node *rn;
+  struct rib *rib;
+  int i, count = 0;
+
+  table = vrf_table (AFI_IP, SAFI_UNICAST, 0);
+  for (i = 0; i < ROUTES; i++)
+    {
+      rn = route_node_lookup (table, (struct prefix *) route (i));
+      if (rn == NULL)
+	continue;
+      for (rib = rn->info; rib; rib = rib->next)
+	if (rib->nexthop
+	    && CHECK_FLAG (rib->nexthop->flags, NEXTHOP_FLAG_FIB))
+	  count++;
+      route_unlock_node (rn);
+    }
+  return count;
+}
+
+int
+main (int argc, char **argv)
+{
+  struct interface *ifp;
+  int i, n, failed = 0;
+
+  zebrad.master = master = thread_master_create ();
+  zlog_default = openzlog ("testnlbatch", ZLOG_NONE, 0, LOG_DAEMON);
+  zlog_set_level (NULL, ZLOG_DEST_STDOUT, ZLOG_DISABLED);
+  cmd_init (1);
+  vty_init (zebrad.master);
+  zebra_if_init ();
+  rib_init ();
+  kernel_init ();
+
+  ifp = if_get_by_name ("test0");
+  ifp->ifindex = 1;
+  ifp->flags = IFF_UP | IFF_RUNNING;
+
+  for (i = 0; i < ROUTES; i++)
+    rib_add_ipv4 (ZEBRA_ROUTE_STATIC, 0, route (i), NULL, NULL,
+		  ifp->ifindex, 0, 0, 0, SAFI_UNICAST);
+
+  /* The replies to the batches are lost, so the kernel may or may not
+     have the routes, and the RIB has to send them again. */
+  overrun = 1;
+  run ();
+  kernel_route_sync ();
+  if ((n = installed ()) != 0)
+    {
+      printf ("%d routes in the FIB after the overrun\n", n);
+      failed++;
+    }
+
+  run ();
+  kernel_route_sync ();
+  if ((n = installed ()) != ROUTES)
+    {
+      printf ("%d of %d routes in the FIB\n", n, ROUTES);
+      failed++;
+    }
+  for (i = 0; i < ROUTES; i++)
+    if (sends[i] != 2)
+      {
+	printf ("route %d sent %d times\n", i, sends[i]);
+	failed++;
+      }
+
+  printf ("failures: %d\n", failed);
+  return failed;
+}
@@ -40,6 +40,7 @@
 #include "zebra/zserv.h"
 #include "zebra/redistribute.h"
 #include "zebra/debug.h"
+#include "zebra/zebra_rnh.h"
 
 /* Default rtm_table for all clients */
 extern struct zebra_t zebrad;
@@ -50,6 +51,9 @@ extern struct zebra_t zebrad;
  */
 int rib_process_hold_time = 10;
 
+/* Initial number of route_nodes a meta queue sub-queue holds. */
+#define MQ_RING_MIN 64
+
 /* Each route type's string and default distance value. */
 static const struct
 {  
@@ -935,6 +939,44 @@ rib_install_kernel (struct route_node *rn, struct rib *rib)
     }
 }
 
+static void rib_queue_add (struct zebra_t *, struct route_node *);
+
+/* The kernel refused to install RIB for P after kernel_add_ipv4() or
+   kernel_add_ipv6() queued it.  Same as a failure reported straight
+   away, if RIB is still in the table.  With RETRY, the kernel's answer
+   was lost rather than known to be a refusal, so the node is processed
+   again, which installs RIB once more. */
+void
+rib_install_kernel_failed (struct prefix *p, struct rib *rib, int retry)
+{
+  struct route_table *table;
+  struct route_node *rn;
+  struct rib *match;
+  struct nexthop *nexthop;
+
+  table = vrf_table (family2afi (p->family), SAFI_UNICAST, 0);
+  if (! table)
+    return;
+
+  rn = route_node_lookup (table, p);
+  if (! rn)
+    return;
+
+  for (match = rn->info; match; match = match->next)
+    if (match == rib)
+      break;
+
+  if (match && ! CHECK_FLAG (match->status, RIB_ENTRY_REMOVED))
+    {
+      for (nexthop = match->nexthop; nexthop; nexthop = nexthop->next)
+	UNSET_FLAG (nexthop->flags, NEXTHOP_FLAG_FIB);
+      if (retry)
+	rib_queue_add (&zebrad, rn);
+    }
+
+  route_unlock_node (rn);
+}
+
 /* Uninstall the route from kernel. */
 static int
 rib_uninstall_kernel (struct route_node *rn, struct rib *rib)
@@ -1173,20 +1215,44 @@ end:
     zlog_debug ("%s: %s/%d: rn %p dequeued", __func__, buf, rn->p.prefixlen, rn);
 }
 
-/* Take a list of route_node structs and return 1, if there was a record
- * picked from it and processed by rib_process(). Don't process more, 
- * than one RN record; operate only in the specified sub-queue.
+/* Microseconds from START to NOW. */
+static unsigned long
+meta_queue_usec (struct timeval *start, struct timeval *now)
+{
+  if (now->tv_sec < start->tv_sec)
+    return 0;
+  return (now->tv_sec - start->tv_sec) * 1000000UL
+         + now->tv_usec - start->tv_usec;
+}
+
+/* Take a sub-queue of route_node structs and return 1, if there was a
+ * record picked from it and processed by rib_process(). Don't process
+ * more, than one RN record; operate only in the specified sub-queue.
+ * NOW is used to account the time the RN spent queued.
  */
 static unsigned int
-process_subq (struct list * subq, u_char qindex)
+process_subq (struct meta_subq *subq, u_char qindex, struct timeval *now)
 {
-  struct listnode *lnode  = listhead (subq);
+  struct meta_subq_entry *entry;
   struct route_node *rnode;
+  unsigned long usec;
+  int bucket;
 
-  if (!lnode)
+  if (!subq->count)
     return 0;
 
-  rnode = listgetdata (lnode);
+  entry = &subq->ring[subq->head];
+  rnode = entry->rn;
+  subq->head = (subq->head + 1) % subq->size;
+  subq->count--;
+
+  usec = meta_queue_usec (&entry->queued, now);
+  for (bucket = 0, usec /= 1000; usec && bucket < MQ_LATENCY_BUCKETS - 1;
+       bucket++, usec /= 10)
+    ;
+  subq->latency[bucket]++;
+  subq->processed++;
+
   rib_process (rnode);
 
   if (rnode->info) /* The first RIB record is holding the flags bitmask. */
@@ -1200,26 +1266,52 @@ process_subq (struct list * subq, u_char qindex)
     }
 #endif
   route_unlock_node (rnode);
-  list_delete_node (subq, lnode);
   return 1;
 }
 
-/* Dispatch the meta queue by picking, processing and unlocking the next RN from
- * a non-empty sub-queue with lowest priority. wq is equal to zebra->ribq and data
- * is pointed to the meta queue structure.
+/* Dispatch the meta queue by picking, processing and unlocking RNs from
+ * the non-empty sub-queue with lowest priority, until the queue is
+ * drained or the time slice is used up. wq is equal to zebra->ribq and
+ * data is pointed to the meta queue structure. Kernel updates made by
+ * rib_process() are batched up and go out once the run is over.
  */
 static wq_item_status
 meta_queue_process (struct work_queue *dummy, void *data)
 {
   struct meta_queue * mq = data;
+  struct timeval start, now;
+  unsigned long batch = 0;
   unsigned i;
 
-  for (i = 0; i < MQ_SIZE; i++)
-    if (process_subq (mq->subq[i], i))
-      {
-	mq->size--;
-	break;
-      }
+  quagga_gettime (QUAGGA_CLK_MONOTONIC, &start);
+  now = start;
+
+  while (mq->size)
+    {
+      for (i = 0; i < MQ_SIZE; i++)
+        if (process_subq (&mq->subq[i], i, &now))
+          {
+            mq->size--;
+            batch++;
+            break;
+          }
+      assert (i < MQ_SIZE);
+
+      quagga_gettime (QUAGGA_CLK_MONOTONIC, &now);
+      if (meta_queue_usec (&start, &now) >= mq->time_slice * 1000UL)
+        break;
+    }
+
+  mq->runs++;
+  mq->batch_total += batch;
+  mq->batch_last = batch;
+  if (batch > mq->batch_max)
+    mq->batch_max = batch;
+
+  /* Tell clients about nexthops this has moved. */
+  if (batch)
+    zebra_rnh_schedule ();
+
   return mq->size ? WQ_REQUEUE : WQ_SUCCESS;
 }
 
@@ -1239,6 +1331,36 @@ static const u_char meta_queue_map[ZEBRA_ROUTE_MAX] = {
   [ZEBRA_ROUTE_BABEL]   = 2,
 };
 
+/* Append RN to the ring of SUBQ, doubling it when full. */
+static void
+meta_subq_add (struct meta_subq *subq, struct route_node *rn)
+{
+  struct meta_subq_entry *entry;
+
+  if (subq->count == subq->size)
+    {
+      struct meta_subq_entry *ring;
+      u_int32_t size = subq->size ? subq->size * 2 : MQ_RING_MIN;
+      u_int32_t i;
+
+      ring = XMALLOC (MTYPE_RIB_QUEUE, size * sizeof (struct meta_subq_entry));
+      for (i = 0; i < subq->count; i++)
+        ring[i] = subq->ring[(subq->head + i) % subq->size];
+      if (subq->ring)
+        XFREE (MTYPE_RIB_QUEUE, subq->ring);
+      subq->ring = ring;
+      subq->head = 0;
+      subq->size = size;
+    }
+
+  entry = &subq->ring[(subq->head + subq->count) % subq->size];
+  entry->rn = rn;
+  entry->queued = recent_relative_time ();
+  subq->count++;
+  if (subq->count > subq->count_max)
+    subq->count_max = subq->count;
+}
+
 /* Look into the RN and queue it into one or more priority queues,
  * increasing the size for each data push done.
  */
@@ -1265,7 +1387,7 @@ rib_meta_queue_add (struct meta_queue *mq, struct route_node *rn)
 	}
 
       SET_FLAG (((struct rib *)rn->info)->rn_status, RIB_ROUTE_QUEUED(qindex));
-      listnode_add (mq->subq[qindex], rn);
+      meta_subq_add (&mq->subq[qindex], rn);
       route_lock_node (rn);
       mq->size++;
 
@@ -1331,16 +1453,11 @@ static struct meta_queue *
 meta_queue_new (void)
 {
   struct meta_queue *new;
-  unsigned i;
 
   new = XCALLOC (MTYPE_WORK_QUEUE, sizeof (struct meta_queue));
   assert(new);
 
-  for (i = 0; i < MQ_SIZE; i++)
-    {
-      new->subq[i] = list_new ();
-      assert(new->subq[i]);
-    }
+  new->time_slice = MQ_TIME_SLICE_DEFAULT;
 
   return new;
 }
@@ -2978,6 +3095,7 @@ rib_close (void)
 {
   rib_close_table (vrf_table (AFI_IP, SAFI_UNICAST, 0));
   rib_close_table (vrf_table (AFI_IP6, SAFI_UNICAST, 0));
+  kernel_route_sync ();
 }
 
 /* Routing information base initialize. */
@@ -0,0 +1,351 @@
+/*
+ * Nexthop tracking for zebra clients.
+ *
+ * This file is part of Quagga routing suite.
+ *
+ * Quagga is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2, or (at your option) any
+ * later version.
+ *
+ * Quagga is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Zebra; see the file COPYING.  If not, write to the Free
+ * Software Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ */
+
+/* Clients register the nexthop addresses they depend on, and are sent
+ * ZEBRA_NEXTHOP_UPDATE with how each resolves: at once, and then every
+ * time that changes.  After every batch of RIB processing, all
+ * registered addresses are looked up again and the result compared with
+ * what was last sent, so the cost follows the number of registered
+ * nexthops rather than the size of the RIB.
+ */
+
+#include <zebra.h>
+
+#include "prefix.h"
+#include "table.h"
+#include "memory.h"
+#include "linklist.h"
+#include "stream.h"
+#include "thread.h"
+#include "command.h"
+#include "log.h"
+#include "zclient.h"
+
+#include "zebra/rib.h"
+#include "zebra/zserv.h"
+#include "zebra/debug.h"
+#include "zebra/zebra_rnh.h"
+
+extern struct zebra_t zebrad;
+
+/* Registered nexthops, by address. */
+static struct route_table *rnh_table[AFI_MAX];
+
+static struct thread *t_rnh_evaluate;
+static struct stream *rnh_stream;
+
+/* Statistics. */
+static unsigned long rnh_count;
+static unsigned long rnh_runs;
+static unsigned long rnh_updates;
+
+static struct route_table *
+zebra_rnh_table (struct prefix *p)
+{
+  if (p->family == AF_INET)
+    return rnh_table[AFI_IP];
+#ifdef HAVE_IPV6
+  if (p->family == AF_INET6)
+    return rnh_table[AFI_IP6];
+#endif /* HAVE_IPV6 */
+  return NULL;
+}
+
+/* Put how P resolves now into S: metric, nexthop count, nexthops. */
+static void
+zebra_rnh_resolve (struct stream *s, struct prefix *p)
+{
+  struct rib *rib = NULL;
+  struct nexthop *nexthop;
+  unsigned long nump;
+  u_char num;
+
+  if (p->family == AF_INET)
+    rib = rib_match_ipv4 (p->u.prefix4);
+#ifdef HAVE_IPV6
+  else if (p->family == AF_INET6)
+    rib = rib_match_ipv6 (&p->u.prefix6);
+#endif /* HAVE_IPV6 */
+
+  if (! rib)
+    {
+      stream_putl (s, 0);
+      stream_putc (s, 0);
+      return;
+    }
+
+  stream_putl (s, rib->metric);
+  num = 0;
+  nump = stream_get_endp (s);
+  stream_putc (s, 0);
+  for (nexthop = rib->nexthop; nexthop; nexthop = nexthop->next)
+    if (CHECK_FLAG (nexthop->flags, NEXTHOP_FLAG_FIB))
+      {
+	stream_putc (s, nexthop->type);
+	switch (nexthop->type)
+	  {
+	  case ZEBRA_NEXTHOP_IPV4:
+	    stream_put_in_addr (s, &nexthop->gate.ipv4);
+	    break;
+	  case ZEBRA_NEXTHOP_IPV4_IFINDEX:
+	    stream_put_in_addr (s, &nexthop->gate.ipv4);
+	    stream_putl (s, nexthop->ifindex);
+	    break;
+	  case ZEBRA_NEXTHOP_IFINDEX:
+	  case ZEBRA_NEXTHOP_IFNAME:
+	    stream_putl (s, nexthop->ifindex);
+	    break;
+#ifdef HAVE_IPV6
+	  case ZEBRA_NEXTHOP_IPV6:
+	    stream_put (s, &nexthop->gate.ipv6, 16);
+	    break;
+	  case ZEBRA_NEXTHOP_IPV6_IFINDEX:
+	  case ZEBRA_NEXTHOP_IPV6_IFNAME:
+	    stream_put (s, &nexthop->gate.ipv6, 16);
+	    stream_putl (s, nexthop->ifindex);
+	    break;
+#endif /* HAVE_IPV6 */
+	  default:
+	    /* do nothing */
+	    break;
+	  }
+	num++;
+      }
+  stream_putc_at (s, nump, num);
+}
+
+static void
+zebra_rnh_send (struct zserv *client, struct rnh *rnh)
+{
+  zsend_nexthop_update (client, &rnh->node->p, rnh->state, rnh->state_len);
+  rnh_updates++;
+}
+
+/* Look RNH up again.  If the result has changed, tell all its clients;
+   otherwise tell just ONLY, if that is given. */
+static void
+zebra_rnh_evaluate (struct rnh *rnh, struct zserv *only)
+{
+  struct listnode *node, *nnode;
+  struct zserv *client;
+  struct stream *s = rnh_stream;
+  u_int16_t len;
+
+  stream_reset (s);
+  zebra_rnh_resolve (s, &rnh->node->p);
+  len = stream_get_endp (s);
+
+  if (rnh->state && len == rnh->state_len
+      && memcmp (rnh->state, STREAM_DATA (s), len) == 0)
+    {
+      if (only)
+	zebra_rnh_send (only, rnh);
+      return;
+    }
+
+  rnh->state = XREALLOC (MTYPE_RNH, rnh->state, len);
+  memcpy (rnh->state, STREAM_DATA (s), len);
+  rnh->state_len = len;
+  rnh->changes++;
+
+  if (IS_ZEBRA_DEBUG_EVENT)
+    {
+      char buf[INET6_ADDRSTRLEN];
+
+      zlog_debug ("nexthop %s changed, notifying %d client(s)",
+		  inet_ntop (rnh->node->p.family, &rnh->node->p.u.prefix,
+			     buf, sizeof (buf)),
+		  listcount (rnh->client_list));
+    }
+
+  for (ALL_LIST_ELEMENTS (rnh->client_list, node, nnode, client))
+    zebra_rnh_send (client, rnh);
+}
+
+static int
+zebra_rnh_evaluate_all (struct thread *thread)
+{
+  struct route_node *rn;
+  afi_t afi;
+
+  t_rnh_evaluate = NULL;
+  rnh_runs++;
+
+  for (afi = AFI_IP; afi < AFI_MAX; afi++)
+    if (rnh_table[afi])
+      for (rn = route_top (rnh_table[afi]); rn; rn = route_next (rn))
+	if (rn->info)
+	  zebra_rnh_evaluate (rn->info, NULL);
+
+  return 0;
+}
+
+void
+zebra_rnh_schedule (void)
+{
+  if (rnh_count && ! t_rnh_evaluate)
+    t_rnh_evaluate = thread_add_event (zebrad.master, zebra_rnh_evaluate_all,
+				       NULL, 0);
+}
+
+static void
+zebra_rnh_free (struct rnh *rnh)
+{
+  struct route_node *rn = rnh->node;
+
+  list_delete (rnh->client_list);
+  if (rnh->state)
+    XFREE (MTYPE_RNH, rnh->state);
+  XFREE (MTYPE_RNH, rnh);
+  rnh_count--;
+
+  rn->info = NULL;
+  route_unlock_node (rn);
+}
+
+void
+zebra_rnh_register (struct zserv *client, struct prefix *p)
+{
+  struct route_table *table;
+  struct route_node *rn;
+  struct rnh *rnh;
+
+  if (! (table = zebra_rnh_table (p)))
+    return;
+
+  rn = route_node_get (table, p);
+  if (rn->info)
+    {
+      rnh = rn->info;
+      route_unlock_node (rn);
+    }
+  else
+    {
+      rnh = XCALLOC (MTYPE_RNH, sizeof (struct rnh));
+      rnh->node = rn;
+      rnh->client_list = list_new ();
+      rn->info = rnh;
+      rnh_count++;
+    }
+
+  if (! listnode_lookup (rnh->client_list, client))
+    listnode_add (rnh->client_list, client);
+
+  zebra_rnh_evaluate (rnh, client);
+}
+
+void
+zebra_rnh_unregister (struct zserv *client, struct prefix *p)
+{
+  struct route_table *table;
+  struct route_node *rn;
+  struct rnh *rnh;
+
+  if (! (table = zebra_rnh_table (p)))
+    return;
+
+  rn = route_node_lookup (table, p);
+  if (! rn)
+    return;
+
+  if ((rnh = rn->info) != NULL)
+    {
+      listnode_delete (rnh->client_list, client);
+      if (listcount (rnh->client_list) == 0)
+	zebra_rnh_free (rnh);
+    }
+  route_unlock_node (rn);
+}
+
+/* Drop all registrations of a client going away. */
+void
+zebra_rnh_client_close (struct zserv *client)
+{
+  struct route_node *rn;
+  struct rnh *rnh;
+  afi_t afi;
+
+  for (afi = AFI_IP; afi < AFI_MAX; afi++)
+    if (rnh_table[afi])
+      for (rn = route_top (rnh_table[afi]); rn; rn = route_next (rn))
+	if ((rnh = rn->info) != NULL)
+	  {
+	    listnode_delete (rnh->client_list, client);
+	    if (listcount (rnh->client_list) == 0)
+	      zebra_rnh_free (rnh);
+	  }
+}
+
+static void
+zebra_rnh_show (struct vty *vty, struct rnh *rnh)
+{
+  struct prefix *p = &rnh->node->p;
+  char buf[INET6_ADDRSTRLEN];
+  u_int32_t metric;
+
+  vty_out (vty, " %s", inet_ntop (p->family, &p->u.prefix, buf, sizeof (buf)));
+  if (rnh->state_len > 4 && rnh->state[4])
+    {
+      memcpy (&metric, rnh->state, 4);
+      vty_out (vty, " resolved, metric %u, %d nexthop(s)",
+	       ntohl (metric), rnh->state[4]);
+    }
+  else
+    vty_out (vty, " unresolved");
+  vty_out (vty, ", %d client(s), changed %lu time(s)%s",
+	   listcount (rnh->client_list), rnh->changes, VTY_NEWLINE);
+}
+
+DEFUN (show_ip_nht,
+       show_ip_nht_cmd,
+       "show ip nht",
+       SHOW_STR
+       IP_STR
+       "Nexthop tracking\n")
+{
+  struct route_node *rn;
+  afi_t afi;
+
+  vty_out (vty, "%lu registered nexthop(s), evaluated %lu time(s), "
+	   "%lu update(s) sent%s", rnh_count, rnh_runs, rnh_updates,
+	   VTY_NEWLINE);
+
+  for (afi = AFI_IP; afi < AFI_MAX; afi++)
+    if (rnh_table[afi])
+      for (rn = route_top (rnh_table[afi]); rn; rn = route_next (rn))
+	if (rn->info)
+	  zebra_rnh_show (vty, rn->info);
+
+  return CMD_SUCCESS;
+}
+
+void
+zebra_rnh_init (void)
+{
+  rnh_table[AFI_IP] = route_table_init ();
+#ifdef HAVE_IPV6
+  rnh_table[AFI_IP6] = route_table_init ();
+#endif /* HAVE_IPV6 */
+  rnh_stream = stream_new (ZEBRA_MAX_PACKET_SIZ);
+
+  install_element (VIEW_NODE, &show_ip_nht_cmd);
+  install_element (ENABLE_NODE, &show_ip_nht_cmd);
+}
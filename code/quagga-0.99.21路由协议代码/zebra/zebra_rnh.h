@@ -0,0 +1,51 @@
+/*
+ * Nexthop tracking for zebra clients.
+ *
+ * This file is part of Quagga routing suite.
+ *
+ * Quagga is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2, or (at your option) any
+ * later version.
+ *
+ * Quagga is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Zebra; see the file COPYING.  If not, write to the Free
+ * Software Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ */
+
+#ifndef _ZEBRA_RNH_H
+#define _ZEBRA_RNH_H
+
+/* A nexthop address clients have registered interest in. */
+struct rnh
+{
+  struct route_node *node;
+
+  /* Registered clients. */
+  struct list *client_list;
+
+  /* How the address resolved when it was last evaluated, as sent in
+     ZEBRA_NEXTHOP_UPDATE after the address: metric, nexthop count and
+     nexthops. */
+  u_char *state;
+  u_int16_t state_len;
+
+  /* Number of times that changed. */
+  unsigned long changes;
+};
+
+extern void zebra_rnh_init (void);
+extern void zebra_rnh_register (struct zserv *, struct prefix *);
+extern void zebra_rnh_unregister (struct zserv *, struct prefix *);
+extern void zebra_rnh_client_close (struct zserv *);
+
+/* The RIB has changed: evaluate registered nexthops again, soon. */
+extern void zebra_rnh_schedule (void);
+
+#endif /* _ZEBRA_RNH_H */
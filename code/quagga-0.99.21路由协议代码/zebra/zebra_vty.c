@@ -30,6 +30,8 @@
 
 #include "zebra/zserv.h"
 
+extern struct zebra_t zebrad;
+
 /* General fucntion for static route. */
 static int
 zebra_static_ipv4 (struct vty *vty, int add_cmd, const char *dest_str,
@@ -2108,9 +2110,83 @@ static int config_write_protocol(struct vty *vty)
       vty_out (vty, "ip protocol %s route-map %s%s", "any",
                proto_rm[AFI_IP][ZEBRA_ROUTE_MAX], VTY_NEWLINE);
 
+  if (zebrad.mq->time_slice != MQ_TIME_SLICE_DEFAULT)
+    vty_out (vty, "rib-queue time-slice %u%s", zebrad.mq->time_slice,
+             VTY_NEWLINE);
+
   return 1;
 }   
 
+DEFUN (rib_queue_time_slice,
+       rib_queue_time_slice_cmd,
+       "rib-queue time-slice <1-1000>",
+       "RIB processing queue\n"
+       "Time a run of the queue may go on for\n"
+       "Milliseconds\n")
+{
+  u_int32_t msec;
+
+  VTY_GET_INTEGER_RANGE ("time slice", msec, argv[0], 1, 1000);
+  zebrad.mq->time_slice = msec;
+  return CMD_SUCCESS;
+}
+
+DEFUN (no_rib_queue_time_slice,
+       no_rib_queue_time_slice_cmd,
+       "no rib-queue time-slice",
+       NO_STR
+       "RIB processing queue\n"
+       "Time a run of the queue may go on for\n")
+{
+  zebrad.mq->time_slice = MQ_TIME_SLICE_DEFAULT;
+  return CMD_SUCCESS;
+}
+
+ALIAS (no_rib_queue_time_slice,
+       no_rib_queue_time_slice_val_cmd,
+       "no rib-queue time-slice <1-1000>",
+       NO_STR
+       "RIB processing queue\n"
+       "Time a run of the queue may go on for\n"
+       "Milliseconds\n")
+
+DEFUN (show_zebra_rib_queue,
+       show_zebra_rib_queue_cmd,
+       "show zebra rib-queue",
+       SHOW_STR
+       "Zebra information\n"
+       "RIB processing queue\n")
+{
+  struct meta_queue *mq = zebrad.mq;
+  static const char *qname[MQ_SIZE] =
+    { "connected", "static", "IGP", "BGP", "other" };
+  unsigned i, j;
+
+  vty_out (vty, "Queued route nodes: %u, time slice %u msec%s",
+           mq->size, mq->time_slice, VTY_NEWLINE);
+  vty_out (vty, "Runs: %lu, nodes per run: last %lu, average %lu, max %lu%s",
+           mq->runs, mq->batch_last,
+           mq->runs ? mq->batch_total / mq->runs : 0, mq->batch_max,
+           VTY_NEWLINE);
+  vty_out (vty, "%s%-10s %8s %8s %10s   Queued for (msec)%s",
+           VTY_NEWLINE, "Sub-queue", "Depth", "Peak", "Processed",
+           VTY_NEWLINE);
+  vty_out (vty, "%-10s %8s %8s %10s %8s %8s %8s %8s %8s %8s%s",
+           "", "", "", "", "<1", "<10", "<100", "<1000", "<10000", "more",
+           VTY_NEWLINE);
+  for (i = 0; i < MQ_SIZE; i++)
+    {
+      struct meta_subq *subq = &mq->subq[i];
+
+      vty_out (vty, "%-10s %8u %8u %10lu", qname[i],
+               subq->count, subq->count_max, subq->processed);
+      for (j = 0; j < MQ_LATENCY_BUCKETS; j++)
+        vty_out (vty, " %8lu", subq->latency[j]);
+      vty_out (vty, "%s", VTY_NEWLINE);
+    }
+  return CMD_SUCCESS;
+}
+
 /* table node for protocol filtering */
 static struct cmd_node protocol_node = { PROTOCOL_NODE, "", 1 };
 
@@ -2128,6 +2204,11 @@ zebra_vty_init (void)
   install_element (CONFIG_NODE, &no_ip_protocol_cmd);
   install_element (VIEW_NODE, &show_ip_protocol_cmd);
   install_element (ENABLE_NODE, &show_ip_protocol_cmd);
+  install_element (CONFIG_NODE, &rib_queue_time_slice_cmd);
+  install_element (CONFIG_NODE, &no_rib_queue_time_slice_cmd);
+  install_element (CONFIG_NODE, &no_rib_queue_time_slice_val_cmd);
+  install_element (VIEW_NODE, &show_zebra_rib_queue_cmd);
+  install_element (ENABLE_NODE, &show_zebra_rib_queue_cmd);
   install_element (CONFIG_NODE, &ip_route_cmd);
   install_element (CONFIG_NODE, &ip_route_flags_cmd);
   install_element (CONFIG_NODE, &ip_route_flags2_cmd);
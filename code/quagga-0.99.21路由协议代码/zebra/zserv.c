@@ -42,6 +42,7 @@
 #include "zebra/redistribute.h"
 #include "zebra/debug.h"
 #include "zebra/ipforward.h"
+#include "zebra/zebra_rnh.h"
 
 /* Event list of zebra. */
 enum event { ZEBRA_SERV, ZEBRA_READ, ZEBRA_WRITE };
@@ -584,6 +585,28 @@ zsend_ipv4_nexthop_lookup (struct zserv *client, struct in_addr addr)
   return zebra_server_send_message(client);
 }
 
+/* Tell CLIENT how the registered nexthop P resolves.  STATE is the
+   metric, nexthop count and nexthops as in a nexthop lookup reply. */
+int
+zsend_nexthop_update (struct zserv *client, struct prefix *p,
+		      u_char *state, u_int16_t len)
+{
+  struct stream *s;
+
+  s = client->obuf;
+  stream_reset (s);
+
+  zserv_create_header (s, ZEBRA_NEXTHOP_UPDATE);
+  stream_putw (s, p->family);
+  stream_putc (s, p->prefixlen);
+  stream_put (s, &p->u.prefix, PSIZE (p->prefixlen));
+  stream_put (s, state, len);
+
+  stream_putw_at (s, 0, stream_get_endp (s));
+
+  return zebra_server_send_message(client);
+}
+
 static int
 zsend_ipv4_import_lookup (struct zserv *client, struct prefix_ipv4 *p)
 {
@@ -1046,6 +1069,36 @@ zread_ipv6_nexthop_lookup (struct zserv *client, u_short length)
 }
 #endif /* HAVE_IPV6 */
 
+/* Nexthop tracking (un)registration. */
+static int
+zread_nexthop_register (int command, struct zserv *client, u_short length)
+{
+  struct stream *s = client->ibuf;
+  struct prefix p;
+
+  memset (&p, 0, sizeof (struct prefix));
+  p.family = stream_getw (s);
+  p.prefixlen = stream_getc (s);
+
+  if ((p.family != AF_INET || p.prefixlen != IPV4_MAX_BITLEN)
+#ifdef HAVE_IPV6
+      && (p.family != AF_INET6 || p.prefixlen != IPV6_MAX_BITLEN)
+#endif /* HAVE_IPV6 */
+      )
+    {
+      zlog_warn ("%s: bad nexthop from client %d, family %d length %d",
+		 __func__, client->sock, p.family, p.prefixlen);
+      return -1;
+    }
+  stream_get (&p.u.prefix, s, PSIZE (p.prefixlen));
+
+  if (command == ZEBRA_NEXTHOP_REGISTER)
+    zebra_rnh_register (client, &p);
+  else
+    zebra_rnh_unregister (client, &p);
+  return 0;
+}
+
 /* Register zebra server router-id information.  Send current router-id */
 static int
 zread_router_id_add (struct zserv *client, u_short length)
@@ -1115,6 +1168,9 @@ zebra_score_rib (int client_sock)
 static void
 zebra_client_close (struct zserv *client)
 {
+  /* Forget the nexthops it was tracking. */
+  zebra_rnh_client_close (client);
+
   /* Close file descriptor. */
   if (client->sock)
     {
@@ -1124,6 +1180,8 @@ zebra_client_close (struct zserv *client)
     }
 
   /* Free stream buffers. */
+  if (client->rb)
+    stream_free (client->rb);
   if (client->ibuf)
     stream_free (client->ibuf);
   if (client->obuf)
@@ -1154,6 +1212,7 @@ zebra_client_create (int sock)
 
   /* Make client input/output buffer. */
   client->sock = sock;
+  client->rb = stream_new (ZSERV_READ_SIZE);
   client->ibuf = stream_new (ZEBRA_MAX_PACKET_SIZ);
   client->obuf = stream_new (ZEBRA_MAX_PACKET_SIZ);
   client->wb = buffer_new(0);
@@ -1168,106 +1227,15 @@ zebra_client_create (int sock)
   zebra_event (ZEBRA_READ, sock, client);
 }
 
-/* Handler of zebra service request. */
-static int
-zebra_client_read (struct thread *thread)
+/* Hand a message read from the client, in client->ibuf past its header,
+   to its handler. */
+static void
+zebra_client_dispatch (struct zserv *client, uint16_t command,
+		       uint16_t length)
 {
-  int sock;
-  struct zserv *client;
-  size_t already;
-  uint16_t length, command;
-  uint8_t marker, version;
-
-  /* Get thread data.  Reset reading thread because I'm running. */
-  sock = THREAD_FD (thread);
-  client = THREAD_ARG (thread);
-  client->t_read = NULL;
-
-  if (client->t_suicide)
-    {
-      zebra_client_close(client);
-      return -1;
-    }
-
-  /* Read length and command (if we don't have it already). */
-  if ((already = stream_get_endp(client->ibuf)) < ZEBRA_HEADER_SIZE)
-    {
-      ssize_t nbyte;
-      if (((nbyte = stream_read_try (client->ibuf, sock,
-				     ZEBRA_HEADER_SIZE-already)) == 0) ||
-	  (nbyte == -1))
-	{
-	  if (IS_ZEBRA_DEBUG_EVENT)
-	    zlog_debug ("connection closed socket [%d]", sock);
-	  zebra_client_close (client);
-	  return -1;
-	}
-      if (nbyte != (ssize_t)(ZEBRA_HEADER_SIZE-already))
-	{
-	  /* Try again later. */
-	  zebra_event (ZEBRA_READ, sock, client);
-	  return 0;
-	}
-      already = ZEBRA_HEADER_SIZE;
-    }
-
-  /* Reset to read from the beginning of the incoming packet. */
-  stream_set_getp(client->ibuf, 0);
-
-  /* Fetch header values */
-  length = stream_getw (client->ibuf);
-  marker = stream_getc (client->ibuf);
-  version = stream_getc (client->ibuf);
-  command = stream_getw (client->ibuf);
-
-  if (marker != ZEBRA_HEADER_MARKER || version != ZSERV_VERSION)
-    {
-      zlog_err("%s: socket %d version mismatch, marker %d, version %d",
-               __func__, sock, marker, version);
-      zebra_client_close (client);
-      return -1;
-    }
-  if (length < ZEBRA_HEADER_SIZE) 
-    {
-      zlog_warn("%s: socket %d message length %u is less than header size %d",
-	        __func__, sock, length, ZEBRA_HEADER_SIZE);
-      zebra_client_close (client);
-      return -1;
-    }
-  if (length > STREAM_SIZE(client->ibuf))
-    {
-      zlog_warn("%s: socket %d message length %u exceeds buffer size %lu",
-	        __func__, sock, length, (u_long)STREAM_SIZE(client->ibuf));
-      zebra_client_close (client);
-      return -1;
-    }
-
-  /* Read rest of data. */
-  if (already < length)
-    {
-      ssize_t nbyte;
-      if (((nbyte = stream_read_try (client->ibuf, sock,
-				     length-already)) == 0) ||
-	  (nbyte == -1))
-	{
-	  if (IS_ZEBRA_DEBUG_EVENT)
-	    zlog_debug ("connection closed [%d] when reading zebra data", sock);
-	  zebra_client_close (client);
-	  return -1;
-	}
-      if (nbyte != (ssize_t)(length-already))
-        {
-	  /* Try again later. */
-	  zebra_event (ZEBRA_READ, sock, client);
-	  return 0;
-	}
-    }
-
-  length -= ZEBRA_HEADER_SIZE;
-
   /* Debug packet information. */
   if (IS_ZEBRA_DEBUG_EVENT)
-    zlog_debug ("zebra message comes from socket [%d]", sock);
+    zlog_debug ("zebra message comes from socket [%d]", client->sock);
 
   if (IS_ZEBRA_DEBUG_PACKET && IS_ZEBRA_DEBUG_RECV)
     zlog_debug ("zebra message received [%s] %d", 
@@ -1327,19 +1295,111 @@ zebra_client_read (struct thread *thread)
     case ZEBRA_HELLO:
       zread_hello (client);
       break;
+    case ZEBRA_NEXTHOP_REGISTER:
+    case ZEBRA_NEXTHOP_UNREGISTER:
+      zread_nexthop_register (command, client, length);
+      break;
     default:
       zlog_info ("Zebra received unknown command %d", command);
       break;
     }
+}
+
+/* Handler of zebra service request.  Reads what the client has sent, as
+   far as client->rb holds, and handles every whole message in it: a
+   client sending a burst of routes corks them into large writes, and
+   they are read back in as few. */
+static int
+zebra_client_read (struct thread *thread)
+{
+  int sock;
+  struct zserv *client;
+  ssize_t nbyte;
+  size_t getp;
+  uint16_t length, command;
+  uint8_t marker, version;
+
+  /* Get thread data.  Reset reading thread because I'm running. */
+  sock = THREAD_FD (thread);
+  client = THREAD_ARG (thread);
+  client->t_read = NULL;
 
   if (client->t_suicide)
     {
-      /* No need to wait for thread callback, just kill immediately. */
       zebra_client_close(client);
       return -1;
     }
 
-  stream_reset (client->ibuf);
+  nbyte = stream_read_try (client->rb, sock, STREAM_WRITEABLE (client->rb));
+  if (nbyte == 0 || nbyte == -1)
+    {
+      if (IS_ZEBRA_DEBUG_EVENT)
+	zlog_debug ("connection closed socket [%d]", sock);
+      zebra_client_close (client);
+      return -1;
+    }
+  if (nbyte == -2)
+    {
+      /* Try again later. */
+      zebra_event (ZEBRA_READ, sock, client);
+      return 0;
+    }
+  client->reads++;
+
+  while (STREAM_READABLE (client->rb) >= ZEBRA_HEADER_SIZE)
+    {
+      /* Fetch header values */
+      getp = stream_get_getp (client->rb);
+      length = stream_getw_from (client->rb, getp);
+      marker = stream_getc_from (client->rb, getp + 2);
+      version = stream_getc_from (client->rb, getp + 3);
+      command = stream_getw_from (client->rb, getp + 4);
+
+      if (marker != ZEBRA_HEADER_MARKER || version != ZSERV_VERSION)
+	{
+	  zlog_err("%s: socket %d version mismatch, marker %d, version %d",
+		   __func__, sock, marker, version);
+	  zebra_client_close (client);
+	  return -1;
+	}
+      if (length < ZEBRA_HEADER_SIZE) 
+	{
+	  zlog_warn("%s: socket %d message length %u is less than header size %d",
+		    __func__, sock, length, ZEBRA_HEADER_SIZE);
+	  zebra_client_close (client);
+	  return -1;
+	}
+      if (length > STREAM_SIZE(client->ibuf))
+	{
+	  zlog_warn("%s: socket %d message length %u exceeds buffer size %lu",
+		    __func__, sock, length, (u_long)STREAM_SIZE(client->ibuf));
+	  zebra_client_close (client);
+	  return -1;
+	}
+
+      /* The rest of it is still to come. */
+      if (STREAM_READABLE (client->rb) < length)
+	break;
+
+      /* Handlers read the message from ibuf, past the header. */
+      stream_reset (client->ibuf);
+      stream_put (client->ibuf, stream_pnt (client->rb), length);
+      stream_forward_getp (client->rb, length);
+      stream_set_getp (client->ibuf, ZEBRA_HEADER_SIZE);
+
+      zebra_client_dispatch (client, command, length - ZEBRA_HEADER_SIZE);
+      client->messages++;
+
+      if (client->t_suicide)
+	{
+	  /* No need to wait for thread callback, just kill immediately. */
+	  zebra_client_close(client);
+	  return -1;
+	}
+    }
+
+  /* Keep the start of a message for the next read. */
+  stream_pulldown (client->rb);
   zebra_event (ZEBRA_READ, sock, client);
   return 0;
 }
@@ -1600,7 +1660,8 @@ DEFUN (show_zebra_client,
   struct zserv *client;
 
   for (ALL_LIST_ELEMENTS_RO (zebrad.client_list, node, client))
-    vty_out (vty, "Client fd %d%s", client->sock, VTY_NEWLINE);
+    vty_out (vty, "Client fd %d: %lu messages in %lu reads%s", client->sock,
+	     client->messages, client->reads, VTY_NEWLINE);
   
   return CMD_SUCCESS;
 }
@@ -1776,6 +1837,9 @@ zebra_init (void)
 
   /* Route-map */
   zebra_route_map_init ();
+
+  /* Nexthop tracking. */
+  zebra_rnh_init ();
 }
 
 /* Make zebra server socket, wiping any existing one (see bug #403). */
@@ -32,14 +32,20 @@
 /* Default configuration filename. */
 #define DEFAULT_CONFIG_FILE "zebra.conf"
 
+/* Bytes read from a client at once. */
+#define ZSERV_READ_SIZE               65536
+
 /* Client structure. */
 struct zserv
 {
   /* Client file descriptor. */
   int sock;
 
-  /* Input/output buffer to the client. */
+  /* Data read from the client, and the message being handled. */
+  struct stream *rb;
   struct stream *ibuf;
+
+  /* Output buffer to the client. */
   struct stream *obuf;
 
   /* Buffer of data waiting to be written to client. */
@@ -66,6 +72,10 @@ struct zserv
 
   /* Router-id information. */
   u_char ridinfo;
+
+  /* Messages handled, and the reads they came in. */
+  unsigned long messages;
+  unsigned long reads;
 };
 
 /* Zebra instance */
@@ -107,6 +117,8 @@ extern int zsend_interface_update (int, struct zserv *, struct interface *);
 extern int zsend_route_multipath (int, struct zserv *, struct prefix *, 
                                   struct rib *);
 extern int zsend_router_id_update(struct zserv *, struct prefix *);
+extern int zsend_nexthop_update (struct zserv *, struct prefix *,
+                                 u_char *, u_int16_t);
 
 extern pid_t pid;
 